@@ -0,0 +1,13 @@
+BENCH_CFLAGS := $(CFLAGS) -Isrc
+
+BENCH = bench_launch bench_loop bench_parse bench_placement bench_read bench_serve
+
+build/bench_%.o: bench/bench_%.c
+	@echo "CC   bench_$*.c"
+	@$(CC) -c -o $@ $(BENCH_CFLAGS) $<
+
+$(BENCH): %: all build/%.o
+	@echo "LINK $@"
+	@$(LINK.cc) -o $@ build/$@.o $(OBJ)
+
+bench: $(BENCH)
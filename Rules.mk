@@ -1,6 +1,13 @@
 build/:
 	mkdir build/
 
+build/pic/:
+	mkdir -p build/pic/
+
 build/%.o: src/%.c
 	@echo "CC   $*.c"
 	@$(CC) -c -o $@ $(CFLAGS) $<
+
+build/pic/%.o: src/%.c
+	@echo "CC   $*.c (PIC)"
+	@$(CC) -c -fPIC -o $@ $(CFLAGS) $<
@@ -1,11 +1,26 @@
 TEST_CFLAGS := $(CFLAGS) -Isrc -Ibuild/cmockery/include/google
 
 TEST_OBJ = build/test_all.o \
+           build/test_arithmetic.o \
+           build/test_array.o \
            build/test_builtin.o \
            build/test_command.o \
            build/test_exec.o \
+           build/test_expansion.o \
+           build/test_functions.o \
+           build/test_heredoc.o \
+           build/test_jobs.o \
+           build/test_launcher.o \
+           build/test_libmush.o \
+           build/test_optimizer.o \
            build/test_parser.o \
-           build/test_queue.o
+           build/test_queue.o \
+           build/test_redirection.o \
+           build/test_schedule.o \
+           build/test_script.o \
+           build/test_server.o \
+           build/test_topology.o \
+           build/test_transfer.o
 
 build/test_%.o: tests/test_%.c
 	@@echo "CC   test_$*.c"
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Measures how long it takes to launch a program from a shell which has
+ * grown large, with and without the launcher helper.
+ *
+ * usage: bench_launch [megabytes [iterations]]
+ */
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "exec.h"
+#include "launcher.h"
+
+/*!
+ \brief Launch \c true \a iterations times, waiting for each
+ \return average time per launch in microseconds
+ */
+static double _measure(int iterations)
+{
+	char *argv[] = {"true", NULL};
+	struct timeval start;
+	struct timeval end;
+	pid_t pid;
+	int i;
+	gettimeofday(&start, NULL);
+	for(i = 0; i < iterations; i++) {
+		pid = executeInChild(1, argv, NULL);
+		if(pid == -1) {
+			perror("bench_launch");
+			exit(1);
+		}
+		waitpid(pid, NULL, 0);
+	}
+	gettimeofday(&end, NULL);
+	return ((end.tv_sec - start.tv_sec) * 1e6 + (end.tv_usec - start.tv_usec)) / iterations;
+}
+
+int main(int argc, char **argv)
+{
+	size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 1024;
+	int iterations = argc > 2 ? atoi(argv[2]) : 200;
+	double withoutLauncher;
+	double withLauncher;
+	char *ballast;
+	if(iterations <= 0) {
+		fprintf(stderr, "usage: bench_launch [megabytes [iterations]]\n");
+		return 1;
+	}
+	/* The launcher has to be forked while the process is still small */
+	if(launcherStart() != 0) {
+		perror("bench_launch: launcher");
+		return 1;
+	}
+	/* Touch every page so it is mapped, as a shell's heap would be */
+	ballast = malloc(megabytes * 1024 * 1024);
+	if(ballast == NULL && megabytes > 0) {
+		perror("bench_launch");
+		return 1;
+	}
+#if defined(MADV_NOHUGEPAGE)
+	/* A heap of small objects is mapped in small pages, each copied by fork() */
+	madvise((void *)((unsigned long)ballast & ~4095UL), megabytes * 1024 * 1024, MADV_NOHUGEPAGE);
+#endif
+	memset(ballast, 1, megabytes * 1024 * 1024);
+	withLauncher = _measure(iterations);
+	launcherStop();
+	withoutLauncher = _measure(iterations);
+	printf("%zu MB resident, %d launches\n", megabytes, iterations);
+	printf("fork:     %10.1f us/launch\n", withoutLauncher);
+	printf("launcher: %10.1f us/launch\n", withLauncher);
+	free(ballast);
+	return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Measures how long a loop of conditional assignments takes when it is
+ * compiled once, compared to the same commands written out as separate
+ * lines, each parsed as the shell reads it.
+ *
+ * usage: bench_loop
+ */
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parser.h"
+#include "script.h"
+#include "variables.h"
+
+/*! \brief Nested loops of ten words each, 100000 iterations */
+static char _loop[] =
+	"for a in 0 1 2 3 4 5 6 7 8 9; do\n"
+	"for b in 0 1 2 3 4 5 6 7 8 9; do\n"
+	"for c in 0 1 2 3 4 5 6 7 8 9; do\n"
+	"for d in 0 1 2 3 4 5 6 7 8 9; do\n"
+	"for e in 0 1 2 3 4 5 6 7 8 9; do\n"
+	"if test $e != 5; then x=$a$b$c$d$e; else y=$e; fi\n"
+	"done; done; done; done; done\n";
+
+/*! \brief Amount of iterations of \a _loop */
+#define ITERATIONS 100000
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval end;
+	gettimeofday(&end, NULL);
+	return (end.tv_sec - start->tv_sec) + (end.tv_usec - start->tv_usec) / 1e6;
+}
+
+/*!
+ \brief Parse, compile and execute \a source
+ \return \c 0 on success, \c -1 on error
+ */
+static int _run(char *source)
+{
+	queue_t *commands;
+	script_t *script;
+	commands = commandQueueFromInput(source);
+	if(commands == NULL) {
+		return -1;
+	}
+	script = scriptCompile(commands);
+	queueFree(commands);
+	if(script == NULL) {
+		return -1;
+	}
+	scriptExecute(script);
+	scriptFree(script);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct timeval start;
+	double looped;
+	double unrolled;
+	char line[64];
+	int i;
+	variablesSetPositional(argc, argv);
+	gettimeofday(&start, NULL);
+	if(_run(_loop) != 0) {
+		fprintf(stderr, "bench_loop: unable to run loop\n");
+		return 1;
+	}
+	looped = _elapsed(&start);
+	if(strcmp(variableGet("x"), "99999") != 0) {
+		fprintf(stderr, "bench_loop: loop ended with x=%s\n", variableGet("x"));
+		return 1;
+	}
+	gettimeofday(&start, NULL);
+	for(i = 0; i < ITERATIONS; i++) {
+		snprintf(line, sizeof(line), "if test %d != 5; then x=%05d; else y=%d; fi", i % 10, i, i % 10);
+		if(_run(line) != 0) {
+			fprintf(stderr, "bench_loop: unable to run line\n");
+			return 1;
+		}
+	}
+	unrolled = _elapsed(&start);
+	printf("%d iterations\n", ITERATIONS);
+	printf("loop:     %8.3f s (%6.2f us/iteration)\n", looped, looped * 1e6 / ITERATIONS);
+	printf("unrolled: %8.3f s (%6.2f us/line)\n", unrolled, unrolled * 1e6 / ITERATIONS);
+	return 0;
+}
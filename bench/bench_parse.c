@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Measures how parsing and compiling scales with threads, each using a
+ * context of its own. With no state shared between the contexts, the
+ * throughput grows with the threads up to the amount of processors.
+ *
+ * usage: bench_parse [max-threads [iterations]]
+ */
+#include <sys/time.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "libmush.h"
+
+/*! \brief A script of the kind a service would run */
+static const char _source[] =
+	"for file in a b c d e f; do\n"
+	"if test -f \"$file\"; then gzip -9 < \"$file\" > \"$file.gz\" && rm \"$file\"; fi\n"
+	"done\n"
+	"case \"$mode\" in fast) jobs=8 ;; *) jobs=1 ;; esac\n"
+	"grep -v '^#' config | sort -u | head -n 100 > sorted 2>/dev/null || echo failed >&2\n";
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval end;
+	gettimeofday(&end, NULL);
+	return (end.tv_sec - start->tv_sec) + (end.tv_usec - start->tv_usec) / 1e6;
+}
+
+/*!
+ \brief Parse \a _source the amount of times pointed to by \a argument
+ \return \c NULL on success, \a argument on error
+ */
+static void *_parse(void *argument)
+{
+	mush_context_t *context = mushContextNew();
+	script_t *script;
+	int iterations = *(int *)argument;
+	int i;
+	if(context == NULL) {
+		return argument;
+	}
+	for(i = 0; i < iterations; i++) {
+		script = mushContextParse(context, _source);
+		if(script == NULL) {
+			mushContextFree(context);
+			return argument;
+		}
+		scriptFree(script);
+	}
+	mushContextFree(context);
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t *threads;
+	struct timeval start;
+	double elapsed;
+	double single = 0;
+	void *result;
+	long processors = sysconf(_SC_NPROCESSORS_ONLN);
+	int maxThreads = argc > 1 ? atoi(argv[1]) : (int)processors * 2;
+	int iterations = argc > 2 ? atoi(argv[2]) : 20000;
+	int threadCount;
+	int index;
+	int failed = 0;
+	if(maxThreads < 1 || iterations < 1) {
+		fprintf(stderr, "usage: bench_parse [max-threads [iterations]]\n");
+		return 2;
+	}
+	threads = malloc(maxThreads * sizeof(*threads));
+	if(threads == NULL) {
+		perror("bench_parse");
+		return 1;
+	}
+	printf("%d parses per thread, %ld processors\n", iterations, processors);
+	for(threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+		gettimeofday(&start, NULL);
+		for(index = 0; index < threadCount; index++) {
+			if(pthread_create(&threads[index], NULL, _parse, &iterations) != 0) {
+				perror("bench_parse");
+				return 1;
+			}
+		}
+		for(index = 0; index < threadCount; index++) {
+			pthread_join(threads[index], &result);
+			failed = failed || result != NULL;
+		}
+		elapsed = _elapsed(&start);
+		if(failed) {
+			fprintf(stderr, "bench_parse: unable to parse\n");
+			return 1;
+		}
+		if(threadCount == 1) {
+			single = iterations / elapsed;
+		}
+		printf("%3d threads: %10.0f parses/s (%5.2fx)\n", threadCount,
+			threadCount * iterations / elapsed, threadCount * iterations / elapsed / single);
+	}
+	free(threads);
+	return 0;
+}
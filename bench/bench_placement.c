@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Measures how long a four stage pipeline takes to pass data through, with
+ * its stages scheduled freely and then placed on CPUs sharing a cache. The
+ * difference only shows on machines with more than one cache.
+ *
+ * usage: bench_placement
+ */
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "parser.h"
+#include "script.h"
+#include "options.h"
+
+/*! \brief Size of the data passed through the pipeline, in bytes */
+#define DATA_SIZE (64 * 1024 * 1024)
+
+/*! \brief Amount of times the pipeline is run with each setting */
+#define ITERATIONS 5
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval end;
+	gettimeofday(&end, NULL);
+	return (end.tv_sec - start->tv_sec) + (end.tv_usec - start->tv_usec) / 1e6;
+}
+
+/*!
+ \brief Parse, compile and execute \a source
+ \return \c 0 on success, \c -1 on error
+ */
+static int _run(char *source)
+{
+	queue_t *commands;
+	script_t *script;
+	commands = commandQueueFromInput(source);
+	if(commands == NULL) {
+		return -1;
+	}
+	script = scriptCompile(commands);
+	queueFree(commands);
+	if(script == NULL) {
+		return -1;
+	}
+	scriptExecute(script);
+	scriptFree(script);
+	return 0;
+}
+
+/*! \brief Fill the file at \a path with \c DATA_SIZE bytes of text */
+static int _writeData(const char *path)
+{
+	size_t written = 0;
+	FILE *file = fopen(path, "w");
+	if(file == NULL) {
+		return -1;
+	}
+	while(written < DATA_SIZE) {
+		written += fprintf(file, "the quick brown fox %zu jumps over the lazy dog\n", written);
+	}
+	return fclose(file);
+}
+
+int main(int argc, char **argv)
+{
+	char path[] = "/tmp/bench_placementXXXXXX";
+	char source[128];
+	struct timeval start;
+	double times[2];
+	int placement;
+	int i;
+	int descriptor = mkstemp(path);
+	if(descriptor == -1) {
+		perror("bench_placement");
+		return 1;
+	}
+	close(descriptor);
+	if(_writeData(path) != 0) {
+		perror("bench_placement");
+		unlink(path);
+		return 1;
+	}
+	snprintf(source, sizeof(source),
+		"tr a-z n-za-m < %s | tr n-za-m a-z | tr a-z A-Z | cksum > /dev/null", path);
+	for(placement = 0; placement < 2; placement++) {
+		optionSet(kOptionPlacement, placement);
+		gettimeofday(&start, NULL);
+		for(i = 0; i < ITERATIONS; i++) {
+			if(_run(source) != 0) {
+				fprintf(stderr, "bench_placement: unable to run pipeline\n");
+				unlink(path);
+				return 1;
+			}
+		}
+		times[placement] = _elapsed(&start);
+	}
+	unlink(path);
+	printf("%d runs of %d MiB through 4 stages\n", ITERATIONS, DATA_SIZE / (1024 * 1024));
+	printf("free:   %8.3f s (%6.1f MiB/s)\n", times[0], ITERATIONS * (DATA_SIZE / 1048576.0) / times[0]);
+	printf("placed: %8.3f s (%6.1f MiB/s)\n", times[1], ITERATIONS * (DATA_SIZE / 1048576.0) / times[1]);
+	return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Measures how fast the read builtin consumes the lines of a file, read in
+ * blocks, compared to the same lines arriving through a pipe, which have to
+ * be read one character at a time.
+ *
+ * usage: bench_read [megabytes]
+ */
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "read.h"
+#include "variables.h"
+
+/*! \brief A line of the generated file */
+#define LINE "the quick brown fox jumps over the lazy dog 0123456789\n"
+
+static double _elapsed(struct timeval *start)
+{
+	struct timeval end;
+	gettimeofday(&end, NULL);
+	return (end.tv_sec - start->tv_sec) + (end.tv_usec - start->tv_usec) / 1e6;
+}
+
+/*!
+ \brief Read every line of standard input into three variables
+ \return amount of lines read
+ */
+static long _readAll(void)
+{
+	char *argv[] = {"read", "-r", "first", "second", "rest", NULL};
+	long lines = 0;
+	while(cmd_read(5, argv) == 0) {
+		lines++;
+	}
+	return lines;
+}
+
+int main(int argc, char **argv)
+{
+	char path[] = "/tmp/bench_read.XXXXXX";
+	struct timeval start;
+	double buffered;
+	double unbuffered;
+	long megabytes = argc > 1 ? atol(argv[1]) : 64;
+	long lineCount = megabytes * 1024 * 1024 / (sizeof(LINE) - 1);
+	long lines;
+	int pipeDescriptors[2];
+	int descriptor;
+	long i;
+	pid_t pid;
+	FILE *file;
+	descriptor = mkstemp(path);
+	if(descriptor == -1 || (file = fdopen(descriptor, "w")) == NULL) {
+		perror("bench_read");
+		return 1;
+	}
+	unlink(path);
+	for(i = 0; i < lineCount; i++) {
+		fputs(LINE, file);
+	}
+	fflush(file);
+
+	lseek(descriptor, 0, SEEK_SET);
+	dup2(descriptor, STDIN_FILENO);
+	gettimeofday(&start, NULL);
+	lines = _readAll();
+	buffered = _elapsed(&start);
+	if(lines != lineCount) {
+		fprintf(stderr, "bench_read: read %ld of %ld lines from the file\n", lines, lineCount);
+		return 1;
+	}
+
+	if(pipe(pipeDescriptors) != 0) {
+		perror("bench_read");
+		return 1;
+	}
+	pid = fork();
+	if(pid == 0) {
+		close(pipeDescriptors[0]);
+		lseek(descriptor, 0, SEEK_SET);
+		dup2(descriptor, STDIN_FILENO);
+		dup2(pipeDescriptors[1], STDOUT_FILENO);
+		execlp("cat", "cat", (char *)NULL);
+		_exit(127);
+	}
+	close(pipeDescriptors[1]);
+	dup2(pipeDescriptors[0], STDIN_FILENO);
+	gettimeofday(&start, NULL);
+	lines = _readAll();
+	unbuffered = _elapsed(&start);
+	waitpid(pid, NULL, 0);
+	if(lines != lineCount) {
+		fprintf(stderr, "bench_read: read %ld of %ld lines from the pipe\n", lines, lineCount);
+		return 1;
+	}
+	printf("%ld lines, %ld MB\n", lineCount, megabytes);
+	printf("file: %8.3f s (%7.1f MB/s)\n", buffered, megabytes / buffered);
+	printf("pipe: %8.3f s (%7.1f MB/s)\n", unbuffered, megabytes / unbuffered);
+	printf("speedup: %.1fx\n", unbuffered / buffered);
+	return 0;
+}
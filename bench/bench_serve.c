@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Load test of the command server: concurrent clients each send command
+ * lines one after the other over their own connection, and the requests
+ * per second and latency percentiles are reported. Without a socket, a
+ * server with one worker per processor is started for the run.
+ *
+ * usage: bench_serve [-c clients] [-n requests] [-e command] [socket]
+ */
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "server.h"
+#include "jobs.h"
+
+static double _now()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static int _compareLatencies(const void *a, const void *b)
+{
+	double first = *(const double *)a;
+	double second = *(const double *)b;
+	return first < second ? -1 : first > second;
+}
+
+static int _connect(const char *path)
+{
+	struct sockaddr_un address;
+	int connection;
+	int attempt;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+	connection = socket(AF_UNIX, SOCK_STREAM, 0);
+	/* A server started by the benchmark may not be listening yet */
+	for(attempt = 0; connection != -1 && attempt < 500; attempt++) {
+		if(connect(connection, (struct sockaddr *)&address, sizeof(address)) == 0) {
+			return connection;
+		}
+		usleep(10000);
+	}
+	return -1;
+}
+
+/*!
+ \brief Send \a requests command lines, recording the latency of each
+ \return \c 0 on success, \c -1 on error
+ */
+static int _runClient(const char *path, const char *command, int requests, double *latencies)
+{
+	server_header_t header;
+	char *payload;
+	double start;
+	int connection = _connect(path);
+	int request;
+	if(connection == -1) {
+		return -1;
+	}
+	for(request = 0; request < requests; request++) {
+		start = _now();
+		if(serverSendMessage(connection, kServerMessageCommand, command, strlen(command),
+			NULL, 0) != 0) {
+			return -1;
+		}
+		do {
+			if(serverReceiveMessage(connection, &header, &payload, NULL, NULL) != 0) {
+				return -1;
+			}
+			free(payload);
+		} while(header.type != kServerMessageStatus);
+		latencies[request] = _now() - start;
+	}
+	close(connection);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	char path[64] = "";
+	const char *command = "echo hello";
+	double *latencies;
+	pid_t *pids;
+	double start;
+	double elapsed;
+	size_t total;
+	pid_t server = -1;
+	int clients = 8;
+	int requests = 1000;
+	int failures = 0;
+	int status;
+	int option;
+	int client;
+	while((option = getopt(argc, argv, "c:n:e:")) != -1) {
+		switch(option) {
+			case 'c':
+				clients = atoi(optarg);
+				break;
+			case 'n':
+				requests = atoi(optarg);
+				break;
+			case 'e':
+				command = optarg;
+				break;
+			default:
+				fprintf(stderr, "usage: bench_serve [-c clients] [-n requests] [-e command] [socket]\n");
+				return 2;
+		}
+	}
+	if(clients < 1 || requests < 1) {
+		fprintf(stderr, "bench_serve: invalid amount of clients or requests\n");
+		return 2;
+	}
+	if(optind < argc) {
+		strncpy(path, argv[optind], sizeof(path) - 1);
+	} else {
+		snprintf(path, sizeof(path), "/tmp/bench_serve.%d", (int)getpid());
+		jobsInitialize();
+		server = fork();
+		if(server == 0) {
+			_exit(serverRun(path, jobsSlotLimit()));
+		}
+	}
+	total = (size_t)clients * requests;
+	latencies = mmap(NULL, total * sizeof(*latencies), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	pids = malloc(clients * sizeof(*pids));
+	if(latencies == MAP_FAILED || pids == NULL) {
+		perror("bench_serve");
+		return 1;
+	}
+	/* Connect once, so the clients do not measure the server starting */
+	close(_connect(path));
+	start = _now();
+	for(client = 0; client < clients; client++) {
+		pids[client] = fork();
+		if(pids[client] == 0) {
+			_exit(_runClient(path, command, requests, latencies + (size_t)client * requests) != 0);
+		}
+	}
+	for(client = 0; client < clients; client++) {
+		if(pids[client] == -1 || waitpid(pids[client], &status, 0) == -1
+		|| !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			failures++;
+		}
+	}
+	elapsed = _now() - start;
+	if(server != -1) {
+		kill(server, SIGTERM);
+		waitpid(server, NULL, 0);
+	}
+	if(failures > 0) {
+		fprintf(stderr, "bench_serve: %d clients failed\n", failures);
+		return 1;
+	}
+	qsort(latencies, total, sizeof(*latencies), _compareLatencies);
+	printf("%zu requests of \"%s\" from %d clients\n", total, command, clients);
+	printf("throughput: %8.1f requests/s\n", total / elapsed);
+	printf("latency:    p50 %7.3f ms, p99 %7.3f ms, max %7.3f ms\n",
+		latencies[total / 2] * 1e3, latencies[total * 99 / 100] * 1e3, latencies[total - 1] * 1e3);
+	return 0;
+}
@@ -0,0 +1,22 @@
+#ifndef CMOCK_SHIM_H
+#define CMOCK_SHIM_H
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <setjmp.h>
+typedef void (*UnitTestFunction)(void **state);
+typedef struct { const char *name; UnitTestFunction f; } UnitTest;
+#define unit_test(f) { #f, f }
+extern jmp_buf _cm_jmp; extern int _cm_fail;
+void _cm_fail_at(const char *msg, const char *file, int line);
+#define assert_true(c) do { if(!(c)) _cm_fail_at(#c, __FILE__, __LINE__); } while(0)
+#define assert_false(c) assert_true(!(c))
+#define assert_int_equal(a,b) do { long long _a=(long long)(a), _b=(long long)(b); if(_a!=_b){ fprintf(stderr,"%lld != %lld\n",_a,_b); _cm_fail_at(#a " == " #b, __FILE__, __LINE__);} } while(0)
+#define assert_int_not_equal(a,b) assert_true((a)!=(b))
+#define assert_string_equal(a,b) do { const char *_a=(a), *_b=(b); if(!_a||!_b||strcmp(_a,_b)){ fprintf(stderr,"'%s' != '%s'\n",_a?_a:"(null)",_b?_b:"(null)"); _cm_fail_at(#a " == " #b, __FILE__, __LINE__);} } while(0)
+#define assert_string_not_equal(a,b) assert_true(strcmp((a),(b))!=0)
+#define assert_memory_equal(a,b,n) assert_true(memcmp((a),(b),(n))==0)
+void mock_assert(int r, const char *e, const char *f, int l);
+int _run_tests(const UnitTest *t, size_t n);
+#define run_tests(t) _run_tests(t, sizeof(t)/sizeof(t[0]))
+#endif
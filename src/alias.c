@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "alias.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "expansion.h"
+#include "hash.h"
+
+/*! \brief Amount of buckets of the alias table, a power of two */
+#define ALIAS_BUCKET_COUNT 64
+
+/*! \brief Aliases, chained by the hash of their name */
+static alias_t *_buckets[ALIAS_BUCKET_COUNT];
+
+/*!
+ \brief Bucket of \a name
+ */
+static unsigned int _hash(const char *name)
+{
+	return hashString(name) & (ALIAS_BUCKET_COUNT - 1);
+}
+
+static void _freeAlias(alias_t *alias)
+{
+	expansionFree(alias->words);
+	free(alias->value);
+	free(alias->name);
+	free(alias);
+}
+
+int aliasDefine(const char *name, const char *value)
+{
+	alias_t *alias = malloc(sizeof(*alias));
+	unsigned int bucket = _hash(name);
+	if(alias == NULL) {
+		return -1;
+	}
+	alias->name = strdup(name);
+	alias->value = strdup(value);
+	alias->words = expansionSplitWords(value);
+	if(alias->name == NULL || alias->value == NULL || alias->words == NULL) {
+		_freeAlias(alias);
+		return -1;
+	}
+	aliasRemove(name);
+	alias->next = _buckets[bucket];
+	_buckets[bucket] = alias;
+	return 0;
+}
+
+alias_t *aliasLookup(const char *name)
+{
+	alias_t *alias;
+	for(alias = _buckets[_hash(name)]; alias != NULL; alias = alias->next) {
+		if(strcmp(alias->name, name) == 0) {
+			return alias;
+		}
+	}
+	return NULL;
+}
+
+int aliasRemove(const char *name)
+{
+	alias_t **link;
+	alias_t *alias;
+	for(link = &_buckets[_hash(name)]; *link != NULL; link = &(*link)->next) {
+		if(strcmp((*link)->name, name) == 0) {
+			alias = *link;
+			*link = alias->next;
+			_freeAlias(alias);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+void aliasesReset()
+{
+	alias_t *alias;
+	size_t bucket;
+	for(bucket = 0; bucket < ALIAS_BUCKET_COUNT; bucket++) {
+		while(_buckets[bucket] != NULL) {
+			alias = _buckets[bucket];
+			_buckets[bucket] = alias->next;
+			_freeAlias(alias);
+		}
+	}
+}
+
+static void _printAlias(alias_t *alias)
+{
+	const char *ptr;
+	printf("alias %s='", alias->name);
+	for(ptr = alias->value; *ptr != '\0'; ptr++) {
+		if(*ptr == '\'') {
+			printf("'\\''");
+		} else {
+			putchar(*ptr);
+		}
+	}
+	printf("'\n");
+}
+
+int cmd_alias(int argc, char **argv)
+{
+	alias_t *alias;
+	char *name;
+	size_t length;
+	int bucket;
+	int argi;
+	int status = 0;
+	if(argc < 2) {
+		for(bucket = 0; bucket < ALIAS_BUCKET_COUNT; bucket++) {
+			for(alias = _buckets[bucket]; alias != NULL; alias = alias->next) {
+				_printAlias(alias);
+			}
+		}
+		return 0;
+	}
+	for(argi = 1; argi < argc; argi++) {
+		length = strcspn(argv[argi], "=");
+		if(argv[argi][length] == '\0') {
+			alias = aliasLookup(argv[argi]);
+			if(alias == NULL) {
+				fprintf(stderr, "alias: %s: not found\n", argv[argi]);
+				status = 1;
+			} else {
+				_printAlias(alias);
+			}
+			continue;
+		}
+		name = strndup(argv[argi], length);
+		if(name == NULL || length == 0 || aliasDefine(name, argv[argi] + length + 1) != 0) {
+			fprintf(stderr, "alias: %s: invalid alias\n", argv[argi]);
+			status = 1;
+		}
+		free(name);
+	}
+	return status;
+}
+
+int cmd_unalias(int argc, char **argv)
+{
+	int bucket;
+	int argi;
+	int status = 0;
+	if(argc < 2) {
+		fprintf(stderr, "usage: unalias -a | name...\n");
+		return 2;
+	}
+	if(strcmp(argv[1], "-a") == 0) {
+		for(bucket = 0; bucket < ALIAS_BUCKET_COUNT; bucket++) {
+			while(_buckets[bucket] != NULL) {
+				aliasRemove(_buckets[bucket]->name);
+			}
+		}
+		return 0;
+	}
+	for(argi = 1; argi < argc; argi++) {
+		if(aliasRemove(argv[argi]) != 0) {
+			fprintf(stderr, "unalias: %s: not found\n", argv[argi]);
+			status = 1;
+		}
+	}
+	return status;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ALIAS_H
+#define ALIAS_H
+
+/*!
+ \addtogroup alias
+ \{
+ */
+
+/*! \brief An alias, replacing the name of a command with other words */
+typedef struct __alias_t {
+	/*! \brief name of the alias */
+	char *name;
+	/*! \brief value as it was defined */
+	char *value;
+	/*! \brief \a value split into words, \c NULL terminated */
+	char **words;
+	/*! \brief next alias in the same bucket */
+	struct __alias_t *next;
+} alias_t;
+
+/*!
+ \brief Define the alias \a name, replacing any previous definition
+
+ The value is split into words once, they are expanded each time the alias
+ is used.
+
+ \return \c 0 on success, \c -1 on error
+ */
+int aliasDefine(const char *name, const char *value);
+
+/*!
+ \brief Find the alias called \a name
+ \return the alias, or \c NULL if there is none
+ */
+alias_t *aliasLookup(const char *name);
+
+/*!
+ \brief Remove the alias called \a name
+ \return \c 0 on success, \c -1 if there is no such alias
+ */
+int aliasRemove(const char *name);
+
+/*!
+ \brief Forget every alias, as a new shell would
+ */
+void aliasesReset();
+
+/*!
+ \brief Run the builtin "alias" command
+
+ \c "alias name=value" defines an alias, \c "alias name" prints it, and
+ without arguments every alias is printed.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return exit status of the command
+ */
+int cmd_alias(int argc, char **argv);
+
+/*!
+ \brief Run the builtin "unalias" command, removing the named aliases, or
+ all of them with \c -a
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return exit status of the command
+ */
+int cmd_unalias(int argc, char **argv);
+
+/*!
+ \}
+ */
+
+#endif /* ALIAS_H */
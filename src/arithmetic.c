@@ -0,0 +1,623 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "arithmetic.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <limits.h>
+#include "hash.h"
+#include "variables.h"
+
+/*! \brief Amount of parsed expressions kept, a power of two */
+#define ARITHMETIC_CACHE_SIZE 256
+
+enum {
+	kArithmeticNodeNumber = 0,
+	kArithmeticNodeVariable,
+	kArithmeticNodePositional,
+	kArithmeticNodeUnary,
+	kArithmeticNodeBinary,
+	kArithmeticNodeAnd,
+	kArithmeticNodeOr,
+	kArithmeticNodeConditional,
+	kArithmeticNodeAssign,
+	kArithmeticNodePrefix,
+	kArithmeticNodePostfix
+};
+
+/*! \brief Binding power of the prefix operators */
+#define ARITHMETIC_POWER_PREFIX 15
+
+/*! \brief A node of a parsed expression */
+typedef struct __arithmetic_node_t {
+	/*! \brief one of the \c kArithmeticNode values */
+	int type;
+	/*! \brief operator character, e.g. \c '+' or \c 'L' for \c << */
+	char operator;
+	/*! \brief value of a number, or index of a positional parameter */
+	long long number;
+	/*! \brief variable read or assigned by the node */
+	variable_t *variable;
+	/*! \brief operands, as indices of nodes */
+	int operands[3];
+} arithmetic_node_t;
+
+/*! \brief A parsed expression */
+typedef struct __arithmetic_expression_t {
+	/*! \brief text the expression was parsed from */
+	char *text;
+	size_t length;
+	arithmetic_node_t *nodes;
+	int nodeCount;
+	/*! \brief index of the node evaluated first */
+	int root;
+} arithmetic_expression_t;
+
+/*! \brief State of the parser */
+typedef struct __arithmetic_parser_t {
+	const char *ptr;
+	const char *end;
+	arithmetic_expression_t *expression;
+	/*! \brief description of the first error, or \c NULL */
+	const char *error;
+} arithmetic_parser_t;
+
+/*!
+ \brief Binary operators, longest first so prefixes match last
+
+ Operators are identified by a single character; the shifts and comparisons
+ made of two characters use otherwise unused ones.
+ */
+static const struct {
+	const char *text;
+	char operator;
+	int power;
+	int isAssignment;
+} _binaryOperators[] = {
+	{"<<=", 'L', 2, 1},
+	{">>=", 'R', 2, 1},
+	{"**", 'P', 14, 0},
+	{"<<", 'L', 11, 0},
+	{">>", 'R', 11, 0},
+	{"<=", 'l', 10, 0},
+	{">=", 'g', 10, 0},
+	{"==", 'e', 9, 0},
+	{"!=", 'n', 9, 0},
+	{"&&", 'A', 5, 0},
+	{"||", 'O', 4, 0},
+	{"+=", '+', 2, 1},
+	{"-=", '-', 2, 1},
+	{"*=", '*', 2, 1},
+	{"/=", '/', 2, 1},
+	{"%=", '%', 2, 1},
+	{"&=", '&', 2, 1},
+	{"^=", '^', 2, 1},
+	{"|=", '|', 2, 1},
+	{"*", '*', 13, 0},
+	{"/", '/', 13, 0},
+	{"%", '%', 13, 0},
+	{"+", '+', 12, 0},
+	{"-", '-', 12, 0},
+	{"<", '<', 10, 0},
+	{">", '>', 10, 0},
+	{"&", '&', 8, 0},
+	{"^", '^', 7, 0},
+	{"|", '|', 6, 0},
+	{"?", '?', 3, 0},
+	{"=", '=', 2, 1},
+	{",", ',', 1, 0},
+	{NULL, 0, 0, 0}
+};
+
+/*! \brief Parsed expressions, indexed by the hash of their text */
+static arithmetic_expression_t *_cache[ARITHMETIC_CACHE_SIZE];
+
+static int _parseExpression(arithmetic_parser_t *parser, int minimumPower);
+
+static void _skipSpace(arithmetic_parser_t *parser)
+{
+	while(parser->ptr < parser->end && isspace((unsigned char)*parser->ptr)) {
+		parser->ptr++;
+	}
+}
+
+static int _isAt(arithmetic_parser_t *parser, const char *text)
+{
+	size_t length = strlen(text);
+	return (size_t)(parser->end - parser->ptr) >= length && strncmp(parser->ptr, text, length) == 0;
+}
+
+/*!
+ \brief Append a node to the expression
+ \return index of the node, or \c -1 on error
+ */
+static int _addNode(arithmetic_parser_t *parser, int type, char operator)
+{
+	arithmetic_expression_t *expression = parser->expression;
+	arithmetic_node_t *grown;
+	arithmetic_node_t *node;
+	grown = realloc(expression->nodes, (expression->nodeCount + 1) * sizeof(*grown));
+	if(grown == NULL) {
+		parser->error = "out of memory";
+		return -1;
+	}
+	expression->nodes = grown;
+	node = &expression->nodes[expression->nodeCount];
+	node->type = type;
+	node->operator = operator;
+	node->number = 0;
+	node->variable = NULL;
+	node->operands[0] = node->operands[1] = node->operands[2] = -1;
+	return expression->nodeCount++;
+}
+
+/*!
+ \brief Parse a variable name, optionally preceded by \c $ or in \c ${}
+ \return index of the node, or \c -1 if there is no name
+ */
+static int _parseVariable(arithmetic_parser_t *parser)
+{
+	const char *start = parser->ptr;
+	int isBraced = 0;
+	size_t length;
+	char *name;
+	int index;
+	if(*start == '$') {
+		start++;
+		isBraced = start < parser->end && *start == '{';
+		start += isBraced;
+	}
+	/* "$1" refers to a positional parameter */
+	if(start < parser->end && isdigit((unsigned char)*start) && start != parser->ptr) {
+		index = _addNode(parser, kArithmeticNodePositional, 0);
+		if(index != -1) {
+			parser->expression->nodes[index].number = strtoll(start, (char **)&parser->ptr, 10);
+		}
+	} else {
+		length = variableNameLength(start);
+		if(length == 0 || start + length > parser->end) {
+			parser->error = "operand expected";
+			return -1;
+		}
+		name = strndup(start, length);
+		index = _addNode(parser, kArithmeticNodeVariable, 0);
+		if(index != -1 && name != NULL) {
+			/* The variable is resolved once, its storage is used from then on */
+			parser->expression->nodes[index].variable = variableLookup(name, 1);
+		}
+		if(name == NULL || (index != -1 && parser->expression->nodes[index].variable == NULL)) {
+			parser->error = "out of memory";
+			index = -1;
+		}
+		free(name);
+		parser->ptr = start + length;
+	}
+	if(isBraced) {
+		if(parser->ptr >= parser->end || *parser->ptr != '}') {
+			parser->error = "missing '}'";
+			return -1;
+		}
+		parser->ptr++;
+	}
+	return index;
+}
+
+/*!
+ \brief Parse an operand, possibly preceded by prefix operators
+ */
+static int _parsePrefix(arithmetic_parser_t *parser)
+{
+	char *end;
+	int index;
+	int operand;
+	char operator;
+	_skipSpace(parser);
+	if(parser->ptr >= parser->end) {
+		parser->error = "operand expected";
+		return -1;
+	}
+	if(isdigit((unsigned char)*parser->ptr)) {
+		index = _addNode(parser, kArithmeticNodeNumber, 0);
+		if(index != -1) {
+			parser->expression->nodes[index].number = strtoll(parser->ptr, &end, 0);
+			if(end > parser->end || isalnum((unsigned char)*end)) {
+				parser->error = "invalid number";
+				return -1;
+			}
+			parser->ptr = end;
+		}
+		return index;
+	}
+	if(*parser->ptr == '(') {
+		parser->ptr++;
+		index = _parseExpression(parser, 0);
+		_skipSpace(parser);
+		if(index != -1 && (parser->ptr >= parser->end || *parser->ptr != ')')) {
+			parser->error = "missing ')'";
+			return -1;
+		}
+		parser->ptr++;
+		return index;
+	}
+	if(_isAt(parser, "++") || _isAt(parser, "--")) {
+		operator = *parser->ptr;
+		parser->ptr += 2;
+		_skipSpace(parser);
+		operand = _parseVariable(parser);
+		index = operand == -1 ? -1 : _addNode(parser, kArithmeticNodePrefix, operator);
+		if(index != -1) {
+			parser->expression->nodes[index].operands[0] = operand;
+		}
+		return index;
+	}
+	if(strchr("+-!~", *parser->ptr) != NULL) {
+		operator = *parser->ptr++;
+		operand = _parseExpression(parser, ARITHMETIC_POWER_PREFIX);
+		index = operand == -1 ? -1 : _addNode(parser, kArithmeticNodeUnary, operator);
+		if(index != -1) {
+			parser->expression->nodes[index].operands[0] = operand;
+		}
+		return index;
+	}
+	return _parseVariable(parser);
+}
+
+/*!
+ \brief Parse operators binding at least as tightly as \a minimumPower, by
+ precedence climbing
+ \return index of the node, or \c -1 on error
+ */
+static int _parseExpression(arithmetic_parser_t *parser, int minimumPower)
+{
+	arithmetic_node_t *nodes;
+	int left;
+	int right;
+	int third = -1;
+	int index;
+	int operator;
+	left = _parsePrefix(parser);
+	while(left != -1) {
+		_skipSpace(parser);
+		if(parser->ptr >= parser->end) {
+			break;
+		}
+		nodes = parser->expression->nodes;
+		if((_isAt(parser, "++") || _isAt(parser, "--"))
+		&& nodes[left].type == kArithmeticNodeVariable) {
+			index = _addNode(parser, kArithmeticNodePostfix, *parser->ptr);
+			if(index != -1) {
+				parser->expression->nodes[index].operands[0] = left;
+			}
+			parser->ptr += 2;
+			left = index;
+			continue;
+		}
+		for(operator = 0; _binaryOperators[operator].text != NULL
+			&& !_isAt(parser, _binaryOperators[operator].text); operator++) {
+		}
+		if(_binaryOperators[operator].text == NULL) {
+			if(*parser->ptr != ')' && *parser->ptr != ':') {
+				parser->error = "syntax error in expression";
+				return -1;
+			}
+			break;
+		}
+		if(_binaryOperators[operator].power < minimumPower) {
+			break;
+		}
+		parser->ptr += strlen(_binaryOperators[operator].text);
+		if(_binaryOperators[operator].isAssignment && nodes[left].type != kArithmeticNodeVariable) {
+			parser->error = "assignment to a non-variable";
+			return -1;
+		}
+		/* Assignments, ?: and ** group to the right, the others to the left */
+		if(_binaryOperators[operator].isAssignment || _binaryOperators[operator].operator == 'P') {
+			right = _parseExpression(parser, _binaryOperators[operator].power);
+		} else if(_binaryOperators[operator].operator == '?') {
+			right = _parseExpression(parser, 0);
+			_skipSpace(parser);
+			if(right != -1 && (parser->ptr >= parser->end || *parser->ptr != ':')) {
+				parser->error = "missing ':'";
+				return -1;
+			}
+			parser->ptr++;
+			third = right == -1 ? -1 : _parseExpression(parser, _binaryOperators[operator].power);
+		} else {
+			right = _parseExpression(parser, _binaryOperators[operator].power + 1);
+		}
+		if(right == -1 || (_binaryOperators[operator].operator == '?' && third == -1)) {
+			return -1;
+		}
+		switch(_binaryOperators[operator].operator) {
+			case 'A':
+				index = _addNode(parser, kArithmeticNodeAnd, 'A');
+				break;
+			case 'O':
+				index = _addNode(parser, kArithmeticNodeOr, 'O');
+				break;
+			case '?':
+				index = _addNode(parser, kArithmeticNodeConditional, '?');
+				break;
+			default:
+				index = _addNode(parser, _binaryOperators[operator].isAssignment
+					? kArithmeticNodeAssign : kArithmeticNodeBinary,
+					_binaryOperators[operator].operator);
+		}
+		if(index == -1) {
+			return -1;
+		}
+		parser->expression->nodes[index].operands[0] = left;
+		parser->expression->nodes[index].operands[1] = right;
+		parser->expression->nodes[index].operands[2] = third;
+		left = index;
+	}
+	return left;
+}
+
+static void _freeExpression(arithmetic_expression_t *expression)
+{
+	if(expression == NULL) {
+		return;
+	}
+	free(expression->text);
+	free(expression->nodes);
+	free(expression);
+}
+
+/*!
+ \brief Parse \a length characters of \a text
+ \param error receives the description of an error
+ \return the parsed expression, or \c NULL on error
+ */
+static arithmetic_expression_t *_parse(const char *text, size_t length, const char **error)
+{
+	arithmetic_parser_t parser;
+	arithmetic_expression_t *expression = malloc(sizeof(*expression));
+	*error = "out of memory";
+	if(expression == NULL) {
+		return NULL;
+	}
+	expression->text = strndup(text, length);
+	expression->length = length;
+	expression->nodes = NULL;
+	expression->nodeCount = 0;
+	parser.ptr = text;
+	parser.end = text + length;
+	parser.expression = expression;
+	parser.error = NULL;
+	_skipSpace(&parser);
+	/* An empty expression is zero */
+	if(parser.ptr == parser.end) {
+		expression->root = _addNode(&parser, kArithmeticNodeNumber, 0);
+	} else {
+		expression->root = _parseExpression(&parser, 0);
+		_skipSpace(&parser);
+		if(expression->root != -1 && parser.ptr < parser.end) {
+			parser.error = "syntax error in expression";
+			expression->root = -1;
+		}
+	}
+	if(expression->root == -1 || expression->text == NULL) {
+		*error = parser.error != NULL ? parser.error : "out of memory";
+		_freeExpression(expression);
+		return NULL;
+	}
+	*error = NULL;
+	return expression;
+}
+
+/*!
+ \brief Apply the binary \a operator
+ \param error receives the description of an error
+ */
+static long long _apply(char operator, long long left, long long right, const char **error)
+{
+	unsigned long long result = 1;
+	unsigned long long base = (unsigned long long)left;
+	/* Overflow wraps around, as it does for unsigned integers */
+	switch(operator) {
+		case '+':
+			return (long long)((unsigned long long)left + (unsigned long long)right);
+		case '-':
+			return (long long)((unsigned long long)left - (unsigned long long)right);
+		case '*':
+			return (long long)((unsigned long long)left * (unsigned long long)right);
+		case '/':
+		case '%':
+			if(right == 0) {
+				*error = "division by zero";
+				return 0;
+			}
+			if(left == LLONG_MIN && right == -1) {
+				return operator == '/' ? LLONG_MIN : 0;
+			}
+			return operator == '/' ? left / right : left % right;
+		case 'P':
+			if(right < 0) {
+				*error = "exponent less than 0";
+				return 0;
+			}
+			for(; right > 0; right >>= 1) {
+				if(right & 1) {
+					result *= base;
+				}
+				base *= base;
+			}
+			return (long long)result;
+		case 'L':
+			return (long long)((unsigned long long)left << (right & 63));
+		case 'R':
+			return left >> (right & 63);
+		case '<':
+			return left < right;
+		case '>':
+			return left > right;
+		case 'l':
+			return left <= right;
+		case 'g':
+			return left >= right;
+		case 'e':
+			return left == right;
+		case 'n':
+			return left != right;
+		case '&':
+			return left & right;
+		case '^':
+			return left ^ right;
+		case '|':
+			return left | right;
+		case ',':
+			return right;
+		default:
+			return right;
+	}
+}
+
+/*!
+ \brief Evaluate the node at \a index
+ \param error receives the description of an error
+ */
+static long long _evaluate(arithmetic_expression_t *expression, int index, const char **error)
+{
+	arithmetic_node_t *node = &expression->nodes[index];
+	variable_t *variable;
+	long long left;
+	long long right;
+	const char *value;
+	switch(node->type) {
+		case kArithmeticNodeNumber:
+			return node->number;
+		case kArithmeticNodeVariable:
+			return variableNumber(node->variable);
+		case kArithmeticNodePositional:
+			value = variablePositional((int)node->number);
+			return value != NULL ? strtoll(value, NULL, 0) : 0;
+		case kArithmeticNodeUnary:
+			left = _evaluate(expression, node->operands[0], error);
+			switch(node->operator) {
+				case '-':
+					return (long long)(0ULL - (unsigned long long)left);
+				case '!':
+					return !left;
+				case '~':
+					return ~left;
+				default:
+					return left;
+			}
+		case kArithmeticNodeAnd:
+			left = _evaluate(expression, node->operands[0], error);
+			return left != 0 && _evaluate(expression, node->operands[1], error) != 0;
+		case kArithmeticNodeOr:
+			left = _evaluate(expression, node->operands[0], error);
+			return left != 0 || _evaluate(expression, node->operands[1], error) != 0;
+		case kArithmeticNodeConditional:
+			left = _evaluate(expression, node->operands[0], error);
+			return _evaluate(expression, node->operands[left != 0 ? 1 : 2], error);
+		case kArithmeticNodePrefix:
+		case kArithmeticNodePostfix:
+			variable = expression->nodes[node->operands[0]].variable;
+			left = variableNumber(variable);
+			right = _apply(node->operator, left, 1, error);
+			variableSetNumber(variable, right);
+			return node->type == kArithmeticNodePrefix ? right : left;
+		case kArithmeticNodeAssign:
+			variable = expression->nodes[node->operands[0]].variable;
+			right = _evaluate(expression, node->operands[1], error);
+			if(node->operator != '=') {
+				right = _apply(node->operator, variableNumber(variable), right, error);
+			}
+			if(*error == NULL) {
+				variableSetNumber(variable, right);
+			}
+			return right;
+		case kArithmeticNodeBinary:
+		default:
+			left = _evaluate(expression, node->operands[0], error);
+			right = _evaluate(expression, node->operands[1], error);
+			return _apply(node->operator, left, right, error);
+	}
+}
+
+int arithmeticEvaluate(const char *text, size_t length, long long *result)
+{
+	arithmetic_expression_t *expression;
+	unsigned int slot = hashBytes(text, length) & (ARITHMETIC_CACHE_SIZE - 1);
+	const char *error = NULL;
+	expression = _cache[slot];
+	if(expression == NULL || expression->length != length
+	|| memcmp(expression->text, text, length) != 0) {
+		expression = _parse(text, length, &error);
+		if(expression == NULL) {
+			fprintf(stderr, "mush: %.*s: %s\n", (int)length, text, error);
+			return -1;
+		}
+		_freeExpression(_cache[slot]);
+		_cache[slot] = expression;
+	}
+	*result = _evaluate(expression, expression->root, &error);
+	if(error != NULL) {
+		fprintf(stderr, "mush: %.*s: %s\n", (int)length, text, error);
+		return -1;
+	}
+	return 0;
+}
+
+void arithmeticReset()
+{
+	size_t slot;
+	for(slot = 0; slot < ARITHMETIC_CACHE_SIZE; slot++) {
+		_freeExpression(_cache[slot]);
+		_cache[slot] = NULL;
+	}
+}
+
+const char *arithmeticFindEnd(const char *text)
+{
+	int depth = 0;
+	for(; *text != '\0'; text++) {
+		if(*text == '(') {
+			depth++;
+		} else if(*text == ')' && depth > 0) {
+			depth--;
+		} else if(*text == ')') {
+			return text[1] == ')' ? text : NULL;
+		}
+	}
+	return NULL;
+}
+
+int cmd_let(int argc, char **argv)
+{
+	long long result = 0;
+	int argi;
+	if(argc < 2) {
+		fprintf(stderr, "usage: let expression...\n");
+		return 2;
+	}
+	for(argi = 1; argi < argc; argi++) {
+		if(arithmeticEvaluate(argv[argi], strlen(argv[argi]), &result) != 0) {
+			return 1;
+		}
+	}
+	return result == 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ARITHMETIC_H
+#define ARITHMETIC_H
+
+#include <stddef.h>
+
+/*!
+ \addtogroup arithmetic
+ \{
+ */
+
+/*!
+ \brief Evaluate an arithmetic expression on 64 bit integers
+
+ The expression supports the operators of C, including assignments, \c ++,
+ \c -- and \c ?:, as well as \c **. Variables may be named with or without
+ \c $ and are read and assigned in place. Each expression is parsed once;
+ the parsed form is kept and reused when the same expression is evaluated
+ again, as in the body of a loop.
+
+ Errors, such as a division by zero, are printed to the standard error.
+
+ \param text the expression, which does not need to be terminated
+ \param length amount of characters of \a text
+ \param result receives the value of the expression
+ \return \c 0 on success, \c -1 on error
+ */
+int arithmeticEvaluate(const char *text, size_t length, long long *result);
+
+/*!
+ \brief Forget the parsed expressions
+
+ Parsed expressions refer to the storage of the variables they name, so
+ they are forgotten whenever the variables are freed.
+ */
+void arithmeticReset();
+
+/*!
+ \brief Find the end of the expression of an arithmetic expansion
+ \param text the expression, following \c $((
+ \return pointer to the closing \c )), or \c NULL if there is none
+ */
+const char *arithmeticFindEnd(const char *text);
+
+/*!
+ \brief Run the builtin "let" command, evaluating each argument as an
+ arithmetic expression
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return \c 0 if the last expression is non-zero, \c 1 otherwise
+ */
+int cmd_let(int argc, char **argv);
+
+/*!
+ \}
+ */
+
+#endif /* ARITHMETIC_H */
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "array.h"
+#include <stdlib.h>
+#include <string.h>
+#include "hash.h"
+
+/*! \brief Initial amount of slots of an associative array, a power of two */
+#define ARRAY_INITIAL_SLOTS 16
+
+array_t *arrayNew(int isAssociative)
+{
+	array_t *array = malloc(sizeof(*array));
+	if(array == NULL) {
+		return NULL;
+	}
+	array->isAssociative = isAssociative;
+	array->values = NULL;
+	array->entries = NULL;
+	array->size = 0;
+	array->length = 0;
+	array->count = 0;
+	return array;
+}
+
+void arrayFree(array_t *array)
+{
+	size_t index;
+	if(array == NULL) {
+		return;
+	}
+	for(index = 0; index < array->size; index++) {
+		if(array->isAssociative) {
+			free(array->entries[index].key);
+			free(array->entries[index].value);
+		} else {
+			free(array->values[index]);
+		}
+	}
+	free(array->values);
+	free(array->entries);
+	free(array);
+}
+
+int arraySetIndex(array_t *array, size_t index, const char *value)
+{
+	char **grown;
+	char *copy;
+	size_t size;
+	if(index >= ARRAY_INDEX_LIMIT) {
+		return -1;
+	}
+	if(index >= array->size) {
+		for(size = array->size > 0 ? array->size : 8; size <= index; size *= 2) {
+		}
+		grown = realloc(array->values, size * sizeof(*grown));
+		if(grown == NULL) {
+			return -1;
+		}
+		memset(grown + array->size, 0, (size - array->size) * sizeof(*grown));
+		array->values = grown;
+		array->size = size;
+	}
+	copy = strdup(value);
+	if(copy == NULL) {
+		return -1;
+	}
+	if(array->values[index] == NULL) {
+		array->count++;
+	}
+	free(array->values[index]);
+	array->values[index] = copy;
+	if(index >= array->length) {
+		array->length = index + 1;
+	}
+	return 0;
+}
+
+const char *arrayGetIndex(const array_t *array, size_t index)
+{
+	return index < array->length ? array->values[index] : NULL;
+}
+
+void arrayRemoveIndex(array_t *array, size_t index)
+{
+	if(index >= array->length || array->values[index] == NULL) {
+		return;
+	}
+	free(array->values[index]);
+	array->values[index] = NULL;
+	array->count--;
+	while(array->length > 0 && array->values[array->length - 1] == NULL) {
+		array->length--;
+	}
+}
+
+/*!
+ \brief Find the slot holding \a key, or the free slot where it belongs
+ */
+static size_t _findSlot(const array_t *array, const char *key, unsigned int hash)
+{
+	size_t mask = array->size - 1;
+	size_t slot;
+	for(slot = hash & mask; array->entries[slot].key != NULL; slot = (slot + 1) & mask) {
+		if(array->entries[slot].hash == hash && strcmp(array->entries[slot].key, key) == 0) {
+			break;
+		}
+	}
+	return slot;
+}
+
+/*!
+ \brief Double the amount of slots, placing each element again
+ \return \c 0 on success, \c -1 on error
+ */
+static int _grow(array_t *array)
+{
+	array_entry_t *entries = array->entries;
+	size_t size = array->size;
+	size_t index;
+	size_t slot;
+	array->size = size > 0 ? size * 2 : ARRAY_INITIAL_SLOTS;
+	array->entries = calloc(array->size, sizeof(*array->entries));
+	if(array->entries == NULL) {
+		array->entries = entries;
+		array->size = size;
+		return -1;
+	}
+	for(index = 0; index < size; index++) {
+		if(entries[index].key != NULL) {
+			slot = _findSlot(array, entries[index].key, entries[index].hash);
+			array->entries[slot] = entries[index];
+		}
+	}
+	free(entries);
+	return 0;
+}
+
+int arraySetKey(array_t *array, const char *key, const char *value)
+{
+	unsigned int hash = hashString(key);
+	array_entry_t *entry;
+	char *copy;
+	/* At most three quarters of the slots are used, keeping probes short */
+	if((array->count + 1) * 4 > array->size * 3 && _grow(array) != 0) {
+		return -1;
+	}
+	copy = strdup(value);
+	if(copy == NULL) {
+		return -1;
+	}
+	entry = &array->entries[_findSlot(array, key, hash)];
+	if(entry->key == NULL) {
+		entry->key = strdup(key);
+		if(entry->key == NULL) {
+			free(copy);
+			return -1;
+		}
+		entry->hash = hash;
+		array->count++;
+	}
+	free(entry->value);
+	entry->value = copy;
+	return 0;
+}
+
+const char *arrayGetKey(const array_t *array, const char *key)
+{
+	if(array->size == 0) {
+		return NULL;
+	}
+	return array->entries[_findSlot(array, key, hashString(key))].value;
+}
+
+void arrayRemoveKey(array_t *array, const char *key)
+{
+	size_t mask = array->size - 1;
+	size_t slot;
+	size_t next;
+	size_t home;
+	if(array->size == 0) {
+		return;
+	}
+	slot = _findSlot(array, key, hashString(key));
+	if(array->entries[slot].key == NULL) {
+		return;
+	}
+	free(array->entries[slot].key);
+	free(array->entries[slot].value);
+	array->count--;
+	/* Move following elements back into the gap, so probes do not stop at it */
+	for(next = (slot + 1) & mask; array->entries[next].key != NULL; next = (next + 1) & mask) {
+		home = array->entries[next].hash & mask;
+		if(((next - home) & mask) >= ((next - slot) & mask)) {
+			array->entries[slot] = array->entries[next];
+			slot = next;
+		}
+	}
+	array->entries[slot].key = NULL;
+	array->entries[slot].value = NULL;
+}
+
+const char *arrayNext(const array_t *array, size_t *position, const char **key)
+{
+	if(array->isAssociative) {
+		for(; *position < array->size; (*position)++) {
+			if(array->entries[*position].key != NULL) {
+				*key = array->entries[*position].key;
+				return array->entries[*position].value;
+			}
+		}
+		return NULL;
+	}
+	*key = NULL;
+	for(; *position < array->length; (*position)++) {
+		if(array->values[*position] != NULL) {
+			return array->values[*position];
+		}
+	}
+	return NULL;
+}
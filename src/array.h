@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ARRAY_H
+#define ARRAY_H
+
+#include <stddef.h>
+
+/*!
+ \addtogroup array
+ \{
+ */
+
+/*!
+ \brief Bound of the indices of an indexed array
+
+ Indexed arrays are stored as vectors, so an index allocates every element
+ below it.
+ */
+#define ARRAY_INDEX_LIMIT ((size_t)1 << 24)
+
+/*! \brief An element of an associative array */
+typedef struct __array_entry_t {
+	/*! \brief key of the element, or \c NULL if the slot is free */
+	char *key;
+	char *value;
+	/*! \brief hash of \a key, kept so that growing does not hash it again */
+	unsigned int hash;
+} array_entry_t;
+
+/*!
+ \brief An indexed or associative array
+
+ Indexed arrays are vectors of values, unset elements being \c NULL.
+ Associative arrays are hash tables with open addressing.
+ */
+typedef struct __array_t {
+	/*! \brief whether elements are found by a key rather than an index */
+	int isAssociative;
+	/*! \brief values of an indexed array */
+	char **values;
+	/*! \brief elements of an associative array */
+	array_entry_t *entries;
+	/*! \brief amount of elements allocated in \a values or slots in
+	 \a entries */
+	size_t size;
+	/*! \brief highest index which is set plus one, for an indexed array */
+	size_t length;
+	/*! \brief amount of elements which are set */
+	size_t count;
+} array_t;
+
+/*!
+ \brief Create an empty array
+ \return the array, or \c NULL on error
+ */
+array_t *arrayNew(int isAssociative);
+
+/*!
+ \brief Free \a array and its elements
+ */
+void arrayFree(array_t *array);
+
+/*!
+ \brief Assign a copy of \a value to element \a index of an indexed array
+ \return \c 0 on success, \c -1 on error or if \a index is not below
+ #ARRAY_INDEX_LIMIT
+ */
+int arraySetIndex(array_t *array, size_t index, const char *value);
+
+/*!
+ \brief Return element \a index of an indexed array
+ \return the value, or \c NULL if it is unset
+ */
+const char *arrayGetIndex(const array_t *array, size_t index);
+
+/*!
+ \brief Assign a copy of \a value to the element \a key of an associative
+ array
+ \return \c 0 on success, \c -1 on error
+ */
+int arraySetKey(array_t *array, const char *key, const char *value);
+
+/*!
+ \brief Return the element \a key of an associative array
+ \return the value, or \c NULL if it is unset
+ */
+const char *arrayGetKey(const array_t *array, const char *key);
+
+/*!
+ \brief Unset element \a index of an indexed array
+ */
+void arrayRemoveIndex(array_t *array, size_t index);
+
+/*!
+ \brief Unset the element \a key of an associative array
+ */
+void arrayRemoveKey(array_t *array, const char *key);
+
+/*!
+ \brief Find the first element which is set at or after \a *position
+
+ Elements are visited in the order of their indices, or in no particular
+ order for an associative array:
+
+ \code
+ for(position = 0; (value = arrayNext(array, &position, &key)) != NULL; position++)
+ \endcode
+
+ \param position slot to start at, receives the slot of the element, which
+ is its index for an indexed array
+ \param key receives the key of an associative element, or \c NULL
+ \return the value, or \c NULL if there are no more elements
+ */
+const char *arrayNext(const array_t *array, size_t *position, const char **key);
+
+/*!
+ \}
+ */
+
+#endif
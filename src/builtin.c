@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "builtin.h"
+#include <string.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/*! \brief Every builtin command known to the shell */
+static const builtin_t _builtins[] = {
+	{"[", cmd_test, kBuiltinFlagNoFork},
+	{"alias", cmd_alias, kBuiltinFlagModifiesShell},
+	{"cat", cmd_cat, kBuiltinFlagNone},
+	{"cd", cmd_cd, kBuiltinFlagModifiesShell},
+	{"cp", cmd_cp, kBuiltinFlagNone},
+	{"declare", cmd_declare, kBuiltinFlagModifiesShell | kBuiltinFlagDeclaration},
+	{"echo", cmd_echo, kBuiltinFlagNoFork},
+	{"exec", cmd_exec, kBuiltinFlagReplacesShell},
+	{"exit", cmd_exit, kBuiltinFlagModifiesShell},
+	{"false", cmd_false, kBuiltinFlagNoFork},
+	{"jobs", cmd_jobs, kBuiltinFlagModifiesShell},
+	{"let", cmd_let, kBuiltinFlagModifiesShell},
+	{"parallel", cmd_parallel, kBuiltinFlagNone},
+	{"printf", cmd_printf, kBuiltinFlagNoFork},
+	{"prompt", cmd_prompt, kBuiltinFlagModifiesShell},
+	{"pwd", cmd_pwd, kBuiltinFlagNone},
+	{"read", cmd_read, kBuiltinFlagModifiesShell},
+	{"return", cmd_return, kBuiltinFlagModifiesShell},
+	{"set", cmd_set, kBuiltinFlagModifiesShell},
+	{"tee", cmd_tee, kBuiltinFlagNone},
+	{"test", cmd_test, kBuiltinFlagNoFork},
+	{"timeout", cmd_timeout, kBuiltinFlagRunsCommand},
+	{"true", cmd_true, kBuiltinFlagNoFork},
+	{"ulimit", cmd_ulimit, kBuiltinFlagModifiesShell},
+	{"unalias", cmd_unalias, kBuiltinFlagModifiesShell},
+	{"unset", cmd_unset, kBuiltinFlagModifiesShell},
+	{"wait", cmd_wait, kBuiltinFlagModifiesShell},
+	{NULL, NULL, kBuiltinFlagNone}
+};
+
+const builtin_t *builtinLookup(const char *name)
+{
+	const builtin_t *builtin;
+	if(name == NULL) {
+		return NULL;
+	}
+	for(builtin = _builtins; builtin->name != NULL; builtin++) {
+		if(strcmp(builtin->name, name) == 0) {
+			return builtin;
+		}
+	}
+	return NULL;
+}
+
+int builtinExecuteProgram(char **argv)
+{
+	/* The PATH lookup does not know about builtins */
+	execvp(argv[0], argv);
+	fprintf(stderr, "%s: unsupported option and no %s program found\n", argv[0], argv[0]);
+	return 2;
+}
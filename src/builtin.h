@@ -19,19 +19,97 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
  * DEALINGS IN THE SOFTWARE.
  */
+#ifndef BUILTIN_H
+#define BUILTIN_H
+
 #include "prompt.h"
 #include "exit.h"
 #include "pwd.h"
 #include "cd.h"
+#include "parallel.h"
+#include "jobs.h"
+#include "echo.h"
+#include "printf.h"
+#include "true.h"
+#include "false.h"
+#include "test.h"
+#include "cat.h"
+#include "cp.h"
+#include "tee.h"
+#include "options.h"
+#include "arithmetic.h"
+#include "alias.h"
+#include "functions.h"
+#include "read.h"
+#include "variables.h"
+#include "exec.h"
+#include "ulimit.h"
+#include "timeout.h"
 
 /*!
  \addtogroup builtin Builtin functions
  \{
  */
 
-/*! \brief Interface for all builtin command functions */
-typedef void (*commandBuiltinFunction)(int argc, char **argv);
+/*!
+ \brief Interface for all builtin command functions
+ \return exit status of the command
+ */
+typedef int (*commandBuiltinFunction)(int argc, char **argv);
+
+enum {
+	/*! \brief The builtin may run in a child process like any other command */
+	kBuiltinFlagNone = 0,
+	/*! \brief The builtin changes the state of the shell, so it must run in the
+	 shell process itself */
+	kBuiltinFlagModifiesShell = 1,
+	/*! \brief The builtin is cheap enough that forking would dominate its cost,
+	 so it runs in the shell process unless it has to run concurrently with
+	 other commands */
+	kBuiltinFlagNoFork = 2,
+	/*! \brief Arguments which are assignments are passed to the builtin
+	 without being expanded, the builtin performs them */
+	kBuiltinFlagDeclaration = 4,
+	/*! \brief The builtin replaces the shell, or keeps its redirections
+	 applied to it, so it runs in the shell process unless it has to run
+	 concurrently with other commands */
+	kBuiltinFlagReplacesShell = 8,
+	/*! \brief The builtin starts a command and waits for it, so it runs in
+	 the shell process unless it has to run concurrently with other
+	 commands, rather than in a child doing nothing but waiting */
+	kBuiltinFlagRunsCommand = 16
+};
+
+/*! \brief Describes a builtin command */
+typedef struct __builtin_t {
+	/*! \brief name by which the builtin is invoked */
+	const char *name;
+	/*! \brief function implementing the builtin */
+	commandBuiltinFunction function;
+	/*! \brief combination of \c kBuiltinFlag values */
+	int flags;
+} builtin_t;
+
+/*!
+ \brief Find the builtin command called \a name
+ \param name name of the command
+ \return the builtin, or \c NULL if \a name is not a builtin command
+ */
+const builtin_t *builtinLookup(const char *name);
+
+/*!
+ \brief Execute the program of the same name as a builtin
+
+ Used by builtins running in a child process for options they do not
+ implement themselves. Only returns if the program cannot be executed.
+
+ \param argv \c NULL terminated arguments, starting with the program name
+ \return exit status of the command
+ */
+int builtinExecuteProgram(char **argv);
 
 /*!
  \}
  */
+
+#endif /* BUILTIN_H */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "cat.h"
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "builtin.h"
+#include "transfer.h"
+
+int cmd_cat(int argc, char **argv)
+{
+	char *standardInput[] = {"-"};
+	char **files;
+	int fileCount;
+	int descriptor;
+	int status = 0;
+	int argi;
+	/* Nothing is buffered anyway, so -u does not change anything */
+	for(argi = 1; argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0'; argi++) {
+		if(strcmp(argv[argi], "--") == 0) {
+			argi++;
+			break;
+		}
+		if(strcmp(argv[argi], "-u") != 0) {
+			return builtinExecuteProgram(argv);
+		}
+	}
+	files = argi < argc ? argv + argi : standardInput;
+	fileCount = argi < argc ? argc - argi : 1;
+	for(; fileCount > 0; files++, fileCount--) {
+		if(strcmp(*files, "-") == 0) {
+			descriptor = STDIN_FILENO;
+		} else {
+			descriptor = open(*files, O_RDONLY | O_CLOEXEC);
+			if(descriptor == -1) {
+				fprintf(stderr, "cat: %s: %s\n", *files, strerror(errno));
+				status = 1;
+				continue;
+			}
+			posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+		}
+		if(transferDescriptor(descriptor, STDOUT_FILENO) != 0) {
+			fprintf(stderr, "cat: %s: %s\n", *files, strerror(errno));
+			status = 1;
+		}
+		if(descriptor != STDIN_FILENO) {
+			close(descriptor);
+		}
+	}
+	return status;
+}
@@ -21,11 +21,15 @@
  */
 #include "cd.h"
 #include <string.h>
+#include <stdio.h>
+#include <errno.h>
 #include <unistd.h>
 
-void cmd_cd(int argc, char **argv)
+int cmd_cd(int argc, char **argv)
 {
-	if(argc > 1) {
-		chdir(argv[1]);
+	if(argc > 1 && chdir(argv[1]) != 0) {
+		fprintf(stderr, "cd: %s: %s\n", argv[1], strerror(errno));
+		return 1;
 	}
+	return 0;
 }
\ No newline at end of file
@@ -31,8 +31,9 @@
  If argc is greater than 1, it is assumed that argv[1] contains the path
  \param argc count of elements in \a argv
  \param argv arguments to be passed to the command
+ \return exit status of the command
  */
-void cmd_cd(int argc, char **argv);
+int cmd_cd(int argc, char **argv);
 
 /*!
  \}
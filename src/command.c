@@ -23,7 +23,11 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "testing_util.h"
+#include "builtin.h"
+#include "script.h"
 
 command_t *commandNew()
 {
@@ -37,7 +41,21 @@ command_t *commandNew()
 	command->argv = NULL;
 	command->redirectToPath = NULL;
 	command->redirectFromPath = NULL;
+	command->redirections = queueNew();
+	if(command->redirections == NULL) {
+		free(command);
+		return NULL;
+	}
+	command->hereDocument = NULL;
+	command->hereDocumentDelimiter = NULL;
+	command->hereDocumentStripsTabs = 0;
+	command->isHereString = 0;
 	command->connectionMask = kCommandConnectionNone;
+	command->isOutputCaptured = 0;
+	command->isInputPassed = 0;
+	command->body = NULL;
+	command->isSubshell = 0;
+	command->attributes = NULL;
 
 	return command;
 }
@@ -62,6 +80,28 @@ void commandSetArgs(command_t *command, int argc, char **argv)
 	command->argv = argv;
 }
 
+/*!
+ \brief Remove redirections opening a file onto \a descriptor
+ */
+static void _commandRemoveOpenRedirections(command_t *command, int descriptor)
+{
+	queue_t *redirections = queueNew();
+	redirection_t *redirection;
+	if(redirections == NULL) {
+		return;
+	}
+	while(queueRemove(command->redirections, (void *)&redirection)) {
+		if(redirection->action == kRedirectionActionOpen
+		&& redirection->descriptor == descriptor) {
+			redirectionFree(redirection);
+		} else {
+			queueInsert(redirections, redirection, (queueNodeFreeFunction)redirectionFree);
+		}
+	}
+	queueFree(command->redirections);
+	command->redirections = redirections;
+}
+
 void commandSetRedirectToPath(command_t *command, char *redirectToPath)
 {
 	assert(command != NULL);
@@ -70,22 +110,71 @@ void commandSetRedirectToPath(command_t *command, char *redirectToPath)
 	}
 	if(redirectToPath == NULL) {
 		command->redirectToPath = NULL;
+		_commandRemoveOpenRedirections(command, STDOUT_FILENO);
 	} else {
 		command->redirectToPath = strdup(redirectToPath);
+		commandAddRedirection(command, redirectionNewOpen(STDOUT_FILENO,
+			redirectToPath, O_WRONLY | O_CREAT | O_TRUNC));
 	}
 }
 
 void commandSetRedirectFromPath(command_t *command, char *redirectFromPath)
 {
 	assert(command != NULL);
-	if(command->redirectFromPath == NULL) {
+	if(command->redirectFromPath != NULL) {
 		free(command->redirectFromPath);
 	}
 	if(redirectFromPath == NULL) {
 		command->redirectFromPath = NULL;
+		_commandRemoveOpenRedirections(command, STDIN_FILENO);
 	} else {
 		command->redirectFromPath = strdup(redirectFromPath);
+		commandAddRedirection(command, redirectionNewOpen(STDIN_FILENO,
+			redirectFromPath, O_RDONLY));
+	}
+}
+
+void commandAddRedirection(command_t *command, redirection_t *redirection)
+{
+	assert(command != NULL);
+	if(redirection == NULL) {
+		return;
+	}
+	queueInsert(command->redirections, redirection, (queueNodeFreeFunction)redirectionFree);
+}
+
+void commandSetHereDocument(command_t *command, char *hereDocument)
+{
+	assert(command != NULL);
+	if(command->hereDocument != NULL) {
+		free(command->hereDocument);
+	}
+	if(hereDocument == NULL) {
+		command->hereDocument = NULL;
+	} else {
+		command->hereDocument = strdup(hereDocument);
+	}
+	command->isHereString = 0;
+}
+
+void commandSetHereString(command_t *command, char *word)
+{
+	commandSetHereDocument(command, word);
+	command->isHereString = word != NULL;
+}
+
+void commandSetHereDocumentDelimiter(command_t *command, char *delimiter, int stripsTabs)
+{
+	assert(command != NULL);
+	if(command->hereDocumentDelimiter != NULL) {
+		free(command->hereDocumentDelimiter);
+	}
+	if(delimiter == NULL) {
+		command->hereDocumentDelimiter = NULL;
+	} else {
+		command->hereDocumentDelimiter = strdup(delimiter);
 	}
+	command->hereDocumentStripsTabs = stripsTabs;
 }
 
 void commandSetConnectionMask(command_t *command, int connectionMask)
@@ -96,6 +185,7 @@ void commandSetConnectionMask(command_t *command, int connectionMask)
 
 void commandFree(command_t *command)
 {
+	int argi;
 	assert(command != NULL);
 	command->argv = NULL;
 	/* path is an alias for argv[0], which has already been freed */
@@ -108,15 +198,117 @@ void commandFree(command_t *command)
 		free(command->redirectFromPath);
 		command->redirectFromPath = NULL;
 	}
+	if(command->redirections != NULL) {
+		queueFree(command->redirections);
+		command->redirections = NULL;
+	}
+	if(command->hereDocument != NULL) {
+		free(command->hereDocument);
+		command->hereDocument = NULL;
+	}
+	if(command->hereDocumentDelimiter != NULL) {
+		free(command->hereDocumentDelimiter);
+		command->hereDocumentDelimiter = NULL;
+	}
+	if(command->body != NULL) {
+		scriptFree(command->body);
+		command->body = NULL;
+	}
+	if(command->attributes != NULL) {
+		for(argi = 0; command->attributes[argi] != NULL; argi++) {
+			free(command->attributes[argi]);
+		}
+		free(command->attributes);
+		command->attributes = NULL;
+	}
 	/* FIXME: We should be freeing command itself here, but apparently it's either
 	   being freed before or the object is modified after beeing freed. Either
 	   way, if we free command here, the program crashes */
 }
 
+void commandFreeArguments(command_t *command)
+{
+	int argi;
+	assert(command != NULL);
+	if(command->argv == NULL) {
+		return;
+	}
+	for(argi = 0; argi < command->argc; argi++) {
+		free(command->argv[argi]);
+	}
+	free(command->argv);
+	command->argv = NULL;
+	command->argc = 0;
+	command->path = NULL;
+}
+
+command_t *commandCopy(command_t *command)
+{
+	command_t *copy;
+	struct __queue_node_t *node;
+	redirection_t *redirection;
+	int argi;
+	assert(command != NULL);
+	copy = commandNew();
+	if(copy == NULL) {
+		return NULL;
+	}
+	copy->argv = malloc((command->argc + 1) * sizeof(*copy->argv));
+	if(copy->argv == NULL) {
+		commandFree(copy);
+		free(copy);
+		return NULL;
+	}
+	for(argi = 0; argi < command->argc; argi++) {
+		copy->argv[argi] = strdup(command->argv[argi]);
+	}
+	copy->argv[command->argc] = NULL;
+	copy->argc = command->argc;
+	copy->path = command->argc > 0 ? copy->argv[0] : NULL;
+	for(node = command->redirections->head; node != NULL; node = node->next) {
+		redirection = node->data;
+		switch(redirection->action) {
+			case kRedirectionActionOpen:
+				commandAddRedirection(copy, redirectionNewOpen(redirection->descriptor,
+					redirection->path, redirection->flags));
+				break;
+			case kRedirectionActionDuplicate:
+				commandAddRedirection(copy, redirectionNewDuplicate(redirection->descriptor,
+					redirection->sourceDescriptor));
+				break;
+			case kRedirectionActionClose:
+				commandAddRedirection(copy, redirectionNewClose(redirection->descriptor));
+				break;
+		}
+	}
+	if(command->redirectToPath != NULL) {
+		copy->redirectToPath = strdup(command->redirectToPath);
+	}
+	if(command->redirectFromPath != NULL) {
+		copy->redirectFromPath = strdup(command->redirectFromPath);
+	}
+	commandSetHereDocument(copy, command->hereDocument);
+	copy->isHereString = command->isHereString;
+	copy->connectionMask = command->connectionMask;
+	copy->isOutputCaptured = command->isOutputCaptured;
+	copy->isInputPassed = command->isInputPassed;
+	copy->body = command->body != NULL ? scriptRetain(command->body) : NULL;
+	copy->isSubshell = command->isSubshell;
+	if(command->attributes != NULL) {
+		for(argi = 0; command->attributes[argi] != NULL; argi++) {
+		}
+		copy->attributes = malloc((argi + 1) * sizeof(*copy->attributes));
+		if(copy->attributes != NULL) {
+			for(argi = 0; command->attributes[argi] != NULL; argi++) {
+				copy->attributes[argi] = strdup(command->attributes[argi]);
+			}
+			copy->attributes[argi] = NULL;
+		}
+	}
+	return copy;
+}
+
 int commandIsBuiltIn(command_t *command)
 {
-	return strcmp(command->path, "prompt") == 0
-	    || strcmp(command->path, "exit") == 0
-	    || strcmp(command->path, "pwd") == 0
-	    || strcmp(command->path, "cd") == 0;
+	return builtinLookup(command->path) != NULL;
 }
@@ -23,6 +23,9 @@
 #ifndef COMMAND_H
 #define COMMAND_H
 
+#include "queue.h"
+#include "redirection.h"
+
 /*!
  \addtogroup command
  \{
@@ -37,8 +40,19 @@ enum {
 	kCommandConnectionBackground = 2,
 	/*! \brief The command is to be executed sequentially in the foreground */
 	kCommandConnectionSequential = 4,
+	/*! \brief The next command is only executed if this command succeeds */
+	kCommandConnectionAnd = 8,
+	/*! \brief The next command is only executed if this command fails */
+	kCommandConnectionOr = 16,
+	/*! \brief The command ends a clause of a \c case construct (\c ;;) */
+	kCommandConnectionCaseEnd = 32,
+	/*! \brief The output of the command is duplicated to each of the
+	 following branches (\c |+) */
+	kCommandConnectionFanOut = 64,
 };
 
+struct __script_t;
+
 /*! \brief Represents a command and all relevant information for execution */
 typedef struct __command_t {
 	/*! \brief path of the command */
@@ -51,8 +65,37 @@ typedef struct __command_t {
 	char *redirectToPath;
 	/*! \brief path from which input is redirected, or \a NULL */
 	char *redirectFromPath;
+	/*! \brief queue of \c redirection_t objects applied in order */
+	queue_t *redirections;
+	/*! \brief contents of a here-document or here-string fed to the input,
+	 or \a NULL */
+	char *hereDocument;
+	/*! \brief delimiter of a here-document whose contents have not been read
+	 yet, or \a NULL */
+	char *hereDocumentDelimiter;
+	/*! \brief whether leading tabs are stripped from the here-document lines
+	 (\c <<- form) */
+	int hereDocumentStripsTabs;
+	/*! \brief whether the \link command_t::hereDocument hereDocument
+	 \endlink is the word of a here-string, expanded as the command runs */
+	int isHereString;
 	/*! \brief whether to pipe the output to the next command */
 	int connectionMask;
+	/*! \brief whether a builtin piped to the next command runs in the shell,
+	 writing into a file which the next command then reads */
+	int isOutputCaptured;
+	/*! \brief whether this \c "cat file" passes its file to the next command
+	 as its input instead of running, if the file can be read as it runs */
+	int isInputPassed;
+	/*! \brief commands of a group (\c "{ ...; }") or subshell
+	 (\c "( ... )"), compiled separately, or \a NULL for a simple command */
+	struct __script_t *body;
+	/*! \brief whether the \link command_t::body body \endlink runs in a
+	 child process */
+	int isSubshell;
+	/*! \brief \c NULL terminated scheduling attributes preceding the command
+	 (e.g. \c "@nice=5"), applied to its child process, or \a NULL */
+	char **attributes;
 } command_t;
 
 /*!
@@ -99,7 +142,10 @@ void commandSetArgs(command_t *command, int argc, char **argv);
 
  The \a redirectToPath string is copied and assigned to the
  \link command_t::redirectToPath redirectToPath \endlink of \a command. The
- copied string will be freed when commandFree() is called.
+ copied string will be freed when commandFree() is called. A redirection
+ truncating the file onto the standard output is added to
+ \link command_t::redirections redirections \endlink. If \a redirectToPath is
+ \c NULL, any redirections of the standard output to a file are removed.
 
  \param command a pointer to the \c command_t structure to manipulate
  \param redirectToPath the path to be set
@@ -112,13 +158,68 @@ void commandSetRedirectToPath(command_t *command, char *redirectToPath);
 
  The \a redirectFromPath string is copied and assigned to the
  \link command_t::redirectFromPath redirectFromPath \endlink of \a command. The
- copied string will be freed when commandFree() is called.
+ copied string will be freed when commandFree() is called. A redirection
+ opening the file onto the standard input is added to
+ \link command_t::redirections redirections \endlink. If \a redirectFromPath
+ is \c NULL, any redirections of the standard input from a file are removed.
 
  \param command a pointer to the \c command_t structure to manipulate
  \param redirectFromPath the path to be set
  */
 void commandSetRedirectFromPath(command_t *command, char *redirectFromPath);
 
+/*!
+ \brief Append a redirection to the \link command_t::redirections
+ redirections \endlink of a \c command_t structure
+
+ The \a redirection is owned by \a command and freed when commandFree() is
+ called.
+
+ \param command a pointer to the \c command_t structure to manipulate
+ \param redirection the redirection to be appended
+ */
+void commandAddRedirection(command_t *command, redirection_t *redirection);
+
+/*!
+ \brief Set the \link command_t::hereDocument hereDocument \endlink of a
+ \c command_t structure
+
+ The \a hereDocument string is copied and assigned to the
+ \link command_t::hereDocument hereDocument \endlink of \a command. The copied
+ string will be freed when commandFree() is called.
+
+ \param command a pointer to the \c command_t structure to manipulate
+ \param hereDocument the contents to be fed to the command's input
+ */
+void commandSetHereDocument(command_t *command, char *hereDocument);
+
+/*!
+ \brief Set the word of a here-string (\c <<<) as the
+ \link command_t::hereDocument hereDocument \endlink of a \c command_t
+ structure
+
+ The word is kept as written. It is expanded each time the command runs, and
+ fed to its input followed by a new line.
+
+ \param command a pointer to the \c command_t structure to manipulate
+ \param word the word following the operator
+ */
+void commandSetHereString(command_t *command, char *word);
+
+/*!
+ \brief Set the \link command_t::hereDocumentDelimiter hereDocumentDelimiter
+ \endlink of a \c command_t structure
+
+ The \a delimiter string is copied. The delimiter is only kept while the
+ contents of the here-document are being read and is freed when
+ commandFree() is called.
+
+ \param command a pointer to the \c command_t structure to manipulate
+ \param delimiter the line terminating the here-document
+ \param stripsTabs whether leading tabs are stripped from each line
+ */
+void commandSetHereDocumentDelimiter(command_t *command, char *delimiter, int stripsTabs);
+
 /*!
  \brief Assign the \link command_t::connectionMask connectionMask \endlink of a
  \c command_t structure
@@ -133,6 +234,25 @@ void commandSetConnectionMask(command_t *command, int connectionMask);
  */
 void commandFree(command_t *command);
 
+/*!
+ \brief Free the \link command_t::argv arguments \endlink of a \c command_t
+ structure, including each argument
+
+ This is only valid for commands whose arguments were allocated one by one,
+ as done by the parser. The \link command_t::path path \endlink is freed
+ along with the first argument.
+
+ \param command a pointer to the \c command_t structure to manipulate
+ */
+void commandFreeArguments(command_t *command);
+
+/*!
+ \brief Create a copy of \a command which does not share any memory with it
+ \param command a pointer to the \c command_t structure to copy
+ \return the copy, or \c NULL on error
+ */
+command_t *commandCopy(command_t *command);
+
 /*!
  \brief Indicate whether the command is builtin or external
  \param command a pointer to the \c command_t structure
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "cp.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libgen.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "builtin.h"
+#include "transfer.h"
+
+/*!
+ \brief Copy the file \a source to \a destination
+ \param isForced whether to remove \a destination if it cannot be opened
+ \return \c 0 on success, \c 1 on error
+ */
+static int _copyFile(const char *source, const char *destination, int isForced)
+{
+	struct stat sourceStatus;
+	struct stat destinationStatus;
+	int input;
+	int output;
+	int status = 0;
+	input = open(source, O_RDONLY | O_CLOEXEC);
+	if(input == -1 || fstat(input, &sourceStatus) != 0) {
+		fprintf(stderr, "cp: %s: %s\n", source, strerror(errno));
+		if(input != -1) {
+			close(input);
+		}
+		return 1;
+	}
+	if(S_ISDIR(sourceStatus.st_mode)) {
+		fprintf(stderr, "cp: %s is a directory (not copied)\n", source);
+		close(input);
+		return 1;
+	}
+	/* Opening the destination would truncate the source */
+	if(stat(destination, &destinationStatus) == 0
+		&& destinationStatus.st_dev == sourceStatus.st_dev
+		&& destinationStatus.st_ino == sourceStatus.st_ino) {
+		fprintf(stderr, "cp: %s and %s are the same file\n", source, destination);
+		close(input);
+		return 1;
+	}
+	output = open(destination, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, sourceStatus.st_mode & 0777);
+	if(output == -1 && isForced && unlink(destination) == 0) {
+		output = open(destination, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, sourceStatus.st_mode & 0777);
+	}
+	if(output == -1) {
+		fprintf(stderr, "cp: %s: %s\n", destination, strerror(errno));
+		close(input);
+		return 1;
+	}
+	posix_fadvise(input, 0, 0, POSIX_FADV_SEQUENTIAL);
+	if(transferDescriptor(input, output) != 0 || close(output) != 0) {
+		fprintf(stderr, "cp: %s: %s\n", destination, strerror(errno));
+		status = 1;
+	}
+	close(input);
+	return status;
+}
+
+int cmd_cp(int argc, char **argv)
+{
+	struct stat status;
+	char *destination;
+	char *path;
+	char *sourceCopy;
+	int isForced = 0;
+	int isDirectory;
+	int exitStatus = 0;
+	int argi;
+	for(argi = 1; argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0'; argi++) {
+		if(strcmp(argv[argi], "--") == 0) {
+			argi++;
+			break;
+		}
+		if(strcmp(argv[argi], "-f") != 0) {
+			return builtinExecuteProgram(argv);
+		}
+		isForced = 1;
+	}
+	if(argc - argi < 2) {
+		fprintf(stderr, "usage: cp [-f] source target\n       cp [-f] source ... directory\n");
+		return 2;
+	}
+	destination = argv[argc - 1];
+	isDirectory = stat(destination, &status) == 0 && S_ISDIR(status.st_mode);
+	if(!isDirectory && argc - argi > 2) {
+		fprintf(stderr, "cp: %s is not a directory\n", destination);
+		return 1;
+	}
+	if(!isDirectory) {
+		return _copyFile(argv[argi], destination, isForced);
+	}
+	for(; argi < argc - 1; argi++) {
+		sourceCopy = strdup(argv[argi]);
+		if(sourceCopy == NULL || asprintf(&path, "%s/%s", destination, basename(sourceCopy)) == -1) {
+			free(sourceCopy);
+			return 1;
+		}
+		if(_copyFile(argv[argi], path, isForced) != 0) {
+			exitStatus = 1;
+		}
+		free(path);
+		free(sourceCopy);
+	}
+	return exitStatus;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "echo.h"
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "writer.h"
+#include "printf.h"
+
+int cmd_echo(int argc, char **argv)
+{
+	writer_t writer;
+	const char *option;
+	int isNewLineWritten = 1;
+	int isEscaped = 0;
+	int isStopped = 0;
+	int argi;
+	/* Options are only recognized as long as every letter is one */
+	for(argi = 1; argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0'; argi++) {
+		option = argv[argi] + 1;
+		if(strspn(option, "neE") != strlen(option)) {
+			break;
+		}
+		for(; *option != '\0'; option++) {
+			if(*option == 'n') {
+				isNewLineWritten = 0;
+			} else {
+				isEscaped = *option == 'e';
+			}
+		}
+	}
+	writerInitialize(&writer, STDOUT_FILENO);
+	for(; argi < argc && !isStopped; argi++) {
+		if(isEscaped) {
+			isStopped = printfPutEscaped(&writer, argv[argi], 0);
+		} else {
+			writerPutString(&writer, argv[argi]);
+		}
+		if(argi + 1 < argc && !isStopped) {
+			writerPutCharacter(&writer, ' ');
+		}
+	}
+	if(isNewLineWritten && !isStopped) {
+		writerPutCharacter(&writer, '\n');
+	}
+	if(writerFlush(&writer) != 0) {
+		fprintf(stderr, "echo: write error: %s\n", strerror(errno));
+		return 1;
+	}
+	return 0;
+}
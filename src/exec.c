@@ -19,149 +19,1336 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
  * DEALINGS IN THE SOFTWARE.
  */
+#define _GNU_SOURCE
 #include "exec.h"
+#include <sys/wait.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include <glob.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
 #include <assert.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
 #include "command.h"
 #include "builtin.h"
 #include "testing_util.h"
 #include "mush_error.h"
+#include "heredoc.h"
+#include "redirection.h"
+#include "jobs.h"
+#include "launcher.h"
+#include "expansion.h"
+#include "variables.h"
+#include "script.h"
+#include "alias.h"
+#include "functions.h"
+#include "scriptfile.h"
+#include "parser.h"
+#include "transfer.h"
+#include "schedule.h"
+#include "topology.h"
+#include "options.h"
 
-static void _executeBuiltinCommand(command_t *command)
+/*! \brief Exit status of the last foreground pipeline */
+static int _lastStatus = 0;
+/*! \brief Whether the next pipeline is the last the shell runs, see
+ executeFinal() */
+static int _isFinal = 0;
+/*! \brief CPU the next child is pinned to, or \c -1 */
+static int _placementCpu = -1;
+/*! \brief Whether the next child leads a new process group */
+static int _isGroupLeader = 0;
+/*! \brief Process of the program embedding the shell, or \c -1 */
+static pid_t _embeddingProcess = -1;
+
+int executeLastStatus()
+{
+	return _lastStatus;
+}
+
+void executeSetLastStatus(int status)
 {
-	commandBuiltinFunction builtinFunc = NULL;
-	/* TODO: Ideally this should be in a hash table so it is easier to look up
-	 the command and execute it. It would also allow them to be plugin-based
-	 */
-	/* Determine builtin command and execute it */
-	if(strcmp(command->path, "prompt") == 0) {
-		builtinFunc = cmd_prompt;
-	} else if(strcmp(command->path, "exit") == 0) {
-		builtinFunc = cmd_exit;
-	} else if(strcmp(command->path, "pwd") == 0) {
-		builtinFunc = cmd_pwd;
-	} else if(strcmp(command->path, "cd") == 0) {
-		builtinFunc = cmd_cd;
+	_lastStatus = status;
+}
+
+/*!
+ \brief Convert a status returned by waitpid() into an exit status
+ */
+static int _exitStatus(int waitStatus)
+{
+	if(WIFSIGNALED(waitStatus)) {
+		return 128 + WTERMSIG(waitStatus);
 	}
-	assert(builtinFunc != NULL);
-	builtinFunc(command->argc, command->argv);
-	builtinFunc = NULL;
+	return WEXITSTATUS(waitStatus);
 }
 
-static glob_t *_globCommand(command_t *command)
+/*!
+ \brief Leave a child of the shell with \a status
+
+ The exit handlers and destructors registered in the shell, such as those of
+ a program embedding it, belong to the shell process alone.
+ */
+static void _exitChild(int status)
 {
-	glob_t *globBuf;
-	int index;
-	globBuf = malloc(sizeof(*globBuf));
-	if(command->argc > 0) {
-		globBuf->gl_offs = 0;
-		glob(command->argv[0], GLOB_NOCHECK, NULL, globBuf);
-		for(index = 1; index < command->argc; index++) {
-			glob(command->argv[index], GLOB_APPEND|GLOB_NOCHECK, NULL, globBuf);
+	fflush(NULL);
+	_exit(status);
+}
+
+/*!
+ \brief Indicate whether this is the process of a program embedding the
+ shell, which the shell must neither end nor replace
+ */
+static int _isEmbedding()
+{
+	return _embeddingProcess != -1 && _embeddingProcess == getpid();
+}
+
+/*!
+ \brief Build the redirections of a child process executing \a command
+
+ The pipeline descriptors are set up first, so the redirections of the command
+ itself take precedence (e.g. \c "cmd 2>&1 | less" sends both outputs into the
+ pipe).
+
+ \param commandRedirections the redirections of the command being executed
+ \param inputDescriptor read end of the pipe from the previous command, or
+ \c -1
+ \param outputDescriptor write end of the pipe to the next command, or \c -1
+ \param hereDocumentDescriptor descriptor of the here-document, or \c -1
+ \return queue of \c redirection_t objects, or \c NULL on error
+ */
+static queue_t *_redirectionsForCommand(queue_t *commandRedirections, int inputDescriptor,
+	int outputDescriptor, int hereDocumentDescriptor)
+{
+	queue_t *redirections = queueNew();
+	struct __queue_node_t *node;
+	if(redirections == NULL) {
+		return NULL;
+	}
+	if(inputDescriptor != -1) {
+		queueInsert(redirections, redirectionNewDuplicate(STDIN_FILENO, inputDescriptor),
+			(queueNodeFreeFunction)redirectionFree);
+	}
+	if(outputDescriptor != -1) {
+		queueInsert(redirections, redirectionNewDuplicate(STDOUT_FILENO, outputDescriptor),
+			(queueNodeFreeFunction)redirectionFree);
+	}
+	if(hereDocumentDescriptor != -1) {
+		queueInsert(redirections, redirectionNewDuplicate(STDIN_FILENO, hereDocumentDescriptor),
+			(queueNodeFreeFunction)redirectionFree);
+	}
+	/* The command's redirections are shared, not owned by this queue */
+	for(node = commandRedirections->head; node != NULL; node = node->next) {
+		queueInsert(redirections, node->data, NULL);
+	}
+	return redirections;
+}
+
+/*! \brief A descriptor of the shell replaced while a builtin runs in it */
+typedef struct __saved_descriptor_t {
+	int descriptor;
+	/*! \brief copy of the original descriptor, or \c -1 if it was closed */
+	int copy;
+} saved_descriptor_t;
+
+/*!
+ \brief Save each descriptor changed by \a redirections
+ \param count receives the amount of saved descriptors
+ \return the saved descriptors, to be passed to _restoreDescriptors()
+ */
+static saved_descriptor_t *_saveDescriptors(queue_t *redirections, size_t *count)
+{
+	saved_descriptor_t *saved;
+	struct __queue_node_t *node;
+	redirection_t *redirection;
+	size_t index;
+	*count = 0;
+	saved = malloc(queueCount(redirections) * sizeof(*saved));
+	if(saved == NULL) {
+		return NULL;
+	}
+	for(node = redirections->head; node != NULL; node = node->next) {
+		redirection = node->data;
+		for(index = 0; index < *count && saved[index].descriptor != redirection->descriptor; index++) {
 		}
-		command->path = globBuf->gl_pathv[0];
-		command->argv = globBuf->gl_pathv;
-		command->argc = globBuf->gl_pathc;
+		if(index < *count) {
+			continue;
+		}
+		saved[*count].descriptor = redirection->descriptor;
+		/* Copies are kept clear of the low descriptors used by redirections */
+		saved[*count].copy = fcntl(redirection->descriptor, F_DUPFD_CLOEXEC, 10);
+		(*count)++;
 	}
-	return globBuf;
+	return saved;
 }
 
-int executeCommandsInQueue(queue_t *commandQueue)
+static void _restoreDescriptors(saved_descriptor_t *saved, size_t count)
+{
+	size_t index;
+	for(index = 0; index < count; index++) {
+		if(saved[index].copy == -1) {
+			close(saved[index].descriptor);
+		} else {
+			dup2(saved[index].copy, saved[index].descriptor);
+			close(saved[index].copy);
+		}
+	}
+	free(saved);
+}
+
+/*!
+ \brief Execute the commands of the group or subshell \a command
+ \return exit status of the last command
+ */
+static int _executeBody(command_t *command)
+{
+	if(scriptExecuteGroup(command->body) != kMushNoError) {
+		fprintf(stderr, "mush: %s\n", mushErrorDescription());
+		setMushError(kMushNoError);
+		return 1;
+	}
+	return executeLastStatus();
+}
+
+/*!
+ \brief Run \a builtin, \a function or the group \a command in the shell
+ process, with \a redirections applied until it returns
+ \return exit status of the builtin, function or group
+ */
+static int _executeInShell(const builtin_t *builtin, function_t *function, command_t *command,
+	int argc, char **argv, queue_t *redirections)
+{
+	struct sigaction ignoreAction;
+	struct sigaction savedAction;
+	redirection_t *failedRedirection;
+	saved_descriptor_t *saved = NULL;
+	size_t savedCount = 0;
+	int status;
+	/* Output buffered by the shell belongs before that of the builtin */
+	fflush(NULL);
+	if(queueCount(redirections) > 0) {
+		saved = _saveDescriptors(redirections, &savedCount);
+		if(saved == NULL) {
+			return kMushExecutionError;
+		}
+	}
+	failedRedirection = redirectionsApply(redirections);
+	if(failedRedirection != NULL) {
+		redirectionPrintError(failedRedirection);
+		status = 1;
+	} else {
+		/* A closed pipe fails the write rather than terminating the shell */
+		memset(&ignoreAction, 0, sizeof(ignoreAction));
+		ignoreAction.sa_handler = SIG_IGN;
+		sigaction(SIGPIPE, &ignoreAction, &savedAction);
+		if(builtin != NULL) {
+			status = builtin->function(argc, argv);
+		} else if(function != NULL) {
+			status = functionCall(function, argc, argv);
+		} else {
+			status = _executeBody(command);
+		}
+		fflush(NULL);
+		sigaction(SIGPIPE, &savedAction, NULL);
+	}
+	/* "exec" without a program keeps the redirections, unless they would
+	   change the descriptors of a program embedding the shell */
+	if(saved != NULL && builtin != NULL && (builtin->flags & kBuiltinFlagReplacesShell)
+	&& !_isEmbedding()) {
+		while(savedCount > 0) {
+			savedCount--;
+			if(saved[savedCount].copy != -1) {
+				close(saved[savedCount].copy);
+			}
+		}
+		free(saved);
+	} else if(saved != NULL) {
+		_restoreDescriptors(saved, savedCount);
+	}
+	return status;
+}
+
+/*!
+ \brief Fork a child of the shell, which applies \a redirections
+ \return process ID of the child in the shell, \c 0 in the child, or \c -1 on
+ error
+ */
+static pid_t _fork(queue_t *redirections)
+{
+	redirection_t *failedRedirection;
+	pid_t pid;
+	/* Pending output would otherwise be written by both processes */
+	fflush(NULL);
+	pid = fork();
+	if(pid != 0) {
+		return pid;
+	}
+	/* The shell reaps its children, this process reaps its own */
+	signal(SIGCHLD, SIG_DFL);
+	/* Processes of the launcher would be children of the shell instead */
+	launcherStop();
+	/* Placement is a hint, the command runs wherever it cannot be followed */
+	if(_placementCpu != -1) {
+		topologyPin(_placementCpu);
+	}
+	if(_isGroupLeader) {
+		setpgid(0, 0);
+		_isGroupLeader = 0;
+	}
+	if(redirections != NULL) {
+		failedRedirection = redirectionsApply(redirections);
+		if(failedRedirection != NULL) {
+			redirectionPrintError(failedRedirection);
+			_exitChild(kMushExecutionError);
+		}
+	}
+	return 0;
+}
+
+/*!
+ \brief Run the mush script \a script in this child as a new shell would,
+ without executing mush again
+ \param path path of the script, which becomes \c $0
+ */
+static void _executeScriptFile(script_t *script, char *path, int argc, char **argv)
+{
+	char *name = argv[0];
+	/* Only the environment is inherited by the script */
+	variablesReset();
+	functionsReset();
+	aliasesReset();
+	jobsReset();
+	argv[0] = path;
+	variablesSetPositional(argc, argv);
+	argv[0] = name;
+	_lastStatus = 0;
+	if(scriptExecute(script) != kMushNoError && mushError() != kMushNoError) {
+		fprintf(stderr, "mush: %s\n", mushErrorDescription());
+	}
+	_exitChild(_lastStatus);
+}
+
+/*!
+ \brief Replace the shell with the program \a argv
+
+ A mush script is executed in this process instead.
+ \return only if the program could not be executed
+ */
+static void _replaceShell(int argc, char **argv)
+{
+	script_t *script;
+	char *path;
+	script = scriptFileLookup(argv[0], &path);
+	if(script != NULL) {
+		_executeScriptFile(script, path, argc, argv);
+	}
+	fflush(NULL);
+	/* The launcher would otherwise outlive the shell */
+	launcherStop();
+	/* Builtins run with SIGPIPE ignored, which the program would inherit */
+	signal(SIGPIPE, SIG_DFL);
+	execvp(argv[0], argv);
+}
+
+/*!
+ \brief Apply the scheduling attributes \a attributes to this child, which
+ exits if one of them cannot be applied
+ \param attributes \c NULL terminated attributes as written, or \c NULL
+ */
+static void _applyAttributes(char **attributes)
+{
+	char *attribute;
+	int error;
+	for(; attributes != NULL && *attributes != NULL; attributes++) {
+		attribute = expansionExpandString(*attributes + 1, 0);
+		if(attribute == NULL || scheduleApply(attribute) != 0) {
+			error = attribute != NULL ? errno : ENOMEM;
+			fprintf(stderr, "mush: %s: %s\n", attribute != NULL ? attribute : *attributes,
+				strerror(error));
+			_exitChild(1);
+		}
+		free(attribute);
+	}
+}
+
+/*!
+ \brief Launch \a argv as executeInChild() does, in a child applying the
+ scheduling attributes \a attributes before it runs the program
+ */
+static pid_t _executeInChild(int argc, char **argv, queue_t *redirections, char **attributes)
 {
-	command_t *currentCommand = NULL;
-	command_t *previousCommand = NULL;
+	const builtin_t *builtin;
+	function_t *function;
+	script_t *script = NULL;
+	char *path;
 	pid_t pid;
+	/* Functions take precedence over builtins of the same name */
+	function = functionLookup(argv[0]);
+	builtin = function == NULL ? builtinLookup(argv[0]) : NULL;
+	/* The script is compiled in the shell, so it is cached for the next run */
+	if(builtin == NULL && function == NULL) {
+		script = scriptFileLookup(argv[0], &path);
+	}
+	if(script != NULL) {
+		pid = _fork(redirections);
+		if(pid == 0) {
+			_applyAttributes(attributes);
+			_executeScriptFile(script, path, argc, argv);
+		}
+		scriptFree(script);
+		free(path);
+		return pid;
+	}
+	/* The launcher cannot apply attributes, placement or process groups to
+	   the programs it spawns */
+	if(builtin == NULL && function == NULL && attributes == NULL && _placementCpu == -1
+	&& !_isGroupLeader && launcherIsRunning()) {
+		pid = launcherSpawn(argv, redirections);
+		if(pid != -1) {
+			return pid;
+		}
+	}
+	pid = _fork(redirections);
+	if(pid != 0) {
+		return pid;
+	}
+	_applyAttributes(attributes);
+	if(builtin != NULL) {
+		_exitChild(builtin->function(argc, argv));
+	}
+	if(function != NULL) {
+		_exitChild(functionCall(function, argc, argv));
+	}
+	/* Builtins starting programs run with SIGPIPE ignored */
+	signal(SIGPIPE, SIG_DFL);
+	execvp(argv[0], argv);
+	fprintf(stderr, "could not execute: %s\n", argv[0]);
+	_exitChild(kMushExecutionError);
+	return -1;
+}
+
+pid_t executeInChild(int argc, char **argv, queue_t *redirections)
+{
+	return _executeInChild(argc, argv, redirections, NULL);
+}
+
+pid_t executeInChildGroup(int argc, char **argv, queue_t *redirections)
+{
+	pid_t pid;
+	_isGroupLeader = 1;
+	pid = _executeInChild(argc, argv, redirections, NULL);
+	_isGroupLeader = 0;
+	/* The group must exist when this returns, whichever process runs first */
+	if(pid > 0) {
+		setpgid(pid, pid);
+	}
+	return pid;
+}
+
+/*!
+ \brief Indicate whether \a command runs alongside the commands following it,
+ rather than being waited for
+ */
+static int _isAlongside(command_t *command)
+{
+	return command->connectionMask == kCommandConnectionPipe
+		|| command->connectionMask == kCommandConnectionFanOut
+		|| command->connectionMask == kCommandConnectionBackground;
+}
+
+/*! \brief Pipes to the branches of a fan-out (\c "producer |+ a |+ b") */
+typedef struct __fan_out_t {
+	/*! \brief read end of the pipe of each branch, \c -1 once taken */
+	int *inputs;
+	size_t count;
+	/*! \brief index of the input of the next branch */
+	size_t next;
+} fan_out_t;
+
+/*!
+ \brief Close the inputs of \a fanOut not taken by a branch
+ */
+static void _finishFanOut(fan_out_t *fanOut)
+{
+	while(fanOut->count > 0) {
+		fanOut->count--;
+		if(fanOut->inputs[fanOut->count] != -1) {
+			close(fanOut->inputs[fanOut->count]);
+		}
+	}
+	free(fanOut->inputs);
+	fanOut->inputs = NULL;
+	fanOut->next = 0;
+}
+
+/*!
+ \brief Fork a child duplicating the pipe \a input into a pipe for each of
+ the branches following the producer at \a node
+
+ The data is duplicated with tee() and moved with splice(), so it is not
+ copied into the child. A branch whose reader exits is dropped, and each
+ of the others is written at the pace its reader consumes it.
+ \param fanOut receives the inputs of the branches
+ \return process ID of the child, or \c -1 on error
+ */
+static pid_t _startFanOut(int input, struct __queue_node_t *node, fan_out_t *fanOut)
+{
+	queue_t *redirections;
 	int pipeDescriptors[2];
-	int execStatus = 0;
-	int pipeStatus;
-	int waitStatus;
-	glob_t *globBuf;
-	int wasGlobUsed = 0;
-	char *errorDescription = NULL;
+	int *outputs;
+	size_t count;
+	size_t index;
+	pid_t pid;
+	_finishFanOut(fanOut);
+	for(count = 0, node = node->next; node != NULL; node = node->next) {
+		count++;
+		if(((command_t *)node->data)->connectionMask != kCommandConnectionFanOut) {
+			break;
+		}
+	}
+	fanOut->inputs = malloc(count * sizeof(*fanOut->inputs));
+	outputs = malloc(count * sizeof(*outputs));
+	redirections = queueNew();
+	if(fanOut->inputs == NULL || outputs == NULL || redirections == NULL) {
+		free(outputs);
+		if(redirections != NULL) {
+			queueFree(redirections);
+		}
+		return -1;
+	}
+	for(index = 0; index < count && redirectionPipe(pipeDescriptors) == 0; index++) {
+		fanOut->inputs[index] = pipeDescriptors[0];
+		outputs[index] = pipeDescriptors[1];
+		fanOut->count++;
+		/* The child would otherwise never see a branch exit */
+		queueInsert(redirections, redirectionNewClose(pipeDescriptors[0]),
+			(queueNodeFreeFunction)redirectionFree);
+	}
+	pid = index == count ? _fork(redirections) : -1;
+	if(pid == 0) {
+		/* A branch which exited is dropped rather than ending the others */
+		signal(SIGPIPE, SIG_IGN);
+		_exitChild(transferDescriptorToMany(input, outputs, count) == 0 ? 0 : 1);
+	}
+	queueFree(redirections);
+	for(index = 0; index < fanOut->count; index++) {
+		close(outputs[index]);
+	}
+	free(outputs);
+	return pid;
+}
 
-	/* Check if we have something to execute */
-	if(commandQueue == NULL) {
+/*! \brief Pipes to the commands of the process substitutions of a command */
+typedef struct __substitutions_t {
+	/*! \brief words of the command, naming the pipes instead */
+	char **words;
+	/*! \brief redirections of the command, onto the pipes instead */
+	queue_t *redirections;
+	/*! \brief ends of the pipes held by the shell until the command started */
+	int *descriptors;
+	size_t count;
+} substitutions_t;
+
+/*!
+ \brief Indicate whether \a word is a process substitution, \c "<(commands)"
+ or \c ">(commands)"
+ */
+static int _isSubstitution(const char *word)
+{
+	size_t length = strlen(word);
+	return length >= 3 && (word[0] == '<' || word[0] == '>') && word[1] == '('
+		&& word[length - 1] == ')';
+}
+
+/*!
+ \brief Indicate whether \a redirection opens a path which differs from the
+ word it was written as, such as \c "$file"
+ */
+static int _isExpandedPath(redirection_t *redirection)
+{
+	return redirection->action == kRedirectionActionOpen && !_isSubstitution(redirection->path)
+		&& strpbrk(redirection->path, "$`'\"\\~") != NULL;
+}
+
+/*!
+ \brief Fork a child running the commands of the process substitution
+ \a word, which write into or read from a pipe
+ \param substitutions receives the end of the pipe held by the shell
+ \return process ID of the child, or \c -1 on error
+ */
+static pid_t _startSubstitution(const char *word, substitutions_t *substitutions)
+{
+	queue_t *redirections;
+	queue_t *commands;
+	int pipeDescriptors[2];
+	int *grown;
+	/* The commands of "<(...)" write into the pipe, the shell keeps the end
+	   the command reads from */
+	int isRead = word[0] == '<';
+	size_t index;
+	char *text;
+	pid_t pid;
+	grown = realloc(substitutions->descriptors,
+		(substitutions->count + 1) * sizeof(*grown));
+	if(grown == NULL) {
+		return -1;
+	}
+	substitutions->descriptors = grown;
+	if(redirectionPipe(pipeDescriptors) != 0) {
+		return -1;
+	}
+	redirections = queueNew();
+	queueInsert(redirections, isRead
+		? redirectionNewDuplicate(STDOUT_FILENO, pipeDescriptors[1])
+		: redirectionNewDuplicate(STDIN_FILENO, pipeDescriptors[0]),
+		(queueNodeFreeFunction)redirectionFree);
+	/* Commands run within the child would otherwise hold the pipes open, and
+	   those reading from them would never see their end */
+	queueInsert(redirections, redirectionNewClose(pipeDescriptors[isRead ? 0 : 1]),
+		(queueNodeFreeFunction)redirectionFree);
+	for(index = 0; index < substitutions->count; index++) {
+		queueInsert(redirections, redirectionNewClose(substitutions->descriptors[index]),
+			(queueNodeFreeFunction)redirectionFree);
+	}
+	pid = _fork(redirections);
+	if(pid == 0) {
+		text = strndup(word + 2, strlen(word) - 3);
+		commands = text != NULL ? commandQueueFromInput(text) : NULL;
+		if((commands == NULL || executeCommandsInQueue(commands) != kMushNoError)
+		&& mushError() != kMushNoError) {
+			fprintf(stderr, "mush: %s\n", mushErrorDescription());
+			_exitChild(kMushExecutionError);
+		}
+		_exitChild(_lastStatus);
+	}
+	queueFree(redirections);
+	close(pipeDescriptors[isRead ? 1 : 0]);
+	if(pid == -1) {
+		close(pipeDescriptors[isRead ? 0 : 1]);
+		return -1;
+	}
+	substitutions->descriptors[substitutions->count++] = pipeDescriptors[isRead ? 0 : 1];
+	return pid;
+}
+
+/*!
+ \brief Add \a pid to the \a count processes of \a pids
+ \return \c 1 on success, \c 0 if the array could not grow
+ */
+static int _appendPid(pid_t **pids, size_t *count, pid_t pid)
+{
+	pid_t *grown = realloc(*pids, (*count + 1) * sizeof(*grown));
+	if(grown == NULL) {
+		return 0;
+	}
+	*pids = grown;
+	(*pids)[(*count)++] = pid;
+	return 1;
+}
+
+/*!
+ \brief Release the pipes and words of \a substitutions once \a command
+ started, leaving the pipes to it and the commands of the substitutions
+ */
+static void _finishSubstitutions(command_t *command, substitutions_t *substitutions)
+{
+	int index;
+	if(substitutions->words != command->argv) {
+		for(index = 0; index < command->argc; index++) {
+			if(substitutions->words[index] != command->argv[index]) {
+				free(substitutions->words[index]);
+			}
+		}
+		free(substitutions->words);
+	}
+	if(substitutions->redirections != command->redirections) {
+		queueFree(substitutions->redirections);
+	}
+	while(substitutions->count > 0) {
+		close(substitutions->descriptors[--substitutions->count]);
+	}
+	free(substitutions->descriptors);
+	substitutions->descriptors = NULL;
+}
+
+/*!
+ \brief Start the process substitutions among the words and redirections of
+ \a command, each replaced by the pipe to its commands
+
+ A word becomes the path of the pipe, \c /dev/fd/N, and only the command
+ inherits the descriptor. A redirection duplicates the pipe instead. The
+ paths of the other redirections are expanded, once for this run.
+ \param pids receives the process IDs of the children
+ \return \c kMushNoError on success, or an error to be returned after
+ calling _finishSubstitutions()
+ */
+static int _startSubstitutions(command_t *command, substitutions_t *substitutions,
+	pid_t **pids, size_t *pidCount)
+{
+	struct __queue_node_t *node;
+	redirection_t *redirection;
+	queue_t *redirections;
+	char **words;
+	char *path;
+	size_t argumentCount;
+	size_t descriptor;
+	int isRedirected;
+	int index;
+	pid_t pid;
+	substitutions->words = command->argv;
+	substitutions->redirections = command->redirections;
+	substitutions->descriptors = NULL;
+	substitutions->count = 0;
+	for(index = 0; index < command->argc; index++) {
+		if(!_isSubstitution(command->argv[index])) {
+			continue;
+		}
+		if(substitutions->words == command->argv) {
+			words = malloc((command->argc + 1) * sizeof(*words));
+			if(words == NULL) {
+				return kMushGenericError;
+			}
+			memcpy(words, command->argv, (command->argc + 1) * sizeof(*words));
+			substitutions->words = words;
+		}
+		pid = _startSubstitution(command->argv[index], substitutions);
+		if(pid == -1 || !_appendPid(pids, pidCount, pid)) {
+			return kMushExecutionError;
+		}
+		if(asprintf(&substitutions->words[index], "/dev/fd/%d",
+			substitutions->descriptors[substitutions->count - 1]) == -1) {
+			substitutions->words[index] = command->argv[index];
+			return kMushGenericError;
+		}
+	}
+	argumentCount = substitutions->count;
+	isRedirected = 0;
+	for(node = command->redirections->head; node != NULL && !isRedirected; node = node->next) {
+		redirection = node->data;
+		isRedirected = redirection->action == kRedirectionActionOpen
+			&& (_isSubstitution(redirection->path) || _isExpandedPath(redirection));
+	}
+	if(argumentCount == 0 && !isRedirected) {
 		return kMushNoError;
 	}
+	redirections = queueNew();
+	if(redirections == NULL) {
+		return kMushGenericError;
+	}
+	substitutions->redirections = redirections;
+	/* Arguments are opened by the command, so their pipes must survive exec */
+	for(descriptor = 0; descriptor < argumentCount; descriptor++) {
+		queueInsert(redirections, redirectionNewDuplicate(substitutions->descriptors[descriptor],
+			substitutions->descriptors[descriptor]), (queueNodeFreeFunction)redirectionFree);
+	}
+	/* The remaining redirections are shared, not owned by this queue */
+	for(node = command->redirections->head; node != NULL; node = node->next) {
+		redirection = node->data;
+		if(_isExpandedPath(redirection)) {
+			path = expansionExpandString(redirection->path, 0);
+			if(path == NULL) {
+				return kMushGenericError;
+			}
+			queueInsert(redirections, redirectionNewOpen(redirection->descriptor, path,
+				redirection->flags), (queueNodeFreeFunction)redirectionFree);
+			free(path);
+			continue;
+		}
+		if(redirection->action != kRedirectionActionOpen || !_isSubstitution(redirection->path)) {
+			queueInsert(redirections, redirection, NULL);
+			continue;
+		}
+		pid = _startSubstitution(redirection->path, substitutions);
+		if(pid == -1 || !_appendPid(pids, pidCount, pid)) {
+			return kMushExecutionError;
+		}
+		queueInsert(redirections, redirectionNewDuplicate(redirection->descriptor,
+			substitutions->descriptors[substitutions->count - 1]),
+			(queueNodeFreeFunction)redirectionFree);
+	}
+	return kMushNoError;
+}
 
-	while(queueRemove(commandQueue, (void *)&currentCommand)) {
-		assert(currentCommand != NULL);
-		/* Create the pipe before forking */
-		if(currentCommand->connectionMask == kCommandConnectionPipe) {
-			pipeStatus = pipe(pipeDescriptors);
-			if(pipeStatus != 0) {
-				setMushError(kMushGenericError);
-				setMushErrorDescription("unable to create pipe");
-				free(errorDescription);
-				errorDescription = NULL;
-				return mushError();
+/*!
+ \brief Count the assignments preceding the program name of \a command
+ */
+static int _assignmentCount(command_t *command)
+{
+	int count = 0;
+	while(count < command->argc && variableIsAssignment(command->argv[count])) {
+		count++;
+	}
+	return count;
+}
+
+/*!
+ \brief Assign the value of each assignment word to its variable
+ \return \c 0 on success, \c 1 on error
+ */
+static int _assign(char **words, int count)
+{
+	int index;
+	int status = 0;
+	for(index = 0; index < count; index++) {
+		if(variableAssign(words[index]) != 0) {
+			status = 1;
+		}
+	}
+	return status;
+}
+
+/*!
+ \brief Expand the arguments of a command
+
+ A builtin declaring variables receives its assignments as they are written,
+ to expand them itself, so that \c "declare name=(a b)" assigns an array.
+
+ \return the expanded arguments, or \c NULL on error
+ */
+static char **_expandArguments(char **words, int *count)
+{
+	const builtin_t *builtin;
+	char **arguments = NULL;
+	char **expanded;
+	char **grown;
+	char *single[2] = {NULL, NULL};
+	int expandedCount;
+	int index;
+	if(words[0] == NULL || functionLookup(words[0]) != NULL || aliasLookup(words[0]) != NULL
+	|| (builtin = builtinLookup(words[0])) == NULL || !(builtin->flags & kBuiltinFlagDeclaration)) {
+		return expansionExpandWords(words, count);
+	}
+	*count = 0;
+	for(; *words != NULL; words++) {
+		if(variableIsAssignment(*words)) {
+			expandedCount = 1;
+			expanded = calloc(2, sizeof(*expanded));
+			if(expanded != NULL && (expanded[0] = strdup(*words)) == NULL) {
+				free(expanded);
+				expanded = NULL;
 			}
+		} else {
+			single[0] = *words;
+			expanded = expansionExpandWords(single, &expandedCount);
 		}
-		globBuf = _globCommand(currentCommand);
-		wasGlobUsed = globBuf != NULL;
-		/* Execute builtin command, pwd is a special case as it has output */
-		if(commandIsBuiltIn(currentCommand)
-		&& strncmp(currentCommand->path, "pwd", 3) != 0) {
-			_executeBuiltinCommand(currentCommand);
+		grown = expanded != NULL ? realloc(arguments, (*count + expandedCount + 1) * sizeof(*grown)) : NULL;
+		if(grown == NULL) {
+			expansionFree(expanded);
+			expansionFree(arguments);
+			return NULL;
+		}
+		arguments = grown;
+		/* The strings are moved */
+		for(index = 0; index < expandedCount; index++) {
+			arguments[(*count)++] = expanded[index];
+		}
+		arguments[*count] = NULL;
+		free(expanded);
+	}
+	return arguments;
+}
+
+/*! \brief A variable of the environment replaced while a program starts */
+typedef struct __saved_variable_t {
+	char *name;
+	/*! \brief previous value, or \c NULL if the variable was not set */
+	char *value;
+} saved_variable_t;
+
+/*!
+ \brief Place the assignments preceding a program name into the environment,
+ from which the program inherits them
+ \return the replaced variables, to be passed to _restoreEnvironment()
+ */
+static saved_variable_t *_exportAssignments(char **words, int count)
+{
+	saved_variable_t *saved;
+	char *value;
+	char *appended;
+	size_t nameLength;
+	int isAppend;
+	int index;
+	saved = malloc(count * sizeof(*saved));
+	if(saved == NULL) {
+		return NULL;
+	}
+	for(index = 0; index < count; index++) {
+		nameLength = variableNameLength(words[index]);
+		isAppend = words[index][nameLength] == '+';
+		saved[index].name = strndup(words[index], nameLength);
+		saved[index].value = NULL;
+		if(saved[index].name == NULL) {
 			continue;
 		}
-		pid = fork();
-		/* Child */
-		if(pid == 0) {
-			/* Redirect stdout to file if file is specified */
-			if(currentCommand->redirectToPath != NULL) {
-				freopen(currentCommand->redirectToPath, "w", stdout);
+		if(getenv(saved[index].name) != NULL) {
+			saved[index].value = strdup(getenv(saved[index].name));
+		}
+		value = expansionExpandString(words[index] + nameLength + isAppend + 1, 0);
+		/* "name+=value" appends to the value the command would see */
+		if(isAppend && value != NULL && getenv(saved[index].name) != NULL) {
+			if(asprintf(&appended, "%s%s", getenv(saved[index].name), value) == -1) {
+				appended = NULL;
 			}
-			/* Redirect stdin to file if file is specified */
-			if(currentCommand->redirectFromPath != NULL) {
-				freopen(currentCommand->redirectFromPath, "r", stdin);
+			free(value);
+			value = appended;
+		}
+		if(value != NULL) {
+			setenv(saved[index].name, value, 1);
+			free(value);
+		}
+	}
+	return saved;
+}
+
+static void _restoreEnvironment(saved_variable_t *saved, int count)
+{
+	int index;
+	if(saved == NULL) {
+		return;
+	}
+	for(index = count - 1; index >= 0; index--) {
+		if(saved[index].name == NULL) {
+			continue;
+		}
+		if(saved[index].value != NULL) {
+			setenv(saved[index].name, saved[index].value, 1);
+		} else {
+			unsetenv(saved[index].name);
+		}
+		free(saved[index].name);
+		free(saved[index].value);
+	}
+	free(saved);
+}
+
+/*!
+ \brief Create an anonymous file receiving the output of a builtin run in the
+ shell, for the next command of the pipeline to read
+ \return descriptor of the file, or \c -1 if a pipe has to be used instead
+ */
+static int _captureDescriptor()
+{
+#if defined(MFD_CLOEXEC)
+	return memfd_create("mush-capture", MFD_CLOEXEC);
+#else
+	return -1;
+#endif
+}
+
+/*!
+ \brief Create the descriptor feeding the here-document of \a command, or
+ its here-string once expanded
+ \return the descriptor, or \c -1 on error
+ */
+static int _hereDocumentInput(command_t *command)
+{
+	char *word;
+	char *text;
+	int descriptor;
+	if(!command->isHereString) {
+		return hereDocumentDescriptor(command->hereDocument);
+	}
+	word = expansionExpandString(command->hereDocument, 0);
+	/* A here-string is terminated by a new line, like a here-document */
+	if(word == NULL || asprintf(&text, "%s\n", word) == -1) {
+		free(word);
+		return -1;
+	}
+	free(word);
+	descriptor = hereDocumentDescriptor(text);
+	free(text);
+	return descriptor;
+}
+
+static void _closeDescriptor(int *descriptor)
+{
+	if(*descriptor != -1) {
+		close(*descriptor);
+		*descriptor = -1;
+	}
+}
+
+/*!
+ \brief Replace the first of \a arguments with the words of its alias, if it
+ has one
+ \param count amount of \a arguments, updated with the new amount
+ \return the arguments, replacing \a arguments, or \c NULL on error
+ */
+static char **_expandAlias(char **arguments, int *count)
+{
+	alias_t *alias = aliasLookup(arguments[0]);
+	char **words;
+	char **expanded;
+	int wordCount;
+	if(alias == NULL) {
+		return arguments;
+	}
+	words = expansionExpandWords(alias->words, &wordCount);
+	expanded = words != NULL ? malloc((wordCount + *count) * sizeof(*expanded)) : NULL;
+	if(expanded == NULL) {
+		expansionFree(words);
+		expansionFree(arguments);
+		return NULL;
+	}
+	/* The strings are moved, the name of the alias is dropped */
+	memcpy(expanded, words, wordCount * sizeof(*expanded));
+	memcpy(expanded + wordCount, arguments + 1, *count * sizeof(*expanded));
+	free(arguments[0]);
+	free(arguments);
+	free(words);
+	*count += wordCount - 1;
+	return expanded;
+}
+
+int cmd_exec(int argc, char **argv)
+{
+	pid_t pid;
+	int error;
+	if(argc == 1 && _isEmbedding()) {
+		fprintf(stderr, "exec: redirections cannot outlive the command in an embedded shell\n");
+		return 1;
+	} else if(argc == 1) {
+		return 0;
+	}
+	/* The program runs in a child instead, after which the script ends */
+	if(_isEmbedding()) {
+		pid = _executeInChild(argc - 1, argv + 1, NULL, NULL);
+		if(pid == -1) {
+			fprintf(stderr, "exec: %s: %s\n", argv[1], strerror(errno));
+			return executeExit(kMushExecutionError);
+		}
+		return executeExit(_exitStatus(jobsWaitForeground(&pid, 1)));
+	}
+	_replaceShell(argc - 1, argv + 1);
+	error = errno;
+	fprintf(stderr, "exec: %s: %s\n", argv[1], strerror(error));
+	return error == ENOENT ? 127 : 126;
+}
+
+/*!
+ \brief Open the file of a \c "cat file" passing its input to the next command
+ \return descriptor of the file, or \c -1 if cat has to run, such as to
+ report a file which cannot be read
+ */
+static int _openPassedInput(command_t *command)
+{
+	struct stat status;
+	int descriptor;
+	/* An alias or function defined since the optimizer ran replaces cat */
+	if(aliasLookup(command->argv[0]) != NULL || functionLookup(command->argv[0]) != NULL) {
+		return -1;
+	}
+	descriptor = open(command->argv[1], O_RDONLY | O_CLOEXEC);
+	if(descriptor == -1) {
+		return -1;
+	}
+	if(fstat(descriptor, &status) != 0 || S_ISDIR(status.st_mode)) {
+		close(descriptor);
+		return -1;
+	}
+	return descriptor;
+}
+
+int executePipeline(queue_t *pipeline, pid_t **pids, size_t *pidCount, int *lastStatus)
+{
+	struct __queue_node_t *node;
+	command_t *command = NULL;
+	queue_t *redirections;
+	redirection_t *failedRedirection;
+	saved_variable_t *savedVariables;
+	const builtin_t *builtin;
+	function_t *function;
+	pid_t pid;
+	int pipeDescriptors[2];
+	int pipelineInput = -1;
+	int pipelineOutput = -1;
+	int hereDocumentInput = -1;
+	int isInShell;
+	int isCaptured;
+	int status = 0;
+	char **arguments;
+	int argumentCount;
+	int assignmentCount;
+	substitutions_t substitutions;
+	fan_out_t fanOut = {NULL, 0, 0};
+	command_t *previous = NULL;
+	int isBranch;
+	int isProducer;
+	int placementGroup = -1;
+	size_t stage = 0;
+	/* Pipelines run by the last one, such as those of a function, do not
+	   replace the shell */
+	int isFinal = _isFinal && pipeline->head != NULL && pipeline->head->next == NULL;
+	_isFinal = 0;
+
+	*pids = NULL;
+	*pidCount = 0;
+	*lastStatus = -1;
+	/* Stages exchanging data through pipes benefit from sharing a cache */
+	if(optionIsSet(kOptionPlacement) && pipeline->head != NULL && pipeline->head->next != NULL) {
+		placementGroup = topologyPlacePipeline();
+	}
+	for(node = pipeline->head; node != NULL; node = node->next, stage++) {
+		command = node->data;
+		assert(command != NULL);
+		/* Each branch of a fan-out reads its own copy of the output */
+		isBranch = previous != NULL && previous->connectionMask == kCommandConnectionFanOut;
+		isProducer = command->connectionMask == kCommandConnectionFanOut && !isBranch;
+		previous = command;
+		if(isBranch && fanOut.next < fanOut.count) {
+			pipelineInput = fanOut.inputs[fanOut.next];
+			fanOut.inputs[fanOut.next++] = -1;
+		}
+		/* The next command reads the file itself rather than through cat */
+		if(command->isInputPassed && pipelineInput == -1 && node->next != NULL
+		&& (pipelineInput = _openPassedInput(command)) != -1) {
+			continue;
+		}
+		/* The commands of a group or subshell are expanded as they run */
+		assignmentCount = 0;
+		arguments = NULL;
+		argumentCount = 0;
+		status = _startSubstitutions(command, &substitutions, pids, pidCount);
+		if(status != kMushNoError) {
+			_finishSubstitutions(command, &substitutions);
+			_closeDescriptor(&pipelineInput);
+			_finishFanOut(&fanOut);
+			setMushError(status);
+			setMushErrorDescription(status == kMushExecutionError
+				? "unable to start process substitution" : "unable to expand redirections");
+			return mushError();
+		}
+		if(command->body == NULL) {
+			assignmentCount = _assignmentCount(command);
+			arguments = _expandArguments(substitutions.words + assignmentCount, &argumentCount);
+			if(arguments != NULL && argumentCount > 0) {
+				arguments = _expandAlias(arguments, &argumentCount);
 			}
-			/* Send stdout to the write end of the pipe */
-			if(currentCommand->connectionMask == kCommandConnectionPipe) {
-				dup2(pipeDescriptors[1], fileno(stdout));
-				close(pipeDescriptors[0]);
+		}
+		if(arguments == NULL && command->body == NULL) {
+			_finishSubstitutions(command, &substitutions);
+			_closeDescriptor(&pipelineInput);
+			_finishFanOut(&fanOut);
+			setMushError(kMushGenericError);
+			setMushErrorDescription("unable to expand arguments");
+			return mushError();
+		}
+		/* Assignments alone change the variables of the shell, unless they
+		   run alongside other commands */
+		if(argumentCount == 0 && command->body == NULL) {
+			status = 0;
+			if(!_isAlongside(command)) {
+				status = _assign(command->argv, assignmentCount);
 			}
-			/* Redirect the read end into stdin */
-			if(previousCommand != NULL && previousCommand->connectionMask == kCommandConnectionPipe) {
-				dup2(pipeDescriptors[0], fileno(stdin));
-				close(pipeDescriptors[1]);
+			_finishSubstitutions(command, &substitutions);
+			_closeDescriptor(&pipelineInput);
+			*lastStatus = status;
+			expansionFree(arguments);
+			continue;
+		}
+		/* Builtins changing the state of the shell cannot run in a child, and
+		   forking would cost more than running cheap builtins, unless they
+		   have to run alongside other commands. A queued job runs later, so
+		   it must not change the shell then either ("cd / &") */
+		function = NULL;
+		builtin = NULL;
+		if(command->body == NULL) {
+			function = functionLookup(arguments[0]);
+			builtin = function == NULL ? builtinLookup(arguments[0]) : NULL;
+		}
+		isInShell = builtin != NULL && (builtin->flags & (kBuiltinFlagModifiesShell
+			| kBuiltinFlagNoFork | kBuiltinFlagRunsCommand)) && !_isAlongside(command);
+		/* Functions run in the shell unless they run alongside other commands */
+		isInShell = isInShell || (function != NULL && !_isAlongside(command));
+		/* "exec" only replaces the shell if it is the whole pipeline */
+		isInShell = isInShell || (builtin != NULL && (builtin->flags & kBuiltinFlagReplacesShell)
+			&& node == pipeline->head && !_isAlongside(command));
+		/* As do groups, whereas subshells always fork */
+		isInShell = isInShell || (command->body != NULL && !command->isSubshell
+			&& !_isAlongside(command));
+		/* Scheduling attributes apply to a child, never to the shell */
+		isInShell = isInShell && command->attributes == NULL;
+		/* A builtin marked by the optimizer writes all of its output before
+		   the next command starts reading it */
+		isCaptured = 0;
+		if(command->isOutputCaptured && command->connectionMask == kCommandConnectionPipe
+		&& builtin != NULL && (builtin->flags & kBuiltinFlagNoFork) && command->attributes == NULL) {
+			pipelineOutput = _captureDescriptor();
+			isCaptured = pipelineOutput != -1;
+			isInShell = isInShell || isCaptured;
+		}
+		/* Create the pipe before forking */
+		if((command->connectionMask == kCommandConnectionPipe || isProducer) && !isCaptured) {
+			if(redirectionPipe(pipeDescriptors) != 0) {
+				_finishSubstitutions(command, &substitutions);
+				_closeDescriptor(&pipelineInput);
+				_finishFanOut(&fanOut);
+				expansionFree(arguments);
+				setMushError(kMushGenericError);
+				setMushErrorDescription("unable to create pipe");
+				return mushError();
 			}
-			if(strncmp(currentCommand->path, "pwd", 3) == 0) {
-				_executeBuiltinCommand(currentCommand);
-				exit(EXIT_SUCCESS);
-			} else if(wasGlobUsed) {
-				execStatus = execvp(currentCommand->path, &globBuf->gl_pathv[0]);
-			} else {
-				execStatus = execvp(currentCommand->path, currentCommand->argv);
+			pipelineOutput = pipeDescriptors[1];
+		}
+		if(command->hereDocument != NULL) {
+			hereDocumentInput = _hereDocumentInput(command);
+			if(hereDocumentInput == -1) {
+				_finishSubstitutions(command, &substitutions);
+				_closeDescriptor(&pipelineInput);
+				_finishFanOut(&fanOut);
+				_closeDescriptor(&pipelineOutput);
+				expansionFree(arguments);
+				setMushError(kMushGenericError);
+				setMushErrorDescription("unable to create here-document");
+				return mushError();
 			}
-			if(execStatus != 0) {
-				fprintf(stderr, "could not execute: %s\n", currentCommand->path);
+		}
+		/* The redirections are computed before forking, the child only applies them */
+		redirections = _redirectionsForCommand(substitutions.redirections, pipelineInput,
+			pipelineOutput, hereDocumentInput);
+		pid = -1;
+		/* Assignments preceding the program name only apply to the program */
+		savedVariables = NULL;
+		if(assignmentCount > 0) {
+			savedVariables = _exportAssignments(command->argv, assignmentCount);
+		}
+		/* Explicit attributes are applied after the placement, overriding it */
+		if(placementGroup != -1) {
+			_placementCpu = topologyCpuForStage(placementGroup, stage);
+		}
+		if(redirections != NULL && isInShell) {
+			status = _executeInShell(builtin, function, command, argumentCount, arguments,
+				redirections);
+		} else if(redirections != NULL && isFinal && builtin == NULL && function == NULL
+		&& command->body == NULL) {
+			/* Nothing follows, so the program takes the place of the shell */
+			failedRedirection = redirectionsApply(redirections);
+			if(failedRedirection != NULL) {
+				redirectionPrintError(failedRedirection);
 				exit(kMushExecutionError);
 			}
-		} else {
-			if(currentCommand->connectionMask != kCommandConnectionBackground) {
-				waitpid(pid, &waitStatus, 0);
+			_applyAttributes(command->attributes);
+			_replaceShell(argumentCount, arguments);
+			fprintf(stderr, "could not execute: %s\n", arguments[0]);
+			exit(kMushExecutionError);
+		} else if(redirections != NULL && command->body != NULL) {
+			pid = _fork(redirections);
+			if(pid == 0) {
+				_applyAttributes(command->attributes);
+				_exitChild(_executeBody(command));
 			}
+		} else if(redirections != NULL) {
+			pid = _executeInChild(argumentCount, arguments, redirections, command->attributes);
+		}
+		_placementCpu = -1;
+		_restoreEnvironment(savedVariables, assignmentCount);
+		if(redirections != NULL) {
+			queueFree(redirections);
 		}
-		if(previousCommand != NULL) {
-			commandFree(previousCommand);
+		/* The descriptors now belong to the child */
+		_finishSubstitutions(command, &substitutions);
+		_closeDescriptor(&pipelineInput);
+		if(isCaptured) {
+			lseek(pipelineOutput, 0, SEEK_SET);
+			pipelineInput = pipelineOutput;
+			pipelineOutput = -1;
+		}
+		_closeDescriptor(&pipelineOutput);
+		_closeDescriptor(&hereDocumentInput);
+		if(command->connectionMask == kCommandConnectionPipe && !isCaptured) {
+			pipelineInput = pipeDescriptors[0];
+		}
+		if(isInShell) {
+			*lastStatus = status;
+		} else if(pid == -1) {
+			_closeDescriptor(&pipelineInput);
+			fprintf(stderr, "mush: unable to execute %s: %s\n",
+				command->body != NULL ? "subshell" : arguments[0], strerror(errno));
+			*lastStatus = kMushExecutionError;
+		} else {
+			_appendPid(pids, pidCount, pid);
+			*lastStatus = -1;
+		}
+		expansionFree(arguments);
+		if(isProducer) {
+			pid = _startFanOut(pipeDescriptors[0], node, &fanOut);
+			close(pipeDescriptors[0]);
+			if(pid == -1 || !_appendPid(pids, pidCount, pid)) {
+				_finishFanOut(&fanOut);
+				setMushError(kMushGenericError);
+				setMushErrorDescription("unable to start fan-out");
+				return mushError();
+			}
 		}
-		previousCommand = currentCommand;
-		currentCommand = NULL;
 	}
-	/* FIXME: Dieing children can interrupt the loop, causing a NULL pointer to be
-	   freed. This is a temporary solution. */
-	if(previousCommand != NULL) {
-		commandFree(previousCommand);
-		previousCommand = NULL;
+	_closeDescriptor(&pipelineInput);
+	_finishFanOut(&fanOut);
+	return kMushNoError;
+}
+
+void executeSetEmbedded(int isEmbedded)
+{
+	_embeddingProcess = isEmbedded ? getpid() : -1;
+}
+
+int executeExit(int status)
+{
+	if(_embeddingProcess == -1) {
+		jobsFinish();
+		exit(status);
 	}
-	if(wasGlobUsed) {
-		globfree(globBuf);
+	/* The program embedding the shell goes on, only its scripts end */
+	if(_isEmbedding()) {
+		scriptExit();
+		return status;
 	}
+	jobsFinish();
+	_exitChild(status);
+	return status;
+}
 
-	return 0;
+int executeForeground(queue_t *pipeline)
+{
+	pid_t *pids;
+	size_t pidCount;
+	int lastStatus;
+	int waitStatus;
+	int status;
+	/* Every command of a pipeline runs concurrently, wait once all started */
+	status = executePipeline(pipeline, &pids, &pidCount, &lastStatus);
+	waitStatus = jobsWaitForeground(pids, pidCount);
+	_lastStatus = lastStatus != -1 ? lastStatus : _exitStatus(waitStatus);
+	free(pids);
+	return status;
+}
+
+int executeFinal(queue_t *pipeline)
+{
+	/* The shell still has to start and wait for its jobs before exiting */
+	jobsReap();
+	_isFinal = !jobsArePending();
+	return executeForeground(pipeline);
+}
+
+int executeCommandsInQueue(queue_t *commandQueue)
+{
+	script_t *script;
+	int status;
+
+	/* Check if we have something to execute */
+	if(commandQueue == NULL) {
+		return kMushNoError;
+	}
+	script = scriptCompile(commandQueue);
+	if(script == NULL) {
+		return mushError();
+	}
+	status = scriptExecute(script);
+	scriptFree(script);
+	return status;
 }
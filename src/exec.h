@@ -24,12 +24,139 @@
 /*!
  \brief Execute each command in the queue
  
- Each command in the queue is removed and executed sequentially. If a command
+ The commands are removed from the queue and compiled into a script (see
+ scriptCompile()), which is then executed. If a command
  has a \a connectionMask value of \c kCommandConnectionPipe, the output of the
  command is piped to the next command. If the \a connectionMask has a value of
  \c kCommandConnectionBackground the command is run in the background, i.e., the
- shell does not wait for the command to terminate.
+ shell does not wait for the command to terminate. Background pipelines are
+ handed to the job table, which starts them once a job slot is free. The
+ masks \c kCommandConnectionAnd and \c kCommandConnectionOr run the next
+ pipeline only if the exit status is zero or non-zero, respectively.
  
  \param commandQueue queue of \c command_t objects
+ \return \c kMushNoError on success, an error code otherwise
  */
-int executeCommandsInQueue(queue_t *commandQueue);
\ No newline at end of file
+int executeCommandsInQueue(queue_t *commandQueue);
+
+/*!
+ \brief Start each command of a pipeline without waiting for them
+
+ The commands of \a pipeline are connected by pipes according to their
+ \a connectionMask and started. They are left in \a pipeline, so the same
+ pipeline may be executed again. Words are expanded each time. Commands
+ consisting only of assignments set shell variables, while assignments
+ preceding a program name are only passed to the environment of the program.
+
+ Cheap builtins run in the shell process rather than in a child if they do
+ not have to run alongside other commands, i.e. if they are not piped into
+ another command or run in the background.
+
+ \param pipeline queue of \c command_t objects
+ \param pids receives the allocated array of started processes, in order
+ \param pidCount receives the amount of elements in \a pids
+ \param lastStatus receives the exit status of the last command if it
+ already finished (because it ran in the shell or could not be started), or
+ \c -1 if it has to be waited for
+ \return \c kMushNoError on success, an error code otherwise
+ */
+int executePipeline(queue_t *pipeline, pid_t **pids, size_t *pidCount, int *lastStatus);
+
+/*!
+ \brief Execute a pipeline and wait for it to terminate
+
+ The exit status of the pipeline becomes the status returned by
+ executeLastStatus().
+
+ \param pipeline queue of \c command_t objects, left untouched
+ \return \c kMushNoError on success, an error code otherwise
+ */
+int executeForeground(queue_t *pipeline);
+
+/*!
+ \brief Execute a pipeline as the last command the shell runs
+
+ A pipeline consisting of a single program replaces the shell, rather than
+ being run in a child which the shell then waits for, unless background jobs
+ are still queued or running. Any other pipeline is executed with
+ executeForeground().
+
+ \param pipeline queue of \c command_t objects
+ \return \c kMushNoError on success, an error code otherwise
+ */
+int executeFinal(queue_t *pipeline);
+
+/*!
+ \brief Set whether the shell runs within another program (see libmush.h)
+
+ The calling process is then that of the program: \c exit ends the scripts
+ being executed rather than the process, \c exec runs its program in a
+ child, and children of the shell leave without running the exit handlers
+ of the program.
+
+ \param isEmbedded \c 1 if the calling process embeds the shell
+ */
+void executeSetEmbedded(int isEmbedded);
+
+/*!
+ \brief End the shell with \a status, as the builtin "exit" does
+
+ A shell running a script or command string waits for its jobs first (see
+ jobsFinish()). Within a program embedding the shell, only the scripts being
+ executed end.
+
+ \return \a status, only if the shell is embedded
+ */
+int executeExit(int status);
+
+/*!
+ \brief Return the exit status of the last foreground pipeline
+ \return the exit status, or 128 plus the signal number if the last command
+ of the pipeline was terminated by a signal
+ */
+int executeLastStatus();
+
+/*!
+ \brief Replace the exit status returned by executeLastStatus()
+ \param status the exit status
+ */
+void executeSetLastStatus(int status);
+
+/*!
+ \brief Launch a program in a child process without waiting for it
+
+ The child applies \a redirections and executes the program named by
+ \a argv[0]. Builtin commands are run directly in the child instead, saving
+ the exec. Programs are created by the launcher helper if it is running
+ (see launcherStart()), so the cost of fork() does not grow with the shell.
+
+ \param argc amount of elements in \a argv
+ \param argv \c NULL terminated arguments, starting with the program name
+ \param redirections queue of \c redirection_t objects, or \c NULL
+ \return process identifier of the child, or \c -1 on error
+ */
+pid_t executeInChild(int argc, char **argv, queue_t *redirections);
+
+/*!
+ \brief Launch a program as executeInChild() does, in a new process group
+ led by the child
+
+ Every process the program starts joins the group, so they can be signalled
+ at once with kill(-pid, ...). The launcher is not used.
+
+ \return process identifier of the child, which is also the process group
+ identifier, or \c -1 on error
+ */
+pid_t executeInChildGroup(int argc, char **argv, queue_t *redirections);
+
+/*!
+ \brief Run the builtin "exec" command
+
+ \c "exec program [arguments...]" replaces the shell with the program. Without
+ a program, the redirections of the command stay applied to the shell.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return exit status of the command, if the shell was not replaced
+ */
+int cmd_exec(int argc, char **argv);
\ No newline at end of file
@@ -21,12 +21,14 @@
  */
 #include "exit.h"
 #include <stdlib.h>
+#include "exec.h"
 
-void cmd_exit(int argc, char **argv)
+int cmd_exit(int argc, char **argv)
 {
-	int status = 0;
+	/* Without an argument the status of the last command is kept */
+	int status = executeLastStatus();
 	if(argc > 1) {
 		status = atoi(argv[1]);
 	}
-	exit(status);
+	return executeExit(status);
 }
@@ -28,11 +28,13 @@
 /*!
  \brief Run the builtin "exit" command
  
- If argc is greater than 1, it is assumed that argv[1] contains the exit status
+ If argc is greater than 1, it is assumed that argv[1] contains the exit status.
+ Only returns within a program embedding the shell, see executeExit().
  \param argc count of elements in \a argv
  \param argv arguments to be passed to the command
+ \return exit status of the command
  */
-void cmd_exit(int argc, char **argv);
+int cmd_exit(int argc, char **argv);
 
 /*!
  \}
@@ -0,0 +1,1013 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "expansion.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <glob.h>
+#include <fnmatch.h>
+#include "arithmetic.h"
+#include "variables.h"
+#include "exec.h"
+
+/*! \brief Growable array of arguments */
+typedef struct __expansion_arguments_t {
+	char **arguments;
+	int count;
+	int size;
+} expansion_arguments_t;
+
+static int _appendArgument(expansion_arguments_t *arguments, char *argument)
+{
+	char **grown;
+	if(argument == NULL) {
+		return -1;
+	}
+	/* One element is kept for the terminating NULL */
+	if(arguments->count + 1 >= arguments->size) {
+		grown = realloc(arguments->arguments, arguments->size * 2 * sizeof(*grown));
+		if(grown == NULL) {
+			free(argument);
+			return -1;
+		}
+		arguments->arguments = grown;
+		arguments->size *= 2;
+	}
+	arguments->arguments[arguments->count++] = argument;
+	arguments->arguments[arguments->count] = NULL;
+	return 0;
+}
+
+/*! \brief Growable string */
+typedef struct __expansion_buffer_t {
+	char *data;
+	size_t length;
+	size_t size;
+} expansion_buffer_t;
+
+static int _bufferAppend(expansion_buffer_t *buffer, const char *string, size_t length)
+{
+	char *grown;
+	size_t size = buffer->size;
+	while(buffer->length + length + 1 > size) {
+		size = size * 2;
+	}
+	if(size != buffer->size) {
+		grown = realloc(buffer->data, size);
+		if(grown == NULL) {
+			return -1;
+		}
+		buffer->data = grown;
+		buffer->size = size;
+	}
+	memcpy(buffer->data + buffer->length, string, length);
+	buffer->length += length;
+	buffer->data[buffer->length] = '\0';
+	return 0;
+}
+
+/*! \brief State of the expansion of a single word */
+typedef struct __expansion_word_t {
+	/*! \brief the field being built, without quotes */
+	expansion_buffer_t field;
+	/*! \brief the field as a glob() pattern, with quoted characters escaped */
+	expansion_buffer_t pattern;
+	/*! \brief whether the field has unquoted pattern characters */
+	int isPattern;
+	/*! \brief whether the field exists even if it is empty, e.g. \c "''" */
+	int isStarted;
+	/*! \brief whether unquoted expansions are split into several fields */
+	int isSplit;
+	/*! \brief completed fields, or \c NULL if the word is not split */
+	expansion_arguments_t *arguments;
+} expansion_word_t;
+
+/*!
+ \brief Append \a character to the current field
+ \param isQuoted whether the character stands for itself in a pattern
+ */
+static int _appendCharacter(expansion_word_t *word, char character, int isQuoted)
+{
+	int status = 0;
+	if(isQuoted && strchr("*?[]\\", character) != NULL) {
+		status = _bufferAppend(&word->pattern, "\\", 1);
+	} else if(!isQuoted && strchr("*?[", character) != NULL) {
+		word->isPattern = 1;
+	}
+	word->isStarted = 1;
+	if(status == 0) {
+		status = _bufferAppend(&word->pattern, &character, 1);
+	}
+	if(status == 0) {
+		status = _bufferAppend(&word->field, &character, 1);
+	}
+	return status;
+}
+
+/*!
+ \brief Complete the current field, expanding it to the matching path names
+ if it is a pattern
+ */
+static int _finishField(expansion_word_t *word)
+{
+	glob_t globBuffer;
+	size_t index;
+	int status = 0;
+	if(!word->isStarted) {
+		return 0;
+	}
+	/* A pattern without matches is left as it is */
+	if(word->isPattern && glob(word->pattern.data, 0, NULL, &globBuffer) == 0) {
+		for(index = 0; index < globBuffer.gl_pathc && status == 0; index++) {
+			status = _appendArgument(word->arguments, strdup(globBuffer.gl_pathv[index]));
+		}
+		globfree(&globBuffer);
+	} else {
+		status = _appendArgument(word->arguments, strdup(word->field.data));
+	}
+	word->field.length = 0;
+	word->field.data[0] = '\0';
+	word->pattern.length = 0;
+	word->pattern.data[0] = '\0';
+	word->isPattern = 0;
+	word->isStarted = 0;
+	return status;
+}
+
+/*!
+ \brief Append the value of an expansion to the current field
+
+ Unquoted values of a split word are split into fields at white space. The
+ characters of a value are never taken as a pattern.
+ */
+static int _appendValue(expansion_word_t *word, const char *value, int isQuoted)
+{
+	int status = 0;
+	if(value == NULL) {
+		return 0;
+	}
+	for(; *value != '\0' && status == 0; value++) {
+		if(!isQuoted && word->isSplit && isspace((unsigned char)*value)) {
+			status = _finishField(word);
+		} else {
+			status = _appendCharacter(word, *value, 1);
+		}
+	}
+	return status;
+}
+
+/*!
+ \brief Append an element of a list such as \c $@ or \c ${name[@]}
+ \param isFirst whether \a value is the first element of the list
+ \param isSeparate whether quoted elements are kept separate fields, as in
+ \c "$@", rather than being joined with blanks, as in \c "$*"
+ */
+static int _appendListElement(expansion_word_t *word, const char *value, int isFirst,
+	int isSeparate, int isQuoted)
+{
+	int status = 0;
+	if(!isFirst && isQuoted && isSeparate && word->isSplit) {
+		status = _finishField(word);
+		word->isStarted = 1;
+	} else if(!isFirst) {
+		status = _appendValue(word, " ", isQuoted);
+	}
+	return status == 0 ? _appendValue(word, value, isQuoted) : status;
+}
+
+/*!
+ \brief Indicate whether \a subscript, including its brackets, stands for
+ every element, i.e. \c [@] or \c [*]
+ */
+static int _isListSubscript(const char *subscript)
+{
+	return subscript[0] == '[' && (subscript[1] == '@' || subscript[1] == '*')
+		&& subscript[2] == ']' && subscript[3] == '\0';
+}
+
+/*!
+ \brief Append an element, or every element, of an array
+ \param name the name of the array followed by the subscript
+ \param nameLength length of the name of the array
+ \param isKeys whether the keys (\c ${!name[@]}) are appended rather than
+ the values
+ */
+static int _appendElements(expansion_word_t *word, const char *name, size_t nameLength,
+	int isKeys, int isQuoted)
+{
+	variable_t *variable;
+	const char *subscript = name + nameLength;
+	const char *value;
+	const char *key;
+	char number[32];
+	char *arrayName;
+	char *raw;
+	char *expanded;
+	size_t position;
+	int isFirst = 1;
+	int status = 0;
+	arrayName = strndup(name, nameLength);
+	if(arrayName == NULL) {
+		return -1;
+	}
+	if(!_isListSubscript(subscript)) {
+		raw = strndup(subscript + 1, strlen(subscript) - 2);
+		expanded = raw != NULL ? expansionExpandString(raw, 0) : NULL;
+		status = expanded != NULL
+			? _appendValue(word, variableElement(arrayName, expanded), isQuoted) : -1;
+		free(expanded);
+		free(raw);
+		free(arrayName);
+		return status;
+	}
+	variable = variableLookup(arrayName, 0);
+	free(arrayName);
+	/* A variable which is not an array is a list of its value */
+	if(variable == NULL || variable->array == NULL) {
+		value = variable != NULL ? variable->value : NULL;
+		return value != NULL ? _appendValue(word, isKeys ? "0" : value, isQuoted) : 0;
+	}
+	/* The values are appended to the arguments directly, "${name[@]}" is
+	   never joined into a string and split again */
+	for(position = 0; status == 0 && (value = arrayNext(variable->array, &position, &key)) != NULL; position++) {
+		if(isKeys && key == NULL) {
+			snprintf(number, sizeof(number), "%zu", position);
+			key = number;
+		}
+		status = _appendListElement(word, isKeys ? key : value, isFirst, subscript[1] == '@', isQuoted);
+		isFirst = 0;
+	}
+	return status;
+}
+
+/*!
+ \brief Append the value of the parameter \a name, which is a variable, an
+ element of an array, a positional or a special parameter
+ */
+static int _appendParameter(expansion_word_t *word, const char *name, int isQuoted)
+{
+	char number[32];
+	size_t nameLength;
+	int index;
+	int status = 0;
+	if(isdigit((unsigned char)name[0])) {
+		return _appendValue(word, variablePositional(atoi(name)), isQuoted);
+	}
+	nameLength = variableNameLength(name);
+	if(nameLength > 0 && name[nameLength] == '[') {
+		return _appendElements(word, name, nameLength, 0, isQuoted);
+	}
+	if(nameLength > 0) {
+		return _appendValue(word, variableGet(name), isQuoted);
+	}
+	switch(name[0]) {
+		case '?':
+			snprintf(number, sizeof(number), "%d", executeLastStatus());
+			break;
+		case '#':
+			snprintf(number, sizeof(number), "%d", variablesPositionalCount());
+			break;
+		case '$':
+			snprintf(number, sizeof(number), "%d", (int)getpid());
+			break;
+		case '@':
+		case '*':
+			for(index = 1; index <= variablesPositionalCount() && status == 0; index++) {
+				status = _appendListElement(word, variablePositional(index), index == 1,
+					name[0] == '@', isQuoted);
+			}
+			return status;
+		default:
+			number[0] = '\0';
+	}
+	return _appendValue(word, number, isQuoted);
+}
+
+static int _initializeWord(expansion_word_t *word, int isSplit, expansion_arguments_t *arguments);
+
+/*!
+ \brief Return the value of the parameter \a name as a single string
+ \param isSet receives whether the parameter is set
+ \return newly allocated value, empty if the parameter is unset, or \c NULL
+ on error
+ */
+static char *_parameterValue(const char *name, int *isSet)
+{
+	expansion_word_t value;
+	size_t nameLength = variableNameLength(name);
+	const char *element;
+	char *arrayName;
+	char *subscript;
+	char *expanded;
+	*isSet = 1;
+	if(nameLength > 0 && name[nameLength] == '[') {
+		arrayName = strndup(name, nameLength);
+		if(arrayName == NULL) {
+			return NULL;
+		}
+		if(_isListSubscript(name + nameLength)) {
+			*isSet = variableElementCount(arrayName) > 0;
+			free(arrayName);
+		} else {
+			/* The subscript is only evaluated once, it may assign variables */
+			subscript = strndup(name + nameLength + 1, strlen(name + nameLength) - 2);
+			expanded = subscript != NULL ? expansionExpandString(subscript, 0) : NULL;
+			element = expanded != NULL ? variableElement(arrayName, expanded) : NULL;
+			*isSet = element != NULL;
+			value.field.data = expanded != NULL ? strdup(element != NULL ? element : "") : NULL;
+			free(expanded);
+			free(subscript);
+			free(arrayName);
+			return value.field.data;
+		}
+	} else if(isdigit((unsigned char)name[0])) {
+		*isSet = variablePositional(atoi(name)) != NULL;
+	} else if(nameLength > 0) {
+		*isSet = variableGet(name) != NULL;
+	} else if(strchr("@*", name[0]) != NULL) {
+		*isSet = variablesPositionalCount() > 0;
+	}
+	if(_initializeWord(&value, 0, NULL) != 0) {
+		return NULL;
+	}
+	if(_appendParameter(&value, name, 1) != 0) {
+		free(value.pattern.data);
+		free(value.field.data);
+		return NULL;
+	}
+	free(value.pattern.data);
+	return value.field.data;
+}
+
+/*!
+ \brief Determine the length of the parameter name at the start of \a text,
+ i.e. a variable name with an optional subscript, a number or a special
+ parameter
+ */
+static size_t _parameterNameLength(const char *text)
+{
+	size_t length = 0;
+	if(isdigit((unsigned char)*text)) {
+		while(isdigit((unsigned char)text[length])) {
+			length++;
+		}
+		return length;
+	}
+	length = variableNameLength(text);
+	if(length > 0) {
+		return length + variableSubscriptLength(text + length);
+	}
+	return *text != '\0' && strchr("?#$@*", *text) != NULL;
+}
+
+/*!
+ \brief Indicate whether characters \a start up to \a end of \a value match
+ \a pattern
+
+ The pattern is compared directly if it does not contain any pattern
+ characters, otherwise it is matched with fnmatch().
+ */
+static int _matches(const char *pattern, int isLiteral, char *value, size_t start, size_t end)
+{
+	char saved;
+	int isMatching;
+	if(isLiteral) {
+		return strlen(pattern) == end - start && memcmp(pattern, value + start, end - start) == 0;
+	}
+	saved = value[end];
+	value[end] = '\0';
+	isMatching = fnmatch(pattern, value + start, 0) == 0;
+	value[end] = saved;
+	return isMatching;
+}
+
+static int _isLiteral(const char *pattern)
+{
+	return strpbrk(pattern, "*?[\\") == NULL;
+}
+
+/*!
+ \brief Remove the shortest or longest prefix (\c #, \c ##) or suffix
+ (\c %, \c %%) of \a value matching \a pattern
+ \return \a value, or the remaining part within it
+ */
+static char *_removeMatch(char *value, const char *pattern, int operator, int isLongest)
+{
+	size_t length = strlen(value);
+	size_t index;
+	size_t position;
+	int isLiteral = _isLiteral(pattern);
+	for(index = 0; index <= length; index++) {
+		if(operator == '#') {
+			position = isLongest ? length - index : index;
+			if(_matches(pattern, isLiteral, value, 0, position)) {
+				return value + position;
+			}
+		} else {
+			position = isLongest ? index : length - index;
+			if(_matches(pattern, isLiteral, value, position, length)) {
+				value[position] = '\0';
+				return value;
+			}
+		}
+	}
+	return value;
+}
+
+/*!
+ \brief Find the longest match of \a pattern starting at \a position
+ \param isAtEnd whether the match has to extend to the end of \a value
+ \param end receives the end of the match
+ \return \c 1 if there is a match, \c 0 otherwise
+ */
+static int _longestMatch(const char *pattern, int isLiteral, char *value, size_t position,
+	int isAtEnd, size_t *end)
+{
+	size_t length = strlen(value);
+	size_t patternLength;
+	size_t index;
+	if(isAtEnd) {
+		*end = length;
+		return _matches(pattern, isLiteral, value, position, length);
+	}
+	if(isLiteral) {
+		patternLength = strlen(pattern);
+		*end = position + patternLength;
+		return patternLength <= length - position
+			&& memcmp(pattern, value + position, patternLength) == 0;
+	}
+	for(index = length + 1; index-- > position;) {
+		if(_matches(pattern, 0, value, position, index)) {
+			*end = index;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*!
+ \brief Replace the first, or every, match of \a pattern in \a value
+ \param anchor \c '#' to only match a prefix, \c '%' to only match a suffix,
+ \c '/' to replace every match, or \c 0
+ \return newly allocated result, or \c NULL on error
+ */
+static char *_replaceMatches(char *value, const char *pattern, const char *replacement, int anchor)
+{
+	expansion_buffer_t result;
+	size_t length = strlen(value);
+	size_t position = 0;
+	size_t end;
+	int isLiteral = _isLiteral(pattern);
+	int isReplaced = 0;
+	int status = 0;
+	result.length = 0;
+	result.size = length + 1;
+	result.data = malloc(result.size);
+	if(result.data == NULL) {
+		return NULL;
+	}
+	result.data[0] = '\0';
+	while(position <= length && status == 0) {
+		if(*pattern != '\0' && (!isReplaced || anchor == '/') && (anchor != '#' || position == 0)
+		&& _longestMatch(pattern, isLiteral, value, position, anchor == '%', &end)) {
+			status = _bufferAppend(&result, replacement, strlen(replacement));
+			isReplaced = 1;
+			if(end > position) {
+				position = end;
+				continue;
+			}
+		}
+		if(position < length && status == 0) {
+			status = _bufferAppend(&result, value + position, 1);
+		}
+		position++;
+	}
+	if(status != 0) {
+		free(result.data);
+		return NULL;
+	}
+	return result.data;
+}
+
+/*!
+ \brief Keep the part of \a value given by \a range, \c "offset" or
+ \c "offset:length", both being arithmetic expressions
+
+ A negative offset counts from the end of \a value, as does a negative
+ length.
+
+ \return the part within \a value, or \c NULL on error
+ */
+static char *_substring(char *value, const char *range)
+{
+	long long length = (long long)strlen(value);
+	long long offset;
+	long long count;
+	const char *separator;
+	int depth = 0;
+	for(separator = range; *separator != '\0' && (*separator != ':' || depth > 0); separator++) {
+		depth += *separator == '(' ? 1 : *separator == ')' ? -1 : 0;
+	}
+	if(arithmeticEvaluate(range, separator - range, &offset) != 0) {
+		return NULL;
+	}
+	if(offset < 0) {
+		offset = offset + length < 0 ? length : offset + length;
+	}
+	if(offset > length) {
+		offset = length;
+	}
+	if(*separator == ':') {
+		if(arithmeticEvaluate(separator + 1, strlen(separator + 1), &count) != 0) {
+			return NULL;
+		}
+		if(count < 0) {
+			count += length - offset;
+			if(count < 0) {
+				fprintf(stderr, "mush: %s: substring expression < 0\n", separator + 1);
+				return NULL;
+			}
+		}
+		if(count < length - offset) {
+			value[offset + count] = '\0';
+		}
+	}
+	return value + offset;
+}
+
+/*!
+ \brief Convert the first, or every, character of \a value matching
+ \a pattern to upper or lower case
+ \param pattern the pattern, or an empty string to convert any character
+ */
+static void _convertCase(char *value, const char *pattern, int isUpper, int isAll)
+{
+	char character[2] = {'\0', '\0'};
+	for(; *value != '\0'; value++) {
+		character[0] = *value;
+		if(*pattern == '\0' || fnmatch(pattern, character, 0) == 0) {
+			*value = isUpper ? toupper((unsigned char)*value) : tolower((unsigned char)*value);
+		}
+		if(!isAll) {
+			break;
+		}
+	}
+}
+
+/*!
+ \brief Find the \c / separating the pattern of \c ${name/pattern/string}
+ from the replacement, skipping quoted characters
+ \return the separator, or the end of \a text if there is none
+ */
+static char *_findReplacement(char *text)
+{
+	char quote = 0;
+	for(; *text != '\0' && (quote != 0 || *text != '/'); text++) {
+		if(*text == '\\' && quote != '\'' && text[1] != '\0') {
+			text++;
+		} else if(quote == 0 && (*text == '\'' || *text == '"')) {
+			quote = *text;
+		} else if(*text == quote) {
+			quote = 0;
+		}
+	}
+	return text;
+}
+
+static int _badSubstitution(const char *content)
+{
+	fprintf(stderr, "mush: ${%s}: bad substitution\n", content);
+	return -1;
+}
+
+/*!
+ \brief Expand \c ${content}, applying the operator following the name of
+ the parameter, if any
+ */
+static int _expandBraced(expansion_word_t *word, char *content, int isQuoted)
+{
+	char number[32];
+	char *name;
+	char *operator;
+	char *argument = NULL;
+	char *replacement = NULL;
+	char *separator;
+	char *value;
+	char *result;
+	char *allocated = NULL;
+	size_t nameLength;
+	int isSet;
+	int isColon;
+	int anchor;
+	int status = 0;
+	/* ${#name} is the length of the value, ${#} is the amount of parameters */
+	if(content[0] == '#' && content[1] != '\0' && _parameterNameLength(content + 1) == strlen(content + 1)) {
+		nameLength = variableNameLength(content + 1);
+		if(content[1] == '@' || content[1] == '*') {
+			snprintf(number, sizeof(number), "%d", variablesPositionalCount());
+		} else if(nameLength > 0 && _isListSubscript(content + 1 + nameLength)) {
+			/* ${#name[@]} is the amount of elements */
+			content[1 + nameLength] = '\0';
+			snprintf(number, sizeof(number), "%zu", variableElementCount(content + 1));
+		} else {
+			value = _parameterValue(content + 1, &isSet);
+			if(value == NULL) {
+				return -1;
+			}
+			snprintf(number, sizeof(number), "%zu", strlen(value));
+			free(value);
+		}
+		return _appendValue(word, number, isQuoted);
+	}
+	/* ${!name[@]} are the keys or indices of an array */
+	nameLength = variableNameLength(content + 1);
+	if(content[0] == '!' && nameLength > 0 && _isListSubscript(content + 1 + nameLength)) {
+		return _appendElements(word, content + 1, nameLength, 1, isQuoted);
+	}
+	nameLength = _parameterNameLength(content);
+	if(nameLength == 0) {
+		return _badSubstitution(content);
+	}
+	operator = content + nameLength;
+	if(*operator == '\0') {
+		return _appendParameter(word, content, isQuoted);
+	}
+	name = strndup(content, nameLength);
+	value = name != NULL ? _parameterValue(name, &isSet) : NULL;
+	if(value == NULL) {
+		free(name);
+		return -1;
+	}
+	result = value;
+	isColon = operator[0] == ':' && operator[1] != '\0' && strchr("-=+?", operator[1]) != NULL;
+	switch(operator[isColon]) {
+		case '-':
+		case '=':
+		case '+':
+		case '?':
+			/* With a colon an empty value counts as unset */
+			isSet = isSet && !(isColon && *value == '\0');
+			if(isSet == (operator[isColon] == '+')) {
+				allocated = expansionExpandString(operator + isColon + 1, 0);
+				result = allocated;
+			} else if(operator[isColon] == '+') {
+				result = "";
+			}
+			if(isSet || result == NULL) {
+				break;
+			}
+			if(operator[isColon] == '?') {
+				fprintf(stderr, "mush: %s: %s\n", name,
+					*result != '\0' ? result : "parameter null or not set");
+				result = NULL;
+			} else if(operator[isColon] == '=') {
+				if(variableNameLength(name) != nameLength) {
+					fprintf(stderr, "mush: $%s: cannot assign in this way\n", name);
+					result = NULL;
+				} else if(variableSet(name, result) != 0) {
+					result = NULL;
+				}
+			}
+			break;
+		case ':':
+			result = _substring(value, operator + 1);
+			break;
+		case '#':
+		case '%':
+			argument = expansionExpandString(operator + 1 + (operator[1] == operator[0]), 1);
+			result = argument != NULL
+				? _removeMatch(value, argument, operator[0], operator[1] == operator[0]) : NULL;
+			break;
+		case '/':
+			/* ${name//pattern/string} replaces every match, # and % anchor it */
+			anchor = operator[1] != '\0' && strchr("/#%", operator[1]) != NULL ? operator[1] : 0;
+			operator += anchor != 0 ? 2 : 1;
+			separator = _findReplacement(operator);
+			if(*separator == '/') {
+				*separator++ = '\0';
+			}
+			argument = expansionExpandString(operator, 1);
+			replacement = expansionExpandString(separator, 0);
+			if(argument != NULL && replacement != NULL) {
+				allocated = _replaceMatches(value, argument, replacement, anchor);
+			}
+			result = allocated;
+			break;
+		case '^':
+		case ',':
+			argument = expansionExpandString(operator + 1 + (operator[1] == operator[0]), 1);
+			if(argument != NULL) {
+				_convertCase(value, argument, operator[0] == '^', operator[1] == operator[0]);
+			}
+			result = argument != NULL ? value : NULL;
+			break;
+		default:
+			result = NULL;
+			_badSubstitution(content);
+	}
+	status = result != NULL ? _appendValue(word, result, isQuoted) : -1;
+	free(allocated);
+	free(argument);
+	free(replacement);
+	free(value);
+	free(name);
+	return status;
+}
+
+/*!
+ \brief Expand the parameter at \a *wordPtr, which points to the \c $
+
+ \a *wordPtr is advanced to the last character of the expansion.
+ */
+static int _expandParameter(expansion_word_t *word, const char **wordPtr, int isQuoted)
+{
+	const char *ptr = *wordPtr + 1;
+	char number[32];
+	char *content;
+	char *expanded;
+	size_t length;
+	int status;
+	const char *end;
+	long long result;
+	if(ptr[0] == '(' && ptr[1] == '(' && (end = arithmeticFindEnd(ptr + 2)) != NULL) {
+		/* Expressions are evaluated as they are written, unless they contain
+		   expansions with operators or subscripts */
+		content = NULL;
+		if(memmem(ptr + 2, end - ptr - 2, "${", 2) != NULL) {
+			content = strndup(ptr + 2, end - ptr - 2);
+			expanded = content != NULL ? expansionExpandString(content, 0) : NULL;
+			free(content);
+			content = expanded;
+			if(content == NULL) {
+				return -1;
+			}
+		}
+		status = content != NULL ? arithmeticEvaluate(content, strlen(content), &result)
+			: arithmeticEvaluate(ptr + 2, end - ptr - 2, &result);
+		free(content);
+		if(status != 0) {
+			return -1;
+		}
+		*wordPtr = end + 1;
+		snprintf(number, sizeof(number), "%lld", result);
+		return _appendValue(word, number, isQuoted);
+	}
+	if(*ptr == '{') {
+		end = expansionFindParameterEnd(ptr + 1);
+		if(end == NULL) {
+			return _appendCharacter(word, '$', isQuoted);
+		}
+		content = strndup(ptr + 1, end - ptr - 1);
+		*wordPtr = end;
+		status = content != NULL ? _expandBraced(word, content, isQuoted) : -1;
+		free(content);
+		return status;
+	}
+	length = variableNameLength(ptr);
+	if(length == 0 && *ptr != '\0' && strchr("0123456789?#$@*", *ptr) != NULL) {
+		length = 1;
+	}
+	if(length == 0) {
+		return _appendCharacter(word, '$', isQuoted);
+	}
+	content = strndup(ptr, length);
+	*wordPtr = ptr + length - 1;
+	status = content != NULL ? _appendParameter(word, content, isQuoted) : -1;
+	free(content);
+	return status;
+}
+
+/*!
+ \brief Expand parameters in \a word and remove its quotes
+
+ If \a state->isSplit is set, unquoted expansions end the current field at
+ white space and each completed field is appended to \a state->arguments.
+ The last field is left in \a state->field and \a state->pattern.
+
+ \return \c 0 on success, \c -1 on error
+ */
+static int _expandWord(const char *word, expansion_word_t *state)
+{
+	char quote = 0;
+	int status = 0;
+	state->isPattern = 0;
+	state->isStarted = 0;
+	for(; *word != '\0' && status == 0; word++) {
+		if(quote == 0 && (*word == '\'' || *word == '"')) {
+			quote = *word;
+			state->isStarted = 1;
+		} else if(quote != 0 && *word == quote) {
+			quote = 0;
+		} else if(*word == '$' && quote != '\'') {
+			status = _expandParameter(state, &word, quote != 0);
+		} else if(*word == '\\' && quote != '\'' && word[1] != '\0'
+			&& (quote == 0 || strchr("$`\"\\", word[1]) != NULL)) {
+			/* A backslash quotes the next character */
+			word++;
+			status = _appendCharacter(state, *word, 1);
+		} else {
+			status = _appendCharacter(state, *word, quote != 0);
+		}
+	}
+	return status;
+}
+
+static int _initializeWord(expansion_word_t *word, int isSplit, expansion_arguments_t *arguments)
+{
+	word->field.size = 64;
+	word->field.length = 0;
+	word->field.data = malloc(word->field.size);
+	word->pattern.size = 64;
+	word->pattern.length = 0;
+	word->pattern.data = malloc(word->pattern.size);
+	if(word->field.data == NULL || word->pattern.data == NULL) {
+		free(word->field.data);
+		free(word->pattern.data);
+		return -1;
+	}
+	word->field.data[0] = '\0';
+	word->pattern.data[0] = '\0';
+	word->isSplit = isSplit;
+	word->arguments = arguments;
+	return 0;
+}
+
+/*!
+ \brief Indicate whether \a word is \c "$@" without parameters or
+ \c "${name[@]}" without elements, which expand to no field at all
+ */
+static int _isEmptyList(const char *word)
+{
+	size_t length = strlen(word);
+	size_t nameLength;
+	char *name;
+	size_t count;
+	if(strcmp(word, "\"$@\"") == 0 || strcmp(word, "\"${@}\"") == 0) {
+		return variablesPositionalCount() == 0;
+	}
+	nameLength = strncmp(word, "\"${", 3) == 0 ? variableNameLength(word + 3) : 0;
+	if(nameLength == 0 || length != nameLength + 8 || strcmp(word + 3 + nameLength, "[@]}\"") != 0) {
+		return 0;
+	}
+	name = strndup(word + 3, nameLength);
+	if(name == NULL) {
+		return 0;
+	}
+	count = variableElementCount(name);
+	free(name);
+	return count == 0;
+}
+
+char **expansionExpandWords(char **words, int *count)
+{
+	expansion_arguments_t arguments;
+	expansion_word_t word;
+	int status = 0;
+	arguments.size = 8;
+	arguments.count = 0;
+	arguments.arguments = malloc(arguments.size * sizeof(*arguments.arguments));
+	if(arguments.arguments == NULL) {
+		return NULL;
+	}
+	arguments.arguments[0] = NULL;
+	if(_initializeWord(&word, 1, &arguments) != 0) {
+		free(arguments.arguments);
+		return NULL;
+	}
+	for(; *words != NULL && status == 0; words++) {
+		if(_isEmptyList(*words)) {
+			continue;
+		}
+		status = _expandWord(*words, &word);
+		if(status == 0) {
+			status = _finishField(&word);
+		}
+	}
+	free(word.field.data);
+	free(word.pattern.data);
+	if(status != 0) {
+		expansionFree(arguments.arguments);
+		return NULL;
+	}
+	*count = arguments.count;
+	return arguments.arguments;
+}
+
+char *expansionExpandString(const char *string, int isPattern)
+{
+	expansion_word_t word;
+	if(_initializeWord(&word, 0, NULL) != 0) {
+		return NULL;
+	}
+	if(_expandWord(string, &word) != 0) {
+		free(word.field.data);
+		free(word.pattern.data);
+		return NULL;
+	}
+	if(isPattern) {
+		free(word.field.data);
+		return word.pattern.data;
+	}
+	free(word.pattern.data);
+	return word.field.data;
+}
+
+char **expansionSplitWords(const char *text)
+{
+	expansion_arguments_t words;
+	const char *start;
+	const char *end;
+	char quote;
+	words.size = 8;
+	words.count = 0;
+	words.arguments = malloc(words.size * sizeof(*words.arguments));
+	if(words.arguments == NULL) {
+		return NULL;
+	}
+	words.arguments[0] = NULL;
+	while(*text != '\0') {
+		if(isspace((unsigned char)*text)) {
+			text++;
+			continue;
+		}
+		start = text;
+		for(quote = 0; *text != '\0' && (quote != 0 || !isspace((unsigned char)*text)); text++) {
+			if(*text == '\\' && quote != '\'' && text[1] != '\0') {
+				text++;
+			} else if(*text == quote) {
+				quote = 0;
+			} else if(quote == 0 && (*text == '\'' || *text == '"')) {
+				quote = *text;
+			} else if(quote != '\'' && strncmp(text, "${", 2) == 0
+				&& (end = expansionFindParameterEnd(text + 2)) != NULL) {
+				text = end;
+			} else if(quote != '\'' && strncmp(text, "$((", 3) == 0
+				&& (end = arithmeticFindEnd(text + 3)) != NULL) {
+				text = end + 1;
+			}
+		}
+		if(_appendArgument(&words, strndup(start, text - start)) != 0) {
+			expansionFree(words.arguments);
+			return NULL;
+		}
+	}
+	return words.arguments;
+}
+
+const char *expansionFindParameterEnd(const char *text)
+{
+	char quote = 0;
+	int depth = 0;
+	for(; *text != '\0'; text++) {
+		if(*text == '\\' && quote != '\'' && text[1] != '\0') {
+			text++;
+		} else if(quote == 0 && (*text == '\'' || *text == '"')) {
+			quote = *text;
+		} else if(*text == quote) {
+			quote = 0;
+		} else if(quote != '\'' && text[0] == '$' && text[1] == '{') {
+			depth++;
+			text++;
+		} else if(quote != '\'' && *text == '}') {
+			if(depth == 0) {
+				return text;
+			}
+			depth--;
+		}
+	}
+	return NULL;
+}
+
+void expansionFree(char **arguments)
+{
+	char **argument;
+	if(arguments == NULL) {
+		return;
+	}
+	for(argument = arguments; *argument != NULL; argument++) {
+		free(*argument);
+	}
+	free(arguments);
+}
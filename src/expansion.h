@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef EXPANSION_H
+#define EXPANSION_H
+
+/*!
+ \addtogroup expansion
+ \{
+ */
+
+/*!
+ \brief Expand the words of a command into the arguments of a program
+
+ Parameters (\c $name, \c ${name}, \c $1, \c $#, \c $?, \c $@ ...) are
+ replaced by their values. Within braces the value may be changed by an
+ operator: defaults (\c ${name:-word}, \c :=, \c :+, \c :?), the length
+ (\c ${#name}), removing a prefix or suffix matching a pattern (\c #, \c ##,
+ \c %, \c %%), replacing matches (\c ${name/pattern/string}, \c //, \c /#,
+ \c /%), substrings (\c ${name:offset:length}) and case conversion (\c ^,
+ \c ^^, \c ,, \c ,,). Elements of arrays are expanded with
+ \c ${name[subscript]}. Unquoted values are split into separate arguments
+ at white space, while \c "$@" becomes one argument per positional parameter
+ and \c "${name[@]}" one per element.
+ Words containing unquoted pattern characters (\c *, \c ? and \c [) are
+ replaced by the matching path names, if any; characters resulting from an
+ expansion never act as a pattern. Quotes and backslashes are removed, so
+ \c "'a b'" becomes the single argument \c "a b".
+
+ \param words \c NULL terminated words as parsed
+ \param count receives the amount of expanded arguments
+ \return \c NULL terminated array of arguments, to be freed with
+ expansionFree(), or \c NULL on error
+ */
+char **expansionExpandWords(char **words, int *count);
+
+/*!
+ \brief Expand a single word without splitting it or expanding path names
+
+ This is used where exactly one string results from a word, such as the
+ value of an assignment or the word of a \c case.
+
+ \param string the word as parsed
+ \param isPattern if set, quoted characters are escaped so the result can be
+ matched with fnmatch()
+ \return newly allocated string, or \c NULL on error
+ */
+char *expansionExpandString(const char *string, int isPattern);
+
+/*!
+ \brief Split \a text into words at unquoted blanks, without expanding them
+
+ Blanks within quotes, \c ${...} and \c $((...)) do not end a word.
+
+ \return \c NULL terminated words, to be freed with expansionFree(), or
+ \c NULL on error
+ */
+char **expansionSplitWords(const char *text);
+
+/*!
+ \brief Find the end of a parameter expansion in braces, skipping nested
+ expansions and quoted characters
+ \param text the expansion, following \c ${
+ \return pointer to the closing \c }, or \c NULL if there is none
+ */
+const char *expansionFindParameterEnd(const char *text);
+
+/*!
+ \brief Free arguments returned by expansionExpandWords()
+ \param arguments the arguments to be freed
+ */
+void expansionFree(char **arguments);
+
+/*!
+ \}
+ */
+
+#endif /* EXPANSION_H */
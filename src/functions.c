@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "functions.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "exec.h"
+#include "hash.h"
+#include "mush_error.h"
+#include "variables.h"
+
+/*! \brief Amount of buckets of the function table, a power of two */
+#define FUNCTIONS_BUCKET_COUNT 64
+
+/*! \brief Functions, chained by the hash of their name */
+static function_t *_buckets[FUNCTIONS_BUCKET_COUNT];
+
+/*!
+ \brief Bucket of \a name
+ */
+static unsigned int _hash(const char *name)
+{
+	return hashString(name) & (FUNCTIONS_BUCKET_COUNT - 1);
+}
+
+int functionDefine(const char *name, script_t *body)
+{
+	function_t *function = functionLookup(name);
+	unsigned int bucket;
+	if(function == NULL) {
+		function = malloc(sizeof(*function));
+		if(function == NULL) {
+			return -1;
+		}
+		function->name = strdup(name);
+		if(function->name == NULL) {
+			free(function);
+			return -1;
+		}
+		function->body = NULL;
+		bucket = _hash(name);
+		function->next = _buckets[bucket];
+		_buckets[bucket] = function;
+	}
+	/* A running function may be redefining itself, it keeps its own
+	   reference to the previous body */
+	scriptFree(function->body);
+	function->body = scriptRetain(body);
+	return 0;
+}
+
+function_t *functionLookup(const char *name)
+{
+	function_t *function;
+	for(function = _buckets[_hash(name)]; function != NULL; function = function->next) {
+		if(strcmp(function->name, name) == 0) {
+			return function;
+		}
+	}
+	return NULL;
+}
+
+void functionsReset()
+{
+	function_t *function;
+	size_t bucket;
+	for(bucket = 0; bucket < FUNCTIONS_BUCKET_COUNT; bucket++) {
+		while(_buckets[bucket] != NULL) {
+			function = _buckets[bucket];
+			_buckets[bucket] = function->next;
+			scriptFree(function->body);
+			free(function->name);
+			free(function);
+		}
+	}
+}
+
+int functionCall(function_t *function, int argc, char **argv)
+{
+	variables_positional_t saved;
+	script_t *body;
+	int status;
+	if(variablesPushPositional(argc, argv, &saved) != 0) {
+		return 1;
+	}
+	body = scriptRetain(function->body);
+	status = scriptExecute(body);
+	scriptFree(body);
+	variablesPopPositional(&saved);
+	if(status != kMushNoError) {
+		fprintf(stderr, "mush: %s: %s\n", argv[0], mushErrorDescription());
+		setMushError(kMushNoError);
+		return 1;
+	}
+	return executeLastStatus();
+}
+
+int cmd_return(int argc, char **argv)
+{
+	if(argc > 1) {
+		return atoi(argv[1]) & 0xff;
+	}
+	return executeLastStatus();
+}
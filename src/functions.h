@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FUNCTIONS_H
+#define FUNCTIONS_H
+
+#include "script.h"
+
+/*!
+ \addtogroup functions
+ \{
+ */
+
+/*! \brief A shell function */
+typedef struct __function_t {
+	/*! \brief name of the function */
+	char *name;
+	/*! \brief compiled commands of the function */
+	script_t *body;
+	/*! \brief next function in the same bucket */
+	struct __function_t *next;
+} function_t;
+
+/*!
+ \brief Define the function \a name, replacing any previous definition
+
+ The body is kept in its compiled form, it is not compiled again when the
+ function is called.
+
+ \param name name of the function
+ \param body compiled commands, retained until the function is redefined
+ \return \c 0 on success, \c -1 on error
+ */
+int functionDefine(const char *name, script_t *body);
+
+/*!
+ \brief Find the function called \a name
+ \return the function, or \c NULL if there is none
+ */
+function_t *functionLookup(const char *name);
+
+/*!
+ \brief Forget every function, as a new shell would
+ */
+void functionsReset();
+
+/*!
+ \brief Execute \a function in the shell process
+
+ The arguments become the positional parameters while the function runs.
+
+ \param function the function to be called
+ \param argc count of elements in \a argv
+ \param argv the name of the function followed by its arguments
+ \return exit status of the last command executed by the function
+ */
+int functionCall(function_t *function, int argc, char **argv);
+
+/*!
+ \brief Run the builtin "return" command
+
+ The status becomes that of the function, the compiled script stops
+ executing after the command.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return the given status, or that of the last command
+ */
+int cmd_return(int argc, char **argv);
+
+/*!
+ \}
+ */
+
+#endif /* FUNCTIONS_H */
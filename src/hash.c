@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "hash.h"
+
+#define HASH_OFFSET_BASIS 2166136261u
+#define HASH_PRIME 16777619u
+
+unsigned int hashString(const char *text)
+{
+	unsigned int hash = HASH_OFFSET_BASIS;
+	for(; *text != '\0'; text++) {
+		hash = (hash ^ (unsigned char)*text) * HASH_PRIME;
+	}
+	return hash;
+}
+
+unsigned int hashBytes(const char *text, size_t length)
+{
+	unsigned int hash = HASH_OFFSET_BASIS;
+	for(; length > 0; text++, length--) {
+		hash = (hash ^ (unsigned char)*text) * HASH_PRIME;
+	}
+	return hash;
+}
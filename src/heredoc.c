@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "heredoc.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <errno.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#include "redirection.h"
+
+/*!
+ \brief Write \a length bytes of \a buffer to \a fd, retrying partial writes
+ \return \c 0 on success, \c -1 on error
+ */
+static int _writeAll(int fd, const char *buffer, size_t length)
+{
+	ssize_t written;
+	while(length > 0) {
+		written = write(fd, buffer, length);
+		if(written == -1) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		buffer += written;
+		length -= written;
+	}
+	return 0;
+}
+
+static int _pipeDescriptor(const char *contents, size_t length)
+{
+	int pipeDescriptors[2];
+	pid_t pid;
+	if(redirectionPipe(pipeDescriptors) != 0) {
+		return -1;
+	}
+	/* Contents up to PIPE_BUF are guaranteed to fit without blocking */
+	if(length <= PIPE_BUF) {
+		_writeAll(pipeDescriptors[1], contents, length);
+		close(pipeDescriptors[1]);
+		return pipeDescriptors[0];
+	}
+	pid = fork();
+	if(pid == -1) {
+		close(pipeDescriptors[0]);
+		close(pipeDescriptors[1]);
+		return -1;
+	} else if(pid == 0) {
+		close(pipeDescriptors[0]);
+		_writeAll(pipeDescriptors[1], contents, length);
+		_exit(EXIT_SUCCESS);
+	}
+	close(pipeDescriptors[1]);
+	return pipeDescriptors[0];
+}
+
+#if defined(MFD_ALLOW_SEALING)
+static int _memoryFileDescriptor(const char *contents, size_t length)
+{
+	int fd;
+	fd = memfd_create("mush-heredoc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if(fd == -1) {
+		return -1;
+	}
+	if(_writeAll(fd, contents, length) != 0) {
+		close(fd);
+		return -1;
+	}
+	/* The command only ever reads the contents */
+	fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+	if(lseek(fd, 0, SEEK_SET) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+#endif
+
+int hereDocumentDescriptor(const char *contents)
+{
+	size_t length = strlen(contents);
+#if defined(MFD_ALLOW_SEALING)
+	int fd;
+	if(length > PIPE_BUF) {
+		fd = _memoryFileDescriptor(contents, length);
+		if(fd != -1) {
+			return fd;
+		}
+	}
+#endif
+	return _pipeDescriptor(contents, length);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HEREDOC_H
+#define HEREDOC_H
+
+/*!
+ \addtogroup heredoc
+ \{
+ */
+
+/*!
+ \brief Create a file descriptor from which \a contents can be read
+
+ Small contents are written into a pipe, which can hold them without blocking.
+ Larger contents are written into an anonymous memory file (memfd_create())
+ which is sealed against further modification, so no file system I/O takes
+ place. On systems without anonymous memory files a child process feeds the
+ contents into a pipe instead.
+
+ The descriptor is opened with \c O_CLOEXEC and should be duplicated onto the
+ input of the command and closed by the caller.
+
+ \param contents the here-document contents
+ \return a readable file descriptor positioned at the start of \a contents, or
+ \c -1 on error
+ */
+int hereDocumentDescriptor(const char *contents);
+
+/*!
+ \}
+ */
+
+#endif /* HEREDOC_H */
@@ -0,0 +1,546 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "jobs.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include "command.h"
+#include "exec.h"
+#include "redirection.h"
+
+/*! \brief Slot limit derived from the processors and load average */
+#define JOBS_SLOT_LIMIT_LOAD 0
+
+/*! \brief Jobs in order of submission */
+static job_t *_jobs = NULL;
+/*! \brief Configured slot limit, or \c JOBS_SLOT_LIMIT_LOAD */
+static int _slotLimit = 1;
+/*! \brief Written to by the SIGCHLD handler */
+static int _signalPipe[2] = {-1, -1};
+/*! \brief Process which created \a _signalPipe */
+static pid_t _signalPipeOwner = -1;
+/*! \brief Whether the shell reads commands from a terminal */
+static int _isInteractive = 0;
+
+static void _signalHandler(int signal)
+{
+	int savedErrno = errno;
+	write(_signalPipe[1], "", 1);
+	errno = savedErrno;
+}
+
+/*!
+ \brief Create the pipe written to by the SIGCHLD handler
+ \return \c 0 on success, \c -1 on error
+ */
+static int _openSignalPipe()
+{
+	if(redirectionPipe(_signalPipe) != 0) {
+		return -1;
+	}
+	_signalPipe[0] = redirectionMoveAside(_signalPipe[0]);
+	_signalPipe[1] = redirectionMoveAside(_signalPipe[1]);
+	fcntl(_signalPipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(_signalPipe[1], F_SETFL, O_NONBLOCK);
+	_signalPipeOwner = getpid();
+	return 0;
+}
+
+/*!
+ \brief Install the SIGCHLD handler writing to the signal pipe
+ \param previousAction receives the previous action, or \c NULL
+ \return \c 0 on success, \c -1 on error
+ */
+static int _setSignalHandler(struct sigaction *previousAction)
+{
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = _signalHandler;
+	action.sa_flags = SA_RESTART;
+	sigfillset(&action.sa_mask);
+	return sigaction(SIGCHLD, &action, previousAction);
+}
+
+void jobsInitialize()
+{
+	char *slots;
+	if(_openSignalPipe() != 0 || _setSignalHandler(NULL) != 0) {
+		fprintf(stderr, "mush: unable to setup signal handler\n");
+		exit(1);
+	}
+	slots = getenv("MUSH_JOB_SLOTS");
+	if(slots != NULL && strcmp(slots, "load") == 0) {
+		jobsSetSlotLimit(JOBS_SLOT_LIMIT_LOAD);
+	} else if(slots != NULL && atoi(slots) > 0) {
+		jobsSetSlotLimit(atoi(slots));
+	} else {
+		jobsSetSlotLimit((int)sysconf(_SC_NPROCESSORS_ONLN));
+	}
+}
+
+int jobsSignalDescriptor()
+{
+	return _signalPipe[0];
+}
+
+void jobsSetSlotLimit(int limit)
+{
+	_slotLimit = limit < 0 ? 1 : limit;
+}
+
+int jobsSlotLimit()
+{
+	long processors;
+	double load;
+	if(_slotLimit != JOBS_SLOT_LIMIT_LOAD) {
+		return _slotLimit;
+	}
+	/* Leave the processors busy with other work alone */
+	processors = sysconf(_SC_NPROCESSORS_ONLN);
+	if(getloadavg(&load, 1) != 1) {
+		return (int)processors;
+	}
+	return (int)processors - (int)load > 1 ? (int)processors - (int)load : 1;
+}
+
+static size_t _runningCount()
+{
+	job_t *job;
+	size_t count = 0;
+	for(job = _jobs; job != NULL; job = job->next) {
+		if(job->state == kJobStateRunning) {
+			count++;
+		}
+	}
+	return count;
+}
+
+int jobsArePending()
+{
+	job_t *job;
+	for(job = _jobs; job != NULL; job = job->next) {
+		if(job->state != kJobStateDone) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*!
+ \brief Join the arguments of each command of \a pipeline with pipes
+ \return newly allocated string
+ */
+static char *_pipelineDescription(queue_t *pipeline)
+{
+	struct __queue_node_t *node;
+	command_t *command;
+	char *description = strdup("");
+	char *joined;
+	int argi;
+	for(node = pipeline->head; node != NULL && description != NULL; node = node->next) {
+		command = node->data;
+		for(argi = 0; argi < command->argc && command->argv[argi] != NULL; argi++) {
+			if(asprintf(&joined, "%s%s%s", description, *description != '\0' ? " " : "",
+				command->argv[argi]) == -1) {
+				joined = NULL;
+			}
+			free(description);
+			description = joined;
+			if(description == NULL) {
+				return NULL;
+			}
+		}
+		if(node->next != NULL) {
+			if(asprintf(&joined, "%s |", description) == -1) {
+				joined = NULL;
+			}
+			free(description);
+			description = joined;
+		}
+	}
+	return description;
+}
+
+static void _jobStart(job_t *job)
+{
+	int lastStatus;
+	executePipeline(job->pipeline, &job->pids, &job->pidCount, &lastStatus);
+	queueFree(job->pipeline);
+	job->pipeline = NULL;
+	job->runningCount = job->pidCount;
+	job->state = job->pidCount > 0 ? kJobStateRunning : kJobStateDone;
+}
+
+/*!
+ \brief Start queued jobs, in order, while slots are free
+ */
+static void _jobsAdmit()
+{
+	job_t *job;
+	size_t running = _runningCount();
+	for(job = _jobs; job != NULL; job = job->next) {
+		if(job->state != kJobStateQueued) {
+			continue;
+		}
+		/* At least one job always runs, so queued jobs make progress */
+		if(running > 0 && running >= (size_t)jobsSlotLimit()) {
+			return;
+		}
+		_jobStart(job);
+		if(job->state == kJobStateRunning) {
+			running++;
+		}
+	}
+}
+
+static void _jobsProcessExited(pid_t pid, int status)
+{
+	job_t *job;
+	size_t index;
+	for(job = _jobs; job != NULL; job = job->next) {
+		for(index = 0; index < job->pidCount; index++) {
+			if(job->pids[index] != pid) {
+				continue;
+			}
+			if(index == job->pidCount - 1) {
+				job->status = status;
+			}
+			job->runningCount--;
+			if(job->runningCount == 0) {
+				job->state = kJobStateDone;
+				_jobsAdmit();
+			}
+			return;
+		}
+	}
+}
+
+job_t *jobsSubmit(queue_t *pipeline)
+{
+	job_t *job;
+	job_t *last;
+	job = malloc(sizeof(*job));
+	if(job == NULL) {
+		queueFree(pipeline);
+		return NULL;
+	}
+	job->identifier = 1;
+	job->state = kJobStateQueued;
+	job->pids = NULL;
+	job->pidCount = 0;
+	job->runningCount = 0;
+	job->status = 0;
+	job->description = _pipelineDescription(pipeline);
+	job->pipeline = pipeline;
+	job->next = NULL;
+	if(_jobs == NULL) {
+		_jobs = job;
+	} else {
+		for(last = _jobs; last->next != NULL; last = last->next) {
+		}
+		job->identifier = last->identifier + 1;
+		last->next = job;
+	}
+	_jobsAdmit();
+	return job;
+}
+
+void jobsReap()
+{
+	char buffer[64];
+	pid_t pid;
+	int status;
+	while(read(_signalPipe[0], buffer, sizeof(buffer)) > 0) {
+	}
+	while((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		_jobsProcessExited(pid, status);
+	}
+}
+
+int jobsWaitForeground(pid_t *pids, size_t count)
+{
+	size_t remaining = count;
+	size_t index;
+	int status;
+	int lastStatus = 0;
+	pid_t pid;
+	while(remaining > 0) {
+		pid = waitpid(-1, &status, 0);
+		if(pid == -1) {
+			if(errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		for(index = 0; index < count && pids[index] != pid; index++) {
+		}
+		if(index == count) {
+			_jobsProcessExited(pid, status);
+			continue;
+		}
+		if(index == count - 1) {
+			lastStatus = status;
+		}
+		remaining--;
+	}
+	return lastStatus;
+}
+
+int jobsWaitUntil(pid_t pid, int timer, int *status)
+{
+	struct sigaction previousAction;
+	struct pollfd descriptors[2];
+	char buffer[64];
+	pid_t exited;
+	int waitStatus;
+	int result = -1;
+	/* A child of the shell must not consume the wake ups of the shell */
+	if(_signalPipe[0] == -1 || _signalPipeOwner != getpid()) {
+		if(_signalPipe[0] != -1) {
+			close(_signalPipe[0]);
+			close(_signalPipe[1]);
+		}
+		if(_openSignalPipe() != 0) {
+			_signalPipe[0] = -1;
+			_signalPipe[1] = -1;
+			return -1;
+		}
+	}
+	/* Children of the shell run with the default handler */
+	_setSignalHandler(&previousAction);
+	while(1) {
+		/* Reaping after draining the pipe misses no termination */
+		while(read(_signalPipe[0], buffer, sizeof(buffer)) > 0) {
+		}
+		while((exited = waitpid(-1, &waitStatus, WNOHANG)) > 0) {
+			if(exited == pid) {
+				*status = waitStatus;
+				result = 0;
+			} else {
+				_jobsProcessExited(exited, waitStatus);
+			}
+		}
+		if(result == 0 || (exited == -1 && errno == ECHILD)) {
+			break;
+		}
+		descriptors[0].fd = _signalPipe[0];
+		descriptors[0].events = POLLIN;
+		descriptors[1].fd = timer;
+		descriptors[1].events = POLLIN;
+		if(poll(descriptors, timer == -1 ? 1 : 2, -1) == -1) {
+			if(errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		if(timer != -1 && (descriptors[1].revents & POLLIN)) {
+			/* A timerfd holds the amount of expirations */
+			read(timer, buffer, sizeof(buffer));
+			result = 1;
+			break;
+		}
+	}
+	sigaction(SIGCHLD, &previousAction, NULL);
+	return result;
+}
+
+/*!
+ \brief Wait for \a job to terminate, or for every job if \a job is \c NULL
+
+ Queued jobs are started as running jobs terminate, so the awaited jobs are
+ eventually started as well.
+ */
+static void _jobsWaitFor(job_t *job)
+{
+	job_t *pending;
+	pid_t pid;
+	int status;
+	while(1) {
+		pending = job;
+		if(job == NULL) {
+			for(pending = _jobs; pending != NULL && pending->state == kJobStateDone;
+				pending = pending->next) {
+			}
+		}
+		if(pending == NULL || pending->state == kJobStateDone) {
+			return;
+		}
+		pid = waitpid(-1, &status, 0);
+		if(pid == -1) {
+			if(errno == EINTR) {
+				continue;
+			}
+			/* The jobs belong to the shell this process was forked from */
+			return;
+		}
+		_jobsProcessExited(pid, status);
+	}
+}
+
+void jobsSetInteractive(int isInteractive)
+{
+	_isInteractive = isInteractive;
+}
+
+void jobsFinish()
+{
+	/* Queued jobs would never start once a script or command string ends */
+	if(!_isInteractive) {
+		_jobsWaitFor(NULL);
+	}
+}
+
+static void _jobFree(job_t *job)
+{
+	if(job->pipeline != NULL) {
+		queueFree(job->pipeline);
+	}
+	free(job->pids);
+	free(job->description);
+	free(job);
+}
+
+void jobsReset()
+{
+	job_t *job;
+	/* The processes of the jobs are children of the shell, not this process */
+	while(_jobs != NULL) {
+		job = _jobs;
+		_jobs = job->next;
+		_jobFree(job);
+	}
+	close(_signalPipe[0]);
+	close(_signalPipe[1]);
+	jobsInitialize();
+}
+
+/*!
+ \brief Print the jobs, forgetting those that are done
+ \param isOnlyDone whether to only print jobs which are done
+ */
+static void _jobsPrint(int isOnlyDone)
+{
+	static const char *stateNames[] = {"Queued", "Running", "Done"};
+	job_t *job;
+	job_t **link = &_jobs;
+	while(*link != NULL) {
+		job = *link;
+		if(!isOnlyDone || job->state == kJobStateDone) {
+			printf("[%d]  %-8s %s\n", job->identifier, stateNames[job->state],
+				job->description != NULL ? job->description : "");
+		}
+		if(job->state == kJobStateDone) {
+			*link = job->next;
+			_jobFree(job);
+		} else {
+			link = &job->next;
+		}
+	}
+}
+
+void jobsNotify()
+{
+	_jobsPrint(1);
+}
+
+int cmd_jobs(int argc, char **argv)
+{
+	jobsReap();
+	if(argc > 1 && strcmp(argv[1], "-s") == 0) {
+		if(argc == 2) {
+			printf("%d\n", jobsSlotLimit());
+		} else if(strcmp(argv[2], "load") == 0) {
+			jobsSetSlotLimit(JOBS_SLOT_LIMIT_LOAD);
+		} else if(atoi(argv[2]) > 0) {
+			jobsSetSlotLimit(atoi(argv[2]));
+		} else {
+			fprintf(stderr, "jobs: invalid slot limit: %s\n", argv[2]);
+			return 1;
+		}
+		/* A higher limit may admit queued jobs */
+		_jobsAdmit();
+		return 0;
+	} else if(argc > 1) {
+		fprintf(stderr, "usage: jobs [-s [slots|load]]\n");
+		return 2;
+	}
+	_jobsPrint(0);
+	return 0;
+}
+
+/*!
+ \brief Find the job referred to by \a name, either \c "%n" for its number or
+ the process ID of one of its processes
+ \return the job, or \c NULL if there is no such job
+ */
+static job_t *_jobsLookup(const char *name)
+{
+	job_t *job;
+	size_t index;
+	for(job = _jobs; job != NULL; job = job->next) {
+		if(name[0] == '%' && atoi(name + 1) == job->identifier) {
+			return job;
+		}
+		for(index = 0; name[0] != '%' && index < job->pidCount; index++) {
+			if(job->pids[index] == (pid_t)atoi(name)) {
+				return job;
+			}
+		}
+	}
+	return NULL;
+}
+
+int cmd_wait(int argc, char **argv)
+{
+	job_t *job;
+	int argi;
+	int status = 0;
+	jobsReap();
+	if(argc == 1) {
+		_jobsWaitFor(NULL);
+		return 0;
+	}
+	for(argi = 1; argi < argc; argi++) {
+		job = _jobsLookup(argv[argi]);
+		if(job == NULL) {
+			fprintf(stderr, "wait: %s: no such job\n", argv[argi]);
+			status = 127;
+			continue;
+		}
+		_jobsWaitFor(job);
+		if(job->state != kJobStateDone) {
+			status = 127;
+		} else if(WIFSIGNALED(job->status)) {
+			status = 128 + WTERMSIG(job->status);
+		} else {
+			status = WEXITSTATUS(job->status);
+		}
+	}
+	return status;
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <sys/types.h>
+#include "queue.h"
+
+/*!
+ \addtogroup jobs
+ \{
+ */
+
+enum {
+	/*! \brief The job waits for a free slot */
+	kJobStateQueued = 0,
+	/*! \brief The processes of the job are running */
+	kJobStateRunning,
+	/*! \brief Every process of the job terminated */
+	kJobStateDone
+};
+
+/*! \brief A background pipeline */
+typedef struct __job_t {
+	/*! \brief number by which the job is referred to */
+	int identifier;
+	/*! \brief one of the \c kJobState values */
+	int state;
+	/*! \brief processes of the pipeline */
+	pid_t *pids;
+	/*! \brief amount of elements in \a pids */
+	size_t pidCount;
+	/*! \brief amount of processes which have not terminated yet */
+	size_t runningCount;
+	/*! \brief wait status of the last process of the pipeline */
+	int status;
+	/*! \brief command line of the pipeline */
+	char *description;
+	/*! \brief queue of \c command_t objects waiting to be started, or \a NULL
+	 once the job was started */
+	queue_t *pipeline;
+	/*! \brief next job in the job table */
+	struct __job_t *next;
+} job_t;
+
+/*!
+ \brief Set up the handling of terminating child processes
+
+ Must be called before any job is started. The slot limit defaults to the
+ value of the \c MUSH_JOB_SLOTS environment variable or, if it is not set,
+ the number of online processors.
+ */
+void jobsInitialize();
+
+/*!
+ \brief Forget the jobs of the shell in a child process, which then handles
+ its own children as jobsInitialize() does
+ */
+void jobsReset();
+
+/*!
+ \brief Return a descriptor which becomes readable when a child terminates
+
+ The descriptor can be polled while the shell waits for input. jobsReap()
+ should be called once it is readable.
+
+ \return readable descriptor, or \c -1 if jobsInitialize() was not called
+ */
+int jobsSignalDescriptor();
+
+/*!
+ \brief Run a pipeline in the background, or queue it if no slot is free
+
+ Queued jobs are started in order as running jobs terminate. Ownership of
+ \a pipeline is transferred to the job table.
+
+ \param pipeline queue of \c command_t objects, the last of which has the
+ \c kCommandConnectionBackground connection mask
+ \return the job, or \c NULL on error
+ */
+job_t *jobsSubmit(queue_t *pipeline);
+
+/*!
+ \brief Collect terminated background processes and start queued jobs
+ */
+void jobsReap();
+
+/*!
+ \brief Wait for the processes of a foreground pipeline to terminate
+
+ Background processes terminating in the mean time are collected as well,
+ so queued jobs start while the foreground pipeline runs.
+
+ \param pids processes of the pipeline, in order
+ \param count amount of elements in \a pids
+ \return wait status of the last process of the pipeline
+ */
+int jobsWaitForeground(pid_t *pids, size_t count);
+
+/*!
+ \brief Wait for the process \a pid to terminate or for \a timer to become
+ readable, whichever happens first
+
+ The termination of children is noticed through the same SIGCHLD handler
+ and descriptor as the jobs, which is set up for the duration of the call
+ in children of the shell as well. Background processes terminating in the
+ mean time are collected as jobsWaitForeground() does.
+
+ \param pid process to wait for
+ \param timer descriptor which becomes readable on a deadline, such as a
+ timerfd, or \c -1 to wait for \a pid alone
+ \param status receives the wait status of \a pid if it terminated
+ \return \c 0 if \a pid terminated, \c 1 if \a timer became readable first,
+ or \c -1 on error
+ */
+int jobsWaitUntil(pid_t pid, int timer, int *status);
+
+/*!
+ \brief Indicate whether any job is queued or running
+ \return \c 1 if a job has not terminated yet, \c 0 otherwise
+ */
+int jobsArePending();
+
+/*!
+ \brief Set the amount of background jobs which may run at once
+ \param limit amount of slots, or \c 0 to derive the amount from the number
+ of online processors and the load average
+ */
+void jobsSetSlotLimit(int limit);
+
+/*!
+ \brief Return the amount of background jobs which may run at once
+ \return amount of slots currently available to background jobs in total
+ */
+int jobsSlotLimit();
+
+/*!
+ \brief Print and forget jobs which terminated since they were last reported
+ */
+void jobsNotify();
+
+/*!
+ \brief Set whether the shell reads commands from a terminal
+ \param isInteractive \c 1 if the shell is interactive, \c 0 otherwise
+ */
+void jobsSetInteractive(int isInteractive);
+
+/*!
+ \brief Wait for the queued and running jobs before the shell exits
+
+ A shell running a script or command string waits for every job, starting
+ queued jobs as slots become free. An interactive shell leaves them alone.
+ */
+void jobsFinish();
+
+/*!
+ \addtogroup builtin
+ \{
+ */
+
+/*!
+ \brief Run the builtin "jobs" command
+
+ Without arguments, lists the queued, running and recently completed jobs.
+ \c "jobs -s" prints the slot limit, \c "jobs -s N" sets it and
+ \c "jobs -s load" derives it from the number of processors and the load
+ average.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return exit status of the command
+ */
+int cmd_jobs(int argc, char **argv);
+
+/*!
+ \brief Run the builtin "wait" command
+
+ Without arguments, waits for every queued and running job. Otherwise waits
+ for each job given by its number (\c "%n") or the process ID of one of its
+ processes.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return exit status of the last job waited for, or \c 127 if it is unknown
+ */
+int cmd_wait(int argc, char **argv);
+
+/*!
+ \}
+ */
+
+/*!
+ \}
+ */
+
+#endif /* JOBS_H */
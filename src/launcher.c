@@ -0,0 +1,670 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "launcher.h"
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#include "redirection.h"
+#include "mush_error.h"
+
+/*! \brief Most descriptors which can be passed along with a single request */
+#define LAUNCHER_DESCRIPTORS_MAX 32
+/*! \brief Size of the stack a launched process starts out on */
+#define LAUNCHER_STACK_SIZE (64 * 1024)
+
+extern char **environ;
+
+/*! \brief Resource limits a launched process takes from the shell, which may
+ have changed them since it forked the launcher ("ulimit") */
+static const int _limitResources[] = {
+	RLIMIT_CORE, RLIMIT_DATA, RLIMIT_FSIZE, RLIMIT_NOFILE,
+	RLIMIT_STACK, RLIMIT_CPU, RLIMIT_NPROC, RLIMIT_AS
+};
+/*! \brief Amount of elements in \a _limitResources */
+#define LAUNCHER_LIMIT_COUNT (sizeof(_limitResources) / sizeof(*_limitResources))
+
+/*! \brief Shell's end of the socket, or \c -1 if the launcher is not running */
+static int _socket = -1;
+/*! \brief Process ID of the launcher */
+static pid_t _launcherPid = -1;
+
+/*! \brief Growable buffer a request is serialized into */
+typedef struct __launcher_buffer_t {
+	char *data;
+	size_t length;
+	size_t size;
+} launcher_buffer_t;
+
+/*! \brief Position within a received request */
+typedef struct __launcher_reader_t {
+	const char *data;
+	size_t length;
+	size_t position;
+} launcher_reader_t;
+
+/*! \brief A decoded request, as seen by the launched process */
+typedef struct __launcher_request_t {
+	/*! \brief descriptor numbers in the shell */
+	int descriptors[LAUNCHER_DESCRIPTORS_MAX];
+	/*! \brief whether the corresponding descriptor is open in the shell */
+	int isPassed[LAUNCHER_DESCRIPTORS_MAX];
+	size_t descriptorCount;
+	/*! \brief descriptors received for those which are passed, in order */
+	int received[LAUNCHER_DESCRIPTORS_MAX];
+	size_t receivedCount;
+	queue_t *redirections;
+	const char *directory;
+	/*! \brief file mode creation mask of the shell */
+	int mask;
+	/*! \brief limits of the shell, in the order of \a _limitResources */
+	struct rlimit limits[LAUNCHER_LIMIT_COUNT];
+	char **argv;
+	char **envp;
+	/*! \brief launcher's end of the socket, closed in the launched process */
+	int socket;
+} launcher_request_t;
+
+/*! \brief Reply sent by the launcher for each request */
+typedef struct __launcher_reply_t {
+	int32_t pid;
+	int32_t error;
+} launcher_reply_t;
+
+static int _bufferAppend(launcher_buffer_t *buffer, const void *data, size_t length)
+{
+	char *grown;
+	size_t size;
+	if(buffer->length + length > buffer->size) {
+		size = buffer->size > 0 ? buffer->size : 256;
+		while(size < buffer->length + length) {
+			size *= 2;
+		}
+		grown = realloc(buffer->data, size);
+		if(grown == NULL) {
+			return -1;
+		}
+		buffer->data = grown;
+		buffer->size = size;
+	}
+	memcpy(buffer->data + buffer->length, data, length);
+	buffer->length += length;
+	return 0;
+}
+
+static int _bufferAppendInteger(launcher_buffer_t *buffer, int value)
+{
+	int32_t integer = value;
+	return _bufferAppend(buffer, &integer, sizeof(integer));
+}
+
+static int _bufferAppendLimit(launcher_buffer_t *buffer, rlim_t value)
+{
+	uint64_t limit = value;
+	return _bufferAppend(buffer, &limit, sizeof(limit));
+}
+
+static int _bufferAppendString(launcher_buffer_t *buffer, const char *string)
+{
+	if(string == NULL) {
+		string = "";
+	}
+	return _bufferAppend(buffer, string, strlen(string) + 1);
+}
+
+static int _readInteger(launcher_reader_t *reader, int *value)
+{
+	int32_t integer;
+	if(reader->length - reader->position < sizeof(integer)) {
+		return -1;
+	}
+	memcpy(&integer, reader->data + reader->position, sizeof(integer));
+	reader->position += sizeof(integer);
+	*value = integer;
+	return 0;
+}
+
+static int _readLimit(launcher_reader_t *reader, rlim_t *value)
+{
+	uint64_t limit;
+	if(reader->length - reader->position < sizeof(limit)) {
+		return -1;
+	}
+	memcpy(&limit, reader->data + reader->position, sizeof(limit));
+	reader->position += sizeof(limit);
+	*value = limit;
+	return 0;
+}
+
+static const char *_readString(launcher_reader_t *reader)
+{
+	const char *string = reader->data + reader->position;
+	const char *end;
+	end = memchr(string, '\0', reader->length - reader->position);
+	if(end == NULL) {
+		return NULL;
+	}
+	reader->position += end - string + 1;
+	return string;
+}
+
+/*!
+ \brief Read a \a NULL terminated array of strings preceded by its length
+ \return newly allocated array pointing into the request, or \a NULL on error
+ */
+static char **_readStrings(launcher_reader_t *reader)
+{
+	char **strings;
+	int count;
+	int index;
+	if(_readInteger(reader, &count) != 0 || count < 0
+		|| (size_t)count > reader->length - reader->position) {
+		return NULL;
+	}
+	strings = malloc((count + 1) * sizeof(*strings));
+	if(strings == NULL) {
+		return NULL;
+	}
+	for(index = 0; index < count; index++) {
+		strings[index] = (char *)_readString(reader);
+		if(strings[index] == NULL) {
+			free(strings);
+			return NULL;
+		}
+	}
+	strings[count] = NULL;
+	return strings;
+}
+
+static int _writeAll(int descriptor, const void *data, size_t length)
+{
+	ssize_t count;
+	size_t written = 0;
+	while(written < length) {
+		count = send(descriptor, (const char *)data + written, length - written, MSG_NOSIGNAL);
+		if(count == -1 && errno == EINTR) {
+			continue;
+		}
+		if(count <= 0) {
+			return -1;
+		}
+		written += count;
+	}
+	return 0;
+}
+
+static int _readAll(int descriptor, void *data, size_t length)
+{
+	ssize_t count;
+	size_t received = 0;
+	while(received < length) {
+		count = read(descriptor, (char *)data + received, length - received);
+		if(count == -1 && errno == EINTR) {
+			continue;
+		}
+		if(count <= 0) {
+			return -1;
+		}
+		received += count;
+	}
+	return 0;
+}
+
+#if defined(__linux__)
+/*!
+ \brief Entry point of a launched process
+
+ Places the passed descriptors at their numbers in the shell, then proceeds
+ as a child forked by the shell would.
+ */
+static int _launchedProcessMain(void *argument)
+{
+	launcher_request_t *request = argument;
+	redirection_t *failedRedirection;
+	int placed[LAUNCHER_DESCRIPTORS_MAX];
+	int lowest = 0;
+	size_t index;
+	size_t passedIndex = 0;
+	for(index = 0; index < request->descriptorCount; index++) {
+		if(request->descriptors[index] >= lowest) {
+			lowest = request->descriptors[index] + 1;
+		}
+	}
+	/* Move the received descriptors out of the way of their targets first */
+	for(index = 0; index < request->descriptorCount; index++) {
+		if(request->isPassed[index]) {
+			placed[index] = fcntl(request->received[passedIndex++], F_DUPFD_CLOEXEC, lowest);
+			if(placed[index] == -1) {
+				_exit(kMushExecutionError);
+			}
+		}
+	}
+	for(index = 0; index < request->receivedCount; index++) {
+		close(request->received[index]);
+	}
+	close(request->socket);
+	for(index = 0; index < request->descriptorCount; index++) {
+		if(!request->isPassed[index]) {
+			/* Duplicating a descriptor the shell does not have must fail */
+			close(request->descriptors[index]);
+			continue;
+		}
+		if(dup2(placed[index], request->descriptors[index]) == -1) {
+			_exit(kMushExecutionError);
+		}
+		close(placed[index]);
+		/* As in the shell, only the standard descriptors survive exec */
+		if(request->descriptors[index] > STDERR_FILENO) {
+			fcntl(request->descriptors[index], F_SETFD, FD_CLOEXEC);
+		}
+	}
+	if(*request->directory != '\0' && chdir(request->directory) != 0) {
+		fprintf(stderr, "mush: %s: %s\n", request->directory, strerror(errno));
+		_exit(kMushExecutionError);
+	}
+	umask(request->mask);
+	for(index = 0; index < LAUNCHER_LIMIT_COUNT; index++) {
+		if(setrlimit(_limitResources[index], &request->limits[index]) != 0) {
+			fprintf(stderr, "mush: unable to set resource limit: %s\n", strerror(errno));
+			_exit(kMushExecutionError);
+		}
+	}
+	environ = request->envp;
+	if(request->redirections != NULL) {
+		failedRedirection = redirectionsApply(request->redirections);
+		if(failedRedirection != NULL) {
+			redirectionPrintError(failedRedirection);
+			_exit(kMushExecutionError);
+		}
+	}
+	execvp(request->argv[0], request->argv);
+	fprintf(stderr, "could not execute: %s\n", request->argv[0]);
+	_exit(kMushExecutionError);
+}
+
+/*!
+ \brief Decode the redirections of a request
+ \return \c 0 on success, \c -1 on error
+ */
+static int _readRedirections(launcher_reader_t *reader, queue_t *redirections)
+{
+	redirection_t *redirection;
+	const char *path;
+	int count;
+	int action;
+	int descriptor;
+	int sourceDescriptor;
+	int flags;
+	if(_readInteger(reader, &count) != 0) {
+		return -1;
+	}
+	while(count-- > 0) {
+		if(_readInteger(reader, &action) != 0 || _readInteger(reader, &descriptor) != 0
+			|| _readInteger(reader, &sourceDescriptor) != 0
+			|| _readInteger(reader, &flags) != 0 || (path = _readString(reader)) == NULL) {
+			return -1;
+		}
+		if(action == kRedirectionActionOpen) {
+			redirection = redirectionNewOpen(descriptor, (char *)path, flags);
+		} else if(action == kRedirectionActionDuplicate) {
+			redirection = redirectionNewDuplicate(descriptor, sourceDescriptor);
+		} else {
+			redirection = redirectionNewClose(descriptor);
+		}
+		if(redirection == NULL) {
+			return -1;
+		}
+		queueInsert(redirections, redirection, (queueNodeFreeFunction)redirectionFree);
+	}
+	return 0;
+}
+
+/*!
+ \brief Decode a request and create the process it describes
+ \return process ID of the new process, or \c -1 on error with \c errno set
+ */
+static pid_t _launch(launcher_request_t *request, launcher_reader_t *reader, void *stack)
+{
+	size_t index;
+	size_t passedCount = 0;
+	int count;
+	pid_t pid = -1;
+	request->argv = NULL;
+	request->envp = NULL;
+	request->redirections = queueNew();
+	if(request->redirections == NULL) {
+		return -1;
+	}
+	if(_readInteger(reader, &count) != 0 || count < 0 || count > LAUNCHER_DESCRIPTORS_MAX) {
+		goto protocolError;
+	}
+	request->descriptorCount = count;
+	for(index = 0; index < request->descriptorCount; index++) {
+		if(_readInteger(reader, &request->descriptors[index]) != 0
+			|| _readInteger(reader, &request->isPassed[index]) != 0) {
+			goto protocolError;
+		}
+		if(request->isPassed[index]) {
+			passedCount++;
+		}
+	}
+	if(passedCount != request->receivedCount
+		|| _readRedirections(reader, request->redirections) != 0
+		|| (request->directory = _readString(reader)) == NULL
+		|| _readInteger(reader, &request->mask) != 0) {
+		goto protocolError;
+	}
+	for(index = 0; index < LAUNCHER_LIMIT_COUNT; index++) {
+		if(_readLimit(reader, &request->limits[index].rlim_cur) != 0
+			|| _readLimit(reader, &request->limits[index].rlim_max) != 0) {
+			goto protocolError;
+		}
+	}
+	if((request->argv = _readStrings(reader)) == NULL
+		|| request->argv[0] == NULL
+		|| (request->envp = _readStrings(reader)) == NULL) {
+		goto protocolError;
+	}
+	/* The process becomes a child of the shell, which therefore waits for it */
+	pid = clone(_launchedProcessMain, (char *)stack + LAUNCHER_STACK_SIZE,
+		CLONE_PARENT | SIGCHLD, request);
+	goto cleanup;
+protocolError:
+	errno = EPROTO;
+cleanup:
+	free(request->argv);
+	free(request->envp);
+	queueFree(request->redirections);
+	return pid;
+}
+
+/*!
+ \brief Serve requests until the shell closes its end of the socket
+ */
+static void _launcherServe(int socket)
+{
+	union {
+		char buffer[CMSG_SPACE(sizeof(int) * LAUNCHER_DESCRIPTORS_MAX)];
+		struct cmsghdr alignment;
+	} control;
+	launcher_request_t request;
+	launcher_reader_t reader;
+	launcher_reply_t reply;
+	struct msghdr message;
+	struct iovec vector;
+	struct cmsghdr *header;
+	uint32_t length;
+	char *payload;
+	void *stack;
+	size_t index;
+	ssize_t count;
+	stack = malloc(LAUNCHER_STACK_SIZE);
+	if(stack == NULL) {
+		_exit(1);
+	}
+	request.socket = socket;
+	for(;;) {
+		memset(&message, 0, sizeof(message));
+		vector.iov_base = &length;
+		vector.iov_len = sizeof(length);
+		message.msg_iov = &vector;
+		message.msg_iovlen = 1;
+		message.msg_control = control.buffer;
+		message.msg_controllen = sizeof(control.buffer);
+		count = recvmsg(socket, &message, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+		if(count == -1 && errno == EINTR) {
+			continue;
+		}
+		if(count != sizeof(length)) {
+			_exit(0);
+		}
+		request.receivedCount = 0;
+		for(header = CMSG_FIRSTHDR(&message); header != NULL; header = CMSG_NXTHDR(&message, header)) {
+			if(header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+				request.receivedCount = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+				memcpy(request.received, CMSG_DATA(header), request.receivedCount * sizeof(int));
+			}
+		}
+		payload = malloc(length);
+		if(payload == NULL || _readAll(socket, payload, length) != 0) {
+			_exit(1);
+		}
+		reader.data = payload;
+		reader.length = length;
+		reader.position = 0;
+		reply.pid = _launch(&request, &reader, stack);
+		reply.error = reply.pid == -1 ? errno : 0;
+		for(index = 0; index < request.receivedCount; index++) {
+			close(request.received[index]);
+		}
+		free(payload);
+		if(_writeAll(socket, &reply, sizeof(reply)) != 0) {
+			_exit(1);
+		}
+	}
+}
+#endif
+
+int launcherStart()
+{
+#if defined(__linux__)
+	int sockets[2];
+	if(_socket != -1) {
+		return 0;
+	}
+	if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+		return -1;
+	}
+	fflush(NULL);
+	_launcherPid = fork();
+	if(_launcherPid == -1) {
+		close(sockets[0]);
+		close(sockets[1]);
+		return -1;
+	}
+	if(_launcherPid == 0) {
+		close(sockets[0]);
+		_launcherServe(sockets[1]);
+		_exit(0);
+	}
+	close(sockets[1]);
+	_socket = redirectionMoveAside(sockets[0]);
+	return 0;
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+void launcherStop()
+{
+	if(_socket == -1) {
+		return;
+	}
+	/* The launcher exits once it reads the end of the stream */
+	close(_socket);
+	_socket = -1;
+	waitpid(_launcherPid, NULL, 0);
+	_launcherPid = -1;
+}
+
+int launcherIsRunning()
+{
+	return _socket != -1;
+}
+
+/*!
+ \brief Add \a descriptor to the descriptors passed with a request
+ \return \c 0 on success, \c -1 if too many descriptors are involved
+ */
+static int _addDescriptor(int *descriptors, size_t *count, int descriptor)
+{
+	size_t index;
+	for(index = 0; index < *count; index++) {
+		if(descriptors[index] == descriptor) {
+			return 0;
+		}
+	}
+	if(*count == LAUNCHER_DESCRIPTORS_MAX) {
+		return -1;
+	}
+	descriptors[(*count)++] = descriptor;
+	return 0;
+}
+
+/*!
+ \brief Send a request along with the descriptors it refers to
+ \return \c 0 on success, \c -1 on error
+ */
+static int _sendRequest(launcher_buffer_t *payload, int *descriptors, size_t count)
+{
+	union {
+		char buffer[CMSG_SPACE(sizeof(int) * LAUNCHER_DESCRIPTORS_MAX)];
+		struct cmsghdr alignment;
+	} control;
+	struct msghdr message;
+	struct iovec vector;
+	struct cmsghdr *header;
+	uint32_t length = payload->length;
+	memset(&message, 0, sizeof(message));
+	vector.iov_base = &length;
+	vector.iov_len = sizeof(length);
+	message.msg_iov = &vector;
+	message.msg_iovlen = 1;
+	if(count > 0) {
+		message.msg_control = control.buffer;
+		message.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+		header = CMSG_FIRSTHDR(&message);
+		header->cmsg_level = SOL_SOCKET;
+		header->cmsg_type = SCM_RIGHTS;
+		header->cmsg_len = CMSG_LEN(sizeof(int) * count);
+		memcpy(CMSG_DATA(header), descriptors, sizeof(int) * count);
+	}
+	if(sendmsg(_socket, &message, MSG_NOSIGNAL) != sizeof(length)) {
+		return -1;
+	}
+	return _writeAll(_socket, payload->data, payload->length);
+}
+
+pid_t launcherSpawn(char **argv, queue_t *redirections)
+{
+	launcher_buffer_t payload = {NULL, 0, 0};
+	launcher_reply_t reply;
+	struct __queue_node_t *node;
+	redirection_t *redirection;
+	char directory[PATH_MAX];
+	int descriptors[LAUNCHER_DESCRIPTORS_MAX];
+	int passed[LAUNCHER_DESCRIPTORS_MAX];
+	size_t descriptorCount = 0;
+	size_t passedCount = 0;
+	size_t index;
+	struct rlimit limit;
+	mode_t mask;
+	int isPassed;
+	int status = 0;
+	if(_socket == -1) {
+		errno = ENOSYS;
+		return -1;
+	}
+	/* The standard descriptors and duplicated ones are those of the shell */
+	for(index = 0; index <= STDERR_FILENO; index++) {
+		_addDescriptor(descriptors, &descriptorCount, index);
+	}
+	for(node = redirections != NULL ? redirections->head : NULL; node != NULL; node = node->next) {
+		redirection = node->data;
+		if(redirection->action == kRedirectionActionDuplicate
+			&& _addDescriptor(descriptors, &descriptorCount, redirection->sourceDescriptor) != 0) {
+			errno = EMFILE;
+			return -1;
+		}
+	}
+	status |= _bufferAppendInteger(&payload, descriptorCount);
+	for(index = 0; index < descriptorCount; index++) {
+		isPassed = fcntl(descriptors[index], F_GETFD) != -1;
+		if(isPassed) {
+			passed[passedCount++] = descriptors[index];
+		}
+		status |= _bufferAppendInteger(&payload, descriptors[index]);
+		status |= _bufferAppendInteger(&payload, isPassed);
+	}
+	status |= _bufferAppendInteger(&payload, redirections != NULL ? queueCount(redirections) : 0);
+	for(node = redirections != NULL ? redirections->head : NULL; node != NULL; node = node->next) {
+		redirection = node->data;
+		status |= _bufferAppendInteger(&payload, redirection->action);
+		status |= _bufferAppendInteger(&payload, redirection->descriptor);
+		status |= _bufferAppendInteger(&payload, redirection->sourceDescriptor);
+		status |= _bufferAppendInteger(&payload, redirection->flags);
+		status |= _bufferAppendString(&payload, redirection->path);
+	}
+	status |= _bufferAppendString(&payload, getcwd(directory, sizeof(directory)));
+	/* Reading the mask means setting it, so it is set back right away */
+	mask = umask(0);
+	umask(mask);
+	status |= _bufferAppendInteger(&payload, mask);
+	for(index = 0; index < LAUNCHER_LIMIT_COUNT; index++) {
+		status |= getrlimit(_limitResources[index], &limit);
+		status |= _bufferAppendLimit(&payload, limit.rlim_cur);
+		status |= _bufferAppendLimit(&payload, limit.rlim_max);
+	}
+	for(index = 0; argv[index] != NULL; index++) {
+	}
+	status |= _bufferAppendInteger(&payload, index);
+	for(index = 0; argv[index] != NULL; index++) {
+		status |= _bufferAppendString(&payload, argv[index]);
+	}
+	for(index = 0; environ[index] != NULL; index++) {
+	}
+	status |= _bufferAppendInteger(&payload, index);
+	for(index = 0; environ[index] != NULL; index++) {
+		status |= _bufferAppendString(&payload, environ[index]);
+	}
+	if(status != 0) {
+		free(payload.data);
+		errno = ENOMEM;
+		return -1;
+	}
+	if(_sendRequest(&payload, passed, passedCount) != 0
+		|| _readAll(_socket, &reply, sizeof(reply)) != 0) {
+		/* The launcher is gone, the caller has to create processes itself */
+		free(payload.data);
+		launcherStop();
+		errno = EPIPE;
+		return -1;
+	}
+	free(payload.data);
+	if(reply.pid == -1) {
+		errno = reply.error;
+	}
+	return reply.pid;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#include <sys/types.h>
+#include "queue.h"
+
+/*!
+ \addtogroup launcher
+ \{
+ */
+
+/*!
+ \brief Fork the launcher helper process
+
+ The cost of fork() grows with the memory mapped by the calling process. The
+ launcher is forked while the shell is still small and creates processes on
+ its behalf: the shell sends it the arguments, environment, working
+ directory, file mode creation mask, resource limits and redirections of a
+ command over a UNIX socket, passing the descriptors
+ involved with \c SCM_RIGHTS. The launcher creates the process as a child of
+ the shell (\c CLONE_PARENT), so the shell waits for it as usual.
+
+ The launcher is only available on Linux.
+
+ \return \c 0 on success, \c -1 on error
+ */
+int launcherStart();
+
+/*!
+ \brief Terminate the launcher helper process
+ */
+void launcherStop();
+
+/*!
+ \brief Return whether the launcher helper process is running
+ \return non-zero if launcherSpawn() can be used
+ */
+int launcherIsRunning();
+
+/*!
+ \brief Execute a program as a child of the shell using the launcher
+
+ The program is looked up in the \c PATH of the shell's environment. If the
+ launcher can no longer be reached it is stopped, and the caller should
+ create the process itself.
+
+ \param argv \a NULL terminated arguments, the first being the program
+ \param redirections queue of \c redirection_t objects applied in the child,
+ or \a NULL
+ \return process ID of the child, or \c -1 on error with \c errno set
+ */
+pid_t launcherSpawn(char **argv, queue_t *redirections);
+
+/*!
+ \}
+ */
+
+#endif /* LAUNCHER_H */
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "libmush.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "parser.h"
+#include "exec.h"
+#include "jobs.h"
+
+/*! \brief Held while a script executes */
+static pthread_mutex_t _executionLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t _shellOnce = PTHREAD_ONCE_INIT;
+
+/*!
+ \brief Set up the shell of the process on its first execution
+ */
+static void _initializeShell()
+{
+	jobsInitialize();
+	executeSetEmbedded(1);
+}
+
+/*!
+ \brief Keep the error of the calling thread in \a context
+ */
+static void _keepError(mush_context_t *context)
+{
+	const char *description = mushErrorDescription();
+	context->error = mushError();
+	free(context->errorDescription);
+	context->errorDescription = NULL;
+	if(context->error != kMushNoError && description != NULL) {
+		context->errorDescription = strdup(description);
+	}
+}
+
+mush_context_t *mushContextNew()
+{
+	mush_context_t *context = malloc(sizeof(*context));
+	if(context == NULL) {
+		return NULL;
+	}
+	context->error = kMushNoError;
+	context->errorDescription = NULL;
+	context->status = 0;
+	return context;
+}
+
+void mushContextFree(mush_context_t *context)
+{
+	if(context == NULL) {
+		return;
+	}
+	free(context->errorDescription);
+	free(context);
+}
+
+script_t *mushContextParse(mush_context_t *context, const char *source)
+{
+	queue_t *commands;
+	script_t *script = NULL;
+	/* The parser works on a copy, the caller's string may be constant */
+	char *input = strdup(source);
+	setMushError(kMushNoError);
+	if(input == NULL) {
+		setMushError(kMushGenericError);
+		setMushErrorDescription("out of memory");
+		_keepError(context);
+		return NULL;
+	}
+	commands = commandQueueFromInput(input);
+	if(commands != NULL) {
+		script = scriptCompile(commands);
+		queueFree(commands);
+	}
+	free(input);
+	if(script == NULL && mushError() == kMushNoError) {
+		setMushError(kMushParseError);
+		setMushErrorDescription("unable to parse input");
+	}
+	_keepError(context);
+	return script;
+}
+
+int mushProcessExecute(mush_context_t *context, script_t *script)
+{
+	int status;
+	pthread_once(&_shellOnce, _initializeShell);
+	pthread_mutex_lock(&_executionLock);
+	setMushError(kMushNoError);
+	status = scriptExecute(script);
+	context->status = executeLastStatus();
+	_keepError(context);
+	pthread_mutex_unlock(&_executionLock);
+	return status;
+}
+
+int mushProcessRun(mush_context_t *context, const char *source)
+{
+	script_t *script = mushContextParse(context, source);
+	int status;
+	if(script == NULL) {
+		return -1;
+	}
+	status = mushProcessExecute(context, script);
+	scriptFree(script);
+	return status == kMushNoError || context->error == kMushNoError ? context->status : -1;
+}
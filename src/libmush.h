@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LIBMUSH_H
+#define LIBMUSH_H
+
+#include "mush_error.h"
+#include "script.h"
+
+/*!
+ \addtogroup libmush
+ \{
+
+ The shell as a library, built as \c libmush.a and \c libmush.so by
+ <tt>make lib</tt>. Command lines are parsed and compiled through a context,
+ which holds the outcome of the calls made with it: any number of contexts
+ may parse at once, each used by one thread at a time.
+
+ Execution is not part of a context. There is a single shell per process,
+ whose variables, functions, aliases, options, jobs and working directory
+ are those of the process. mushProcessExecute() and mushProcessRun() act on
+ that shell, serialized among every thread, and only keep their outcome in
+ the context passed to them.
+ */
+
+/*! \brief Outcome of the calls made by one user of the library; the state
+ of the shell itself is that of the process */
+typedef struct __mush_context_t {
+	/*! \brief error of the last call */
+	MushErrorCode error;
+	/*! \brief description of \a error, or \c NULL */
+	char *errorDescription;
+	/*! \brief exit status of the last command line executed */
+	int status;
+} mush_context_t;
+
+/*!
+ \brief Allocate a context
+ \return the context, or \c NULL on error
+ */
+mush_context_t *mushContextNew();
+
+/*!
+ \brief Free \a context and everything it holds
+ */
+void mushContextFree(mush_context_t *context);
+
+/*!
+ \brief Parse and compile the command lines of \a source
+
+ Safe to call from several threads at once with different contexts. On
+ error, the error and its description are kept in \a context; an
+ incomplete construct, such as an unterminated loop, is reported as
+ \c kMushIncompleteInputError.
+
+ \return the compiled script, to be freed with scriptFree(), or \c NULL on
+ error
+ */
+script_t *mushContextParse(mush_context_t *context, const char *source);
+
+/*!
+ \brief Execute \a script in the shell of the process, waiting for it to
+ finish
+
+ Builtins, functions and groups run within the calling process, and other
+ programs in its children, as in the shell. The state of the shell is that
+ of the process, shared by every context and thread, and executions are
+ serialized. The first execution sets up the handling of \c SIGCHLD as the
+ shell does (see jobsInitialize()).
+
+ The process is never ended or replaced: \c exit ends the script, \c exec
+ runs its program in a child and then ends the script, and children of the
+ shell leave with \c _exit() (see executeSetEmbedded()).
+
+ \return \c kMushNoError on success, an error code otherwise. The exit
+ status of the script is kept in \a context
+ */
+int mushProcessExecute(mush_context_t *context, script_t *script);
+
+/*!
+ \brief Parse, compile and execute \a source, as mushContextParse() and
+ mushProcessExecute() do
+ \return exit status of the command lines, or \c -1 if they could not be
+ parsed or executed
+ */
+int mushProcessRun(mush_context_t *context, const char *source);
+
+/*!
+ \}
+ */
+
+#endif /* LIBMUSH_H */
@@ -19,15 +19,25 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
  * DEALINGS IN THE SOFTWARE.
  */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <signal.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
 #include "parser.h"
 #include "exec.h"
 #include "prompt.h"
 #include "testing_util.h"
 #include "mush_error.h"
+#include "jobs.h"
+#include "launcher.h"
+#include "options.h"
+#include "script.h"
+#include "scriptfile.h"
+#include "variables.h"
+#include "server.h"
 
 /*!
  \brief Main program loop
@@ -36,55 +46,202 @@ static void run();
 
 /*!
  \brief Retrieve input from the user
- \return input string
+ \return input string, or \c NULL if the end of input was reached
  */
 static const char *getInput();
 
-static void signalHandler(int signal);
-static void setupSignalHandler();
-static void claimChildren();
+/*!
+ \brief Parse \a input, reading continuation lines while it is incomplete
+
+ Constructs such as here-documents or loops span multiple lines. While the
+ parser reports the input as incomplete, more lines are read and appended to
+ \a *input before parsing it again.
+
+ \param input pointer to the input string, which may be reallocated
+ \return the compiled input, or \c NULL on error
+ */
+static script_t *parseInput(char **input);
+
+/*!
+ \brief Parse and compile \a input
+ \return the compiled input, or \c NULL on error
+ */
+static script_t *compileInput(char *input);
+
+/*!
+ \brief Execute \a script, then free it
+ \param isFinal whether the shell exits afterwards, see scriptExecuteFinal()
+ \return \c kMushNoError on success, an error code otherwise
+ */
+static int runScript(script_t *script, int isFinal);
+
+/*!
+ \brief Execute the commands in \a source at once, as given to \c -c or read
+ from a script file
+ \return exit status of the shell
+ */
+static int runSource(char *source);
+
+/*!
+ \brief Read a single character from standard input
+
+ While no input is available, terminated background jobs are collected so
+ that queued jobs start without waiting for the next command line.
+
+ \return the character, or \c EOF if the end of input was reached
+ */
+static int readCharacter();
 
 /*! \brief Initial size of the input buffer */
 #define INPUT_BUFFER_SIZE_INITIAL 24
 /*! \brief Multiplier by which the input buffer's size increases */
 #define INPUT_BUFFER_SIZE_MULTIPLIER 1.5f
+/*! \brief Prompt displayed while reading continuation lines */
+#define CONTINUATION_PROMPT "> "
+/*! \brief Size of the buffer standard input is read into */
+#define READ_BUFFER_SIZE 4096
 
-int main()
+int main(int argc, char **argv)
 {
 	char *prompt_argv[2] = {"prompt", "% "};
+	char *source;
+	int status = 0;
 	cmd_prompt(2, prompt_argv);
-	setupSignalHandler();
-	run();
-	return 0;
+	/* Fork the launcher while the shell is still small */
+	if(getenv("MUSH_LAUNCHER") != NULL && atoi(getenv("MUSH_LAUNCHER")) != 0) {
+		if(launcherStart() != 0) {
+			fprintf(stderr, "mush: unable to start launcher\n");
+		}
+	}
+	jobsInitialize();
+	variablesSetPositional(1, argv);
+	if(argc > 2 && strcmp(argv[1], "-c") == 0) {
+		/* "mush -c commands [name [arguments...]]" */
+		if(argc > 3) {
+			variablesSetPositional(argc - 3, argv + 3);
+		}
+		source = strdup(argv[2]);
+		status = source != NULL ? runSource(source) : 1;
+	} else if(argc > 2 && strcmp(argv[1], "--serve") == 0) {
+		/* "mush --serve socket [workers]" */
+		status = serverRun(argv[2], argc > 3 ? atoi(argv[3]) : jobsSlotLimit());
+	} else if(argc > 1) {
+		/* "mush script [arguments...]" */
+		source = scriptFileRead(argv[1]);
+		if(source == NULL) {
+			fprintf(stderr, "mush: %s: %s\n", argv[1], strerror(errno));
+			status = 127;
+		} else {
+			variablesSetPositional(argc - 1, argv + 1);
+			status = runSource(source);
+		}
+	} else {
+		jobsSetInteractive(isatty(STDIN_FILENO));
+		run();
+		status = executeLastStatus();
+	}
+	jobsFinish();
+	launcherStop();
+	return status;
+}
+
+int runSource(char *source)
+{
+	script_t *script;
+	setMushError(kMushNoError);
+	script = compileInput(source);
+	free(source);
+	if(script == NULL) {
+		fprintf(stderr, "mush: %s\n", mushErrorDescription());
+		return 2;
+	}
+	runScript(script, 1);
+	return executeLastStatus();
 }
 
 void run()
 {
 	char *input = NULL;
 	char *prompt = NULL;
-	queue_t *commandQueue = NULL;
-	MushErrorCode errorCode;
+	script_t *script = NULL;
 	do {
+		if(isatty(STDIN_FILENO)) {
+			jobsNotify();
+		}
 		prompt = getPrompt();
 		printf("%s", prompt);
+		fflush(stdout);
 		/* Free input buffer from previous loop run */
 		if(input != NULL) {
 			free(input);
 		}
 		input = (char *)getInput();
-		commandQueue = commandQueueFromInput(input);
-		if(commandQueue == NULL && mushError() != kMushNoError) {
+		if(input == NULL) {
+			break;
+		}
+		script = parseInput(&input);
+		if(script == NULL && mushError() != kMushNoError) {
 			fprintf(stderr, "mush: %s\n", mushErrorDescription());
-		} else {
-			errorCode = executeCommandsInQueue(commandQueue);
-			if(errorCode != 0 && mushError() != kMushNoError) {
-				fprintf(stderr, "mush: %s\n", mushErrorDescription());
-			}
-			queueFree(commandQueue);
+		} else if(script != NULL) {
+			runScript(script, 0);
 		}
 	} while(1);
 }
 
+int runScript(script_t *script, int isFinal)
+{
+	int errorCode;
+	if(optionIsSet(kOptionShowPlan)) {
+		scriptPrint(script, stderr);
+	}
+	errorCode = isFinal ? scriptExecuteFinal(script) : scriptExecute(script);
+	if(errorCode != 0 && mushError() != kMushNoError) {
+		fprintf(stderr, "mush: %s\n", mushErrorDescription());
+	}
+	scriptFree(script);
+	return errorCode;
+}
+
+script_t *compileInput(char *input)
+{
+	queue_t *commandQueue;
+	script_t *script;
+	commandQueue = commandQueueFromInput(input);
+	if(commandQueue == NULL) {
+		return NULL;
+	}
+	script = scriptCompile(commandQueue);
+	queueFree(commandQueue);
+	return script;
+}
+
+script_t *parseInput(char **input)
+{
+	script_t *script;
+	char *line;
+	char *joined;
+	setMushError(kMushNoError);
+	script = compileInput(*input);
+	while(script == NULL && mushError() == kMushIncompleteInputError) {
+		printf("%s", CONTINUATION_PROMPT);
+		fflush(stdout);
+		line = (char *)getInput();
+		if(line == NULL) {
+			break;
+		}
+		if(asprintf(&joined, "%s\n%s", *input, line) == -1) {
+			free(line);
+			break;
+		}
+		free(line);
+		free(*input);
+		*input = joined;
+		setMushError(kMushNoError);
+		script = compileInput(*input);
+	}
+	return script;
+}
+
 const char *getInput()
 {
 	char *buffer = malloc(INPUT_BUFFER_SIZE_INITIAL * sizeof(char));
@@ -94,46 +251,58 @@ const char *getInput()
 	if(buffer == NULL) {
 		return buffer;
 	}
-	input = fgetc(stdin);
+	input = readCharacter();
+	if(input == EOF) {
+		free(buffer);
+		return NULL;
+	}
 	/* Get input until we get EOF or a new line */
 	while(input != EOF && (char)input != '\n') {
-		/* Increase the buffer size if necessary */
-		if(inputLength >= bufferSize) {
+		/* Increase the buffer size if necessary, leaving room for the terminator */
+		if(inputLength + 1 >= bufferSize) {
 			bufferSize = bufferSize * INPUT_BUFFER_SIZE_MULTIPLIER;
 			buffer = realloc(buffer, bufferSize * sizeof(*buffer));
 		}
 		buffer[inputLength] = (char)input;
 		inputLength++;
-		input = fgetc(stdin);
+		input = readCharacter();
 	}
 	buffer[inputLength] = '\0';
 	return buffer;
 }
 
-static void setupSignalHandler()
-{
-	struct sigaction act;
-	act.sa_flags = 0;
-	act.sa_handler = signalHandler;
-	sigfillset(&(act.sa_mask) );
-
-	if(sigaction(SIGCHLD, &act, NULL) != 0) {
-		fprintf(stderr, "mush: unable to setup signal handler\n");
-		exit(1);
-	}
-}
-
-static void signalHandler(int signal)
+int readCharacter()
 {
-	if(signal == SIGCHLD) {
-		claimChildren();
+	static char buffer[READ_BUFFER_SIZE];
+	static size_t position = 0;
+	static size_t length = 0;
+	struct pollfd descriptors[2];
+	ssize_t bytesRead;
+	while(position == length) {
+		descriptors[0].fd = STDIN_FILENO;
+		descriptors[0].events = POLLIN;
+		descriptors[1].fd = jobsSignalDescriptor();
+		descriptors[1].events = POLLIN;
+		if(poll(descriptors, descriptors[1].fd == -1 ? 1 : 2, -1) == -1) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return EOF;
+		}
+		if(descriptors[1].fd != -1 && (descriptors[1].revents & POLLIN)) {
+			jobsReap();
+		}
+		if(descriptors[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+			bytesRead = read(STDIN_FILENO, buffer, sizeof(buffer));
+			if(bytesRead == -1 && errno == EINTR) {
+				continue;
+			}
+			if(bytesRead <= 0) {
+				return EOF;
+			}
+			position = 0;
+			length = (size_t)bytesRead;
+		}
 	}
-}
-
-static void claimChildren()
-{
-	pid_t pid;
-	do {
-		pid = waitpid(0, NULL, WNOHANG);
-	} while(pid > 0);
+	return (unsigned char)buffer[position++];
 }
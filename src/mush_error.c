@@ -2,8 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-static int _mushErrorNumber = kMushNoError;
-static char *_mushErrorDescription = NULL;
+/* Each thread parsing with the library has errors of its own */
+static __thread int _mushErrorNumber = kMushNoError;
+static __thread char *_mushErrorDescription = NULL;
 
 MushErrorCode mushError()
 {
@@ -5,7 +5,8 @@ typedef enum {
 	kMushNoError = 0,
 	kMushGenericError,
 	kMushParseError,
-	kMushExecutionError
+	kMushExecutionError,
+	kMushIncompleteInputError
 } MushErrorCode;
 
 MushErrorCode mushError();
@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "optimizer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "command.h"
+#include "builtin.h"
+#include "redirection.h"
+
+/*! \brief Path of the null device, whose output setup can be skipped */
+#define NULL_DEVICE "/dev/null"
+/*! \brief Characters which make a word differ from the argument it expands to */
+#define EXPANDED_CHARACTERS "'\"\\*?[$`~{"
+
+/*!
+ \brief Indicate whether an alias or function replaces the builtin \a name,
+ whose behaviour the rewrites rely on
+ */
+static int _isShadowed(const char *name)
+{
+	return aliasLookup(name) != NULL || functionLookup(name) != NULL;
+}
+
+/*!
+ \brief Find the builtin run by \a command, unless it is shadowed
+ */
+static const builtin_t *_lookupBuiltin(command_t *command)
+{
+	if(command->argv == NULL || command->argv[0] == NULL || _isShadowed(command->argv[0])) {
+		return NULL;
+	}
+	return builtinLookup(command->argv[0]);
+}
+
+/*!
+ \brief Indicate whether \a command is \a name without any redirections
+ \param argc required amount of arguments, including the name
+ */
+static int _isPlainCommand(command_t *command, const char *name, int argc)
+{
+	return command->argc == argc && !_isShadowed(name) && command->argv != NULL
+		&& command->argv[0] != NULL && strcmp(command->argv[0], name) == 0
+		&& queueCount(command->redirections) == 0
+		&& command->hereDocument == NULL;
+}
+
+/*!
+ \brief Indicate whether any redirection of \a command changes \a descriptor
+ */
+static int _isRedirected(command_t *command, int descriptor)
+{
+	struct __queue_node_t *node;
+	redirection_t *redirection;
+	for(node = command->redirections->head; node != NULL; node = node->next) {
+		redirection = node->data;
+		if(redirection->descriptor == descriptor) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int _isNullDeviceRedirection(redirection_t *redirection)
+{
+	return redirection->action == kRedirectionActionOpen
+		&& strcmp(redirection->path, NULL_DEVICE) == 0;
+}
+
+/*!
+ \brief Remove the redirections of \a command opening the null device
+ \param descriptor only remove redirections of this descriptor, or \c -1 to
+ remove them for every descriptor
+ */
+static void _removeNullDeviceRedirections(command_t *command, int descriptor)
+{
+	queue_t *redirections = queueNew();
+	redirection_t *redirection;
+	if(redirections == NULL) {
+		return;
+	}
+	while(queueRemove(command->redirections, (void *)&redirection)) {
+		if(_isNullDeviceRedirection(redirection)
+		&& (descriptor == -1 || redirection->descriptor == descriptor)) {
+			redirectionFree(redirection);
+		} else {
+			queueInsert(redirections, redirection, (queueNodeFreeFunction)redirectionFree);
+		}
+	}
+	queueFree(command->redirections);
+	command->redirections = redirections;
+}
+
+/*!
+ \brief Replace the arguments of \a command by the single word \a name
+ */
+static void _replaceCommand(command_t *command, const char *name)
+{
+	char **argv = malloc(2 * sizeof(*argv));
+	int argi;
+	if(argv == NULL) {
+		return;
+	}
+	for(argi = 1; argi < command->argc; argi++) {
+		free(command->argv[argi]);
+	}
+	free(command->argv);
+	/* The path is the first argument, so it is freed along with it */
+	commandSetPath(command, (char *)name);
+	argv[0] = command->path;
+	argv[1] = NULL;
+	commandSetArgs(command, 1, argv);
+}
+
+/*!
+ \brief Free a command removed from the command line, including its arguments
+ */
+static void _freeCommand(command_t *command)
+{
+	commandFreeArguments(command);
+	commandFree(command);
+	free(command);
+}
+
+/*!
+ \brief Let \c "cat file | cmd" run as \c "cmd < file"
+
+ Whether the file can be read depends on the working directory and the file
+ system as the pipeline runs, so \a cat is only marked here. The shell opens
+ the file when it runs the pipeline, leaving cat to report a file it cannot
+ read, where the command would have read an empty pipe.
+ */
+static void _passInputFile(command_t *cat, command_t *next)
+{
+	char *path;
+	if(!_isPlainCommand(cat, "cat", 2)) {
+		return;
+	}
+	path = cat->argv[1];
+	if(path[0] == '-' || path[0] == '\0' || strpbrk(path, EXPANDED_CHARACTERS) != NULL) {
+		return;
+	}
+	if(next->hereDocument != NULL || _isRedirected(next, STDIN_FILENO)) {
+		return;
+	}
+	cat->isInputPassed = 1;
+}
+
+/*!
+ \brief Skip output to the null device where the command writes nothing
+ */
+static void _removeNullDeviceOutput(command_t *command)
+{
+	struct __queue_node_t *node;
+	const builtin_t *builtin;
+	int isNullOutput = 0;
+	int argi;
+	if(command->argv == NULL || command->argv[0] == NULL) {
+		return;
+	}
+	builtin = _lookupBuiltin(command);
+	if(builtin == NULL) {
+		return;
+	}
+	if(builtin->function == cmd_echo && command->hereDocument == NULL) {
+		/* Expanding the arguments may assign variables ("$((x += 1))") */
+		for(argi = 1; argi < command->argc; argi++) {
+			if(strpbrk(command->argv[argi], EXPANDED_CHARACTERS) != NULL) {
+				return;
+			}
+		}
+		/* Only worth replacing if nothing else is redirected */
+		for(node = command->redirections->head; node != NULL; node = node->next) {
+			if(!_isNullDeviceRedirection(node->data)) {
+				return;
+			}
+			if(((redirection_t *)node->data)->descriptor == STDOUT_FILENO) {
+				isNullOutput = 1;
+			}
+		}
+		if(isNullOutput) {
+			_replaceCommand(command, "true");
+			_removeNullDeviceRedirections(command, -1);
+		}
+	} else if(builtin->function == cmd_true || builtin->function == cmd_false) {
+		_removeNullDeviceRedirections(command, -1);
+	} else if(builtin->function == cmd_test) {
+		/* Errors are still written to the standard error */
+		_removeNullDeviceRedirections(command, STDOUT_FILENO);
+	}
+}
+
+/*!
+ \brief Indicate whether \a command runs differently once it is no longer
+ piped, as groups and \c exec run in the shell when they are alone
+ */
+static int _dependsOnPipe(command_t *command)
+{
+	const builtin_t *builtin;
+	if(command->body != NULL) {
+		return !command->isSubshell;
+	}
+	builtin = _lookupBuiltin(command);
+	return builtin != NULL && (builtin->flags & kBuiltinFlagReplacesShell);
+}
+
+/*!
+ \brief Rewrite the pipeline made of \a count elements of \a commands
+ \return new amount of commands in the pipeline, removed commands are moved
+ past the end and set to \c NULL
+ */
+static size_t _optimizePipeline(command_t **commands, size_t count)
+{
+	const builtin_t *builtin;
+	size_t index;
+	if(count > 1 && !(count == 2 && _dependsOnPipe(commands[1]))) {
+		_passInputFile(commands[0], commands[1]);
+	}
+	if(count > 1 && _isPlainCommand(commands[count - 1], "cat", 1)
+	&& !(count == 2 && _dependsOnPipe(commands[0])) && !isatty(STDOUT_FILENO)) {
+		commands[count - 2]->connectionMask = commands[count - 1]->connectionMask;
+		_freeCommand(commands[count - 1]);
+		commands[--count] = NULL;
+	}
+	for(index = 0; index < count; index++) {
+		_removeNullDeviceOutput(commands[index]);
+		if(index + 1 == count || commands[index]->argv == NULL || commands[index]->isInputPassed) {
+			continue;
+		}
+		builtin = _lookupBuiltin(commands[index]);
+		commands[index]->isOutputCaptured = builtin != NULL
+			&& (builtin->flags & kBuiltinFlagNoFork);
+	}
+	return count;
+}
+
+void optimizeCommandQueue(queue_t *commands)
+{
+	command_t **pending;
+	command_t *command;
+	size_t count = 0;
+	size_t start;
+	size_t end;
+	size_t index;
+	if(commands == NULL || queueCount(commands) == 0) {
+		return;
+	}
+	pending = malloc(queueCount(commands) * sizeof(*pending));
+	if(pending == NULL) {
+		return;
+	}
+	while(queueRemove(commands, (void *)&command)) {
+		pending[count++] = command;
+	}
+	for(start = 0; start < count; start = end) {
+		/* A pipeline extends up to the first command which is not piped */
+		for(end = start; end < count && pending[end]->connectionMask == kCommandConnectionPipe; end++) {
+		}
+		end = end < count ? end + 1 : end;
+		_optimizePipeline(pending + start, end - start);
+	}
+	for(index = 0; index < count; index++) {
+		if(pending[index] != NULL) {
+			queueInsert(commands, pending[index], (queueNodeFreeFunction)commandFree);
+		}
+	}
+	free(pending);
+}
+
+static void _printRedirection(redirection_t *redirection, FILE *stream)
+{
+	switch(redirection->action) {
+		case kRedirectionActionOpen:
+			fprintf(stream, " ");
+			if((redirection->flags & O_ACCMODE) == O_RDONLY) {
+				if(redirection->descriptor != STDIN_FILENO) {
+					fprintf(stream, "%d", redirection->descriptor);
+				}
+				fprintf(stream, "< %s", redirection->path);
+			} else {
+				if(redirection->descriptor != STDOUT_FILENO) {
+					fprintf(stream, "%d", redirection->descriptor);
+				}
+				fprintf(stream, "%s %s", (redirection->flags & O_APPEND) ? ">>" : ">",
+					redirection->path);
+			}
+			break;
+		case kRedirectionActionDuplicate:
+			fprintf(stream, " %d>&%d", redirection->descriptor, redirection->sourceDescriptor);
+			break;
+		case kRedirectionActionClose:
+			fprintf(stream, " %d>&-", redirection->descriptor);
+			break;
+	}
+}
+
+void optimizePrintCommands(queue_t *commands, FILE *stream)
+{
+	struct __queue_node_t *node;
+	struct __queue_node_t *redirectionNode;
+	command_t *command;
+	const char *separator = "";
+	int argi;
+	if(commands == NULL) {
+		return;
+	}
+	for(node = commands->head; node != NULL; node = node->next) {
+		command = node->data;
+		for(argi = 0; command->attributes != NULL && command->attributes[argi] != NULL; argi++) {
+			fprintf(stream, "%s%s", separator, command->attributes[argi]);
+			separator = " ";
+		}
+		for(argi = 0; argi < command->argc; argi++) {
+			fprintf(stream, "%s%s", separator, command->argv[argi]);
+			separator = " ";
+		}
+		if(command->body != NULL) {
+			fprintf(stream, "%s%s", separator, command->isSubshell ? "( ... )" : "{ ...; }");
+			separator = " ";
+		}
+		for(redirectionNode = command->redirections->head; redirectionNode != NULL;
+			redirectionNode = redirectionNode->next) {
+			_printRedirection(redirectionNode->data, stream);
+		}
+		if(command->hereDocument != NULL) {
+			fprintf(stream, " <<here-document");
+		}
+		if(command->isOutputCaptured) {
+			fprintf(stream, " [captured]");
+		}
+		if(command->isInputPassed) {
+			fprintf(stream, " [passed]");
+		}
+		switch(command->connectionMask) {
+			case kCommandConnectionPipe:
+				fprintf(stream, " |");
+				break;
+			case kCommandConnectionFanOut:
+				fprintf(stream, " |+");
+				break;
+			case kCommandConnectionBackground:
+				fprintf(stream, " &");
+				break;
+			case kCommandConnectionAnd:
+				fprintf(stream, " &&");
+				break;
+			case kCommandConnectionOr:
+				fprintf(stream, " ||");
+				break;
+			case kCommandConnectionSequential:
+				if(node->next != NULL) {
+					fprintf(stream, " ;");
+				}
+				break;
+		}
+	}
+}
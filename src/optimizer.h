@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stdio.h>
+#include "queue.h"
+
+/*!
+ \addtogroup optimizer
+ \{
+ */
+
+/*!
+ \brief Rewrite the commands of a parsed command line into cheaper equivalents
+
+ Each pipeline is rewritten on its own:
+ - \c "cat file | cmd" becomes \c "cmd < file", if the file can be read
+ - a trailing \c "| cat" is removed, unless the output is a terminal, which
+   some programs format differently than a pipe
+ - builtins which run in the shell write into a capture file instead of a
+   pipe when followed by another command, so no process is created for them
+ - output to \c /dev/null is not set up for builtins which write nothing,
+   and \c "echo ... > /dev/null" becomes \c "true"
+
+ The commands keep their order and connections, so the rewritten queue is
+ executed as before.
+
+ \param commands queue of \c command_t objects, as returned by
+ commandQueueFromInput()
+ */
+void optimizeCommandQueue(queue_t *commands);
+
+/*!
+ \brief Print the commands in \a commands as they will be executed, on a
+ single line without a terminating new line
+
+ Commands running in the shell with captured output are marked with
+ \c "[captured]".
+
+ \param commands queue of \c command_t objects
+ \param stream stream to print to
+ */
+void optimizePrintCommands(queue_t *commands, FILE *stream);
+
+/*!
+ \}
+ */
+
+#endif /* OPTIMIZER_H */
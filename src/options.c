@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "options.h"
+#include <stdio.h>
+#include <string.h>
+
+/*! \brief Names of the options, indexed by the \c kOption values */
+static const char *_optionNames[kOptionCount] = {
+	"optimize",
+	"showplan",
+	"placement"
+};
+
+/*! \brief State of each option, indexed by the \c kOption values */
+static int _options[kOptionCount] = {
+	1,
+	0,
+	0
+};
+
+int optionIsSet(int option)
+{
+	if(option < 0 || option >= kOptionCount) {
+		return 0;
+	}
+	return _options[option];
+}
+
+void optionSet(int option, int isSet)
+{
+	if(option < 0 || option >= kOptionCount) {
+		return;
+	}
+	_options[option] = isSet != 0;
+}
+
+int optionLookup(const char *name)
+{
+	int option;
+	for(option = 0; option < kOptionCount; option++) {
+		if(strcmp(_optionNames[option], name) == 0) {
+			return option;
+		}
+	}
+	return -1;
+}
+
+int cmd_set(int argc, char **argv)
+{
+	int option;
+	int index;
+	int status = 0;
+	if(argc == 1 || (argc == 2 && strcmp(argv[1], "-o") == 0)) {
+		for(option = 0; option < kOptionCount; option++) {
+			printf("%-15s %s\n", _optionNames[option], _options[option] ? "on" : "off");
+		}
+		return 0;
+	}
+	for(index = 1; index < argc; index += 2) {
+		if((strcmp(argv[index], "-o") != 0 && strcmp(argv[index], "+o") != 0)
+		|| index + 1 >= argc) {
+			fprintf(stderr, "usage: set [-o|+o option]...\n");
+			return 2;
+		}
+		option = optionLookup(argv[index + 1]);
+		if(option == -1) {
+			fprintf(stderr, "set: no such option: %s\n", argv[index + 1]);
+			status = 1;
+			continue;
+		}
+		optionSet(option, argv[index][0] == '-');
+	}
+	return status;
+}
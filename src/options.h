@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+/*!
+ \addtogroup options
+ \{
+ */
+
+enum {
+	/*! \brief Rewrite parsed command lines into cheaper equivalents before
+	 executing them (on by default) */
+	kOptionOptimize = 0,
+	/*! \brief Print each command line to the standard error as it will be
+	 executed */
+	kOptionShowPlan,
+	/*! \brief Pin the stages of each pipeline to CPUs sharing a cache, and
+	 spread pipelines across caches and NUMA nodes */
+	kOptionPlacement,
+	/*! \brief Amount of options */
+	kOptionCount
+};
+
+/*!
+ \brief Indicate whether \a option is enabled
+ \param option one of the \c kOption values
+ \return \c 1 if the option is enabled, \c 0 otherwise
+ */
+int optionIsSet(int option);
+
+/*!
+ \brief Enable or disable \a option
+ \param option one of the \c kOption values
+ \param isSet \c 1 to enable the option, \c 0 to disable it
+ */
+void optionSet(int option, int isSet);
+
+/*!
+ \brief Find the option called \a name
+ \param name name of the option, as used by the "set" builtin
+ \return one of the \c kOption values, or \c -1 if there is no such option
+ */
+int optionLookup(const char *name);
+
+/*!
+ \brief Run the builtin "set" command
+
+ \c "set -o name" enables and \c "set +o name" disables an option. Without an
+ option name the state of every option is printed.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return exit status of the command
+ */
+int cmd_set(int argc, char **argv);
+
+/*!
+ \}
+ */
+
+#endif /* OPTIONS_H */
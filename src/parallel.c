@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "parallel.h"
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include "queue.h"
+#include "redirection.h"
+#include "exec.h"
+
+/*! \brief Amount of bytes read from a descriptor at once */
+#define PARALLEL_READ_SIZE 65536
+/*! \brief Highest exit status, reported when this many commands or more fail */
+#define PARALLEL_MAX_FAILURES 101
+/*! \brief Marker separating the command from the items */
+#define PARALLEL_ITEMS_MARKER ":::"
+/*! \brief Placeholder replaced by the item */
+#define PARALLEL_PLACEHOLDER "{}"
+
+/*! \brief Growable byte buffer */
+typedef struct {
+	char *data;
+	size_t length;
+	size_t size;
+} _parallel_buffer_t;
+
+/*! \brief A command started for an item, occupying a job slot */
+typedef struct {
+	/*! \brief process identifier, or \c -1 if the slot is free */
+	pid_t pid;
+	/*! \brief position of the item in the input */
+	size_t sequence;
+	/*! \brief read ends of the output and error pipes, \c -1 once closed */
+	int descriptors[2];
+	/*! \brief output and errors collected from the pipes */
+	_parallel_buffer_t buffers[2];
+	int hasExited;
+	int status;
+} _parallel_job_t;
+
+/*! \brief Written to by the SIGCHLD handler to wake up poll() */
+static int _childSignalPipe[2] = {-1, -1};
+
+static void _childSignalHandler(int signal)
+{
+	int savedErrno = errno;
+	write(_childSignalPipe[1], "", 1);
+	errno = savedErrno;
+}
+
+static int _bufferAppend(_parallel_buffer_t *buffer, const char *data, size_t length)
+{
+	char *newData;
+	size_t newSize;
+	if(buffer->length + length > buffer->size) {
+		newSize = buffer->size == 0 ? PARALLEL_READ_SIZE : buffer->size;
+		while(newSize < buffer->length + length) {
+			newSize *= 2;
+		}
+		newData = realloc(buffer->data, newSize);
+		if(newData == NULL) {
+			return -1;
+		}
+		buffer->data = newData;
+		buffer->size = newSize;
+	}
+	memcpy(buffer->data + buffer->length, data, length);
+	buffer->length += length;
+	return 0;
+}
+
+static void _bufferFree(_parallel_buffer_t *buffer)
+{
+	free(buffer->data);
+	buffer->data = NULL;
+	buffer->length = 0;
+	buffer->size = 0;
+}
+
+static void _writeAll(int fd, const char *data, size_t length)
+{
+	ssize_t written;
+	while(length > 0) {
+		written = write(fd, data, length);
+		if(written == -1) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+		data += written;
+		length -= written;
+	}
+}
+
+/*!
+ \brief Replace each placeholder in \a argument with \a item
+ \return newly allocated string, or \c NULL on error
+ */
+static char *_substituteItem(const char *argument, const char *item)
+{
+	_parallel_buffer_t result = {NULL, 0, 0};
+	const char *placeholder;
+	while((placeholder = strstr(argument, PARALLEL_PLACEHOLDER)) != NULL) {
+		_bufferAppend(&result, argument, placeholder - argument);
+		_bufferAppend(&result, item, strlen(item));
+		argument = placeholder + strlen(PARALLEL_PLACEHOLDER);
+	}
+	if(_bufferAppend(&result, argument, strlen(argument) + 1) != 0) {
+		_bufferFree(&result);
+		return NULL;
+	}
+	return result.data;
+}
+
+/*!
+ \brief Start the command for \a item in the free \a job slot
+ \return \c 0 on success, \c -1 on error
+ */
+static int _startJob(_parallel_job_t *job, int argc, char **argv, const char *item, int isInputShared)
+{
+	char **jobArgv;
+	int jobArgc = 0;
+	int hasPlaceholder = 0;
+	int pipes[2][2];
+	int index;
+	queue_t *redirections;
+
+	jobArgv = malloc((argc + 2) * sizeof(*jobArgv));
+	if(jobArgv == NULL) {
+		return -1;
+	}
+	for(index = 0; index < argc; index++) {
+		if(strstr(argv[index], PARALLEL_PLACEHOLDER) != NULL) {
+			hasPlaceholder = 1;
+		}
+		jobArgv[jobArgc++] = _substituteItem(argv[index], item);
+	}
+	if(!hasPlaceholder) {
+		jobArgv[jobArgc++] = strdup(item);
+	}
+	jobArgv[jobArgc] = NULL;
+
+	redirections = queueNew();
+	for(index = 0; index < 2; index++) {
+		if(redirectionPipe(pipes[index]) != 0) {
+			pipes[index][0] = -1;
+			pipes[index][1] = -1;
+			continue;
+		}
+		queueInsert(redirections, redirectionNewDuplicate(STDOUT_FILENO + index, pipes[index][1]),
+			(queueNodeFreeFunction)redirectionFree);
+	}
+	/* Commands must not consume the items */
+	if(isInputShared) {
+		queueInsert(redirections, redirectionNewOpen(STDIN_FILENO, "/dev/null", O_RDONLY),
+			(queueNodeFreeFunction)redirectionFree);
+	}
+	job->pid = executeInChild(jobArgc, jobArgv, redirections);
+	queueFree(redirections);
+	for(index = 0; index < 2; index++) {
+		if(pipes[index][1] != -1) {
+			close(pipes[index][1]);
+		}
+		job->descriptors[index] = pipes[index][0];
+		job->buffers[index].length = 0;
+	}
+	job->hasExited = 0;
+	job->status = 0;
+	for(index = 0; index < jobArgc; index++) {
+		free(jobArgv[index]);
+	}
+	free(jobArgv);
+	if(job->pid == -1) {
+		for(index = 0; index < 2; index++) {
+			if(job->descriptors[index] != -1) {
+				close(job->descriptors[index]);
+				job->descriptors[index] = -1;
+			}
+		}
+		return -1;
+	}
+	return 0;
+}
+
+static void _emitJob(_parallel_job_t *job)
+{
+	_writeAll(STDOUT_FILENO, job->buffers[0].data, job->buffers[0].length);
+	_writeAll(STDERR_FILENO, job->buffers[1].data, job->buffers[1].length);
+}
+
+/*!
+ \brief Split the complete lines of \a input into items
+ \param isFinished whether the end of input was reached, making the remainder
+ an item as well
+ */
+static void _queueItems(_parallel_buffer_t *input, queue_t *items, int isFinished)
+{
+	char *lineStart = input->data;
+	char *lineEnd;
+	size_t remaining = input->length;
+	while(remaining > 0 && (lineEnd = memchr(lineStart, '\n', remaining)) != NULL) {
+		queueInsert(items, strndup(lineStart, lineEnd - lineStart), free);
+		remaining -= lineEnd - lineStart + 1;
+		lineStart = lineEnd + 1;
+	}
+	if(isFinished && remaining > 0) {
+		queueInsert(items, strndup(lineStart, remaining), free);
+		remaining = 0;
+	}
+	memmove(input->data, lineStart, remaining);
+	input->length = remaining;
+}
+
+/*!
+ \brief Find the job slot of the process \a pid
+ \return the job, or \c NULL if \a pid is not a job
+ */
+static _parallel_job_t *_jobWithPid(_parallel_job_t *jobs, int jobCount, pid_t pid)
+{
+	int index;
+	for(index = 0; index < jobCount; index++) {
+		if(jobs[index].pid == pid) {
+			return &jobs[index];
+		}
+	}
+	return NULL;
+}
+
+int cmd_parallel(int argc, char **argv)
+{
+	_parallel_job_t *jobs;
+	_parallel_job_t *job;
+	_parallel_job_t *completed = NULL;
+	size_t completedCount = 0;
+	_parallel_buffer_t input = {NULL, 0, 0};
+	queue_t *items;
+	struct pollfd *pollDescriptors;
+	struct sigaction action;
+	struct sigaction previousAction;
+	struct timespec startTime;
+	struct timespec endTime;
+	char buffer[PARALLEL_READ_SIZE];
+	char *item;
+	int jobCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	int isOrdered = 0;
+	int isVerbose = 0;
+	int isInputFinished = 0;
+	int isInputShared = 1;
+	int commandArgc;
+	int argi;
+	int index;
+	int stream;
+	int pollCount;
+	int waitStatus;
+	int running = 0;
+	size_t sequence = 0;
+	size_t nextSequence = 0;
+	size_t failures = 0;
+	ssize_t count;
+	pid_t pid;
+	double elapsed;
+
+	/* Options */
+	for(argi = 1; argi < argc && argv[argi][0] == '-'; argi++) {
+		if(strcmp(argv[argi], "--") == 0) {
+			argi++;
+			break;
+		} else if(strncmp(argv[argi], "-j", 2) == 0) {
+			if(argv[argi][2] != '\0') {
+				jobCount = atoi(argv[argi] + 2);
+			} else if(argi + 1 < argc) {
+				jobCount = atoi(argv[++argi]);
+			}
+		} else if(strcmp(argv[argi], "-k") == 0) {
+			isOrdered = 1;
+		} else if(strcmp(argv[argi], "-v") == 0) {
+			isVerbose = 1;
+		} else {
+			fprintf(stderr, "parallel: unknown option %s\n", argv[argi]);
+			return 2;
+		}
+	}
+	if(jobCount < 1) {
+		jobCount = 1;
+	}
+	/* Command and items */
+	for(commandArgc = 0; argi + commandArgc < argc; commandArgc++) {
+		if(strcmp(argv[argi + commandArgc], PARALLEL_ITEMS_MARKER) == 0) {
+			break;
+		}
+	}
+	if(commandArgc == 0) {
+		fprintf(stderr, "usage: parallel [-j jobs] [-k] [-v] command [arguments] [::: items]\n");
+		return 2;
+	}
+	items = queueNew();
+	if(argi + commandArgc < argc) {
+		for(index = argi + commandArgc + 1; index < argc; index++) {
+			queueInsert(items, strdup(argv[index]), free);
+		}
+		isInputFinished = 1;
+		isInputShared = 0;
+	}
+
+	jobs = malloc(jobCount * sizeof(*jobs));
+	pollDescriptors = malloc((2 * jobCount + 2) * sizeof(*pollDescriptors));
+	if(items == NULL || jobs == NULL || pollDescriptors == NULL
+	|| redirectionPipe(_childSignalPipe) != 0) {
+		fprintf(stderr, "parallel: %s\n", strerror(errno));
+		return PARALLEL_MAX_FAILURES;
+	}
+	fcntl(_childSignalPipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(_childSignalPipe[1], F_SETFL, O_NONBLOCK);
+	memset(jobs, 0, jobCount * sizeof(*jobs));
+	for(index = 0; index < jobCount; index++) {
+		jobs[index].pid = -1;
+	}
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = _childSignalHandler;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGCHLD, &action, &previousAction);
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+	while(1) {
+		/* Hand out items to every free slot */
+		for(index = 0; index < jobCount && queueCount(items) > 0; index++) {
+			if(jobs[index].pid != -1) {
+				continue;
+			}
+			queueRemove(items, (void *)&item);
+			jobs[index].sequence = sequence;
+			if(_startJob(&jobs[index], commandArgc, argv + argi, item, isInputShared) == 0) {
+				sequence++;
+				running++;
+			} else {
+				fprintf(stderr, "parallel: unable to start job: %s\n", strerror(errno));
+				failures++;
+			}
+			free(item);
+		}
+		if(running == 0 && queueCount(items) == 0 && isInputFinished) {
+			break;
+		}
+
+		pollCount = 0;
+		pollDescriptors[pollCount].fd = _childSignalPipe[0];
+		pollDescriptors[pollCount++].events = POLLIN;
+		/* Only read ahead as far as the slots can take */
+		if(!isInputFinished && queueCount(items) < (size_t)jobCount) {
+			pollDescriptors[pollCount].fd = STDIN_FILENO;
+			pollDescriptors[pollCount++].events = POLLIN;
+		}
+		for(index = 0; index < jobCount; index++) {
+			for(stream = 0; stream < 2; stream++) {
+				if(jobs[index].pid != -1 && jobs[index].descriptors[stream] != -1) {
+					pollDescriptors[pollCount].fd = jobs[index].descriptors[stream];
+					pollDescriptors[pollCount++].events = POLLIN;
+				}
+			}
+		}
+		if(poll(pollDescriptors, pollCount, -1) == -1) {
+			if(errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+
+		for(index = 1; index < pollCount; index++) {
+			if(pollDescriptors[index].revents == 0) {
+				continue;
+			}
+			count = read(pollDescriptors[index].fd, buffer, sizeof(buffer));
+			if(count == -1 && errno == EINTR) {
+				continue;
+			}
+			if(pollDescriptors[index].fd == STDIN_FILENO) {
+				if(count > 0) {
+					_bufferAppend(&input, buffer, count);
+				} else {
+					isInputFinished = 1;
+				}
+				_queueItems(&input, items, isInputFinished);
+				continue;
+			}
+			for(job = jobs; job < jobs + jobCount; job++) {
+				for(stream = 0; stream < 2; stream++) {
+					if(job->pid == -1 || job->descriptors[stream] != pollDescriptors[index].fd) {
+						continue;
+					}
+					if(count > 0) {
+						_bufferAppend(&job->buffers[stream], buffer, count);
+					} else {
+						close(job->descriptors[stream]);
+						job->descriptors[stream] = -1;
+					}
+				}
+			}
+		}
+
+		/* Reap terminated commands */
+		while(read(_childSignalPipe[0], buffer, sizeof(buffer)) > 0) {
+		}
+		while((pid = waitpid(-1, &waitStatus, WNOHANG)) > 0) {
+			job = _jobWithPid(jobs, jobCount, pid);
+			if(job != NULL) {
+				job->hasExited = 1;
+				job->status = waitStatus;
+			}
+		}
+
+		/* A job is complete once it terminated and its output was collected */
+		for(job = jobs; job < jobs + jobCount; job++) {
+			if(job->pid == -1 || !job->hasExited
+			|| job->descriptors[0] != -1 || job->descriptors[1] != -1) {
+				continue;
+			}
+			if(!WIFEXITED(job->status) || WEXITSTATUS(job->status) != 0) {
+				failures++;
+			}
+			running--;
+			if(!isOrdered) {
+				_emitJob(job);
+			} else {
+				completed = realloc(completed, (completedCount + 1) * sizeof(*completed));
+				completed[completedCount++] = *job;
+				/* The buffers now belong to the completed job */
+				memset(job->buffers, 0, sizeof(job->buffers));
+			}
+			job->pid = -1;
+		}
+		/* Emit the completed jobs which are next in order */
+		for(index = 0; index < (int)completedCount; index++) {
+			if(completed[index].sequence != nextSequence) {
+				continue;
+			}
+			_emitJob(&completed[index]);
+			_bufferFree(&completed[index].buffers[0]);
+			_bufferFree(&completed[index].buffers[1]);
+			completed[index] = completed[--completedCount];
+			nextSequence++;
+			index = -1;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+	if(isVerbose) {
+		elapsed = (endTime.tv_sec - startTime.tv_sec)
+			+ (endTime.tv_nsec - startTime.tv_nsec) / 1e9;
+		fprintf(stderr, "parallel: %zu jobs in %.3f s (%.1f jobs/s) on %d slots, %zu failed\n",
+			sequence, elapsed, elapsed > 0 ? sequence / elapsed : 0.0, jobCount, failures);
+	}
+	sigaction(SIGCHLD, &previousAction, NULL);
+	close(_childSignalPipe[0]);
+	close(_childSignalPipe[1]);
+	for(index = 0; index < jobCount; index++) {
+		_bufferFree(&jobs[index].buffers[0]);
+		_bufferFree(&jobs[index].buffers[1]);
+	}
+	free(completed);
+	free(jobs);
+	free(pollDescriptors);
+	_bufferFree(&input);
+	queueFree(items);
+	return failures > PARALLEL_MAX_FAILURES ? PARALLEL_MAX_FAILURES : (int)failures;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ \addtogroup builtin
+ \{
+ */
+
+/*!
+ \brief Run the builtin "parallel" command
+
+ Usage: \c "parallel [-j jobs] [-k] [-v] command [arguments] [::: items]"
+
+ The command is run once per item, with each \c "{}" in the arguments
+ replaced by the item, or the item appended if there is no \c "{}". Items
+ are taken from the arguments following \c ":::", or otherwise read from the
+ standard input, one per line.
+
+ Up to \a jobs commands (by default the number of online processors) run at
+ once. Whenever a command terminates the next item is started, so slots never
+ sit idle behind a long running command. The output of each command is
+ buffered and written as a whole once it terminates, in order of termination
+ or, with \c -k, in order of the items. With \c -v the throughput is reported
+ on the standard error once all items are processed.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return \c 0 if every command succeeded, otherwise the amount of failed
+ commands (at most 101)
+ */
+int cmd_parallel(int argc, char **argv);
+
+/*!
+ \}
+ */
@@ -19,6 +19,7 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
  * DEALINGS IN THE SOFTWARE.
  */
+#define _GNU_SOURCE
 #include "parser.h"
 
 #include <stdlib.h>
@@ -26,19 +27,38 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 #include "testing_util.h"
 #include "command.h"
 #include "queue.h"
 #include "mush_error.h"
+#include "arithmetic.h"
+#include "expansion.h"
+#include "variables.h"
 
 enum {
 	/*! No redirection */
 	kRedirectionTypeNone = 0,
 	/*! Output redirected */
 	kRedirectionTypeOut,
+	/*! Output appended (>>) */
+	kRedirectionTypeAppend,
 	/*! Input redirected */
-	kRedirectionTypeIn
+	kRedirectionTypeIn,
+	/*! File opened for reading and writing (<>) */
+	kRedirectionTypeReadWrite,
+	/*! Output descriptor duplicated or closed (>&) */
+	kRedirectionTypeDuplicateOut,
+	/*! Input descriptor duplicated or closed (<&) */
+	kRedirectionTypeDuplicateIn,
+	/*! Input read from the following lines, up to a delimiter (<<) */
+	kRedirectionTypeHereDocument,
+	/*! Here-document with leading tabs stripped from each line (<<-) */
+	kRedirectionTypeHereDocumentStrippingTabs,
+	/*! Input read from the word following the operator (<<<) */
+	kRedirectionTypeHereString
 };
 
 enum {
@@ -88,7 +108,7 @@ static void _setCommandPath(command_t *command, const char *path, size_t n) {
 	}
 	memset(str, 0, size);
 	str = strncpy(str, path, n);
-	*(str + n + 1) = '\0';
+	*(str + n) = '\0';
 	commandSetPath(command, str);
 	free(str);
 }
@@ -110,26 +130,365 @@ static void _setConnectionMaskBasedOnCharacter(command_t *command, char chr) {
 	}
 }
 
+/*!
+ \brief Find the \c ) ending the list of words of an array assignment, or
+ the commands of a process substitution, skipping quoted characters,
+ expansions and nested parentheses
+ \param text the list, following \c (
+ \return pointer to the closing \c ), or \c NULL if there is none
+ */
+static const char *_findListEnd(const char *text)
+{
+	const char *end;
+	char quote = 0;
+	int depth = 0;
+	for(; *text != '\0' && (quote != 0 || depth > 0 || *text != ')'); text++) {
+		if(*text == '\\' && quote != '\'' && text[1] != '\0') {
+			text++;
+		} else if(quote == 0 && (*text == '\'' || *text == '"')) {
+			quote = *text;
+		} else if(*text == quote) {
+			quote = 0;
+		} else if(quote == 0 && (*text == '(' || *text == ')')) {
+			depth += *text == '(' ? 1 : -1;
+		} else if(quote != '\'' && strncmp(text, "${", 2) == 0) {
+			if((end = expansionFindParameterEnd(text + 2)) == NULL) {
+				return NULL;
+			}
+			text = end;
+		} else if(quote != '\'' && strncmp(text, "$((", 3) == 0) {
+			if((end = arithmeticFindEnd(text + 3)) == NULL) {
+				return NULL;
+			}
+			text = end + 1;
+		}
+	}
+	return *text == ')' ? text : NULL;
+}
+
+/*!
+ \brief Indicate whether \a ptr starts a process substitution, \c "<(" or
+ \c ">(", rather than a redirection
+ */
+static int _isProcessSubstitution(const char *ptr)
+{
+	return (ptr[0] == '<' || ptr[0] == '>') && ptr[1] == '(';
+}
+
+/*!
+ \brief Skip an arithmetic or braced parameter expansion, the words of an
+ array assignment or a process substitution at \a inputPtr, which may
+ contain blanks and operators without ending the word
+ \param wordStart start of the word containing \a inputPtr
+ \return \c 1 if an expansion was skipped, \c 0 if there is none, and \c -1
+ if it is not terminated
+ */
+static int _skipExpansion(const char *wordStart, char **inputPtr)
+{
+	const char *end;
+	/* The words of an array assignment, name=(words) or name+=(words),
+	 stay in one word */
+	if(**inputPtr == '(' && *inputPtr > wordStart && (*inputPtr)[-1] == '='
+	&& (variableNameLength(wordStart) == (size_t)(*inputPtr - wordStart - 1)
+	|| ((*inputPtr)[-2] == '+' && variableNameLength(wordStart) == (size_t)(*inputPtr - wordStart - 2)))) {
+		end = _findListEnd(*inputPtr + 1);
+		if(end == NULL) {
+			return -1;
+		}
+		*inputPtr = (char *)end + 1;
+		return 1;
+	}
+	/* The commands of <(commands) are parsed once they are run */
+	if(*inputPtr == wordStart && _isProcessSubstitution(*inputPtr)) {
+		end = _findListEnd(*inputPtr + 2);
+		if(end == NULL) {
+			return -1;
+		}
+		*inputPtr = (char *)end + 1;
+		return 1;
+	}
+	if(strncmp(*inputPtr, "$((", 3) == 0) {
+		end = arithmeticFindEnd(*inputPtr + 3);
+		if(end == NULL) {
+			return -1;
+		}
+		*inputPtr = (char *)end + 2;
+		return 1;
+	}
+	if(strncmp(*inputPtr, "${", 2) == 0) {
+		end = expansionFindParameterEnd(*inputPtr + 2);
+		if(end == NULL) {
+			return -1;
+		}
+		*inputPtr = (char *)end + 1;
+		return 1;
+	}
+	return 0;
+}
+
 static int _isTerminator(char ch) {
-	return (ch == '|' || ch == '&' || ch == ';');
+	return (ch == '|' || ch == '&' || ch == ';' || ch == '\n');
+}
+
+/*!
+ \brief Advance \a inputPtr past the parenthesis it points at
+
+ A parenthesis of a subshell is a word of its own, so it ends the word
+ started at \a wordStart. The \c () of a function definition is left in the
+ word.
+ \return \c 1 if the word ends at \a inputPtr, \c 0 otherwise
+ */
+static int _skipParenthesis(const char *wordStart, char **inputPtr)
+{
+	if(**inputPtr == '(' && (*inputPtr)[1] == ')') {
+		*inputPtr += 2;
+		return 0;
+	}
+	if(*inputPtr == wordStart) {
+		(*inputPtr)++;
+	}
+	return 1;
 }
 
-static void _setRedirectionBasedOnType(command_t *command, int redirectionType, char *ptr, size_t n) {
+/*!
+ \brief Copy \a n characters of \a ptr, removing any quotes
+
+ \return newly allocated string, or \c NULL on error
+ */
+static char *_copyUnquoted(const char *ptr, size_t n) {
 	char *str;
-	size_t size = (n + 1) * sizeof(*str);
-	str = malloc(size);
+	char *strPtr;
+	char quote = 0;
+	str = malloc((n + 1) * sizeof(*str));
 	if(str == NULL) {
-		return;
+		return NULL;
 	}
-	memset(str, 0, size);
-	str = strncpy(str, ptr, n);
-	*(str + size) = '\0';
-	if(redirectionType == kRedirectionTypeOut) {
-		commandSetRedirectToPath(command, str);
-	} else if(redirectionType == kRedirectionTypeIn) {
-		commandSetRedirectFromPath(command, str);
+	strPtr = str;
+	for(; n > 0; ptr++, n--) {
+		if(quote == 0 && (*ptr == '\'' || *ptr == '"')) {
+			quote = *ptr;
+		} else if(quote != 0 && *ptr == quote) {
+			quote = 0;
+		} else {
+			*strPtr++ = *ptr;
+		}
+	}
+	*strPtr = '\0';
+	return str;
+}
+
+/*! \brief Redirection operators, longest first so prefixes match last */
+static const struct {
+	const char *operator;
+	int redirectionType;
+} _redirectionOperators[] = {
+	{"<<<", kRedirectionTypeHereString},
+	{"<<-", kRedirectionTypeHereDocumentStrippingTabs},
+	{"<<", kRedirectionTypeHereDocument},
+	{"<>", kRedirectionTypeReadWrite},
+	{"<&", kRedirectionTypeDuplicateIn},
+	{"<", kRedirectionTypeIn},
+	{">>", kRedirectionTypeAppend},
+	{">&", kRedirectionTypeDuplicateOut},
+	{">|", kRedirectionTypeOut},
+	{">", kRedirectionTypeOut},
+	{NULL, kRedirectionTypeNone}
+};
+
+/*!
+ \brief Determine the type of the redirection operator at \a *inputPtr
+
+ \a *inputPtr is advanced past the operator.
+
+ \return type of the redirection, or \c kRedirectionTypeNone
+ */
+static int _parseRedirectionOperator(char **inputPtr) {
+	int index;
+	size_t length;
+	for(index = 0; _redirectionOperators[index].operator != NULL; index++) {
+		length = strlen(_redirectionOperators[index].operator);
+		if(strncmp(*inputPtr, _redirectionOperators[index].operator, length) == 0) {
+			*inputPtr += length;
+			return _redirectionOperators[index].redirectionType;
+		}
+	}
+	return kRedirectionTypeNone;
+}
+
+/*!
+ \brief Determine whether \a ptr is at a redirection of an explicit
+ descriptor, e.g. \c "2>"
+ */
+static int _isDescriptorRedirection(const char *ptr) {
+	if(!isdigit(*ptr)) {
+		return 0;
+	}
+	while(isdigit(*ptr)) {
+		ptr++;
+	}
+	return (*ptr == '<' || *ptr == '>');
+}
+
+/*!
+ \brief Add a redirection duplicating or closing \a descriptor
+
+ \param word either a descriptor number or \c "-" to close \a descriptor
+ \return \c 1 on success, \c 0 if \a word is not valid
+ */
+static int _addDuplicateRedirection(command_t *command, int descriptor, const char *word) {
+	const char *ptr;
+	if(strcmp(word, "-") == 0) {
+		commandAddRedirection(command, redirectionNewClose(descriptor));
+		return 1;
+	}
+	for(ptr = word; *ptr != '\0'; ptr++) {
+		if(!isdigit(*ptr)) {
+			return 0;
+		}
+	}
+	if(ptr == word) {
+		return 0;
+	}
+	commandAddRedirection(command, redirectionNewDuplicate(descriptor, atoi(word)));
+	return 1;
+}
+
+/*!
+ \brief Add the redirection of \a descriptor to \a command
+
+ \param descriptor the explicit descriptor, or \c -1 for the default of the
+ redirection type
+ \return \c 1 on success, \c 0 if the redirection is not valid
+ */
+static int _setRedirectionBasedOnType(command_t *command, int redirectionType, int descriptor, char *ptr, size_t n) {
+	char *str;
+	int isValid = 1;
+	int isInput = (redirectionType == kRedirectionTypeIn
+		|| redirectionType == kRedirectionTypeReadWrite
+		|| redirectionType == kRedirectionTypeDuplicateIn);
+	if(descriptor == -1) {
+		descriptor = isInput ? STDIN_FILENO : STDOUT_FILENO;
+	}
+	/* Paths and here-strings are expanded as the command runs, whereas the
+	   quotes of a process substitution belong to its commands */
+	if(redirectionType == kRedirectionTypeDuplicateOut || redirectionType == kRedirectionTypeDuplicateIn
+	|| redirectionType == kRedirectionTypeHereDocument
+	|| redirectionType == kRedirectionTypeHereDocumentStrippingTabs) {
+		str = _copyUnquoted(ptr, n);
+	} else {
+		str = strndup(ptr, n);
+	}
+	if(str == NULL) {
+		return 0;
+	}
+	switch(redirectionType) {
+		case kRedirectionTypeOut:
+			if(descriptor == STDOUT_FILENO) {
+				commandSetRedirectToPath(command, str);
+			} else {
+				commandAddRedirection(command, redirectionNewOpen(descriptor, str,
+					O_WRONLY | O_CREAT | O_TRUNC));
+			}
+			break;
+		case kRedirectionTypeAppend:
+			commandAddRedirection(command, redirectionNewOpen(descriptor, str,
+				O_WRONLY | O_CREAT | O_APPEND));
+			break;
+		case kRedirectionTypeIn:
+			if(descriptor == STDIN_FILENO) {
+				commandSetRedirectFromPath(command, str);
+			} else {
+				commandAddRedirection(command, redirectionNewOpen(descriptor, str, O_RDONLY));
+			}
+			break;
+		case kRedirectionTypeReadWrite:
+			commandAddRedirection(command, redirectionNewOpen(descriptor, str,
+				O_RDWR | O_CREAT));
+			break;
+		case kRedirectionTypeDuplicateOut:
+		case kRedirectionTypeDuplicateIn:
+			isValid = _addDuplicateRedirection(command, descriptor, str);
+			break;
+		case kRedirectionTypeHereDocument:
+		case kRedirectionTypeHereDocumentStrippingTabs:
+			commandSetHereDocumentDelimiter(command, str,
+				redirectionType == kRedirectionTypeHereDocumentStrippingTabs);
+			break;
+		case kRedirectionTypeHereString:
+			commandSetHereString(command, str);
+			break;
 	}
 	free(str);
+	return isValid;
+}
+
+/*!
+ \brief Read the contents of pending here-documents
+
+ The contents of each here-document start on the line following \a *inputPtr,
+ which should point to the new line terminating the command line. The
+ here-documents are read in the order they appear on the command line, each
+ ending at the line matching its delimiter. \a *inputPtr is advanced to the end
+ of the last delimiter line.
+
+ \param pending queue of commands with unread here-documents, emptied on return
+ \param inputPtr pointer to the current position in the input string
+ \return \c 1 if all here-documents were terminated, \c 0 otherwise
+ */
+static int _readHereDocuments(queue_t *pending, char **inputPtr) {
+	command_t *command;
+	char *linePtr = *inputPtr;
+	char *lineEnd;
+	char *body;
+	size_t bodyLength;
+	size_t lineLength;
+	int isTerminated;
+
+	while(queueRemove(pending, (void *)&command)) {
+		body = malloc(sizeof(*body));
+		if(body == NULL) {
+			return 0;
+		}
+		bodyLength = 0;
+		isTerminated = 0;
+		while(*linePtr != '\0' && !isTerminated) {
+			/* Skip the new line ending the previous line */
+			linePtr++;
+			if(command->hereDocumentStripsTabs) {
+				while(*linePtr == '\t') {
+					linePtr++;
+				}
+			}
+			lineEnd = strchr(linePtr, '\n');
+			if(lineEnd == NULL) {
+				lineEnd = linePtr + strlen(linePtr);
+			}
+			lineLength = lineEnd - linePtr;
+			if(lineLength == strlen(command->hereDocumentDelimiter)
+			&& strncmp(linePtr, command->hereDocumentDelimiter, lineLength) == 0) {
+				isTerminated = 1;
+			} else if(*lineEnd != '\0') {
+				body = realloc(body, (bodyLength + lineLength + 2) * sizeof(*body));
+				if(body == NULL) {
+					return 0;
+				}
+				memcpy(body + bodyLength, linePtr, lineLength);
+				bodyLength += lineLength;
+				body[bodyLength++] = '\n';
+			}
+			linePtr = lineEnd;
+		}
+		if(!isTerminated) {
+			free(body);
+			return 0;
+		}
+		body[bodyLength] = '\0';
+		commandSetHereDocument(command, body);
+		commandSetHereDocumentDelimiter(command, NULL, 0);
+		free(body);
+	}
+	*inputPtr = linePtr;
+	return 1;
 }
 
 
@@ -171,7 +530,7 @@ static void _addTokenToQueue(queue_t *queue, char *token, size_t n) {
 	}
 	memset(str, 0, size);
 	str = strncpy(str, token, n);
-	*(str + size) = '\0';
+	*(str + n) = '\0';
 #if UNIT_TESTING
 	queueInsert(queue, str, NULL);
 #else
@@ -182,10 +541,13 @@ static void _addTokenToQueue(queue_t *queue, char *token, size_t n) {
 queue_t *commandQueueFromInput(char *inputLine) {
 	queue_t *commandQueue = queueNew();
 	queue_t *tokens = queueNew();
+	queue_t *pendingHereDocuments = queueNew();
 	command_t *command = NULL;
 	char *inputPtr = inputLine;
+	char *quoteCheckedPtr = NULL;
 	char *errorDescription = NULL;
-	char lastTerminator = 0;
+	char *lastTerminator = NULL;
+	size_t terminatorLength = 0;
 	
 	int currentState = kMachineStateInitial;
 
@@ -193,10 +555,12 @@ queue_t *commandQueueFromInput(char *inputLine) {
 	char *dataEnd = NULL;
 	int isFinishedParsing = 0;
 	int redirectionType = kRedirectionTypeNone;
+	int redirectionDescriptor = -1;
 
 	int isInSingleQuote = 0;
 	int isInDoubleQuote = 0;
 	int isInQuote = 0;
+	int isSkipped = 0;
 	
 	if(inputLine == NULL) {
 		return NULL;
@@ -204,28 +568,60 @@ queue_t *commandQueueFromInput(char *inputLine) {
 	
 	/* Traverse the input string until it is parsed */
 	while(isFinishedParsing == 0) {
-		if(*inputPtr == '\'' && !isInDoubleQuote) {
-			isInSingleQuote = !isInSingleQuote;
-		}
-		if(*inputPtr == '"' && !isInSingleQuote) {
-			isInDoubleQuote = !isInDoubleQuote;
+		/* States may be changed without advancing, so each character must only
+		   be considered once */
+		if(inputPtr != quoteCheckedPtr) {
+			if(*inputPtr == '\'' && !isInDoubleQuote) {
+				isInSingleQuote = !isInSingleQuote;
+			}
+			if(*inputPtr == '"' && !isInSingleQuote) {
+				isInDoubleQuote = !isInDoubleQuote;
+			}
+			quoteCheckedPtr = inputPtr;
 		}
 		isInQuote = isInDoubleQuote || isInSingleQuote;
 		switch(currentState) {
 			case kMachineStateInitial:
 				/* Set everything up to be ready for parsing the next command */
 				assert(command == NULL);
-				/* Ignore whitespace */
+				/* Here-documents start on the line after the command line */
+				if(*inputPtr == '\n' && queueCount(pendingHereDocuments) > 0) {
+					if(!_readHereDocuments(pendingHereDocuments, &inputPtr)) {
+						setMushError(kMushIncompleteInputError);
+						setMushErrorDescription("unterminated here-document");
+						queueFree(pendingHereDocuments);
+						queueFree(commandQueue);
+						queueFree(tokens);
+						return NULL;
+					}
+					continue;
+				}
+				/* Ignore whitespace and comments */
 				if(isspace(*inputPtr)) {
+					inputPtr++;
+					continue;
+				}
+				if(*inputPtr == '#') {
+					inputPtr += strcspn(inputPtr, "\n");
+					continue;
+				}
+				/* A case clause may be ended on a line of its own */
+				if(inputPtr[0] == ';' && inputPtr[1] == ';' && commandQueue->tail != NULL) {
+					commandSetConnectionMask(commandQueue->tail->data, kCommandConnectionCaseEnd);
+					inputPtr += 2;
 					continue;
 				}
 				if(*inputPtr == '\0') {
-					if(lastTerminator == '|') {
-						asprintf(&errorDescription, "parse error near '%c'", lastTerminator);
+					/* Pipes and conditional connections require another command */
+					if(lastTerminator != NULL && (*lastTerminator == '|'
+						|| (*lastTerminator == '&' && terminatorLength == 2))) {
+						asprintf(&errorDescription, "parse error near '%.*s'",
+							(int)terminatorLength, lastTerminator);
 						setMushError(kMushParseError);
 						setMushErrorDescription(errorDescription);
 						free(errorDescription);
 						errorDescription = NULL;
+						queueFree(pendingHereDocuments);
 						queueFree(commandQueue);
 						queueFree(tokens);
 						return NULL;
@@ -238,7 +634,7 @@ queue_t *commandQueueFromInput(char *inputLine) {
 					}
 					currentState = kMachineStateEnteringPath;
 				}
-				lastTerminator = 0;
+				lastTerminator = NULL;
 				break;
 			case kMachineStateEnteringPath:
 				/* Set up everything to parse the path */
@@ -250,7 +646,24 @@ queue_t *commandQueueFromInput(char *inputLine) {
 				}
 				break;
 			case kMachineStateParsingPath:
-				if((*inputPtr == ' ' && !isInQuote) || *inputPtr == '\0' || (_isTerminator(*inputPtr) && !isInQuote)) {
+				/* An escaped character is part of the word, whatever it is */
+				if(*inputPtr == '\\' && !isInSingleQuote && inputPtr[1] != '\0') {
+					inputPtr += 2;
+				} else if(!isInSingleQuote && (isSkipped = _skipExpansion(dataStart, &inputPtr)) != 0) {
+					if(isSkipped == -1) {
+						setMushError(kMushIncompleteInputError);
+						setMushErrorDescription("unterminated expansion");
+						commandFree(command);
+						queueFree(pendingHereDocuments);
+						queueFree(commandQueue);
+						queueFree(tokens);
+						return NULL;
+					}
+				} else if(!isInQuote && (*inputPtr == '(' || *inputPtr == ')')) {
+					if(_skipParenthesis(dataStart, &inputPtr)) {
+						currentState = kMachineStateLeavingPath;
+					}
+				} else if((isspace(*inputPtr) && !isInQuote) || *inputPtr == '\0' || (_isTerminator(*inputPtr) && !isInQuote)) {
 					currentState = kMachineStateLeavingPath;
 				} else {
 					inputPtr++;
@@ -272,19 +685,36 @@ queue_t *commandQueueFromInput(char *inputLine) {
 						setMushErrorDescription(errorDescription);
 						free(errorDescription);
 						errorDescription = NULL;
+						queueFree(pendingHereDocuments);
 						queueFree(commandQueue);
 						queueFree(tokens);
 						return NULL;
 					}
 					assert(0);
 				}
-				lastTerminator = *inputPtr;
-				_setConnectionMaskBasedOnCharacter(command, *inputPtr);
+				lastTerminator = inputPtr;
+				terminatorLength = 1;
+				if((*inputPtr == '&' || *inputPtr == '|') && inputPtr[1] == *inputPtr) {
+					commandSetConnectionMask(command, *inputPtr == '&'
+						? kCommandConnectionAnd : kCommandConnectionOr);
+					terminatorLength = 2;
+				} else if(*inputPtr == ';' && inputPtr[1] == ';') {
+					commandSetConnectionMask(command, kCommandConnectionCaseEnd);
+					terminatorLength = 2;
+				} else if(*inputPtr == '|' && inputPtr[1] == '+') {
+					commandSetConnectionMask(command, kCommandConnectionFanOut);
+					terminatorLength = 2;
+				} else {
+					_setConnectionMaskBasedOnCharacter(command, *inputPtr);
+				}
 				_addTokensToCommand(tokens, command);
 				queueInsert(commandQueue, command, (queueNodeFreeFunction)commandFree);
 				command = NULL;
 				currentState = kMachineStateInitial;
-				inputPtr++;
+				/* The new line is left for reading pending here-documents */
+				if(*inputPtr != '\n') {
+					inputPtr += terminatorLength;
+				}
 				break;
 			case kMachineStateEnteringToken:
 				assert(tokens != NULL);
@@ -296,7 +726,23 @@ queue_t *commandQueueFromInput(char *inputLine) {
 				}
 				break;
 			case kMachineStateParsingToken:
-				if((*inputPtr == ' ' && !isInQuote) || *inputPtr == '\0' || (_isTerminator(*inputPtr) && !isInQuote)) {
+				if(*inputPtr == '\\' && !isInSingleQuote && inputPtr[1] != '\0') {
+					inputPtr += 2;
+				} else if(!isInSingleQuote && (isSkipped = _skipExpansion(dataStart, &inputPtr)) != 0) {
+					if(isSkipped == -1) {
+						setMushError(kMushIncompleteInputError);
+						setMushErrorDescription("unterminated expansion");
+						commandFree(command);
+						queueFree(pendingHereDocuments);
+						queueFree(commandQueue);
+						queueFree(tokens);
+						return NULL;
+					}
+				} else if(!isInQuote && (*inputPtr == '(' || *inputPtr == ')')) {
+					if(_skipParenthesis(dataStart, &inputPtr)) {
+						currentState = kMachineStateLeavingToken;
+					}
+				} else if((isspace(*inputPtr) && !isInQuote) || *inputPtr == '\0' || (_isTerminator(*inputPtr) && !isInQuote)) {
 					currentState = kMachineStateLeavingToken;
 				} else {
 					inputPtr++;
@@ -310,20 +756,17 @@ queue_t *commandQueueFromInput(char *inputLine) {
 				currentState = kMachineStateDefault;
 				break;
 			case kMachineStateEnteringRedirection:
-				if(redirectionType == kRedirectionTypeNone) {
-					if(*inputPtr == '<') {
-						redirectionType = kRedirectionTypeIn;
-						currentState = kMachineStateParsingRedirection;
-					}	else if(*inputPtr == '>') {
-						redirectionType = kRedirectionTypeOut;
-						currentState = kMachineStateParsingRedirection;
-					}
+				redirectionDescriptor = -1;
+				if(isdigit(*inputPtr)) {
+					redirectionDescriptor = (int)strtol(inputPtr, &inputPtr, 10);
 				}
-				inputPtr++;
+				redirectionType = _parseRedirectionOperator(&inputPtr);
+				assert(redirectionType != kRedirectionTypeNone);
+				currentState = kMachineStateParsingRedirection;
 				break;
 			case kMachineStateParsingRedirection:
 				if(dataStart == NULL) {
-					if(isspace(*inputPtr)) {
+					if(*inputPtr != '\n' && isspace(*inputPtr)) {
 						inputPtr++;
 					}	else if(*inputPtr == '\0' || _isTerminator(*inputPtr)) {
 						asprintf(&errorDescription, "parse error near '%c%c'", *(inputPtr - 1), *inputPtr);
@@ -331,14 +774,28 @@ queue_t *commandQueueFromInput(char *inputLine) {
 						setMushErrorDescription(errorDescription);
 						free(errorDescription);
 						errorDescription = NULL;
+						queueFree(pendingHereDocuments);
 						queueFree(commandQueue);
 						queueFree(tokens);
 						return NULL;
+					} else if(_isProcessSubstitution(inputPtr)) {
+						dataStart = inputPtr;
+						if((inputPtr = (char *)_findListEnd(inputPtr + 2)) == NULL) {
+							setMushError(kMushIncompleteInputError);
+							setMushErrorDescription("unterminated process substitution");
+							commandFree(command);
+							queueFree(pendingHereDocuments);
+							queueFree(commandQueue);
+							queueFree(tokens);
+							return NULL;
+						}
+						inputPtr++;
 					} else {
 						dataStart = inputPtr;
 						inputPtr++;
 					}
-				} else if(isspace(*inputPtr) || _isTerminator(*inputPtr) || *inputPtr == '\0' || *inputPtr == '<' || *inputPtr == '>') {
+				} else if(*inputPtr == '\0' || (!isInQuote && (isspace(*inputPtr) || _isTerminator(*inputPtr) || *inputPtr == '<' || *inputPtr == '>'
+				|| *inputPtr == ')'))) {
 					currentState = kMachineStateLeavingRedirection;
 				} else {
 					inputPtr++;
@@ -346,13 +803,36 @@ queue_t *commandQueueFromInput(char *inputLine) {
 				break;
 			case kMachineStateLeavingRedirection:
 				dataEnd = inputPtr;
-				_setRedirectionBasedOnType(command, redirectionType, dataStart, dataEnd - dataStart);
+				if(!_setRedirectionBasedOnType(command, redirectionType, redirectionDescriptor, dataStart, dataEnd - dataStart)) {
+					asprintf(&errorDescription, "bad file descriptor near '%.*s'", (int)(dataEnd - dataStart), dataStart);
+					setMushError(kMushParseError);
+					setMushErrorDescription(errorDescription);
+					free(errorDescription);
+					errorDescription = NULL;
+					queueFree(pendingHereDocuments);
+					queueFree(commandQueue);
+					queueFree(tokens);
+					return NULL;
+				}
+				if(command->hereDocumentDelimiter != NULL) {
+					queueInsert(pendingHereDocuments, command, NULL);
+				}
 				dataStart = NULL;
 				dataEnd = NULL;
 				redirectionType = kRedirectionTypeNone;
+				redirectionDescriptor = -1;
 				currentState = kMachineStateDefault;
 				break;
 			case kMachineStateTerminal:
+				/* The contents of the here-documents have not been provided yet */
+				if(queueCount(pendingHereDocuments) > 0) {
+					setMushError(kMushIncompleteInputError);
+					setMushErrorDescription("unterminated here-document");
+					queueFree(pendingHereDocuments);
+					queueFree(commandQueue);
+					queueFree(tokens);
+					return NULL;
+				}
 				isFinishedParsing = 1;
 				if(command != NULL) {
 					_addTokensToCommand(tokens, command);
@@ -365,10 +845,14 @@ queue_t *commandQueueFromInput(char *inputLine) {
 				/* Determine what the next element is */
 				if(_isTerminator(*inputPtr)) {
 					currentState = kMachineStateParsingCommandTerminator;
-				} else if(*inputPtr == '>' || *inputPtr == '<') {
+				} else if((*inputPtr == '>' || *inputPtr == '<' || _isDescriptorRedirection(inputPtr))
+				&& !_isProcessSubstitution(inputPtr)) {
 					currentState = kMachineStateEnteringRedirection;
 				} else if(*inputPtr == '\0') {
 					currentState = kMachineStateTerminal;
+				} else if(*inputPtr == '#') {
+					/* The new line is left to terminate the command */
+					inputPtr += strcspn(inputPtr, "\n");
 				} else if(isspace(*inputPtr)) {
 					inputPtr++;
 				} else if(command->path == NULL) {
@@ -380,5 +864,7 @@ queue_t *commandQueueFromInput(char *inputLine) {
 		}
 	}
 
+	queueFree(pendingHereDocuments);
+	queueFree(tokens);
 	return commandQueue;
 }
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "printf.h"
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+
+/*! \brief Longest conversion specification passed on to the C library */
+#define PRINTF_SPECIFICATION_SIZE 64
+
+/*!
+ \brief Write the character of the escape sequence following a backslash
+ \param ptr points behind the backslash
+ \param isFormat whether octal escapes are written \c \\nnn rather than
+ \c \\0nnn
+ \param isStopped set if the sequence ends the output
+ \return pointer to the last character of the sequence
+ */
+static const char *_putEscape(writer_t *writer, const char *ptr, int isFormat, int *isStopped)
+{
+	static const char escapes[] = "a\ab\be\033f\fn\nr\rt\tv\v\\\\";
+	const char *escape;
+	int value = 0;
+	int digits;
+	if(*ptr == '\0') {
+		writerPutCharacter(writer, '\\');
+		return ptr - 1;
+	}
+	if(*ptr == 'c' && !isFormat) {
+		*isStopped = 1;
+		return ptr;
+	}
+	for(escape = escapes; *escape != '\0'; escape += 2) {
+		if(*escape == *ptr) {
+			writerPutCharacter(writer, escape[1]);
+			return ptr;
+		}
+	}
+	if((isFormat && *ptr >= '0' && *ptr <= '7') || (!isFormat && *ptr == '0')) {
+		if(!isFormat) {
+			ptr++;
+		}
+		for(digits = 0; digits < 3 && *ptr >= '0' && *ptr <= '7'; digits++, ptr++) {
+			value = value * 8 + (*ptr - '0');
+		}
+		writerPutCharacter(writer, (char)value);
+		return ptr - 1;
+	}
+	/* Not an escape sequence, so it is written as is */
+	writerPutCharacter(writer, '\\');
+	writerPutCharacter(writer, *ptr);
+	return ptr;
+}
+
+int printfPutEscaped(writer_t *writer, const char *string, int isFormat)
+{
+	const char *ptr;
+	int isStopped = 0;
+	for(ptr = string; *ptr != '\0' && !isStopped; ptr++) {
+		if(*ptr == '\\') {
+			ptr = _putEscape(writer, ptr + 1, isFormat, &isStopped);
+		} else {
+			writerPutCharacter(writer, *ptr);
+		}
+	}
+	return isStopped;
+}
+
+/*!
+ \brief Convert a numeric argument
+
+ A leading quote yields the value of the following character.
+
+ \param argument the argument, or \c NULL if it is missing
+ \param isValid cleared if \a argument is not entirely a number
+ \return value of \a argument
+ */
+static intmax_t _numericArgument(const char *argument, int *isValid)
+{
+	char *end;
+	intmax_t value;
+	if(argument == NULL || *argument == '\0') {
+		return 0;
+	}
+	if(*argument == '\'' || *argument == '"') {
+		return (unsigned char)argument[1];
+	}
+	errno = 0;
+	value = strtoimax(argument, &end, 0);
+	if(*end != '\0' || errno != 0) {
+		fprintf(stderr, "printf: %s: invalid number\n", argument);
+		*isValid = 0;
+	}
+	return value;
+}
+
+static double _floatingArgument(const char *argument, int *isValid)
+{
+	char *end;
+	double value;
+	if(argument == NULL || *argument == '\0') {
+		return 0;
+	}
+	if(*argument == '\'' || *argument == '"') {
+		return (unsigned char)argument[1];
+	}
+	value = strtod(argument, &end);
+	if(*end != '\0') {
+		fprintf(stderr, "printf: %s: invalid number\n", argument);
+		*isValid = 0;
+	}
+	return value;
+}
+
+/*!
+ \brief Write \a format once, consuming arguments starting at \a *argi
+ \param isValid cleared if an argument could not be converted
+ \return \c 1 if the output was ended, by \c \\c or an invalid conversion
+ */
+static int _printfFormat(writer_t *writer, const char *format, int argc, char **argv,
+	int *argi, int *isValid)
+{
+	char specification[PRINTF_SPECIFICATION_SIZE];
+	size_t length;
+	const char *argument;
+	const char *ptr;
+	int isStopped = 0;
+	for(ptr = format; *ptr != '\0' && !isStopped; ptr++) {
+		if(*ptr == '\\') {
+			ptr = _putEscape(writer, ptr + 1, 1, &isStopped);
+			continue;
+		}
+		if(*ptr != '%') {
+			writerPutCharacter(writer, *ptr);
+			continue;
+		}
+		if(ptr[1] == '%') {
+			writerPutCharacter(writer, '%');
+			ptr++;
+			continue;
+		}
+		/* Copy flags, field width and precision, resolving '*' */
+		length = 0;
+		specification[length++] = *ptr++;
+		while(*ptr != '\0' && strchr("-+ #0123456789.*", *ptr) != NULL
+			&& length < PRINTF_SPECIFICATION_SIZE - 24) {
+			if(*ptr == '*') {
+				argument = *argi < argc ? argv[(*argi)++] : NULL;
+				length += snprintf(specification + length, PRINTF_SPECIFICATION_SIZE - length,
+					"%d", (int)_numericArgument(argument, isValid));
+			} else {
+				specification[length++] = *ptr;
+			}
+			ptr++;
+		}
+		argument = *argi < argc ? argv[(*argi)++] : NULL;
+		switch(*ptr) {
+			case 'd':
+			case 'i':
+				snprintf(specification + length, PRINTF_SPECIFICATION_SIZE - length, "j%c", *ptr);
+				writerPrintf(writer, specification, _numericArgument(argument, isValid));
+				break;
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X':
+				snprintf(specification + length, PRINTF_SPECIFICATION_SIZE - length, "j%c", *ptr);
+				writerPrintf(writer, specification, (uintmax_t)_numericArgument(argument, isValid));
+				break;
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+				snprintf(specification + length, PRINTF_SPECIFICATION_SIZE - length, "%c", *ptr);
+				writerPrintf(writer, specification, _floatingArgument(argument, isValid));
+				break;
+			case 'c':
+				if(argument != NULL && *argument != '\0') {
+					snprintf(specification + length, PRINTF_SPECIFICATION_SIZE - length, "c");
+					writerPrintf(writer, specification, *argument);
+				}
+				break;
+			case 's':
+				snprintf(specification + length, PRINTF_SPECIFICATION_SIZE - length, "s");
+				writerPrintf(writer, specification, argument != NULL ? argument : "");
+				break;
+			case 'b':
+				isStopped = printfPutEscaped(writer, argument != NULL ? argument : "", 0);
+				break;
+			default:
+				fprintf(stderr, "printf: %%%c: invalid conversion\n", *ptr);
+				*isValid = 0;
+				return 1;
+		}
+	}
+	return isStopped;
+}
+
+int cmd_printf(int argc, char **argv)
+{
+	writer_t writer;
+	int isValid = 1;
+	int isStopped = 0;
+	int argi = 2;
+	int consumed;
+	if(argc > 1 && strcmp(argv[1], "--") == 0) {
+		argv++;
+		argc--;
+	}
+	if(argc < 2) {
+		fprintf(stderr, "usage: printf format [arguments ...]\n");
+		return 2;
+	}
+	writerInitialize(&writer, STDOUT_FILENO);
+	/* The format is reused as long as it consumes arguments */
+	do {
+		consumed = argi;
+		isStopped = _printfFormat(&writer, argv[1], argc, argv, &argi, &isValid);
+	} while(!isStopped && argi < argc && argi > consumed);
+	if(writerFlush(&writer) != 0) {
+		fprintf(stderr, "printf: write error: %s\n", strerror(errno));
+		return 1;
+	}
+	return isValid ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PRINTF_H
+#define PRINTF_H
+
+#include "writer.h"
+
+/*!
+ \addtogroup builtin
+ \{
+ */
+
+/*!
+ \brief Write \a string, interpreting backslash escapes
+
+ Octal escapes are written \c \\nnn in a format string and \c \\0nnn
+ otherwise, as for the \c %b conversion and "echo -e".
+
+ \param writer writer receiving the output
+ \param string the string to be written
+ \param isFormat whether \a string is a format string
+ \return \c 1 if \c \\c ended the output, \c 0 otherwise
+ */
+int printfPutEscaped(writer_t *writer, const char *string, int isFormat);
+
+/*!
+ \brief Run the builtin "printf" command
+
+ Supports the conversions of printf(1), including \c %b. The format is
+ reused until all arguments are consumed.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return exit status of the command
+ */
+int cmd_printf(int argc, char **argv);
+
+/*!
+ \}
+ */
+
+#endif /* PRINTF_H */
@@ -26,7 +26,7 @@
 
 static char *g_prompt = NULL;
 
-void cmd_prompt(int argc, char **argv)
+int cmd_prompt(int argc, char **argv)
 {
 	size_t newSize;
 	char *promptPtr;
@@ -41,17 +41,17 @@ void cmd_prompt(int argc, char **argv)
 	/* If we don't have any arguments, just set an empty string */
 	if(argc == 1) {
 		g_prompt = malloc(1);
-		if(promptPtr == NULL) {
-			return;
+		if(g_prompt == NULL) {
+			return 1;
 		}
 		*g_prompt = '\0';
-		return;
+		return 0;
 	}
 
 	newSize = 0;
 	/* Determine the size of the prompt */
 	for(argi = 1; argi < argc; argi++) {
-		newSize = strlen(argv[argi]);
+		newSize += strlen(argv[argi]);
 		newSize++; /* space */
 	}
 	/* Previous extra size for "space" can be used for the terminator */
@@ -59,7 +59,7 @@ void cmd_prompt(int argc, char **argv)
 	g_prompt = malloc(newSize * sizeof(*g_prompt));
 	promptPtr = g_prompt;
 	if(promptPtr == NULL) {
-		return;
+		return 1;
 	}
 	memset(g_prompt, 0, newSize * sizeof(*g_prompt));
 
@@ -74,6 +74,7 @@ void cmd_prompt(int argc, char **argv)
 			*promptPtr = '\0';
 		}
 	}
+	return 0;
 }
 
 char *getPrompt()
@@ -29,8 +29,9 @@
  \brief Run the "prompt" command with the specified arguments
  \param argc count of elements in \a argv
  \param argv arguments to be passed to the command
+ \return exit status of the command
  */
-void cmd_prompt(int argc, char **argv);
+int cmd_prompt(int argc, char **argv);
 
 /*!
  \}
@@ -30,8 +30,13 @@
 #define BUFFER_SIZE (PATH_MAX-1)
 #endif
 
-void cmd_pwd(int argc, char **argv)
+int cmd_pwd(int argc, char **argv)
 {
 	char buffer[BUFFER_SIZE];
-	printf("%s\n", getcwd(buffer, BUFFER_SIZE));
+	if(getcwd(buffer, BUFFER_SIZE) == NULL) {
+		perror("pwd");
+		return 1;
+	}
+	printf("%s\n", buffer);
+	return 0;
 }
\ No newline at end of file
@@ -24,16 +24,6 @@
 #include <assert.h>
 #include "testing_util.h"
 
-/*! \brief Node of a queue, storing the data and a link to the next node */
-struct __queue_node_t {
-	/*! \brief The data stored in the node */
-	void *data;
-	/*! \brief Next node in the queue */
-	struct __queue_node_t *next;
-	/*! \brief Callback used for freeing \a data */
-	queueNodeFreeFunction freeFunction;
-};
-
 queue_t *queueNew()
 {
 	queue_t *queue;
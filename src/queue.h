@@ -33,8 +33,21 @@
 /*! \brief Prototype for the function callback used to free queue node data */
 typedef void (*queueNodeFreeFunction)(void *);
 
+/*! \brief Node of a queue, storing the data and a link to the next node */
+struct __queue_node_t {
+	/*! \brief The data stored in the node */
+	void *data;
+	/*! \brief Next node in the queue */
+	struct __queue_node_t *next;
+	/*! \brief Callback used for freeing \a data */
+	queueNodeFreeFunction freeFunction;
+};
+
 /*!
  \brief FIFO queue structure
+
+ The nodes may be traversed from \link queue_t::head head \endlink by
+ following each node's \a next link, without removing them.
  */
 typedef struct __queue_t {
 	/*! \brief Head (oldest) node of the queue */
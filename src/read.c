@@ -0,0 +1,474 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "read.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "variables.h"
+
+/*! \brief Size of the block read ahead */
+#define READ_BUFFER_SIZE 65536
+/*! \brief Field separators used if \c IFS is not set */
+#define READ_DEFAULT_IFS " \t\n"
+
+enum {
+	/*! \brief Read one character per system call */
+	kReadModeCharacter = 0,
+	/*! \brief Read blocks of a regular file, seeking back afterwards */
+	kReadModeSeek,
+	/*! \brief Peek at a socket, consuming what was used afterwards */
+	kReadModePeek
+};
+
+/*!
+ \brief Block read ahead, kept between calls so that consecutive lines of a
+ file are read from memory
+ */
+static struct {
+	char data[READ_BUFFER_SIZE];
+	/*! \brief amount of valid characters in \a data */
+	size_t length;
+	/*! \brief offset within the file of \a data[0] */
+	off_t offset;
+	/*! \brief whether \a data holds a block of the file identified below */
+	int isValid;
+	/*! \brief descriptor the last line was read from */
+	int descriptor;
+	/*! \brief offset the descriptor was left at after the last line */
+	off_t end;
+	dev_t device;
+	ino_t inode;
+	off_t size;
+	struct timespec modified;
+} _readAhead;
+
+/*! \brief Input of a single call of the builtin */
+typedef struct __read_input_t {
+	int descriptor;
+	/*! \brief one of the \c kReadMode values */
+	int mode;
+	/*! \brief position of the next character within the block */
+	size_t position;
+} read_input_t;
+
+/*! \brief A line being read, with the characters quoted by a backslash */
+typedef struct __read_line_t {
+	char *data;
+	/*! \brief non-zero for each character of \a data which was quoted */
+	char *isQuoted;
+	size_t length;
+	size_t size;
+} read_line_t;
+
+static void _beginInput(read_input_t *input, int descriptor)
+{
+	struct stat status;
+	off_t offset;
+	input->descriptor = descriptor;
+	input->mode = kReadModeCharacter;
+	input->position = 0;
+	/* Reading the next line of the same file needs no further checks */
+	if(_readAhead.isValid && _readAhead.descriptor == descriptor) {
+		offset = lseek(descriptor, 0, SEEK_CUR);
+		if(offset != -1 && offset == _readAhead.end) {
+			input->mode = kReadModeSeek;
+			input->position = offset - _readAhead.offset;
+			return;
+		}
+	}
+	if(fstat(descriptor, &status) != 0) {
+		return;
+	}
+	if(S_ISSOCK(status.st_mode)) {
+		_readAhead.isValid = 0;
+		_readAhead.length = 0;
+		input->mode = kReadModePeek;
+		return;
+	}
+	offset = S_ISREG(status.st_mode) ? lseek(descriptor, 0, SEEK_CUR) : -1;
+	if(offset == -1) {
+		return;
+	}
+	input->mode = kReadModeSeek;
+	/* The block is reused if the file did not change since it was read */
+	if(_readAhead.isValid && _readAhead.device == status.st_dev
+	&& _readAhead.inode == status.st_ino && _readAhead.size == status.st_size
+	&& _readAhead.modified.tv_sec == status.st_mtim.tv_sec
+	&& _readAhead.modified.tv_nsec == status.st_mtim.tv_nsec
+	&& offset >= _readAhead.offset && offset <= _readAhead.offset + (off_t)_readAhead.length) {
+		input->position = offset - _readAhead.offset;
+		return;
+	}
+	_readAhead.isValid = 1;
+	_readAhead.descriptor = -1;
+	_readAhead.device = status.st_dev;
+	_readAhead.inode = status.st_ino;
+	_readAhead.size = status.st_size;
+	_readAhead.modified = status.st_mtim;
+	_readAhead.offset = offset;
+	_readAhead.length = 0;
+}
+
+/*!
+ \brief Return the next character of \a input
+ \return the character, or \c -1 at the end of the input or on error
+ */
+static int _nextCharacter(read_input_t *input)
+{
+	ssize_t bytesRead;
+	char character;
+	if(input->mode == kReadModeCharacter) {
+		do {
+			bytesRead = read(input->descriptor, &character, 1);
+		} while(bytesRead == -1 && errno == EINTR);
+		return bytesRead == 1 ? (unsigned char)character : -1;
+	}
+	if(input->position == _readAhead.length) {
+		do {
+			if(input->mode == kReadModeSeek) {
+				bytesRead = pread(input->descriptor, _readAhead.data, READ_BUFFER_SIZE,
+					_readAhead.offset + _readAhead.length);
+			} else {
+				/* The peeked block was used up, so it can be consumed */
+				if(_readAhead.length > 0
+				&& read(input->descriptor, _readAhead.data, _readAhead.length) == -1) {
+					return -1;
+				}
+				_readAhead.length = 0;
+				bytesRead = recv(input->descriptor, _readAhead.data, READ_BUFFER_SIZE, MSG_PEEK);
+			}
+		} while(bytesRead == -1 && errno == EINTR);
+		if(bytesRead <= 0) {
+			return -1;
+		}
+		_readAhead.offset += _readAhead.length;
+		_readAhead.length = bytesRead;
+		input->position = 0;
+	}
+	return (unsigned char)_readAhead.data[input->position++];
+}
+
+/*!
+ \brief Leave the input just past the last character returned
+ */
+static void _endInput(read_input_t *input)
+{
+	if(input->mode == kReadModeSeek) {
+		_readAhead.descriptor = input->descriptor;
+		_readAhead.end = lseek(input->descriptor, _readAhead.offset + input->position, SEEK_SET);
+	} else if(input->mode == kReadModePeek) {
+		if(input->position > 0) {
+			read(input->descriptor, _readAhead.data, input->position);
+		}
+		_readAhead.length = 0;
+	}
+}
+
+
+static int _appendSpan(read_line_t *line, const char *data, size_t length)
+{
+	char *grown;
+	size_t size = line->size == 0 ? 128 : line->size;
+	while(line->length + length >= size) {
+		size *= 2;
+	}
+	if(size != line->size) {
+		grown = realloc(line->data, size);
+		if(grown == NULL) {
+			return -1;
+		}
+		line->data = grown;
+		grown = realloc(line->isQuoted, size);
+		if(grown == NULL) {
+			return -1;
+		}
+		line->isQuoted = grown;
+		line->size = size;
+	}
+	memcpy(line->data + line->length, data, length);
+	memset(line->isQuoted + line->length, 0, length);
+	line->length += length;
+	line->data[line->length] = '\0';
+	return 0;
+}
+
+static int _appendCharacter(read_line_t *line, char character, int isQuoted)
+{
+	if(_appendSpan(line, &character, 1) != 0) {
+		return -1;
+	}
+	line->isQuoted[line->length - 1] = isQuoted;
+	return 0;
+}
+
+/*!
+ \brief Read up to \a delimiter or \a count characters
+ \return \c 0 if the line is complete, \c 1 at the end of the input, \c -1 on
+ error
+ */
+static int _readLine(read_line_t *line, int descriptor, int delimiter, long count, int isRaw)
+{
+	read_input_t input;
+	const char *start;
+	const char *end;
+	size_t span;
+	int character;
+	int status = 1;
+	_beginInput(&input, descriptor);
+	while(count != 0) {
+		/* Characters already in memory are copied up to the next delimiter or
+		   backslash at once */
+		if(input.mode != kReadModeCharacter && count < 0 && input.position < _readAhead.length) {
+			start = _readAhead.data + input.position;
+			end = memchr(start, delimiter, _readAhead.length - input.position);
+			span = end != NULL ? (size_t)(end - start) : _readAhead.length - input.position;
+			if(!isRaw && (end = memchr(start, '\\', span)) != NULL) {
+				span = end - start;
+			}
+			if(span > 0) {
+				if(_appendSpan(line, start, span) != 0) {
+					status = -1;
+					break;
+				}
+				input.position += span;
+				continue;
+			}
+		}
+		character = _nextCharacter(&input);
+		if(character == -1) {
+			break;
+		}
+		if(character == '\\' && !isRaw) {
+			character = _nextCharacter(&input);
+			if(character == -1) {
+				break;
+			}
+			/* A quoted new line continues the line */
+			if(character != '\n' && _appendCharacter(line, character, 1) != 0) {
+				status = -1;
+				break;
+			}
+		} else if(character == delimiter) {
+			status = 0;
+			break;
+		} else if(_appendCharacter(line, character, 0) != 0) {
+			status = -1;
+			break;
+		}
+		if(count > 0 && --count == 0) {
+			status = 0;
+		}
+	}
+	_endInput(&input);
+	return status;
+}
+
+enum {
+	kReadSeparatorNone = 0,
+	/*! \brief A space, tab or new line, which may be repeated */
+	kReadSeparatorBlank,
+	/*! \brief Any other character of \c IFS, separating a field each */
+	kReadSeparatorOther
+};
+
+/*!
+ \brief Indicate whether the character at \a index of \a line separates
+ fields
+ \param separators the \c kReadSeparator kind of each character
+ \param isBlank only consider blanks, i.e. spaces, tabs and new lines
+ */
+static int _isSeparator(read_line_t *line, size_t index, const char *separators, int isBlank)
+{
+	char kind = separators[(unsigned char)line->data[index]];
+	if(line->isQuoted[index] || kind == kReadSeparatorNone) {
+		return 0;
+	}
+	return !isBlank || kind == kReadSeparatorBlank;
+}
+
+/*!
+ \brief Split \a line into fields, assigning one to each of \a names and the
+ remainder to the last one, or each of them to an element of \a array
+ \param array receives every field if it is not \c NULL, \a names being
+ unused then
+ \return \c 0 on success, \c -1 on error
+ */
+static int _assignFields(read_line_t *line, char **names, int nameCount, array_t *array)
+{
+	const char *characters = variableGet("IFS");
+	char separators[256] = {kReadSeparatorNone};
+	size_t position = 0;
+	size_t start;
+	size_t end;
+	char *field;
+	int status = 0;
+	int index;
+	if(characters == NULL) {
+		characters = READ_DEFAULT_IFS;
+	}
+	for(; *characters != '\0'; characters++) {
+		separators[(unsigned char)*characters] = strchr(" \t\n", *characters) != NULL
+			? kReadSeparatorBlank : kReadSeparatorOther;
+	}
+	while(position < line->length && _isSeparator(line, position, separators, 1)) {
+		position++;
+	}
+	for(index = 0; array != NULL ? position < line->length : index < nameCount; index++) {
+		start = position;
+		if(array != NULL || index + 1 < nameCount) {
+			while(position < line->length && !_isSeparator(line, position, separators, 0)) {
+				position++;
+			}
+			end = position;
+			/* Blanks around a single other separator form one separator */
+			while(position < line->length && _isSeparator(line, position, separators, 1)) {
+				position++;
+			}
+			if(position < line->length && _isSeparator(line, position, separators, 0)) {
+				position++;
+				while(position < line->length && _isSeparator(line, position, separators, 1)) {
+					position++;
+				}
+			}
+		} else {
+			/* The last variable receives the rest, without trailing blanks */
+			for(end = line->length; end > start && _isSeparator(line, end - 1, separators, 1); end--) {
+			}
+			position = line->length;
+		}
+		field = strndup(line->data + start, end - start);
+		if(field == NULL) {
+			status = -1;
+		} else if(array != NULL ? arraySetIndex(array, index, field) != 0
+			: variableSet(names[index], field) != 0) {
+			status = -1;
+		}
+		free(field);
+	}
+	return status;
+}
+
+int cmd_read(int argc, char **argv)
+{
+	read_line_t line = {NULL, NULL, 0, 0};
+	char *end;
+	int descriptor = STDIN_FILENO;
+	int delimiter = '\n';
+	long count = -1;
+	int isRaw = 0;
+	int status;
+	char **names;
+	char *value;
+	char *arrayName = NULL;
+	array_t *array;
+	int nameCount;
+	int option;
+	int argi;
+	for(argi = 1; argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0'; argi++) {
+		if(strcmp(argv[argi], "--") == 0) {
+			argi++;
+			break;
+		}
+		option = argv[argi][1];
+		if(option == 'r' && argv[argi][2] == '\0') {
+			isRaw = 1;
+			continue;
+		}
+		/* Option values may be attached or follow as the next argument */
+		value = argv[argi][2] != '\0' ? argv[argi] + 2 : argi + 1 < argc ? argv[++argi] : NULL;
+		if(value == NULL || strchr("dnua", option) == NULL) {
+			fprintf(stderr, "usage: read [-r] [-a array] [-d delim] [-n count] [-u fd] [name...]\n");
+			return 2;
+		}
+		switch(option) {
+			case 'd':
+				delimiter = (unsigned char)value[0];
+				break;
+			case 'n':
+				count = strtol(value, &end, 10);
+				if(*end != '\0' || count < 0) {
+					fprintf(stderr, "read: %s: invalid count\n", value);
+					return 2;
+				}
+				break;
+			case 'u':
+				descriptor = (int)strtol(value, &end, 10);
+				if(*end != '\0' || descriptor < 0) {
+					fprintf(stderr, "read: %s: invalid descriptor\n", value);
+					return 2;
+				}
+				break;
+			case 'a':
+				arrayName = value;
+				break;
+		}
+	}
+	names = argv + argi;
+	nameCount = argc - argi;
+	if(arrayName != NULL) {
+		names = &arrayName;
+		nameCount = 1;
+	}
+	for(argi = 0; argi < nameCount; argi++) {
+		if(variableNameLength(names[argi]) != strlen(names[argi])) {
+			fprintf(stderr, "read: %s: invalid variable name\n", names[argi]);
+			return 2;
+		}
+	}
+	status = _readLine(&line, descriptor, delimiter, count, isRaw);
+	/* An empty line still needs a string */
+	if(status != -1 && line.data == NULL && _appendSpan(&line, "", 0) != 0) {
+		status = -1;
+	}
+	if(status != -1) {
+		if(nameCount == 0) {
+			/* REPLY receives the line as it is */
+			if(variableSet("REPLY", line.data) != 0) {
+				status = -1;
+			}
+		} else if(arrayName != NULL) {
+			array = arrayNew(0);
+			/* The array belongs to the variable once it is set */
+			if(array == NULL || _assignFields(&line, NULL, 0, array) != 0) {
+				arrayFree(array);
+				status = -1;
+			} else if(variableSetArray(arrayName, array) != 0) {
+				status = -1;
+			}
+		} else if(_assignFields(&line, names, nameCount, NULL) != 0) {
+			status = -1;
+		}
+	}
+	if(status == -1) {
+		fprintf(stderr, "read: %s\n", strerror(errno));
+		status = 1;
+	}
+	free(line.data);
+	free(line.isQuoted);
+	return status;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*!
+ \addtogroup builtin
+ \{
+ */
+
+/*!
+ \brief Run the builtin "read" command
+
+ Reads a line and splits it into fields at the characters of \c IFS, which
+ are assigned to the named variables, the last receiving the rest of the
+ line. Without names the whole line is assigned to \c REPLY. Backslashes
+ quote the next character unless \c -r is given. \c -d sets the delimiter
+ instead of a new line, \c -n reads at most that many characters, and
+ \c -u reads from the given descriptor instead of standard input. \c -a
+ assigns every field to an element of the given array instead.
+
+ Where nothing is lost by reading ahead, more than one character is read at
+ a time: regular files are read in blocks and the offset is set to just past
+ the line afterwards, and sockets are peeked at before consuming the line.
+ Other input, such as pipes, is read one character at a time so that the
+ commands that follow can read the rest.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return \c 0 if a delimiter was read, \c 1 at the end of the input
+ */
+int cmd_read(int argc, char **argv);
+
+/*!
+ \}
+ */
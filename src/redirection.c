@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "redirection.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdio.h>
+#include <assert.h>
+#include "testing_util.h"
+
+/*! \brief Permissions of files created by redirections, before the umask */
+#define REDIRECTION_FILE_MODE 0666
+
+static redirection_t *_redirectionNew(int action, int descriptor)
+{
+	redirection_t *redirection;
+	redirection = malloc(sizeof(*redirection));
+	if(redirection == NULL) {
+		return NULL;
+	}
+	redirection->action = action;
+	redirection->descriptor = descriptor;
+	redirection->sourceDescriptor = -1;
+	redirection->path = NULL;
+	redirection->flags = 0;
+	return redirection;
+}
+
+redirection_t *redirectionNewOpen(int descriptor, char *path, int flags)
+{
+	redirection_t *redirection;
+	assert(path != NULL);
+	redirection = _redirectionNew(kRedirectionActionOpen, descriptor);
+	if(redirection == NULL) {
+		return NULL;
+	}
+	redirection->path = strdup(path);
+	redirection->flags = flags;
+	return redirection;
+}
+
+redirection_t *redirectionNewDuplicate(int descriptor, int sourceDescriptor)
+{
+	redirection_t *redirection;
+	redirection = _redirectionNew(kRedirectionActionDuplicate, descriptor);
+	if(redirection != NULL) {
+		redirection->sourceDescriptor = sourceDescriptor;
+	}
+	return redirection;
+}
+
+redirection_t *redirectionNewClose(int descriptor)
+{
+	return _redirectionNew(kRedirectionActionClose, descriptor);
+}
+
+void redirectionFree(redirection_t *redirection)
+{
+	assert(redirection != NULL);
+	if(redirection->path != NULL) {
+		free(redirection->path);
+	}
+	free(redirection);
+}
+
+static int _redirectionApply(redirection_t *redirection)
+{
+	int fd;
+	switch(redirection->action) {
+		case kRedirectionActionOpen:
+			fd = open(redirection->path, redirection->flags | O_CLOEXEC, REDIRECTION_FILE_MODE);
+			if(fd == -1) {
+				return -1;
+			}
+			if(fd != redirection->descriptor) {
+				if(dup2(fd, redirection->descriptor) == -1) {
+					close(fd);
+					return -1;
+				}
+				close(fd);
+			} else {
+				/* Opened straight onto the target, which must survive exec */
+				fcntl(fd, F_SETFD, 0);
+			}
+			return 0;
+		case kRedirectionActionDuplicate:
+			if(redirection->sourceDescriptor == redirection->descriptor) {
+				/* dup2() leaves the close-on-exec flag alone in this case */
+				return fcntl(redirection->descriptor, F_SETFD, 0);
+			}
+			return dup2(redirection->sourceDescriptor, redirection->descriptor) == -1 ? -1 : 0;
+		case kRedirectionActionClose:
+			/* Closing a descriptor which is not open is not an error */
+			if(close(redirection->descriptor) == -1 && errno != EBADF) {
+				return -1;
+			}
+			return 0;
+	}
+	errno = EINVAL;
+	return -1;
+}
+
+redirection_t *redirectionsApply(queue_t *redirections)
+{
+	struct __queue_node_t *node;
+	redirection_t *redirection;
+	for(node = redirections->head; node != NULL; node = node->next) {
+		redirection = node->data;
+		if(_redirectionApply(redirection) != 0) {
+			return redirection;
+		}
+	}
+	return NULL;
+}
+
+void redirectionPrintError(redirection_t *redirection)
+{
+	if(redirection->action == kRedirectionActionOpen) {
+		fprintf(stderr, "mush: %s: %s\n", redirection->path, strerror(errno));
+	} else if(redirection->action == kRedirectionActionDuplicate) {
+		fprintf(stderr, "mush: %d: %s\n", redirection->sourceDescriptor, strerror(errno));
+	} else {
+		fprintf(stderr, "mush: %d: %s\n", redirection->descriptor, strerror(errno));
+	}
+}
+
+int redirectionsAddToSpawnFileActions(queue_t *redirections, posix_spawn_file_actions_t *fileActions)
+{
+	struct __queue_node_t *node;
+	redirection_t *redirection;
+	int status = 0;
+	for(node = redirections->head; node != NULL && status == 0; node = node->next) {
+		redirection = node->data;
+		switch(redirection->action) {
+			case kRedirectionActionOpen:
+				status = posix_spawn_file_actions_addopen(fileActions,
+					redirection->descriptor, redirection->path, redirection->flags,
+					REDIRECTION_FILE_MODE);
+				break;
+			case kRedirectionActionDuplicate:
+				status = posix_spawn_file_actions_adddup2(fileActions,
+					redirection->sourceDescriptor, redirection->descriptor);
+				break;
+			case kRedirectionActionClose:
+				status = posix_spawn_file_actions_addclose(fileActions,
+					redirection->descriptor);
+				break;
+		}
+	}
+	return status;
+}
+
+int redirectionMoveAside(int descriptor)
+{
+	int moved;
+	if(descriptor >= 10) {
+		return descriptor;
+	}
+	moved = fcntl(descriptor, F_DUPFD_CLOEXEC, 10);
+	if(moved == -1) {
+		return descriptor;
+	}
+	close(descriptor);
+	return moved;
+}
+
+int redirectionPipe(int pipeDescriptors[2])
+{
+#if defined(__linux__)
+	return pipe2(pipeDescriptors, O_CLOEXEC);
+#else
+	if(pipe(pipeDescriptors) != 0) {
+		return -1;
+	}
+	fcntl(pipeDescriptors[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pipeDescriptors[1], F_SETFD, FD_CLOEXEC);
+	return 0;
+#endif
+}
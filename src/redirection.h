@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef REDIRECTION_H
+#define REDIRECTION_H
+
+#include <spawn.h>
+#include "queue.h"
+
+/*!
+ \addtogroup redirection
+ \{
+ */
+
+enum {
+	/*! \brief Open a file onto the descriptor */
+	kRedirectionActionOpen = 0,
+	/*! \brief Duplicate another descriptor onto the descriptor */
+	kRedirectionActionDuplicate,
+	/*! \brief Close the descriptor */
+	kRedirectionActionClose
+};
+
+/*!
+ \brief A single action performed on the file descriptors of a child process
+
+ Redirections are kept in a queue and applied in order, so a later action may
+ refer to a descriptor set up by an earlier one (e.g. \c "> file 2>&1").
+ */
+typedef struct __redirection_t {
+	/*! \brief action to be performed */
+	int action;
+	/*! \brief descriptor being redirected */
+	int descriptor;
+	/*! \brief descriptor duplicated by \c kRedirectionActionDuplicate */
+	int sourceDescriptor;
+	/*! \brief path opened by \c kRedirectionActionOpen, or \a NULL */
+	char *path;
+	/*! \brief flags passed to open() by \c kRedirectionActionOpen */
+	int flags;
+} redirection_t;
+
+/*!
+ \brief Initialize a redirection opening \a path onto \a descriptor
+
+ The \a path string is copied. As with malloc() and free(), each redirection
+ should be paired with a call to redirectionFree().
+
+ \param descriptor the descriptor to be redirected
+ \param path the path to be opened
+ \param flags flags passed to open(), e.g. \c O_WRONLY|O_CREAT|O_APPEND
+ \return initialized redirection, or \c NULL on error
+ */
+redirection_t *redirectionNewOpen(int descriptor, char *path, int flags);
+
+/*!
+ \brief Initialize a redirection duplicating \a sourceDescriptor onto
+ \a descriptor, as with dup2()
+ \param descriptor the descriptor to be redirected
+ \param sourceDescriptor the descriptor to be duplicated
+ \return initialized redirection, or \c NULL on error
+ */
+redirection_t *redirectionNewDuplicate(int descriptor, int sourceDescriptor);
+
+/*!
+ \brief Initialize a redirection closing \a descriptor
+ \param descriptor the descriptor to be closed
+ \return initialized redirection, or \c NULL on error
+ */
+redirection_t *redirectionNewClose(int descriptor);
+
+/*!
+ \brief Free memory allocated by one of the redirectionNew functions
+ \param redirection the redirection to be freed
+ */
+void redirectionFree(redirection_t *redirection);
+
+/*!
+ \brief Apply each redirection in the queue to the current process
+
+ This is intended to be called in a child process between fork() and exec().
+ Descriptors opened along the way are only kept at their target, so nothing
+ but the redirected descriptors is inherited by the executed program.
+
+ \param redirections queue of \c redirection_t objects
+ \return the redirection which failed, with \c errno set, or \c NULL on success
+ */
+redirection_t *redirectionsApply(queue_t *redirections);
+
+/*!
+ \brief Print why \a redirection could not be applied, using \c errno
+ \param redirection the redirection returned by redirectionsApply()
+ */
+void redirectionPrintError(redirection_t *redirection);
+
+/*!
+ \brief Add each redirection in the queue to spawn file actions
+
+ The resulting \a fileActions perform the same redirections as
+ redirectionsApply() when passed to posix_spawn().
+
+ \param redirections queue of \c redirection_t objects
+ \param fileActions initialized file actions to add the redirections to
+ \return \c 0 on success, an error number otherwise
+ */
+int redirectionsAddToSpawnFileActions(queue_t *redirections, posix_spawn_file_actions_t *fileActions);
+
+/*!
+ \brief Create a pipe with both descriptors closed on exec
+
+ The descriptors only survive exec() once they are duplicated onto their
+ target, so unrelated children never hold on to either end of the pipe.
+
+ \param pipeDescriptors array receiving the read and write descriptors
+ \return \c 0 on success, \c -1 on error
+ */
+int redirectionPipe(int pipeDescriptors[2]);
+
+/*!
+ \brief Move a descriptor kept open by the shell itself above the
+ descriptors \c 0 to \c 9, which commands may redirect
+
+ The descriptor is then closed on exec, so \c "exec 3< file" neither
+ replaces it nor passes it on.
+
+ \param descriptor the descriptor, which is closed once it was moved
+ \return the new descriptor, or \a descriptor if it could not be moved
+ */
+int redirectionMoveAside(int descriptor);
+
+/*!
+ \}
+ */
+
+#endif /* REDIRECTION_H */
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include "schedule.h"
+#include "ulimit.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__linux__)
+/*! \brief Bits of an I/O priority below its class, see ioprio_set(2) */
+#define SCHEDULE_IO_CLASS_SHIFT 13
+/*! \brief ioprio_set(2) target for a single process */
+#define SCHEDULE_IO_WHO_PROCESS 1
+#endif
+
+/*! \brief I/O scheduling classes, see ioprio_set(2) */
+enum {
+	kScheduleIoClassRealtime = 1,
+	kScheduleIoClassBestEffort = 2,
+	kScheduleIoClassIdle = 3
+};
+
+/*! \brief Names of the I/O scheduling classes, with their short forms */
+static const struct {
+	const char *name;
+	int ioClass;
+} _ioClasses[] = {
+	{"realtime", kScheduleIoClassRealtime},
+	{"rt", kScheduleIoClassRealtime},
+	{"best-effort", kScheduleIoClassBestEffort},
+	{"be", kScheduleIoClassBestEffort},
+	{"idle", kScheduleIoClassIdle},
+	{NULL, 0}
+};
+
+int scheduleIsAttribute(const char *word)
+{
+	const char *ptr = word + 1;
+	if(word[0] != '@' || !isalpha((unsigned char)*ptr)) {
+		return 0;
+	}
+	while(isalnum((unsigned char)*ptr)) {
+		ptr++;
+	}
+	return *ptr == '=';
+}
+
+/*!
+ \brief Parse the decimal number at \a *text, advancing past it
+ \return \c 0 on success, \c -1 if there is none
+ */
+static int _parseNumber(const char **text, long *number)
+{
+	char *end;
+	if(!isdigit((unsigned char)**text) && **text != '-') {
+		return -1;
+	}
+	*number = strtol(*text, &end, 10);
+	if(end == *text) {
+		return -1;
+	}
+	*text = end;
+	return 0;
+}
+
+static int _applyNice(const char *value)
+{
+	long niceness;
+	if(_parseNumber(&value, &niceness) != 0 || *value != '\0') {
+		errno = EINVAL;
+		return -1;
+	}
+	return setpriority(PRIO_PROCESS, 0, (int)niceness);
+}
+
+#if defined(__linux__)
+/*!
+ \brief Restrict the process to the CPUs of \a value, a list of numbers and
+ ranges such as \c "0-3,6"
+ */
+static int _applyCpus(const char *value)
+{
+	cpu_set_t cpus;
+	long first;
+	long last;
+	CPU_ZERO(&cpus);
+	do {
+		if(_parseNumber(&value, &first) != 0) {
+			errno = EINVAL;
+			return -1;
+		}
+		last = first;
+		if(*value == '-') {
+			value++;
+			if(_parseNumber(&value, &last) != 0) {
+				errno = EINVAL;
+				return -1;
+			}
+		}
+		if(first < 0 || last < first || last >= CPU_SETSIZE) {
+			errno = EINVAL;
+			return -1;
+		}
+		for(; first <= last; first++) {
+			CPU_SET(first, &cpus);
+		}
+	} while(*value++ == ',');
+	if(value[-1] != '\0') {
+		errno = EINVAL;
+		return -1;
+	}
+	return sched_setaffinity(0, sizeof(cpus), &cpus);
+}
+
+/*!
+ \brief Set the I/O scheduling class of the process from \a value, a class
+ name optionally followed by \c : and a level from \c 0 (highest) to \c 7
+ */
+static int _applyIo(const char *value)
+{
+	size_t length = strcspn(value, ":");
+	long level = 4;
+	int index;
+	for(index = 0; _ioClasses[index].name != NULL; index++) {
+		if(strlen(_ioClasses[index].name) == length
+		&& strncmp(_ioClasses[index].name, value, length) == 0) {
+			break;
+		}
+	}
+	value += length;
+	if(*value == ':') {
+		value++;
+		if(_parseNumber(&value, &level) != 0) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+	if(_ioClasses[index].name == NULL || *value != '\0' || level < 0 || level > 7) {
+		errno = EINVAL;
+		return -1;
+	}
+	/* The idle class has no levels */
+	if(_ioClasses[index].ioClass == kScheduleIoClassIdle) {
+		level = 0;
+	}
+	return (int)syscall(SYS_ioprio_set, SCHEDULE_IO_WHO_PROCESS, 0,
+		(_ioClasses[index].ioClass << SCHEDULE_IO_CLASS_SHIFT) | (int)level);
+}
+#else
+static int _applyCpus(const char *value)
+{
+	errno = ENOSYS;
+	return -1;
+}
+
+static int _applyIo(const char *value)
+{
+	errno = ENOSYS;
+	return -1;
+}
+#endif
+
+int scheduleApply(const char *attribute)
+{
+	const char *value = strchr(attribute, '=');
+	size_t length;
+	if(value == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	length = value - attribute;
+	value++;
+	if(length == 4 && strncmp(attribute, "cpus", length) == 0) {
+		return _applyCpus(value);
+	} else if(length == 4 && strncmp(attribute, "nice", length) == 0) {
+		return _applyNice(value);
+	} else if(length == 2 && strncmp(attribute, "io", length) == 0) {
+		return _applyIo(value);
+	}
+	return ulimitApply(attribute);
+}
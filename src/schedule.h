@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+/*!
+ \addtogroup schedule
+ \{
+ */
+
+/*!
+ \brief Indicate whether \a word is a scheduling attribute, such as
+ \c "@nice=5", preceding a command
+ */
+int scheduleIsAttribute(const char *word);
+
+/*!
+ \brief Apply the scheduling attribute \a attribute to the calling process,
+ from which its children inherit it
+
+ The attribute is written without the leading \c @:
+ - \c "cpus=0-3,6" restricts the process to a list of CPUs, as with
+   sched_setaffinity()
+ - \c "nice=5" sets the niceness, as with setpriority()
+ - \c "io=idle", \c "io=best-effort:4" or \c "io=realtime:0" sets the I/O
+   scheduling class and level, as with ioprio_set()
+ - resource limits such as \c "memory=1G", as with ulimitApply()
+
+ \param attribute the attribute, as \c name=value
+ \return \c 0 on success, \c -1 on error with \c errno set. \c EINVAL is
+ set for an unknown name or a malformed value
+ */
+int scheduleApply(const char *attribute);
+
+/*!
+ \}
+ */
+
+#endif /* SCHEDULE_H */
@@ -0,0 +1,1661 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "script.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fnmatch.h>
+#include "command.h"
+#include "exec.h"
+#include "expansion.h"
+#include "functions.h"
+#include "jobs.h"
+#include "mush_error.h"
+#include "optimizer.h"
+#include "variables.h"
+#include "schedule.h"
+#include "options.h"
+
+/*! \brief Marks a jump which has not been emitted */
+#define SCRIPT_NO_JUMP ((size_t)-1)
+
+enum {
+	kScriptFrameIf = 0,
+	kScriptFrameWhile,
+	kScriptFrameUntil,
+	kScriptFrameFor,
+	kScriptFrameCase
+};
+
+enum {
+	/*! \brief Reading the condition (\c if, \c elif, \c while), or the words
+	 of a \c for up to \c do */
+	kScriptFrameStateCondition = 0,
+	/*! \brief Reading the commands following \c then, \c do or a pattern */
+	kScriptFrameStateBody,
+	/*! \brief Reading the commands following \c else */
+	kScriptFrameStateElse,
+	/*! \brief Expecting the patterns of a \c case clause, or \c esac */
+	kScriptFrameStatePatterns,
+	/*! \brief Reading further patterns after a \c | */
+	kScriptFrameStateAlternatives
+};
+
+/*! \brief A construct which is being compiled */
+typedef struct __script_frame_t {
+	/*! \brief one of the \c kScriptFrame values */
+	int type;
+	/*! \brief one of the \c kScriptFrameState values */
+	int state;
+	/*! \brief first instruction of the construct */
+	size_t start;
+	/*! \brief amounts of pipelines, word lists and definitions of the
+	 script before the construct */
+	size_t pipelineStart;
+	size_t wordListStart;
+	size_t definitionStart;
+	/*! \brief instruction at which each iteration of a loop starts */
+	size_t top;
+	/*! \brief conditional jump to the next branch, clause or the end of the
+	 loop, or \c SCRIPT_NO_JUMP */
+	size_t condition;
+	/*! \brief jump of a preceding \c && or \c || over the whole construct */
+	size_t skip;
+	/*! \brief jumps to the end of the construct, including \c break */
+	size_t *exits;
+	size_t exitCount;
+	/*! \brief patterns of the \c case clause being read */
+	char **patterns;
+	size_t patternCount;
+} script_frame_t;
+
+/*! \brief State of the compilation of a script */
+typedef struct __script_compiler_t {
+	script_t *script;
+	/*! \brief constructs being compiled, innermost last */
+	script_frame_t *frames;
+	size_t frameCount;
+	/*! \brief jump of a \c && or \c || over the next pipeline or construct,
+	 or \c SCRIPT_NO_JUMP */
+	size_t skip;
+	/*! \brief whether the script is the body of a subshell, ended by \c ) */
+	int isSubshell;
+	/*! \brief whether the script is a single construct, ended by the reserved
+	 word terminating it */
+	int isConstruct;
+	/*! \brief command which followed the \c ) ending the subshell, or the
+	 reserved word ending the construct, once read */
+	command_t *closing;
+	/*! \brief the construct terminated last, see _wrapConstruct() */
+	script_frame_t terminated;
+} script_compiler_t;
+
+/*! \brief Reserved words starting each type of construct */
+static const char *_frameNames[] = {"if", "while", "until", "for", "case", NULL};
+
+/*! \brief Words which start or continue a construct if they start a command */
+static const char *_reservedWords[] = {
+	"if", "then", "elif", "else", "fi", "while", "until", "do", "done", "for",
+	"case", "esac", "}", NULL
+};
+
+static int _isReservedWord(const char *word)
+{
+	int index;
+	for(index = 0; _reservedWords[index] != NULL; index++) {
+		if(strcmp(_reservedWords[index], word) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int _syntaxError(const char *word)
+{
+	char *description;
+	setMushError(kMushParseError);
+	if(asprintf(&description, "parse error near '%s'", word) != -1) {
+		setMushErrorDescription(description);
+		free(description);
+	}
+	return -1;
+}
+
+/*!
+ \brief Append an instruction to the script
+ \return index of the instruction, or \c SCRIPT_NO_JUMP on error
+ */
+static size_t _emit(script_compiler_t *compiler, int opcode, int operand)
+{
+	script_t *script = compiler->script;
+	script_instruction_t *grown;
+	/* The array grows in powers of two */
+	if((script->instructionCount & (script->instructionCount - 1)) == 0) {
+		grown = realloc(script->instructions,
+			(script->instructionCount == 0 ? 1 : script->instructionCount * 2) * sizeof(*grown));
+		if(grown == NULL) {
+			return SCRIPT_NO_JUMP;
+		}
+		script->instructions = grown;
+	}
+	script->instructions[script->instructionCount].opcode = opcode;
+	script->instructions[script->instructionCount].operand = operand;
+	script->instructions[script->instructionCount].target = SCRIPT_NO_JUMP;
+	return script->instructionCount++;
+}
+
+/*!
+ \brief Make the jump at \a index continue at the next emitted instruction
+ */
+static void _patch(script_compiler_t *compiler, size_t index)
+{
+	if(index != SCRIPT_NO_JUMP) {
+		compiler->script->instructions[index].target = compiler->script->instructionCount;
+	}
+}
+
+static int _addPipeline(script_compiler_t *compiler, queue_t *pipeline)
+{
+	script_t *script = compiler->script;
+	queue_t **grown;
+	grown = realloc(script->pipelines, (script->pipelineCount + 1) * sizeof(*grown));
+	if(grown == NULL) {
+		return -1;
+	}
+	script->pipelines = grown;
+	script->pipelines[script->pipelineCount] = pipeline;
+	return script->pipelineCount++;
+}
+
+/*!
+ \brief Add a \c NULL terminated list of words, which is owned by the script
+ \return index of the list, or \c -1 on error
+ */
+static int _addWordList(script_compiler_t *compiler, char **words)
+{
+	script_t *script = compiler->script;
+	char ***grown;
+	if(words == NULL) {
+		return -1;
+	}
+	grown = realloc(script->wordLists, (script->wordListCount + 1) * sizeof(*grown));
+	if(grown == NULL) {
+		return -1;
+	}
+	script->wordLists = grown;
+	script->wordLists[script->wordListCount] = words;
+	return script->wordListCount++;
+}
+
+/*!
+ \brief Copy \a count words of \a words, preceded by \a first if it is not
+ \c NULL, into a \c NULL terminated list
+ */
+static char **_copyWords(const char *first, char **words, size_t count)
+{
+	char **list;
+	size_t index = 0;
+	list = malloc((count + 2) * sizeof(*list));
+	if(list == NULL) {
+		return NULL;
+	}
+	if(first != NULL) {
+		list[index++] = strdup(first);
+	}
+	for(; count > 0; count--, words++) {
+		list[index++] = strdup(*words);
+	}
+	list[index] = NULL;
+	return list;
+}
+
+static void _freeWords(char **words)
+{
+	char **word;
+	for(word = words; *word != NULL; word++) {
+		free(*word);
+	}
+	free(words);
+}
+
+static void _freeCommand(command_t *command)
+{
+	commandFreeArguments(command);
+	commandFree(command);
+	free(command);
+}
+
+/*!
+ \brief Free \a pipeline along with its commands
+ */
+static void _freePipeline(queue_t *pipeline)
+{
+	command_t *command;
+	while(queueRemove(pipeline, (void *)&command)) {
+		_freeCommand(command);
+	}
+	queueFree(pipeline);
+}
+
+/*!
+ \brief Allocate an empty script
+ \return the script, or \c NULL on error
+ */
+static script_t *_newScript()
+{
+	script_t *script = malloc(sizeof(*script));
+	if(script == NULL) {
+		return NULL;
+	}
+	script->instructions = NULL;
+	script->instructionCount = 0;
+	script->pipelines = NULL;
+	script->pipelineCount = 0;
+	script->optimized = NULL;
+	script->wordLists = NULL;
+	script->wordListCount = 0;
+	script->definitions = NULL;
+	script->definitionCount = 0;
+	script->references = 1;
+	return script;
+}
+
+/*!
+ \brief Indicate whether \a command starts a group or subshell
+ */
+static int _isCompoundStart(command_t *command)
+{
+	return command->argc > 0
+		&& (strcmp(command->argv[0], "{") == 0 || strcmp(command->argv[0], "(") == 0);
+}
+
+/*!
+ \brief Indicate whether \a command starts a construct, such as \c while
+ */
+static int _isConstructStart(command_t *command)
+{
+	int index;
+	for(index = 0; command->argc > 0 && _frameNames[index] != NULL; index++) {
+		if(strcmp(command->argv[0], _frameNames[index]) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*!
+ \brief Indicate whether the reserved word ending a construct, left as
+ \a command, is followed by redirections or a connection which apply to the
+ construct as a whole
+ */
+static int _isConstructRedirected(command_t *command)
+{
+	return queueCount(command->redirections) > 0 || command->hereDocument != NULL
+		|| command->connectionMask == kCommandConnectionPipe
+		|| command->connectionMask == kCommandConnectionFanOut
+		|| command->connectionMask == kCommandConnectionBackground;
+}
+
+/*!
+ \brief Indicate whether words other than the \c ) of a subshell follow the
+ reserved word ending a construct
+ */
+static int _hasTrailingWords(command_t *command)
+{
+	return command->argc > 1 && strcmp(command->argv[1], ")") != 0;
+}
+
+/*!
+ \brief Remove the first \a count words of \a command, such as a reserved word
+ */
+static void _shiftWords(command_t *command, int count)
+{
+	int argi;
+	for(argi = 0; argi < count; argi++) {
+		free(command->argv[argi]);
+	}
+	memmove(command->argv, command->argv + count,
+		(command->argc - count + 1) * sizeof(*command->argv));
+	command->argc -= count;
+	command->path = command->argc > 0 ? command->argv[0] : NULL;
+}
+
+/*!
+ \brief Move the scheduling attributes preceding the words of \a command into
+ its \link command_t::attributes attributes \endlink, so they also apply to
+ a group or subshell
+ \return \c 0 on success, \c -1 on error
+ */
+static int _takeAttributes(command_t *command)
+{
+	int count = 0;
+	while(count < command->argc && scheduleIsAttribute(command->argv[count])) {
+		count++;
+	}
+	if(count == 0) {
+		return 0;
+	}
+	command->attributes = malloc((count + 1) * sizeof(*command->attributes));
+	if(command->attributes == NULL) {
+		return -1;
+	}
+	/* The words are moved */
+	memcpy(command->attributes, command->argv, count * sizeof(*command->argv));
+	command->attributes[count] = NULL;
+	memmove(command->argv, command->argv + count,
+		(command->argc - count + 1) * sizeof(*command->argv));
+	command->argc -= count;
+	command->path = command->argc > 0 ? command->argv[0] : NULL;
+	return 0;
+}
+
+static script_frame_t *_pushFrame(script_compiler_t *compiler, int type, int state)
+{
+	script_frame_t *grown;
+	script_frame_t *frame;
+	grown = realloc(compiler->frames, (compiler->frameCount + 1) * sizeof(*grown));
+	if(grown == NULL) {
+		return NULL;
+	}
+	compiler->frames = grown;
+	frame = &compiler->frames[compiler->frameCount++];
+	frame->type = type;
+	frame->state = state;
+	frame->start = compiler->script->instructionCount;
+	frame->pipelineStart = compiler->script->pipelineCount;
+	frame->wordListStart = compiler->script->wordListCount;
+	frame->definitionStart = compiler->script->definitionCount;
+	frame->top = compiler->script->instructionCount;
+	frame->condition = SCRIPT_NO_JUMP;
+	/* A preceding && or || skips the construct as a whole */
+	frame->skip = compiler->skip;
+	compiler->skip = SCRIPT_NO_JUMP;
+	frame->exits = NULL;
+	frame->exitCount = 0;
+	frame->patterns = NULL;
+	frame->patternCount = 0;
+	return frame;
+}
+
+static script_frame_t *_topFrame(script_compiler_t *compiler)
+{
+	return compiler->frameCount > 0 ? &compiler->frames[compiler->frameCount - 1] : NULL;
+}
+
+static void _freeFrame(script_frame_t *frame)
+{
+	size_t index;
+	for(index = 0; index < frame->patternCount; index++) {
+		free(frame->patterns[index]);
+	}
+	free(frame->patterns);
+	free(frame->exits);
+}
+
+/*!
+ \brief Emit a jump to the end of the construct of \a frame
+ */
+static int _emitExit(script_compiler_t *compiler, script_frame_t *frame)
+{
+	size_t *grown;
+	size_t jump = _emit(compiler, kScriptOpJump, 0);
+	if(jump == SCRIPT_NO_JUMP) {
+		return -1;
+	}
+	grown = realloc(frame->exits, (frame->exitCount + 1) * sizeof(*grown));
+	if(grown == NULL) {
+		return -1;
+	}
+	frame->exits = grown;
+	frame->exits[frame->exitCount++] = jump;
+	return 0;
+}
+
+/*!
+ \brief Terminate the construct of the innermost frame at the next
+ instruction
+ */
+static void _popFrame(script_compiler_t *compiler)
+{
+	script_frame_t *frame = _topFrame(compiler);
+	size_t index;
+	for(index = 0; index < frame->exitCount; index++) {
+		_patch(compiler, frame->exits[index]);
+	}
+	_patch(compiler, frame->skip);
+	_freeFrame(frame);
+	compiler->terminated = *frame;
+	compiler->terminated.exits = NULL;
+	compiler->terminated.patterns = NULL;
+	compiler->frameCount--;
+}
+
+/*!
+ \brief Move the construct terminated last into a script of its own, which
+ becomes the body of \a command and runs like a group
+
+ The instructions, pipelines, word lists and definitions of the construct
+ are the last ones of the script, so they are moved as they are, with their
+ indices rebased. The jump of a preceding \c && or \c || is left to skip
+ \a command instead.
+ \return \c 0 on success, \c -1 on error
+ */
+static int _wrapConstruct(script_compiler_t *compiler, command_t *command)
+{
+	script_frame_t *construct = &compiler->terminated;
+	script_t *script = compiler->script;
+	script_instruction_t *instruction;
+	script_t *body;
+	size_t count = script->instructionCount - construct->start;
+	size_t size;
+	size_t index;
+	size_t exit;
+	int isLeaving = compiler->skip != SCRIPT_NO_JUMP && compiler->skip >= construct->start;
+	/* A break or continue of an enclosing loop cannot leave the body */
+	for(index = 0; index < compiler->frameCount; index++) {
+		for(exit = 0; exit < compiler->frames[index].exitCount; exit++) {
+			isLeaving = isLeaving || compiler->frames[index].exits[exit] >= construct->start;
+		}
+	}
+	for(index = construct->start; index < script->instructionCount; index++) {
+		instruction = &script->instructions[index];
+		isLeaving = isLeaving || (instruction->target != SCRIPT_NO_JUMP
+			&& (instruction->target < construct->start || instruction->target > script->instructionCount));
+	}
+	if(isLeaving) {
+		setMushError(kMushParseError);
+		setMushErrorDescription("break and continue cannot leave a redirected or piped construct");
+		return -1;
+	}
+	body = _newScript();
+	if(body == NULL) {
+		return -1;
+	}
+	/* The instructions of a script grow in powers of two */
+	for(size = 1; size < count; size *= 2) {
+	}
+	body->instructions = malloc(size * sizeof(*body->instructions));
+	body->pipelineCount = script->pipelineCount - construct->pipelineStart;
+	body->pipelines = malloc((body->pipelineCount + 1) * sizeof(*body->pipelines));
+	body->wordListCount = script->wordListCount - construct->wordListStart;
+	body->wordLists = malloc((body->wordListCount + 1) * sizeof(*body->wordLists));
+	body->definitionCount = script->definitionCount - construct->definitionStart;
+	body->definitions = malloc((body->definitionCount + 1) * sizeof(*body->definitions));
+	if(body->instructions == NULL || body->pipelines == NULL || body->wordLists == NULL
+	|| body->definitions == NULL) {
+		body->pipelineCount = body->wordListCount = body->definitionCount = 0;
+		scriptFree(body);
+		return -1;
+	}
+	memcpy(body->instructions, script->instructions + construct->start,
+		count * sizeof(*body->instructions));
+	body->instructionCount = count;
+	/* The arrays of the script are only allocated once they hold elements */
+	if(body->pipelineCount > 0) {
+		memcpy(body->pipelines, script->pipelines + construct->pipelineStart,
+			body->pipelineCount * sizeof(*body->pipelines));
+	}
+	if(body->wordListCount > 0) {
+		memcpy(body->wordLists, script->wordLists + construct->wordListStart,
+			body->wordListCount * sizeof(*body->wordLists));
+	}
+	if(body->definitionCount > 0) {
+		memcpy(body->definitions, script->definitions + construct->definitionStart,
+			body->definitionCount * sizeof(*body->definitions));
+	}
+	for(index = 0; index < count; index++) {
+		instruction = &body->instructions[index];
+		if(instruction->target != SCRIPT_NO_JUMP) {
+			instruction->target -= construct->start;
+		}
+		switch(instruction->opcode) {
+			case kScriptOpRun:
+			case kScriptOpBackground:
+				instruction->operand -= construct->pipelineStart;
+				break;
+			case kScriptOpForBegin:
+			case kScriptOpCaseBegin:
+			case kScriptOpCaseMatch:
+				instruction->operand -= construct->wordListStart;
+				break;
+			case kScriptOpDefine:
+				instruction->operand -= construct->definitionStart;
+				break;
+		}
+	}
+	script->instructionCount = construct->start;
+	script->pipelineCount = construct->pipelineStart;
+	script->wordListCount = construct->wordListStart;
+	script->definitionCount = construct->definitionStart;
+	command->body = body;
+	command->isSubshell = 0;
+	compiler->skip = construct->skip;
+	return 0;
+}
+
+/*!
+ \brief Handle the connection following a pipeline or construct
+ \param isCompound whether a construct was terminated, which cannot be piped
+ or run in the background unless it is in a group or subshell
+ */
+static int _endUnit(script_compiler_t *compiler, int connectionMask, int isCompound)
+{
+	script_frame_t *frame = _topFrame(compiler);
+	switch(connectionMask) {
+		case kCommandConnectionAnd:
+			compiler->skip = _emit(compiler, kScriptOpJumpIfFailed, 0);
+			return compiler->skip == SCRIPT_NO_JUMP ? -1 : 0;
+		case kCommandConnectionOr:
+			compiler->skip = _emit(compiler, kScriptOpJumpIfSucceeded, 0);
+			return compiler->skip == SCRIPT_NO_JUMP ? -1 : 0;
+		case kCommandConnectionCaseEnd:
+			if(frame == NULL || frame->type != kScriptFrameCase
+			|| frame->state != kScriptFrameStateBody) {
+				return _syntaxError(";;");
+			}
+			if(_emitExit(compiler, frame) != 0) {
+				return -1;
+			}
+			_patch(compiler, frame->condition);
+			frame->condition = SCRIPT_NO_JUMP;
+			frame->state = kScriptFrameStatePatterns;
+			return 0;
+		case kCommandConnectionPipe:
+		case kCommandConnectionFanOut:
+		case kCommandConnectionBackground:
+			if(isCompound) {
+				setMushError(kMushParseError);
+				setMushErrorDescription("only groups and subshells can be piped or run in the background");
+				return -1;
+			}
+			return 0;
+		default:
+			return 0;
+	}
+}
+
+/*!
+ \brief Compile \c break or \c continue, leaving the enclosing loops
+ */
+static int _compileLoopControl(script_compiler_t *compiler, command_t *command)
+{
+	int isBreak = strcmp(command->argv[0], "break") == 0;
+	int levels = command->argc > 1 ? atoi(command->argv[1]) : 1;
+	size_t index;
+	size_t target = SCRIPT_NO_JUMP;
+	size_t jump;
+	script_frame_t *frame;
+	/* The innermost loops are left first, the outermost at most */
+	for(index = compiler->frameCount; index > 0 && levels > 0; index--) {
+		if(compiler->frames[index - 1].type != kScriptFrameCase
+		&& compiler->frames[index - 1].type != kScriptFrameIf) {
+			target = index - 1;
+			levels--;
+		}
+	}
+	if(target == SCRIPT_NO_JUMP) {
+		return _emit(compiler, kScriptOpSetStatus, 0) == SCRIPT_NO_JUMP ? -1 : 0;
+	}
+	/* The words of each "for" left are dropped, as is those of the target of
+	   "break" */
+	for(index = compiler->frameCount; index > target; index--) {
+		if(compiler->frames[index - 1].type == kScriptFrameFor
+		&& (isBreak || index - 1 != target)) {
+			if(_emit(compiler, kScriptOpForDrop, 0) == SCRIPT_NO_JUMP) {
+				return -1;
+			}
+		}
+	}
+	frame = &compiler->frames[target];
+	if(isBreak) {
+		return _emitExit(compiler, frame);
+	}
+	jump = _emit(compiler, kScriptOpJump, 0);
+	if(jump == SCRIPT_NO_JUMP) {
+		return -1;
+	}
+	compiler->script->instructions[jump].target = frame->top;
+	return 0;
+}
+
+/*!
+ \brief Read the patterns of a \c case clause, up to the word ending in \c )
+
+ The patterns are removed from \a command, which is left with the commands of
+ the clause.
+ */
+static int _compilePatterns(script_compiler_t *compiler, script_frame_t *frame, command_t *command)
+{
+	char **grown;
+	char *pattern;
+	size_t length;
+	int isLast = 0;
+	int index;
+	int list;
+	size_t match;
+	for(index = 0; index < command->argc && !isLast; index++) {
+		pattern = command->argv[index];
+		if(index == 0 && frame->state == kScriptFrameStatePatterns && *pattern == '(') {
+			pattern++;
+		}
+		length = strlen(pattern);
+		isLast = length > 0 && pattern[length - 1] == ')';
+		if(isLast) {
+			length--;
+		}
+		/* The parentheses may be words of their own */
+		if(length == 0) {
+			continue;
+		}
+		grown = realloc(frame->patterns, (frame->patternCount + 2) * sizeof(*grown));
+		if(grown == NULL) {
+			return -1;
+		}
+		frame->patterns = grown;
+		frame->patterns[frame->patternCount++] = strndup(pattern, length);
+		frame->patterns[frame->patternCount] = NULL;
+	}
+	if(!isLast) {
+		/* "a|b)" is parsed as a pipe */
+		if(command->connectionMask != kCommandConnectionPipe) {
+			return _syntaxError(command->argv[command->argc - 1]);
+		}
+		frame->state = kScriptFrameStateAlternatives;
+		_shiftWords(command, command->argc);
+		return 0;
+	}
+	if(frame->patternCount == 0) {
+		return _syntaxError(")");
+	}
+	list = _addWordList(compiler, frame->patterns);
+	frame->patterns = NULL;
+	frame->patternCount = 0;
+	match = _emit(compiler, kScriptOpCaseMatch, list);
+	if(list == -1 || match == SCRIPT_NO_JUMP) {
+		return -1;
+	}
+	frame->condition = match;
+	frame->state = kScriptFrameStateBody;
+	_shiftWords(command, index);
+	return 0;
+}
+
+/*!
+ \brief Compile the reserved word starting \a command, removing it
+ \return \c 1 if the word terminated a construct, \c 0 if it started or
+ continued one, \c -1 on error
+ */
+static int _compileReservedWord(script_compiler_t *compiler, command_t *command)
+{
+	script_frame_t *frame = _topFrame(compiler);
+	const char *word = command->argv[0];
+	size_t jump;
+	int list;
+	if(strcmp(word, "if") == 0) {
+		if(_pushFrame(compiler, kScriptFrameIf, kScriptFrameStateCondition) == NULL) {
+			return -1;
+		}
+	} else if(strcmp(word, "while") == 0 || strcmp(word, "until") == 0) {
+		if(_pushFrame(compiler, word[0] == 'w' ? kScriptFrameWhile : kScriptFrameUntil,
+			kScriptFrameStateCondition) == NULL) {
+			return -1;
+		}
+	} else if(strcmp(word, "then") == 0) {
+		if(frame == NULL || frame->type != kScriptFrameIf
+		|| frame->state != kScriptFrameStateCondition) {
+			return _syntaxError(word);
+		}
+		frame->condition = _emit(compiler, kScriptOpJumpIfFailed, 0);
+		frame->state = kScriptFrameStateBody;
+	} else if(strcmp(word, "elif") == 0 || strcmp(word, "else") == 0) {
+		if(frame == NULL || frame->type != kScriptFrameIf
+		|| frame->state != kScriptFrameStateBody) {
+			return _syntaxError(word);
+		}
+		if(_emitExit(compiler, frame) != 0) {
+			return -1;
+		}
+		_patch(compiler, frame->condition);
+		frame->condition = SCRIPT_NO_JUMP;
+		frame->state = word[2] == 'i' ? kScriptFrameStateCondition : kScriptFrameStateElse;
+	} else if(strcmp(word, "fi") == 0) {
+		if(frame == NULL || frame->type != kScriptFrameIf
+		|| frame->state == kScriptFrameStateCondition || _hasTrailingWords(command)) {
+			return _syntaxError(word);
+		}
+		/* Without an else branch the status is zero if no branch was taken */
+		if(frame->state == kScriptFrameStateBody) {
+			if(_emitExit(compiler, frame) != 0) {
+				return -1;
+			}
+			_patch(compiler, frame->condition);
+			_emit(compiler, kScriptOpSetStatus, 0);
+		}
+		_popFrame(compiler);
+		_shiftWords(command, 1);
+		return 1;
+	} else if(strcmp(word, "do") == 0) {
+		if(frame == NULL || frame->type == kScriptFrameIf || frame->type == kScriptFrameCase
+		|| frame->state != kScriptFrameStateCondition) {
+			return _syntaxError(word);
+		}
+		if(frame->type != kScriptFrameFor) {
+			frame->condition = _emit(compiler, frame->type == kScriptFrameWhile
+				? kScriptOpJumpIfFailed : kScriptOpJumpIfSucceeded, 0);
+		}
+		frame->state = kScriptFrameStateBody;
+	} else if(strcmp(word, "done") == 0) {
+		if(frame == NULL || frame->type == kScriptFrameIf || frame->type == kScriptFrameCase
+		|| frame->state != kScriptFrameStateBody || _hasTrailingWords(command)) {
+			return _syntaxError(word);
+		}
+		jump = _emit(compiler, kScriptOpJump, 0);
+		if(jump == SCRIPT_NO_JUMP) {
+			return -1;
+		}
+		compiler->script->instructions[jump].target = frame->top;
+		_patch(compiler, frame->condition);
+		/* A loop whose condition failed has a zero status, as does "break" */
+		if(frame->type != kScriptFrameFor) {
+			frame->condition = SCRIPT_NO_JUMP;
+			for(jump = 0; jump < frame->exitCount; jump++) {
+				_patch(compiler, frame->exits[jump]);
+			}
+			frame->exitCount = 0;
+			_emit(compiler, kScriptOpSetStatus, 0);
+		}
+		_popFrame(compiler);
+		_shiftWords(command, 1);
+		return 1;
+	} else if(strcmp(word, "for") == 0) {
+		if(command->argc < 2 || variableNameLength(command->argv[1]) != strlen(command->argv[1])
+		|| (command->argc > 2 && strcmp(command->argv[2], "in") != 0)) {
+			return _syntaxError(word);
+		}
+		/* The jump over the loop must include its words */
+		frame = _pushFrame(compiler, kScriptFrameFor, kScriptFrameStateCondition);
+		if(frame == NULL) {
+			return -1;
+		}
+		/* Without a list of words the positional parameters are used */
+		if(command->argc == 2) {
+			list = _addWordList(compiler, _copyWords(command->argv[1], (char *[]){"\"$@\""}, 1));
+		} else {
+			list = _addWordList(compiler, _copyWords(command->argv[1], command->argv + 3, command->argc - 3));
+		}
+		if(list == -1 || _emit(compiler, kScriptOpForBegin, list) == SCRIPT_NO_JUMP) {
+			return -1;
+		}
+		frame->top = compiler->script->instructionCount;
+		frame->condition = _emit(compiler, kScriptOpForNext, 0);
+		_shiftWords(command, command->argc);
+		return 0;
+	} else if(strcmp(word, "case") == 0) {
+		if(command->argc < 3 || strcmp(command->argv[2], "in") != 0) {
+			return _syntaxError(word);
+		}
+		if(_pushFrame(compiler, kScriptFrameCase, kScriptFrameStatePatterns) == NULL) {
+			return -1;
+		}
+		list = _addWordList(compiler, _copyWords(NULL, command->argv + 1, 1));
+		if(list == -1 || _emit(compiler, kScriptOpCaseBegin, list) == SCRIPT_NO_JUMP) {
+			return -1;
+		}
+		_shiftWords(command, 3);
+		return 0;
+	} else if(strcmp(word, "esac") == 0) {
+		if(frame == NULL || frame->type != kScriptFrameCase || _hasTrailingWords(command)
+		|| frame->state == kScriptFrameStateAlternatives) {
+			return _syntaxError(word);
+		}
+		/* The last clause does not need to be ended with ";;" */
+		if(frame->state == kScriptFrameStateBody && _emitExit(compiler, frame) != 0) {
+			return -1;
+		}
+		_patch(compiler, frame->condition);
+		_emit(compiler, kScriptOpCaseDrop, 0);
+		_emit(compiler, kScriptOpSetStatus, 0);
+		_popFrame(compiler);
+		_shiftWords(command, 1);
+		return 1;
+	} else {
+		return _syntaxError(word);
+	}
+	_shiftWords(command, 1);
+	return 0;
+}
+
+static int _compileCommand(script_compiler_t *compiler, command_t *command, queue_t *commands);
+
+static int _initializeCompiler(script_compiler_t *compiler)
+{
+	compiler->script = _newScript();
+	if(compiler->script == NULL) {
+		return -1;
+	}
+	compiler->frames = NULL;
+	compiler->frameCount = 0;
+	compiler->skip = SCRIPT_NO_JUMP;
+	compiler->isSubshell = 0;
+	compiler->isConstruct = 0;
+	compiler->closing = NULL;
+	return 0;
+}
+
+/*!
+ \brief Release the state of \a compiler, and its script unless \a status
+ indicates success
+ */
+static void _finishCompiler(script_compiler_t *compiler, int status)
+{
+	_patch(compiler, compiler->skip);
+	while(compiler->frameCount > 0) {
+		_freeFrame(_topFrame(compiler));
+		compiler->frameCount--;
+	}
+	free(compiler->frames);
+	if(compiler->closing != NULL) {
+		_freeCommand(compiler->closing);
+		compiler->closing = NULL;
+	}
+	if(status != 0) {
+		scriptFree(compiler->script);
+		compiler->script = NULL;
+	}
+}
+
+/*!
+ \brief Indicate whether \a command starts with \c "name() {" or
+ \c "name () {"
+ \return amount of words up to and including \c {, or \c 0
+ */
+static int _functionDefinitionLength(command_t *command)
+{
+	size_t length = variableNameLength(command->argv[0]);
+	if(length == 0) {
+		return 0;
+	}
+	if(strcmp(command->argv[0] + length, "()") == 0
+	&& command->argc > 1 && strcmp(command->argv[1], "{") == 0) {
+		return 2;
+	}
+	if(command->argv[0][length] == '\0' && command->argc > 2
+	&& strcmp(command->argv[1], "()") == 0 && strcmp(command->argv[2], "{") == 0) {
+		return 3;
+	}
+	return 0;
+}
+
+/*!
+ \brief Compile the function defined by \a command, reading its body from
+ \a commands up to the closing \c }
+ */
+static int _compileFunction(script_compiler_t *compiler, command_t *command, queue_t *commands)
+{
+	script_compiler_t body;
+	script_definition_t *grown;
+	script_definition_t definition;
+	char *description;
+	size_t skip;
+	size_t define;
+	int connectionMask = kCommandConnectionNone;
+	int isClosed = 0;
+	int status = 0;
+	definition.name = strndup(command->argv[0], variableNameLength(command->argv[0]));
+	if(definition.name == NULL || _initializeCompiler(&body) != 0) {
+		free(definition.name);
+		_freeCommand(command);
+		return -1;
+	}
+	_shiftWords(command, _functionDefinitionLength(command));
+	/* The body is compiled into a script of its own, outliving this one */
+	while(status == 0 && !isClosed && (command != NULL || queueRemove(commands, (void *)&command))) {
+		if(command->argc > 0 && strcmp(command->argv[0], "}") == 0 && body.frameCount == 0) {
+			isClosed = 1;
+			connectionMask = command->connectionMask;
+			if(command->argc > 1) {
+				status = _syntaxError(command->argv[1]);
+			}
+			_freeCommand(command);
+		} else if(command->argc == 0) {
+			_freeCommand(command);
+		} else {
+			status = _compileCommand(&body, command, commands);
+		}
+		command = NULL;
+	}
+	if(status == 0 && !isClosed) {
+		/* More input may complete the function */
+		setMushError(kMushIncompleteInputError);
+		if(asprintf(&description, "unterminated function '%s'", definition.name) != -1) {
+			setMushErrorDescription(description);
+			free(description);
+		}
+		status = -1;
+	}
+	_finishCompiler(&body, status);
+	definition.body = body.script;
+	grown = status == 0 ? realloc(compiler->script->definitions,
+		(compiler->script->definitionCount + 1) * sizeof(*grown)) : NULL;
+	if(grown == NULL) {
+		free(definition.name);
+		scriptFree(definition.body);
+		return -1;
+	}
+	compiler->script->definitions = grown;
+	grown[compiler->script->definitionCount] = definition;
+	skip = compiler->skip;
+	compiler->skip = SCRIPT_NO_JUMP;
+	define = _emit(compiler, kScriptOpDefine, compiler->script->definitionCount++);
+	_patch(compiler, skip);
+	if(define == SCRIPT_NO_JUMP) {
+		return -1;
+	}
+	return _endUnit(compiler, connectionMask, 1);
+}
+
+/*!
+ \brief Split \a *command at the \c ) ending the subshell being compiled
+
+ The words preceding the \c ), and the commands of a group or subshell
+ they end, are moved into a command replacing \a *command, or \c NULL if
+ there are none. The command itself is left with the redirections and
+ connection of the subshell, and any further \c ) of enclosing subshells, as
+ the \link script_compiler_t::closing closing \endlink command.
+ */
+static int _splitClosing(script_compiler_t *compiler, command_t **command)
+{
+	command_t *inner = NULL;
+	int index;
+	for(index = 0; index < (*command)->argc && strcmp((*command)->argv[index], ")") != 0; index++) {
+		if(index > 0 && strcmp((*command)->argv[index], "(") == 0) {
+			return _syntaxError("(");
+		}
+	}
+	if(index == (*command)->argc) {
+		return 0;
+	}
+	if(!compiler->isSubshell || compiler->frameCount > 0) {
+		return _syntaxError(")");
+	}
+	if(index > 0 || (*command)->body != NULL) {
+		inner = commandNew();
+		if(inner == NULL) {
+			return -1;
+		}
+		inner->argv = _copyWords(NULL, (*command)->argv, index);
+		if(inner->argv == NULL) {
+			commandFree(inner);
+			free(inner);
+			return -1;
+		}
+		inner->argc = index;
+		inner->path = inner->argv[0];
+		inner->body = (*command)->body;
+		inner->isSubshell = (*command)->isSubshell;
+		(*command)->body = NULL;
+	}
+	_shiftWords(*command, index + 1);
+	compiler->closing = *command;
+	*command = inner;
+	return 0;
+}
+
+/*!
+ \brief Compile the group (\c "{ ...; }") or subshell (\c "( ... )")
+ started by \a command, reading its commands from \a commands up to the
+ closing \c } or \c )
+
+ The commands are compiled into a script of their own, which is executed
+ like a single command of a pipeline.
+ \return the command executing the script, with the redirections and
+ connection following the closing word, or \c NULL on error
+ */
+static command_t *_compileCompound(script_compiler_t *compiler, command_t *command, queue_t *commands)
+{
+	script_compiler_t body;
+	command_t *compound = NULL;
+	char **attributes = command->attributes;
+	int isSubshell = strcmp(command->argv[0], "(") == 0;
+	int status = 0;
+	if(_initializeCompiler(&body) != 0) {
+		_freeCommand(command);
+		return NULL;
+	}
+	body.isSubshell = isSubshell;
+	/* The attributes belong to the command ending the group */
+	command->attributes = NULL;
+	_shiftWords(command, 1);
+	while(status == 0 && compound == NULL && (command != NULL || queueRemove(commands, (void *)&command))) {
+		if(!isSubshell && command->argc > 0 && strcmp(command->argv[0], "}") == 0
+		&& body.frameCount == 0) {
+			_shiftWords(command, 1);
+			compound = command;
+		} else if(command->argc == 0) {
+			_freeCommand(command);
+		} else {
+			status = _compileCommand(&body, command, commands);
+			compound = body.closing;
+			body.closing = NULL;
+		}
+		command = NULL;
+	}
+	if(status == 0 && compound == NULL) {
+		/* More input may complete the construct */
+		setMushError(kMushIncompleteInputError);
+		setMushErrorDescription(isSubshell ? "unterminated '('" : "unterminated '{'");
+		status = -1;
+	}
+	_finishCompiler(&body, status);
+	if(status != 0) {
+		if(compound != NULL) {
+			_freeCommand(compound);
+		}
+		expansionFree(attributes);
+		return NULL;
+	}
+	compound->body = body.script;
+	compound->isSubshell = isSubshell;
+	compound->attributes = attributes;
+	return compound;
+}
+
+/*!
+ \brief Compile the construct started by \a command, such as a loop which
+ another command is piped to, reading its commands from \a commands up to
+ the reserved word terminating it
+
+ The construct is compiled into a script of its own, which is executed like
+ a group.
+ \return the command executing the script, with the redirections and
+ connection following the terminating word, or \c NULL on error
+ */
+static command_t *_compileConstruct(script_compiler_t *compiler, command_t *command, queue_t *commands)
+{
+	script_compiler_t body;
+	command_t *construct = NULL;
+	char **attributes = command->attributes;
+	char *description;
+	int status = 0;
+	if(_initializeCompiler(&body) != 0) {
+		_freeCommand(command);
+		return NULL;
+	}
+	body.isConstruct = 1;
+	/* The attributes belong to the command ending the construct */
+	command->attributes = NULL;
+	while(status == 0 && construct == NULL && (command != NULL || queueRemove(commands, (void *)&command))) {
+		if(command->argc == 0) {
+			_freeCommand(command);
+		} else {
+			status = _compileCommand(&body, command, commands);
+			construct = body.closing;
+			body.closing = NULL;
+		}
+		command = NULL;
+	}
+	if(status == 0 && construct == NULL) {
+		/* More input may complete the construct */
+		setMushError(kMushIncompleteInputError);
+		if(asprintf(&description, "unterminated '%s'",
+			_frameNames[body.frameCount > 0 ? _topFrame(&body)->type : 0]) != -1) {
+			setMushErrorDescription(description);
+			free(description);
+		}
+		status = -1;
+	}
+	_finishCompiler(&body, status);
+	if(status != 0) {
+		if(construct != NULL) {
+			_freeCommand(construct);
+		}
+		expansionFree(attributes);
+		return NULL;
+	}
+	construct->body = body.script;
+	construct->isSubshell = 0;
+	construct->attributes = attributes;
+	return construct;
+}
+
+/*!
+ \brief Compile \a command, and the commands it is piped to
+
+ A construct whose terminating word is followed by redirections, a pipe or
+ \c & is moved into a script of its own by _wrapConstruct(), so that it runs
+ as a group. Otherwise it stays part of the script, so \c break and
+ \c continue may leave it.
+ \param commands the remaining commands of the script
+ */
+static int _compileCommand(script_compiler_t *compiler, command_t *command, queue_t *commands)
+{
+	script_frame_t *frame;
+	queue_t *pipeline;
+	command_t *last;
+	size_t skip;
+	int isCompound = 0;
+	int status;
+	int index;
+	/* Reserved words are removed from the command until a pipeline remains */
+	while(command->argc > 0) {
+		frame = _topFrame(compiler);
+		if(frame != NULL && frame->type == kScriptFrameCase
+		&& (frame->state == kScriptFrameStatePatterns || frame->state == kScriptFrameStateAlternatives)
+		&& strcmp(command->argv[0], "esac") != 0) {
+			status = _compilePatterns(compiler, frame, command);
+		} else if(_functionDefinitionLength(command) > 0) {
+			return _compileFunction(compiler, command, commands);
+		} else if(_isReservedWord(command->argv[0])) {
+			status = _compileReservedWord(compiler, command);
+			isCompound = status == 1;
+		} else {
+			break;
+		}
+		if(status < 0) {
+			_freeCommand(command);
+			return -1;
+		}
+	}
+	/* The construct compiled by _compileConstruct() ended */
+	if(isCompound && compiler->isConstruct && compiler->frameCount == 0) {
+		compiler->closing = command;
+		return 0;
+	}
+	if(_takeAttributes(command) != 0) {
+		_freeCommand(command);
+		return -1;
+	}
+	if(_isCompoundStart(command)) {
+		command = _compileCompound(compiler, command, commands);
+		if(command == NULL) {
+			return -1;
+		}
+	}
+	if(_splitClosing(compiler, &command) != 0) {
+		_freeCommand(command);
+		return -1;
+	}
+	/* The enclosing subshell ended */
+	if(command == NULL) {
+		return 0;
+	}
+	if(isCompound && command->argc == 0 && _isConstructRedirected(command)
+	&& _wrapConstruct(compiler, command) != 0) {
+		_freeCommand(command);
+		return -1;
+	}
+	if(command->argc == 0 && command->body == NULL) {
+		status = _endUnit(compiler, command->connectionMask, isCompound);
+		_freeCommand(command);
+		return status;
+	}
+	if(command->argc > 0 && command->body != NULL) {
+		status = _syntaxError(command->argv[0]);
+		_freeCommand(command);
+		return status;
+	}
+	skip = compiler->skip;
+	compiler->skip = SCRIPT_NO_JUMP;
+	if(command->body == NULL && (strcmp(command->argv[0], "break") == 0 || strcmp(command->argv[0], "continue") == 0)
+	&& command->connectionMask != kCommandConnectionPipe) {
+		status = _compileLoopControl(compiler, command);
+		_patch(compiler, skip);
+		if(status == 0) {
+			status = _endUnit(compiler, command->connectionMask, 0);
+		}
+		_freeCommand(command);
+		return status;
+	}
+	pipeline = queueNew();
+	if(pipeline == NULL) {
+		_freeCommand(command);
+		return -1;
+	}
+	last = command;
+	queueInsert(pipeline, command, (queueNodeFreeFunction)commandFree);
+	index = _addPipeline(compiler, pipeline);
+	if(index == -1) {
+		queueFree(pipeline);
+		return -1;
+	}
+	while((last->connectionMask == kCommandConnectionPipe || last->connectionMask == kCommandConnectionFanOut)
+	&& queueRemove(commands, (void *)&last)) {
+		if(_takeAttributes(last) != 0) {
+			_freeCommand(last);
+			return -1;
+		}
+		if(_isCompoundStart(last)) {
+			last = _compileCompound(compiler, last, commands);
+		} else if(_isConstructStart(last)) {
+			last = _compileConstruct(compiler, last, commands);
+		}
+		if(last == NULL) {
+			return -1;
+		}
+		if(_splitClosing(compiler, &last) != 0 || last == NULL) {
+			if(last != NULL) {
+				_freeCommand(last);
+			} else if(mushError() == kMushNoError) {
+				_syntaxError(")");
+			}
+			return -1;
+		}
+		queueInsert(pipeline, last, (queueNodeFreeFunction)commandFree);
+		if(last->argc > 0 && last->body != NULL) {
+			return _syntaxError(last->argv[0]);
+		}
+		if(last->argc > 0 && _isReservedWord(last->argv[0])) {
+			return _syntaxError(last->argv[0]);
+		}
+	}
+	if(_emit(compiler, last->connectionMask == kCommandConnectionBackground
+		? kScriptOpBackground : kScriptOpRun, index) == SCRIPT_NO_JUMP) {
+		return -1;
+	}
+	/* The builtin sets the status, the script stops after it */
+	if(last == command && last->connectionMask != kCommandConnectionBackground
+	&& command->body == NULL && strcmp(command->argv[0], "return") == 0
+	&& _emit(compiler, kScriptOpReturn, 0) == SCRIPT_NO_JUMP) {
+		return -1;
+	}
+	_patch(compiler, skip);
+	return _endUnit(compiler, last->connectionMask, 0);
+}
+
+script_t *scriptCompile(queue_t *commands)
+{
+	script_compiler_t compiler;
+	command_t *command;
+	char *description;
+	int status = 0;
+	if(_initializeCompiler(&compiler) != 0) {
+		return NULL;
+	}
+	setMushError(kMushNoError);
+	while(status == 0 && queueRemove(commands, (void *)&command)) {
+		status = _compileCommand(&compiler, command, commands);
+	}
+	if(status == 0 && compiler.frameCount > 0) {
+		/* More input may complete the construct */
+		setMushError(kMushIncompleteInputError);
+		if(asprintf(&description, "unterminated '%s'",
+			_frameNames[_topFrame(&compiler)->type]) != -1) {
+			setMushErrorDescription(description);
+			free(description);
+		}
+		status = -1;
+	}
+	_finishCompiler(&compiler, status);
+	if(status != 0) {
+		while(queueRemove(commands, (void *)&command)) {
+			_freeCommand(command);
+		}
+		if(mushError() == kMushNoError) {
+			setMushError(kMushGenericError);
+			setMushErrorDescription("unable to compile commands");
+		}
+		return NULL;
+	}
+	return compiler.script;
+}
+
+/*! \brief Whether \c return was executed in a group, which also ends the
+ scripts executing it */
+static int _isReturning = 0;
+/*! \brief Whether \c exit ended the scripts being executed */
+static int _isExiting = 0;
+/*! \brief Amount of scripts being executed, including functions and groups */
+static int _executionDepth = 0;
+
+/*! \brief Words of a \c for loop being executed */
+typedef struct __script_loop_t {
+	/*! \brief name of the loop variable */
+	const char *name;
+	/*! \brief expanded words, assigned in turn */
+	char **words;
+	int count;
+	int index;
+} script_loop_t;
+
+/*!
+ \brief Copy the commands of \a pipeline
+ \return queue of \c command_t objects, or \c NULL on error
+ */
+static queue_t *_copyPipeline(queue_t *pipeline)
+{
+	struct __queue_node_t *node;
+	command_t *copy;
+	queue_t *copied = queueNew();
+	if(copied == NULL) {
+		return NULL;
+	}
+	for(node = pipeline->head; node != NULL; node = node->next) {
+		copy = commandCopy(node->data);
+		if(copy == NULL) {
+			queueFree(copied);
+			return NULL;
+		}
+		queueInsert(copied, copy, (queueNodeFreeFunction)commandFree);
+	}
+	return copied;
+}
+
+/*!
+ \brief Return the pipeline at \a index as it runs now
+
+ The optimizer is consulted each time, so \c "set +o optimize" within a
+ script applies to the rest of it. A pipeline is rewritten once, into a
+ copy kept alongside the original.
+
+ \return the optimized copy if \c kOptionOptimize is set, the pipeline as
+ compiled otherwise
+ */
+static queue_t *_pipelineToRun(script_t *script, size_t index)
+{
+	if(!optionIsSet(kOptionOptimize)) {
+		return script->pipelines[index];
+	}
+	if(script->optimized == NULL) {
+		script->optimized = calloc(script->pipelineCount, sizeof(*script->optimized));
+		if(script->optimized == NULL) {
+			return script->pipelines[index];
+		}
+	}
+	if(script->optimized[index] == NULL) {
+		script->optimized[index] = _copyPipeline(script->pipelines[index]);
+		if(script->optimized[index] == NULL) {
+			return script->pipelines[index];
+		}
+		optimizeCommandQueue(script->optimized[index]);
+	}
+	return script->optimized[index];
+}
+
+/*!
+ \brief Submit a copy of \a pipeline as a background job
+
+ The job may outlive the script, so it cannot share its commands.
+ */
+static int _submitCopy(queue_t *pipeline)
+{
+	queue_t *jobPipeline = _copyPipeline(pipeline);
+	if(jobPipeline == NULL) {
+		return kMushGenericError;
+	}
+	jobsSubmit(jobPipeline);
+	executeSetLastStatus(0);
+	return kMushNoError;
+}
+
+/*!
+ \brief Indicate whether \a subject matches any of \a patterns
+ \return \c 1 if a pattern matches, \c 0 otherwise
+ */
+static int _matchesPattern(const char *subject, char **patterns)
+{
+	char *pattern;
+	int isMatching = 0;
+	for(; *patterns != NULL && !isMatching; patterns++) {
+		pattern = expansionExpandString(*patterns, 1);
+		if(pattern != NULL) {
+			isMatching = fnmatch(pattern, subject, 0) == 0;
+			free(pattern);
+		}
+	}
+	return isMatching;
+}
+
+/*!
+ \brief Execute \a script
+ \param isFinal whether the shell exits once the script is done, so its last
+ instruction may replace the shell
+ */
+static int _executeScript(script_t *script, int isFinal)
+{
+	script_instruction_t *instruction;
+	script_loop_t *loops = NULL;
+	script_loop_t *grownLoops;
+	size_t loopCount = 0;
+	char **subjects = NULL;
+	char **grownSubjects;
+	size_t subjectCount = 0;
+	size_t position = 0;
+	int status = kMushNoError;
+	_executionDepth++;
+	while(status == kMushNoError && position < script->instructionCount) {
+		instruction = &script->instructions[position++];
+		switch(instruction->opcode) {
+			case kScriptOpRun:
+				if(isFinal && position == script->instructionCount) {
+					status = executeFinal(_pipelineToRun(script, instruction->operand));
+				} else {
+					status = executeForeground(_pipelineToRun(script, instruction->operand));
+				}
+				if(_isReturning || _isExiting) {
+					position = script->instructionCount;
+				}
+				break;
+			case kScriptOpBackground:
+				status = _submitCopy(_pipelineToRun(script, instruction->operand));
+				break;
+			case kScriptOpJump:
+				position = instruction->target;
+				break;
+			case kScriptOpJumpIfFailed:
+				if(executeLastStatus() != 0) {
+					position = instruction->target;
+				}
+				break;
+			case kScriptOpJumpIfSucceeded:
+				if(executeLastStatus() == 0) {
+					position = instruction->target;
+				}
+				break;
+			case kScriptOpSetStatus:
+				executeSetLastStatus(instruction->operand);
+				break;
+			case kScriptOpForBegin:
+				grownLoops = realloc(loops, (loopCount + 1) * sizeof(*loops));
+				if(grownLoops == NULL) {
+					status = kMushGenericError;
+					break;
+				}
+				loops = grownLoops;
+				loops[loopCount].name = script->wordLists[instruction->operand][0];
+				loops[loopCount].index = 0;
+				loops[loopCount].words = expansionExpandWords(script->wordLists[instruction->operand] + 1,
+					&loops[loopCount].count);
+				if(loops[loopCount].words == NULL) {
+					status = kMushGenericError;
+					break;
+				}
+				loopCount++;
+				/* A loop without iterations has a zero status */
+				executeSetLastStatus(0);
+				break;
+			case kScriptOpForNext:
+				if(loops[loopCount - 1].index < loops[loopCount - 1].count) {
+					variableSet(loops[loopCount - 1].name,
+						loops[loopCount - 1].words[loops[loopCount - 1].index++]);
+					break;
+				}
+				position = instruction->target;
+				/* Fall through */
+			case kScriptOpForDrop:
+				expansionFree(loops[--loopCount].words);
+				break;
+			case kScriptOpCaseBegin:
+				grownSubjects = realloc(subjects, (subjectCount + 1) * sizeof(*subjects));
+				if(grownSubjects == NULL) {
+					status = kMushGenericError;
+					break;
+				}
+				subjects = grownSubjects;
+				subjects[subjectCount] = expansionExpandString(script->wordLists[instruction->operand][0], 0);
+				if(subjects[subjectCount] == NULL) {
+					status = kMushGenericError;
+					break;
+				}
+				subjectCount++;
+				break;
+			case kScriptOpCaseMatch:
+				if(!_matchesPattern(subjects[subjectCount - 1], script->wordLists[instruction->operand])) {
+					position = instruction->target;
+					break;
+				}
+				/* Fall through */
+			case kScriptOpCaseDrop:
+				free(subjects[--subjectCount]);
+				break;
+			case kScriptOpDefine:
+				if(functionDefine(script->definitions[instruction->operand].name,
+					script->definitions[instruction->operand].body) != 0) {
+					status = kMushGenericError;
+				}
+				executeSetLastStatus(0);
+				break;
+			case kScriptOpReturn:
+				_isReturning = 1;
+				position = script->instructionCount;
+				break;
+		}
+	}
+	if(status == kMushGenericError && mushError() == kMushNoError) {
+		setMushError(kMushGenericError);
+		setMushErrorDescription("unable to execute script");
+	}
+	/* A failing command may leave loops or a case early */
+	while(loopCount > 0) {
+		expansionFree(loops[--loopCount].words);
+	}
+	while(subjectCount > 0) {
+		free(subjects[--subjectCount]);
+	}
+	free(loops);
+	free(subjects);
+	_executionDepth--;
+	return status;
+}
+
+int scriptExecute(script_t *script)
+{
+	int status = _executeScript(script, 0);
+	_isReturning = 0;
+	_isExiting = _isExiting && _executionDepth > 0;
+	return status;
+}
+
+int scriptExecuteFinal(script_t *script)
+{
+	int status = _executeScript(script, 1);
+	_isReturning = 0;
+	_isExiting = _isExiting && _executionDepth > 0;
+	return status;
+}
+
+int scriptExecuteGroup(script_t *script)
+{
+	return _executeScript(script, 0);
+}
+
+void scriptExit()
+{
+	_isExiting = 1;
+}
+
+void scriptPrint(script_t *script, FILE *stream)
+{
+	static const char *names[] = {
+		"run", "background", "jump", "jump-if-failed", "jump-if-succeeded",
+		"set-status", "for", "for-next", "for-drop", "case", "case-match",
+		"case-drop", "define", "return"
+	};
+	script_instruction_t *instruction;
+	char **word;
+	size_t index;
+	for(index = 0; index < script->instructionCount; index++) {
+		instruction = &script->instructions[index];
+		fprintf(stream, "plan: %4zu %s", index, names[instruction->opcode]);
+		switch(instruction->opcode) {
+			case kScriptOpRun:
+			case kScriptOpBackground:
+				fprintf(stream, " ");
+				optimizePrintCommands(_pipelineToRun(script, instruction->operand), stream);
+				break;
+			case kScriptOpSetStatus:
+				fprintf(stream, " %d", instruction->operand);
+				break;
+			case kScriptOpForBegin:
+			case kScriptOpCaseBegin:
+			case kScriptOpCaseMatch:
+				for(word = script->wordLists[instruction->operand]; *word != NULL; word++) {
+					fprintf(stream, " %s", *word);
+					if(word == script->wordLists[instruction->operand]
+					&& instruction->opcode == kScriptOpForBegin) {
+						fprintf(stream, " in");
+					}
+				}
+				break;
+			case kScriptOpDefine:
+				fprintf(stream, " %s", script->definitions[instruction->operand].name);
+				break;
+		}
+		if(instruction->target != SCRIPT_NO_JUMP) {
+			fprintf(stream, " -> %zu", instruction->target);
+		}
+		fprintf(stream, "\n");
+	}
+}
+
+script_t *scriptRetain(script_t *script)
+{
+	script->references++;
+	return script;
+}
+
+void scriptFree(script_t *script)
+{
+	size_t index;
+	if(script == NULL || --script->references > 0) {
+		return;
+	}
+	for(index = 0; index < script->pipelineCount; index++) {
+		_freePipeline(script->pipelines[index]);
+		if(script->optimized != NULL && script->optimized[index] != NULL) {
+			_freePipeline(script->optimized[index]);
+		}
+	}
+	for(index = 0; index < script->wordListCount; index++) {
+		_freeWords(script->wordLists[index]);
+	}
+	for(index = 0; index < script->definitionCount; index++) {
+		free(script->definitions[index].name);
+		scriptFree(script->definitions[index].body);
+	}
+	free(script->pipelines);
+	free(script->optimized);
+	free(script->wordLists);
+	free(script->definitions);
+	free(script->instructions);
+	free(script);
+}
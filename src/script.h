@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <stdio.h>
+#include "queue.h"
+
+/*!
+ \addtogroup script
+ \{
+ */
+
+enum {
+	/*! \brief Execute pipeline \a operand in the foreground */
+	kScriptOpRun = 0,
+	/*! \brief Submit a copy of pipeline \a operand as a background job */
+	kScriptOpBackground,
+	/*! \brief Continue at \a target */
+	kScriptOpJump,
+	/*! \brief Continue at \a target if the last exit status is non-zero */
+	kScriptOpJumpIfFailed,
+	/*! \brief Continue at \a target if the last exit status is zero */
+	kScriptOpJumpIfSucceeded,
+	/*! \brief Set the last exit status to \a operand */
+	kScriptOpSetStatus,
+	/*! \brief Expand the words of word list \a operand, whose first element is
+	 the name of the loop variable, and start iterating over them */
+	kScriptOpForBegin,
+	/*! \brief Assign the next word to the loop variable, or stop iterating and
+	 continue at \a target once all words were assigned */
+	kScriptOpForNext,
+	/*! \brief Stop iterating, leaving the loop early */
+	kScriptOpForDrop,
+	/*! \brief Expand the first word of word list \a operand as the subject of
+	 a \c case */
+	kScriptOpCaseBegin,
+	/*! \brief Continue at \a target unless the subject matches one of the
+	 patterns of word list \a operand, otherwise drop the subject */
+	kScriptOpCaseMatch,
+	/*! \brief Drop the subject of a \c case which matched no pattern */
+	kScriptOpCaseDrop,
+	/*! \brief Define the function of definition \a operand */
+	kScriptOpDefine,
+	/*! \brief Stop executing the script, after \c return */
+	kScriptOpReturn
+};
+
+/*! \brief A single instruction of a script */
+typedef struct __script_instruction_t {
+	/*! \brief one of the \c kScriptOp values */
+	int opcode;
+	/*! \brief pipeline, word list or status the instruction operates on */
+	int operand;
+	/*! \brief index of the instruction jumped to, if any */
+	size_t target;
+} script_instruction_t;
+
+struct __script_t;
+
+/*! \brief A function defined by a script */
+typedef struct __script_definition_t {
+	/*! \brief name of the function */
+	char *name;
+	/*! \brief commands of the function, compiled separately */
+	struct __script_t *body;
+} script_definition_t;
+
+/*!
+ \brief A command line or script compiled into instructions
+
+ Control flow constructs (\c if, \c while, \c until, \c for and \c case) as
+ well as \c &&, \c ||, \c break and \c continue become jumps between the
+ pipelines, so executing a loop does not parse anything again. The body of a
+ function (\c "name() { ...; }") is compiled into a script of its own, which
+ outlives the script defining it, as are the commands of a group
+ (\c "{ ...; }") or subshell (\c "( ... )"), which are executed as a single
+ command of a pipeline.
+ */
+typedef struct __script_t {
+	/*! \brief the instructions, executed in order unless a jump is taken */
+	script_instruction_t *instructions;
+	/*! \brief amount of elements in \a instructions */
+	size_t instructionCount;
+	/*! \brief queues of \c command_t objects */
+	queue_t **pipelines;
+	/*! \brief amount of elements in \a pipelines */
+	size_t pipelineCount;
+	/*! \brief copies of \a pipelines rewritten by optimizeCommandQueue(),
+	 each made the first time its pipeline runs while \c kOptionOptimize is
+	 set, or \a NULL */
+	queue_t **optimized;
+	/*! \brief \c NULL terminated arrays of unexpanded words */
+	char ***wordLists;
+	/*! \brief amount of elements in \a wordLists */
+	size_t wordListCount;
+	/*! \brief functions defined by the script */
+	script_definition_t *definitions;
+	/*! \brief amount of elements in \a definitions */
+	size_t definitionCount;
+	/*! \brief amount of references to the script, see scriptRetain() */
+	int references;
+} script_t;
+
+/*!
+ \brief Compile the commands of a command line or script
+
+ The commands are removed from \a commands. Reserved words such as \c if or
+ \c done are only recognized as the first word of a command. If a construct
+ is not terminated, the error is set to \c kMushIncompleteInputError, so more
+ input can be read before compiling it again.
+
+ \param commands queue of \c command_t objects, as returned by
+ commandQueueFromInput()
+ \return the compiled script, to be freed with scriptFree(), or \c NULL on
+ error
+ */
+script_t *scriptCompile(queue_t *commands);
+
+/*!
+ \brief Execute a compiled script
+
+ The script is left untouched and may be executed again.
+
+ \param script the script to be executed
+ \return \c kMushNoError on success, an error code otherwise
+ */
+int scriptExecute(script_t *script);
+
+/*!
+ \brief Execute the commands of a group in the shell
+
+ Unlike scriptExecute(), \c return also ends the script executing the group,
+ such as the body of a function.
+
+ \param script the body of the group
+ \return \c kMushNoError on success, an error code otherwise
+ */
+int scriptExecuteGroup(script_t *script);
+
+/*!
+ \brief End every script being executed once the running command returns,
+ as \c exit does within a program embedding the shell
+
+ The outermost scriptExecute() or scriptExecuteFinal() returns and forgets
+ the request.
+ */
+void scriptExit();
+
+/*!
+ \brief Execute a script after which the shell exits, as given to \c -c or
+ read from a script file
+
+ If the last instruction runs a single program and no jobs are queued or
+ running, the program replaces the shell instead of being forked and waited
+ for.
+
+ \param script the script to be executed
+ \return \c kMushNoError on success, an error code otherwise
+ */
+int scriptExecuteFinal(script_t *script);
+
+/*!
+ \brief Print the instructions of \a script, one per line
+ \param script the script to be printed
+ \param stream stream to print to
+ */
+void scriptPrint(script_t *script, FILE *stream);
+
+/*!
+ \brief Add a reference to \a script, which is then only freed once
+ scriptFree() was called for each reference
+ \return \a script
+ */
+script_t *scriptRetain(script_t *script);
+
+/*!
+ \brief Release a reference to \a script, freeing the memory allocated by
+ scriptCompile() once no references are left
+ \param script the script to be freed, or \c NULL
+ */
+void scriptFree(script_t *script);
+
+/*!
+ \}
+ */
+
+#endif /* SCRIPT_H */
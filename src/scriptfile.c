@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "scriptfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "hash.h"
+#include "mush_error.h"
+#include "parser.h"
+
+/*! \brief Amount of buckets of the script cache, a power of two */
+#define SCRIPTFILE_BUCKET_COUNT 64
+/*! \brief Bytes read to find the interpreter of a program */
+#define SCRIPTFILE_SHEBANG_SIZE 128
+/*! \brief Initial size of the buffer a script is read into */
+#define SCRIPTFILE_READ_SIZE 4096
+
+/*! \brief A program found by scriptFileLookup() */
+typedef struct __scriptfile_entry_t {
+	/*! \brief path of the program */
+	char *path;
+	/*! \brief device, inode, size and modification time of the file when it
+	 was read */
+	dev_t device;
+	ino_t inode;
+	off_t size;
+	struct timespec modified;
+	/*! \brief compiled script, or \c NULL if the program is not a mush
+	 script */
+	script_t *script;
+	/*! \brief next program in the same bucket */
+	struct __scriptfile_entry_t *next;
+} scriptfile_entry_t;
+
+/*! \brief A name found in \c PATH by _findProgram() */
+typedef struct __scriptfile_name_t {
+	/*! \brief name of the program */
+	char *name;
+	/*! \brief path the name was found at */
+	char *path;
+	/*! \brief next name in the same bucket */
+	struct __scriptfile_name_t *next;
+} scriptfile_name_t;
+
+/*! \brief Programs, chained by the hash of their path */
+static scriptfile_entry_t *_buckets[SCRIPTFILE_BUCKET_COUNT];
+/*! \brief Names found in \c PATH, chained by the hash of the name */
+static scriptfile_name_t *_names[SCRIPTFILE_BUCKET_COUNT];
+/*! \brief Value of \c PATH the names were found in */
+static char *_namesPath;
+
+/*!
+ \brief Bucket of \a path
+ */
+static unsigned int _hash(const char *path)
+{
+	return hashString(path) & (SCRIPTFILE_BUCKET_COUNT - 1);
+}
+
+char *scriptFileRead(const char *path)
+{
+	FILE *file;
+	char *contents;
+	size_t length = 0;
+	size_t size = SCRIPTFILE_READ_SIZE;
+	size_t bytesRead;
+	file = fopen(path, "r");
+	if(file == NULL) {
+		return NULL;
+	}
+	contents = malloc(size);
+	while(contents != NULL && (bytesRead = fread(contents + length, 1, size - length - 1, file)) > 0) {
+		length += bytesRead;
+		if(length + 1 == size) {
+			size *= 2;
+			contents = realloc(contents, size);
+		}
+	}
+	if(contents != NULL) {
+		contents[length] = '\0';
+	}
+	fclose(file);
+	return contents;
+}
+
+/*!
+ \brief Forget the names found in \c PATH
+ */
+static void _forgetNames()
+{
+	scriptfile_name_t *entry;
+	size_t bucket;
+	for(bucket = 0; bucket < SCRIPTFILE_BUCKET_COUNT; bucket++) {
+		while(_names[bucket] != NULL) {
+			entry = _names[bucket];
+			_names[bucket] = entry->next;
+			free(entry->name);
+			free(entry->path);
+			free(entry);
+		}
+	}
+	free(_namesPath);
+	_namesPath = NULL;
+}
+
+/*!
+ \brief Indicate whether \a path is an executable regular file, with its
+ status in \a status
+ */
+static int _isProgram(const char *path, struct stat *status)
+{
+	return stat(path, status) == 0 && S_ISREG(status->st_mode) && access(path, X_OK) == 0;
+}
+
+/*!
+ \brief Find the executable regular file \a name in \a directories
+ \return newly allocated path, with the status of the file in \a status, or
+ \c NULL if there is none
+ */
+static char *_searchPath(const char *name, const char *directories, struct stat *status)
+{
+	const char *end;
+	char *path;
+	for(;; directories = end + 1) {
+		end = strchrnul(directories, ':');
+		/* An empty entry is the current directory */
+		if(asprintf(&path, "%.*s%s%s", (int)(end - directories), directories,
+			end == directories ? "" : "/", name) == -1) {
+			return NULL;
+		}
+		if(_isProgram(path, status)) {
+			return path;
+		}
+		free(path);
+		if(*end == '\0') {
+			return NULL;
+		}
+	}
+}
+
+/*!
+ \brief Find the executable regular file \a name, searching \c PATH unless
+ it contains a slash
+
+ Where a name was found is remembered until \c PATH changes, so \c PATH is
+ only searched again once the program is gone from there.
+
+ \return newly allocated path, with the status of the file in \a status, or
+ \c NULL if there is none
+ */
+static char *_findProgram(const char *name, struct stat *status)
+{
+	const char *directories;
+	scriptfile_name_t **link;
+	scriptfile_name_t *entry;
+	char *path;
+	if(strchr(name, '/') != NULL) {
+		return _isProgram(name, status) ? strdup(name) : NULL;
+	}
+	directories = getenv("PATH");
+	if(directories == NULL) {
+		directories = "/bin:/usr/bin";
+	}
+	if(_namesPath == NULL || strcmp(_namesPath, directories) != 0) {
+		_forgetNames();
+		_namesPath = strdup(directories);
+	}
+	for(link = &_names[_hash(name)]; *link != NULL && strcmp((*link)->name, name) != 0;
+	link = &(*link)->next) {
+	}
+	if(*link != NULL) {
+		if(_isProgram((*link)->path, status)) {
+			return strdup((*link)->path);
+		}
+		entry = *link;
+		*link = entry->next;
+		free(entry->name);
+		free(entry->path);
+		free(entry);
+	}
+	path = _searchPath(name, directories, status);
+	/* Names not found are searched again, as the program may be installed */
+	if(path == NULL || _namesPath == NULL) {
+		return path;
+	}
+	entry = malloc(sizeof(*entry));
+	if(entry == NULL) {
+		return path;
+	}
+	entry->name = strdup(name);
+	entry->path = strdup(path);
+	if(entry->name == NULL || entry->path == NULL) {
+		free(entry->name);
+		free(entry->path);
+		free(entry);
+		return path;
+	}
+	entry->next = _names[_hash(name)];
+	_names[_hash(name)] = entry;
+	return path;
+}
+
+/*!
+ \brief Indicate whether the last component of the path from \a path up to
+ \a end is \a name
+ */
+static int _isNamed(const char *path, const char *end, const char *name)
+{
+	size_t length = strlen(name);
+	if((size_t)(end - path) < length || strncmp(end - length, name, length) != 0) {
+		return 0;
+	}
+	return (size_t)(end - path) == length || *(end - length - 1) == '/';
+}
+
+/*!
+ \brief Indicate whether the \c #! line read from \a descriptor names mush as
+ the interpreter
+ */
+static int _isMushScript(int descriptor)
+{
+	char line[SCRIPTFILE_SHEBANG_SIZE + 1];
+	char *interpreter;
+	char *end;
+	ssize_t length = read(descriptor, line, SCRIPTFILE_SHEBANG_SIZE);
+	if(length < 2 || line[0] != '#' || line[1] != '!') {
+		return 0;
+	}
+	line[length] = '\0';
+	line[strcspn(line, "\n")] = '\0';
+	interpreter = line + 2 + strspn(line + 2, " \t");
+	end = interpreter + strcspn(interpreter, " \t");
+	/* "#!/usr/bin/env mush" names the interpreter as an argument */
+	if(_isNamed(interpreter, end, "env")) {
+		interpreter = end + strspn(end, " \t");
+		end = interpreter + strcspn(interpreter, " \t");
+	}
+	return _isNamed(interpreter, end, "mush");
+}
+
+/*!
+ \brief Compile the program at \a path if it is a mush script
+ \return the compiled script, or \c NULL if it is not a mush script or could
+ not be compiled
+ */
+static script_t *_load(const char *path)
+{
+	queue_t *commands;
+	script_t *script;
+	char *source;
+	int descriptor;
+	int isMushScript;
+	descriptor = open(path, O_RDONLY | O_CLOEXEC);
+	if(descriptor == -1) {
+		return NULL;
+	}
+	isMushScript = _isMushScript(descriptor);
+	close(descriptor);
+	if(!isMushScript) {
+		return NULL;
+	}
+	source = scriptFileRead(path);
+	if(source == NULL) {
+		return NULL;
+	}
+	commands = commandQueueFromInput(source);
+	free(source);
+	script = commands != NULL ? scriptCompile(commands) : NULL;
+	if(commands != NULL) {
+		queueFree(commands);
+	}
+	/* The script is left for mush itself to report its errors */
+	if(script == NULL) {
+		setMushError(kMushNoError);
+		return NULL;
+	}
+	return script;
+}
+
+script_t *scriptFileLookup(const char *name, char **path)
+{
+	scriptfile_entry_t *entry;
+	struct stat status;
+	unsigned int bucket;
+	char *found = _findProgram(name, &status);
+	if(found == NULL) {
+		return NULL;
+	}
+	bucket = _hash(found);
+	for(entry = _buckets[bucket]; entry != NULL && strcmp(entry->path, found) != 0; entry = entry->next) {
+	}
+	if(entry == NULL) {
+		entry = malloc(sizeof(*entry));
+		if(entry == NULL) {
+			free(found);
+			return NULL;
+		}
+		entry->path = strdup(found);
+		if(entry->path == NULL) {
+			free(entry);
+			free(found);
+			return NULL;
+		}
+		entry->script = NULL;
+		/* No file has a negative size, so the program is read below */
+		entry->device = 0;
+		entry->inode = 0;
+		entry->size = -1;
+		entry->modified.tv_sec = 0;
+		entry->modified.tv_nsec = 0;
+		entry->next = _buckets[bucket];
+		_buckets[bucket] = entry;
+	}
+	if(entry->device != status.st_dev || entry->inode != status.st_ino
+	|| entry->size != status.st_size
+	|| entry->modified.tv_sec != status.st_mtim.tv_sec
+	|| entry->modified.tv_nsec != status.st_mtim.tv_nsec) {
+		scriptFree(entry->script);
+		entry->script = _load(found);
+		entry->device = status.st_dev;
+		entry->inode = status.st_ino;
+		entry->size = status.st_size;
+		entry->modified = status.st_mtim;
+	}
+	if(entry->script == NULL) {
+		free(found);
+		return NULL;
+	}
+	*path = found;
+	return scriptRetain(entry->script);
+}
+
+void scriptFileForget()
+{
+	scriptfile_entry_t *entry;
+	size_t bucket;
+	for(bucket = 0; bucket < SCRIPTFILE_BUCKET_COUNT; bucket++) {
+		while(_buckets[bucket] != NULL) {
+			entry = _buckets[bucket];
+			_buckets[bucket] = entry->next;
+			scriptFree(entry->script);
+			free(entry->path);
+			free(entry);
+		}
+	}
+	_forgetNames();
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SCRIPTFILE_H
+#define SCRIPTFILE_H
+
+#include "script.h"
+
+/*!
+ \addtogroup scriptfile
+ \{
+ */
+
+/*!
+ \brief Read the file at \a path into a newly allocated string
+ \return the contents of the file, or \c NULL on error
+ */
+char *scriptFileRead(const char *path);
+
+/*!
+ \brief Find the program \a name like execvp(), and load it if it is a mush
+ script
+
+ A script is recognized by a \c #! line naming mush as its interpreter,
+ directly or through \c env. Compiled scripts are cached by their path, and
+ compiled again only once the file changes, so running a script repeatedly
+ neither reads nor parses it again. Other programs are remembered as such.
+ Where \a name was found in \c PATH is remembered as well until \c PATH
+ changes, so a program run repeatedly costs a single look at its file.
+
+ \param name name of the program, searched in \c PATH unless it contains a
+ slash
+ \param path set to the newly allocated path of the script, if one is found
+ \return a reference to the compiled script, to be released with
+ scriptFree(), or \c NULL if \a name is not a mush script
+ */
+script_t *scriptFileLookup(const char *name, char **path);
+
+/*!
+ \brief Forget the cached scripts and the names found in \c PATH
+ */
+void scriptFileForget();
+
+/*!
+ \}
+ */
+
+#endif /* SCRIPTFILE_H */
@@ -0,0 +1,508 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include "server.h"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include "parser.h"
+#include "script.h"
+#include "exec.h"
+#include "jobs.h"
+#include "launcher.h"
+#include "redirection.h"
+#include "mush_error.h"
+
+/*! \brief Amount of output read from a command at once */
+#define SERVER_READ_SIZE 65536
+/*! \brief Connections waiting for a worker before they are refused */
+#define SERVER_BACKLOG 128
+
+/*! \brief Set once the server is asked to stop */
+static volatile sig_atomic_t _isStopping = 0;
+/*! \brief Socket connections are accepted on */
+static int _listener = -1;
+/*! \brief Written to by the signal handlers to wake up poll() */
+static int _wakePipe[2] = {-1, -1};
+
+static void _wakeHandler(int signal)
+{
+	int savedErrno = errno;
+	if(signal != SIGCHLD) {
+		_isStopping = 1;
+	}
+	write(_wakePipe[1], "", 1);
+	errno = savedErrno;
+}
+
+static int _writeAll(int descriptor, const void *data, size_t length)
+{
+	ssize_t count;
+	size_t written = 0;
+	while(written < length) {
+		count = send(descriptor, (const char *)data + written, length - written, MSG_NOSIGNAL);
+		if(count == -1 && errno == EINTR) {
+			continue;
+		}
+		if(count <= 0) {
+			return -1;
+		}
+		written += count;
+	}
+	return 0;
+}
+
+static int _readAll(int descriptor, void *data, size_t length)
+{
+	ssize_t count;
+	size_t received = 0;
+	while(received < length) {
+		count = read(descriptor, (char *)data + received, length - received);
+		if(count == -1 && errno == EINTR) {
+			continue;
+		}
+		if(count <= 0) {
+			return -1;
+		}
+		received += count;
+	}
+	return 0;
+}
+
+int serverSendMessage(int socket, uint32_t type, const void *data, size_t length,
+	const int *descriptors, size_t count)
+{
+	union {
+		char buffer[CMSG_SPACE(sizeof(int) * SERVER_DESCRIPTORS_MAX)];
+		struct cmsghdr alignment;
+	} control;
+	server_header_t header;
+	struct msghdr message;
+	struct iovec vectors[2];
+	struct cmsghdr *controlHeader;
+	ssize_t sent;
+	if(count > SERVER_DESCRIPTORS_MAX || length > UINT32_MAX) {
+		errno = EINVAL;
+		return -1;
+	}
+	header.type = type;
+	header.length = (uint32_t)length;
+	memset(&message, 0, sizeof(message));
+	vectors[0].iov_base = &header;
+	vectors[0].iov_len = sizeof(header);
+	vectors[1].iov_base = (void *)data;
+	vectors[1].iov_len = length;
+	message.msg_iov = vectors;
+	message.msg_iovlen = length > 0 ? 2 : 1;
+	if(count > 0) {
+		message.msg_control = control.buffer;
+		message.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+		controlHeader = CMSG_FIRSTHDR(&message);
+		controlHeader->cmsg_level = SOL_SOCKET;
+		controlHeader->cmsg_type = SCM_RIGHTS;
+		controlHeader->cmsg_len = CMSG_LEN(sizeof(int) * count);
+		memcpy(CMSG_DATA(controlHeader), descriptors, sizeof(int) * count);
+	}
+	do {
+		sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+	} while(sent == -1 && errno == EINTR);
+	if(sent < (ssize_t)sizeof(header)) {
+		if(sent != -1) {
+			errno = EPIPE;
+		}
+		return -1;
+	}
+	/* The header and descriptors went out with the first bytes */
+	sent -= sizeof(header);
+	return _writeAll(socket, (const char *)data + sent, length - sent);
+}
+
+int serverReceiveMessage(int socket, server_header_t *header, char **payload,
+	int *descriptors, size_t *count)
+{
+	union {
+		char buffer[CMSG_SPACE(sizeof(int) * SERVER_DESCRIPTORS_MAX)];
+		struct cmsghdr alignment;
+	} control;
+	int received[SERVER_DESCRIPTORS_MAX];
+	size_t receivedCount = 0;
+	struct msghdr message;
+	struct iovec vector;
+	struct cmsghdr *controlHeader;
+	ssize_t length;
+	size_t index;
+	memset(&message, 0, sizeof(message));
+	vector.iov_base = header;
+	vector.iov_len = sizeof(*header);
+	message.msg_iov = &vector;
+	message.msg_iovlen = 1;
+	message.msg_control = control.buffer;
+	message.msg_controllen = sizeof(control.buffer);
+	do {
+		length = recvmsg(socket, &message, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+	} while(length == -1 && errno == EINTR);
+	for(controlHeader = CMSG_FIRSTHDR(&message); controlHeader != NULL;
+		controlHeader = CMSG_NXTHDR(&message, controlHeader)) {
+		if(controlHeader->cmsg_level == SOL_SOCKET && controlHeader->cmsg_type == SCM_RIGHTS) {
+			receivedCount = (controlHeader->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			memcpy(received, CMSG_DATA(controlHeader), receivedCount * sizeof(int));
+		}
+	}
+	if(descriptors != NULL && count != NULL) {
+		memcpy(descriptors, received, receivedCount * sizeof(int));
+		*count = receivedCount;
+	} else {
+		for(index = 0; index < receivedCount; index++) {
+			close(received[index]);
+		}
+	}
+	*payload = NULL;
+	if(length > 0 && length < (ssize_t)sizeof(*header)
+	&& _readAll(socket, (char *)header + length, sizeof(*header) - length) == 0) {
+		length = sizeof(*header);
+	}
+	if(length != sizeof(*header) || header->length > SERVER_PAYLOAD_MAX) {
+		return -1;
+	}
+	*payload = malloc(header->length + 1);
+	if(*payload == NULL || _readAll(socket, *payload, header->length) != 0) {
+		free(*payload);
+		*payload = NULL;
+		return -1;
+	}
+	(*payload)[header->length] = '\0';
+	return 0;
+}
+
+/*!
+ \brief Send a status message of \a status
+ \return \c 0 on success, \c -1 if the client went away
+ */
+static int _sendStatus(int connection, int status)
+{
+	int32_t value = status;
+	return serverSendMessage(connection, kServerMessageStatus, &value, sizeof(value), NULL, 0);
+}
+
+/*!
+ \brief Run the command line \a source in a child, sending back its output
+ unless it is written to one of \a descriptors, then its exit status
+ \param descriptors descriptors passed by the client for standard input,
+ output and error
+ \param count amount of elements in \a descriptors
+ \return \c 0 on success, \c -1 if the client went away
+ */
+static int _runCommand(int connection, char *source, int *descriptors, size_t count)
+{
+	struct pollfd streams[2];
+	char buffer[SERVER_READ_SIZE];
+	char *message;
+	queue_t *commands;
+	queue_t *redirections;
+	script_t *script;
+	redirection_t *failedRedirection;
+	int pipes[2][2];
+	int isConnected = 1;
+	int waitStatus;
+	int stream;
+	ssize_t length;
+	pid_t pid;
+	setMushError(kMushNoError);
+	commands = commandQueueFromInput(source);
+	script = commands != NULL ? scriptCompile(commands) : NULL;
+	if(commands != NULL) {
+		queueFree(commands);
+	}
+	/* Mistakes are reported without creating a process */
+	if(script == NULL) {
+		if(asprintf(&message, "mush: %s\n", mushErrorDescription()) == -1) {
+			message = NULL;
+		}
+		if(message != NULL && serverSendMessage(connection, kServerMessageError, message,
+			strlen(message), NULL, 0) != 0) {
+			isConnected = 0;
+		}
+		free(message);
+		return isConnected ? _sendStatus(connection, 2) : -1;
+	}
+	redirections = queueNew();
+	queueInsert(redirections, count > 0 ? redirectionNewDuplicate(STDIN_FILENO, descriptors[0])
+		: redirectionNewOpen(STDIN_FILENO, "/dev/null", O_RDONLY),
+		(queueNodeFreeFunction)redirectionFree);
+	for(stream = 0; stream < 2; stream++) {
+		pipes[stream][0] = -1;
+		pipes[stream][1] = -1;
+		if(count > (size_t)stream + 1) {
+			queueInsert(redirections, redirectionNewDuplicate(STDOUT_FILENO + stream,
+				descriptors[stream + 1]), (queueNodeFreeFunction)redirectionFree);
+		} else if(redirectionPipe(pipes[stream]) == 0) {
+			queueInsert(redirections, redirectionNewDuplicate(STDOUT_FILENO + stream,
+				pipes[stream][1]), (queueNodeFreeFunction)redirectionFree);
+		}
+	}
+	fflush(NULL);
+	pid = fork();
+	if(pid == 0) {
+		close(connection);
+		close(_listener);
+		for(stream = 0; stream < 2; stream++) {
+			if(pipes[stream][0] != -1) {
+				close(pipes[stream][0]);
+			}
+		}
+		failedRedirection = redirectionsApply(redirections);
+		if(failedRedirection != NULL) {
+			redirectionPrintError(failedRedirection);
+			exit(kMushExecutionError);
+		}
+		/* Each command line starts out as a new shell would */
+		jobsReset();
+		signal(SIGPIPE, SIG_DFL);
+		if(scriptExecuteFinal(script) != kMushNoError && mushError() != kMushNoError) {
+			fprintf(stderr, "mush: %s\n", mushErrorDescription());
+		}
+		exit(executeLastStatus());
+	}
+	queueFree(redirections);
+	scriptFree(script);
+	for(stream = 0; stream < 2; stream++) {
+		if(pipes[stream][1] != -1) {
+			close(pipes[stream][1]);
+		}
+		streams[stream].fd = pipes[stream][0];
+		streams[stream].events = POLLIN;
+	}
+	if(pid == -1) {
+		for(stream = 0; stream < 2; stream++) {
+			if(streams[stream].fd != -1) {
+				close(streams[stream].fd);
+			}
+		}
+		return _sendStatus(connection, kMushExecutionError);
+	}
+	/* The output is sent until every process holding the pipes is done */
+	while(streams[0].fd != -1 || streams[1].fd != -1) {
+		if(poll(streams, 2, -1) == -1) {
+			if(errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		for(stream = 0; stream < 2; stream++) {
+			if(streams[stream].fd == -1 || streams[stream].revents == 0) {
+				continue;
+			}
+			length = read(streams[stream].fd, buffer, sizeof(buffer));
+			if(length == -1 && errno == EINTR) {
+				continue;
+			}
+			if(length <= 0) {
+				close(streams[stream].fd);
+				streams[stream].fd = -1;
+				continue;
+			}
+			/* Output nobody receives any more is still drained */
+			if(isConnected && serverSendMessage(connection, stream == 0 ? kServerMessageOutput
+				: kServerMessageError, buffer, length, NULL, 0) != 0) {
+				isConnected = 0;
+			}
+		}
+	}
+	for(stream = 0; stream < 2; stream++) {
+		if(streams[stream].fd != -1) {
+			close(streams[stream].fd);
+		}
+	}
+	while(waitpid(pid, &waitStatus, 0) == -1 && errno == EINTR) {
+	}
+	if(!isConnected) {
+		return -1;
+	}
+	return _sendStatus(connection, WIFSIGNALED(waitStatus) ? 128 + WTERMSIG(waitStatus)
+		: WEXITSTATUS(waitStatus));
+}
+
+/*!
+ \brief Accept connections and run their command lines, in a worker
+ */
+static void _serveConnections()
+{
+	server_header_t header;
+	int descriptors[SERVER_DESCRIPTORS_MAX];
+	size_t count;
+	size_t index;
+	char *payload;
+	int connection;
+	int status;
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGINT, SIG_DFL);
+	/* The worker and its commands are stopped together */
+	setpgid(0, 0);
+	jobsReset();
+	close(_wakePipe[0]);
+	close(_wakePipe[1]);
+	for(;;) {
+		connection = accept4(_listener, NULL, NULL, SOCK_CLOEXEC);
+		if(connection == -1) {
+			if(errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			_exit(1);
+		}
+		while(serverReceiveMessage(connection, &header, &payload, descriptors, &count) == 0) {
+			status = -1;
+			if(header.type == kServerMessageCommand) {
+				status = _runCommand(connection, payload, descriptors, count);
+			}
+			for(index = 0; index < count; index++) {
+				close(descriptors[index]);
+			}
+			free(payload);
+			if(status != 0) {
+				break;
+			}
+		}
+		close(connection);
+	}
+}
+
+int serverRun(const char *path, int workerCount)
+{
+	struct sockaddr_un address;
+	struct sigaction action;
+	struct sigaction previousActions[3];
+	struct pollfd wake;
+	struct stat status;
+	char buffer[64];
+	pid_t *workers;
+	pid_t pid;
+	int index;
+	if(strlen(path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "mush: %s: path too long for a socket\n", path);
+		return 1;
+	}
+	if(workerCount < 1) {
+		workerCount = 1;
+	}
+	/* Command lines are forked from the workers, which stay small */
+	launcherStop();
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+	if(lstat(path, &status) == 0 && S_ISSOCK(status.st_mode)) {
+		unlink(path);
+	}
+	_listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(_listener == -1 || bind(_listener, (struct sockaddr *)&address, sizeof(address)) != 0
+	|| listen(_listener, SERVER_BACKLOG) != 0) {
+		fprintf(stderr, "mush: %s: %s\n", path, strerror(errno));
+		if(_listener != -1) {
+			close(_listener);
+		}
+		return 1;
+	}
+	workers = malloc(workerCount * sizeof(*workers));
+	if(workers == NULL || redirectionPipe(_wakePipe) != 0) {
+		free(workers);
+		close(_listener);
+		unlink(path);
+		return 1;
+	}
+	fcntl(_wakePipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(_wakePipe[1], F_SETFL, O_NONBLOCK);
+	for(index = 0; index < workerCount; index++) {
+		workers[index] = -1;
+	}
+	/* A signal arriving before poll() is waited for is left in the pipe */
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = _wakeHandler;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGTERM, &action, &previousActions[0]);
+	sigaction(SIGINT, &action, &previousActions[1]);
+	sigaction(SIGCHLD, &action, &previousActions[2]);
+	wake.fd = _wakePipe[0];
+	wake.events = POLLIN;
+	while(!_isStopping) {
+		/* Workers which terminated are replaced */
+		for(index = 0; index < workerCount && !_isStopping; index++) {
+			if(workers[index] != -1) {
+				continue;
+			}
+			fflush(NULL);
+			workers[index] = fork();
+			if(workers[index] == 0) {
+				free(workers);
+				_serveConnections();
+			}
+			if(workers[index] == -1) {
+				fprintf(stderr, "mush: unable to start worker: %s\n", strerror(errno));
+				_isStopping = 1;
+			} else {
+				setpgid(workers[index], workers[index]);
+			}
+		}
+		if(!_isStopping && poll(&wake, 1, -1) == -1 && errno != EINTR) {
+			break;
+		}
+		while(read(_wakePipe[0], buffer, sizeof(buffer)) > 0) {
+		}
+		while((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+			for(index = 0; index < workerCount; index++) {
+				if(workers[index] == pid) {
+					workers[index] = -1;
+				}
+			}
+		}
+	}
+	sigaction(SIGTERM, &previousActions[0], NULL);
+	sigaction(SIGINT, &previousActions[1], NULL);
+	sigaction(SIGCHLD, &previousActions[2], NULL);
+	close(_wakePipe[0]);
+	close(_wakePipe[1]);
+	/* The commands of the workers are stopped with them */
+	for(index = 0; index < workerCount; index++) {
+		if(workers[index] != -1 && kill(-workers[index], SIGTERM) != 0) {
+			kill(workers[index], SIGTERM);
+		}
+	}
+	for(index = 0; index < workerCount; index++) {
+		if(workers[index] != -1) {
+			waitpid(workers[index], NULL, 0);
+		}
+	}
+	free(workers);
+	close(_listener);
+	_listener = -1;
+	unlink(path);
+	return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ \addtogroup server
+ \{
+ */
+
+/*! \brief Most descriptors passed along with a message */
+#define SERVER_DESCRIPTORS_MAX 3
+/*! \brief Longest payload accepted from a client */
+#define SERVER_PAYLOAD_MAX (1024 * 1024)
+
+enum {
+	/*! \brief Client: a command line to run. Descriptors passed along with
+	 it replace standard input, output and error, in that order. Standard
+	 input is otherwise \c /dev/null, and the output is sent back */
+	kServerMessageCommand = 1,
+	/*! \brief Server: data written by the command to standard output */
+	kServerMessageOutput,
+	/*! \brief Server: data written by the command to standard error */
+	kServerMessageError,
+	/*! \brief Server: the command line finished, the payload is its exit
+	 status as an \c int32_t */
+	kServerMessageStatus
+};
+
+/*! \brief Header preceding each message, in host byte order */
+typedef struct __server_header_t {
+	/*! \brief one of the \c kServerMessage values */
+	uint32_t type;
+	/*! \brief amount of bytes following the header */
+	uint32_t length;
+} server_header_t;
+
+/*!
+ \brief Serve command lines on the UNIX socket at \a path until \c SIGTERM
+ or \c SIGINT is received
+
+ \a workerCount worker processes accept connections on the socket, each
+ serving one connection at a time, so that many command lines run at
+ once. The command lines of a connection run one after the other, each in
+ a child of its worker, which starts out as a new shell would. Workers
+ which terminate are replaced. Each worker leads a process group, which is
+ sent \c SIGTERM when the server stops, so that running commands stop too.
+
+ \param path path of the socket, replaced if it is a socket already
+ \param workerCount size of the worker pool
+ \return exit status of the shell
+ */
+int serverRun(const char *path, int workerCount);
+
+/*!
+ \brief Send a message over the socket \a socket
+ \param descriptors descriptors passed along with the header, or \c NULL
+ \param count amount of elements in \a descriptors, at most
+ \c SERVER_DESCRIPTORS_MAX
+ \return \c 0 on success, \c -1 on error with \c errno set
+ */
+int serverSendMessage(int socket, uint32_t type, const void *data, size_t length,
+	const int *descriptors, size_t count);
+
+/*!
+ \brief Receive a message from the socket \a socket
+ \param header receives the header of the message
+ \param payload receives the newly allocated payload, followed by a null
+ character
+ \param descriptors receives the descriptors passed along, or \c NULL to
+ close them
+ \param count receives the amount of descriptors, or \c NULL
+ \return \c 0 on success, \c -1 at the end of the stream or on error
+ */
+int serverReceiveMessage(int socket, server_header_t *header, char **payload,
+	int *descriptors, size_t *count);
+
+/*!
+ \}
+ */
+
+#endif /* SERVER_H */
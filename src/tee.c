@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "tee.h"
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "builtin.h"
+#include "transfer.h"
+
+/*! \brief Permissions of files created by tee, before the umask */
+#define TEE_FILE_MODE 0666
+
+int cmd_tee(int argc, char **argv)
+{
+	int *outputs;
+	int *files;
+	int flags = O_WRONLY | O_CREAT | O_TRUNC;
+	int fileCount = 0;
+	int status = 0;
+	int argi;
+	int index;
+	for(argi = 1; argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0'; argi++) {
+		if(strcmp(argv[argi], "--") == 0) {
+			argi++;
+			break;
+		} else if(strcmp(argv[argi], "-a") == 0) {
+			flags = O_WRONLY | O_CREAT | O_APPEND;
+		} else if(strcmp(argv[argi], "-i") == 0) {
+			signal(SIGINT, SIG_IGN);
+		} else {
+			return builtinExecuteProgram(argv);
+		}
+	}
+	/* Standard output comes first, followed by each file */
+	outputs = malloc((argc - argi + 1) * sizeof(*outputs));
+	files = malloc((argc - argi + 1) * sizeof(*files));
+	if(outputs == NULL || files == NULL) {
+		free(outputs);
+		free(files);
+		return 1;
+	}
+	outputs[fileCount] = STDOUT_FILENO;
+	files[fileCount++] = STDOUT_FILENO;
+	for(; argi < argc; argi++) {
+		outputs[fileCount] = open(argv[argi], flags | O_CLOEXEC, TEE_FILE_MODE);
+		if(outputs[fileCount] == -1) {
+			fprintf(stderr, "tee: %s: %s\n", argv[argi], strerror(errno));
+			status = 1;
+			continue;
+		}
+		files[fileCount] = outputs[fileCount];
+		fileCount++;
+	}
+	if(transferDescriptorToMany(STDIN_FILENO, outputs, fileCount) != 0) {
+		fprintf(stderr, "tee: %s\n", strerror(errno));
+		status = 1;
+	}
+	/* Outputs which failed are cleared, so the descriptors are kept aside */
+	for(index = 1; index < fileCount; index++) {
+		close(files[index]);
+	}
+	free(outputs);
+	free(files);
+	return status;
+}
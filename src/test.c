@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "test.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/*! \brief Position within the arguments of an expression being evaluated */
+typedef struct __test_parser_t {
+	char **tokens;
+	int count;
+	int position;
+	/*! \brief set once the expression turned out to be malformed */
+	int isError;
+} test_parser_t;
+
+static const char *_unaryOperators[] = {
+	"-b", "-c", "-d", "-e", "-f", "-g", "-h", "-k", "-L", "-n", "-p", "-r",
+	"-s", "-S", "-t", "-u", "-w", "-x", "-z", NULL
+};
+
+static const char *_binaryOperators[] = {
+	"=", "==", "!=", "<", ">", "-eq", "-ne", "-gt", "-ge", "-lt", "-le",
+	"-nt", "-ot", "-ef", NULL
+};
+
+static int _isOperator(const char **operators, const char *token)
+{
+	for(; *operators != NULL; operators++) {
+		if(strcmp(*operators, token) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static long _integer(test_parser_t *parser, const char *string)
+{
+	char *end;
+	long value;
+	errno = 0;
+	value = strtol(string, &end, 10);
+	/* Surrounding blanks are allowed, anything else is not */
+	while(*end == ' ' || *end == '\t') {
+		end++;
+	}
+	if(*string == '\0' || *end != '\0' || errno != 0) {
+		fprintf(stderr, "test: %s: integer expression expected\n", string);
+		parser->isError = 1;
+	}
+	return value;
+}
+
+static int _evaluateUnary(const char *operator, const char *operand)
+{
+	struct stat status;
+	int isStatValid;
+	if(operator[1] == 'n') {
+		return *operand != '\0';
+	} else if(operator[1] == 'z') {
+		return *operand == '\0';
+	} else if(operator[1] == 't') {
+		return isatty(atoi(operand));
+	} else if(operator[1] == 'r') {
+		return access(operand, R_OK) == 0;
+	} else if(operator[1] == 'w') {
+		return access(operand, W_OK) == 0;
+	} else if(operator[1] == 'x') {
+		return access(operand, X_OK) == 0;
+	} else if(operator[1] == 'h' || operator[1] == 'L') {
+		return lstat(operand, &status) == 0 && S_ISLNK(status.st_mode);
+	}
+	isStatValid = stat(operand, &status) == 0;
+	switch(operator[1]) {
+		case 'b':
+			return isStatValid && S_ISBLK(status.st_mode);
+		case 'c':
+			return isStatValid && S_ISCHR(status.st_mode);
+		case 'd':
+			return isStatValid && S_ISDIR(status.st_mode);
+		case 'e':
+			return isStatValid;
+		case 'f':
+			return isStatValid && S_ISREG(status.st_mode);
+		case 'g':
+			return isStatValid && (status.st_mode & S_ISGID);
+		case 'k':
+			return isStatValid && (status.st_mode & S_ISVTX);
+		case 'p':
+			return isStatValid && S_ISFIFO(status.st_mode);
+		case 's':
+			return isStatValid && status.st_size > 0;
+		case 'S':
+			return isStatValid && S_ISSOCK(status.st_mode);
+		case 'u':
+			return isStatValid && (status.st_mode & S_ISUID);
+	}
+	return 0;
+}
+
+static int _evaluateBinary(test_parser_t *parser, const char *left, const char *operator,
+	const char *right)
+{
+	struct stat leftStatus;
+	struct stat rightStatus;
+	long leftValue;
+	long rightValue;
+	if(strcmp(operator, "=") == 0 || strcmp(operator, "==") == 0) {
+		return strcmp(left, right) == 0;
+	} else if(strcmp(operator, "!=") == 0) {
+		return strcmp(left, right) != 0;
+	} else if(strcmp(operator, "<") == 0) {
+		return strcmp(left, right) < 0;
+	} else if(strcmp(operator, ">") == 0) {
+		return strcmp(left, right) > 0;
+	} else if(strcmp(operator, "-nt") == 0 || strcmp(operator, "-ot") == 0
+		|| strcmp(operator, "-ef") == 0) {
+		if(stat(left, &leftStatus) != 0 || stat(right, &rightStatus) != 0) {
+			return 0;
+		}
+		if(operator[1] == 'n') {
+			return leftStatus.st_mtime > rightStatus.st_mtime;
+		} else if(operator[1] == 'o') {
+			return leftStatus.st_mtime < rightStatus.st_mtime;
+		}
+		return leftStatus.st_dev == rightStatus.st_dev && leftStatus.st_ino == rightStatus.st_ino;
+	}
+	leftValue = _integer(parser, left);
+	rightValue = _integer(parser, right);
+	if(strcmp(operator, "-eq") == 0) {
+		return leftValue == rightValue;
+	} else if(strcmp(operator, "-ne") == 0) {
+		return leftValue != rightValue;
+	} else if(strcmp(operator, "-gt") == 0) {
+		return leftValue > rightValue;
+	} else if(strcmp(operator, "-ge") == 0) {
+		return leftValue >= rightValue;
+	} else if(strcmp(operator, "-lt") == 0) {
+		return leftValue < rightValue;
+	}
+	return leftValue <= rightValue;
+}
+
+static const char *_peek(test_parser_t *parser, int offset)
+{
+	if(parser->position + offset >= parser->count) {
+		return NULL;
+	}
+	return parser->tokens[parser->position + offset];
+}
+
+static int _parseOr(test_parser_t *parser);
+
+static int _parsePrimary(test_parser_t *parser)
+{
+	const char *token = _peek(parser, 0);
+	int value;
+	if(token == NULL) {
+		fprintf(stderr, "test: argument expected\n");
+		parser->isError = 1;
+		return 0;
+	}
+	if(strcmp(token, "(") == 0 && _peek(parser, 1) != NULL) {
+		parser->position++;
+		value = _parseOr(parser);
+		if(_peek(parser, 0) == NULL || strcmp(_peek(parser, 0), ")") != 0) {
+			fprintf(stderr, "test: ')' expected\n");
+			parser->isError = 1;
+			return 0;
+		}
+		parser->position++;
+		return value;
+	}
+	if(_peek(parser, 1) != NULL && _peek(parser, 2) != NULL
+		&& _isOperator(_binaryOperators, _peek(parser, 1))) {
+		parser->position += 3;
+		return _evaluateBinary(parser, token, _peek(parser, -2), _peek(parser, -1));
+	}
+	if(_isOperator(_unaryOperators, token) && _peek(parser, 1) != NULL) {
+		parser->position += 2;
+		return _evaluateUnary(token, _peek(parser, -1));
+	}
+	parser->position++;
+	return *token != '\0';
+}
+
+static int _parseNot(test_parser_t *parser)
+{
+	if(_peek(parser, 0) != NULL && strcmp(_peek(parser, 0), "!") == 0 && _peek(parser, 1) != NULL) {
+		parser->position++;
+		return !_parseNot(parser);
+	}
+	return _parsePrimary(parser);
+}
+
+static int _parseAnd(test_parser_t *parser)
+{
+	int value = _parseNot(parser);
+	while(_peek(parser, 0) != NULL && strcmp(_peek(parser, 0), "-a") == 0) {
+		parser->position++;
+		/* Both operands are parsed, so errors are found either way */
+		value = _parseNot(parser) && value;
+	}
+	return value;
+}
+
+static int _parseOr(test_parser_t *parser)
+{
+	int value = _parseAnd(parser);
+	while(_peek(parser, 0) != NULL && strcmp(_peek(parser, 0), "-o") == 0) {
+		parser->position++;
+		value = _parseAnd(parser) || value;
+	}
+	return value;
+}
+
+/*!
+ \brief Evaluate \a count tokens, using the rules of POSIX for up to four
+ arguments, which take precedence over operators
+ */
+static int _evaluate(test_parser_t *parser, char **tokens, int count)
+{
+	int value;
+	if(count == 0) {
+		return 0;
+	} else if(count == 1) {
+		return *tokens[0] != '\0';
+	} else if(count == 2 && strcmp(tokens[0], "!") == 0) {
+		return *tokens[1] == '\0';
+	} else if(count == 2 && _isOperator(_unaryOperators, tokens[0])) {
+		return _evaluateUnary(tokens[0], tokens[1]);
+	} else if(count == 3 && _isOperator(_binaryOperators, tokens[1])) {
+		return _evaluateBinary(parser, tokens[0], tokens[1], tokens[2]);
+	} else if((count == 3 || count == 4) && strcmp(tokens[0], "!") == 0) {
+		return !_evaluate(parser, tokens + 1, count - 1);
+	} else if((count == 3 || count == 4) && strcmp(tokens[0], "(") == 0
+		&& strcmp(tokens[count - 1], ")") == 0) {
+		return _evaluate(parser, tokens + 1, count - 2);
+	}
+	parser->tokens = tokens;
+	parser->count = count;
+	parser->position = 0;
+	value = _parseOr(parser);
+	if(!parser->isError && parser->position < parser->count) {
+		fprintf(stderr, "test: %s: unexpected argument\n", parser->tokens[parser->position]);
+		parser->isError = 1;
+	}
+	return value;
+}
+
+int cmd_test(int argc, char **argv)
+{
+	test_parser_t parser;
+	int value;
+	if(strcmp(argv[0], "[") == 0) {
+		if(argc < 2 || strcmp(argv[argc - 1], "]") != 0) {
+			fprintf(stderr, "[: missing ']'\n");
+			return 2;
+		}
+		argc--;
+	}
+	parser.isError = 0;
+	value = _evaluate(&parser, argv + 1, argc - 1);
+	if(parser.isError) {
+		return 2;
+	}
+	return value ? 0 : 1;
+}
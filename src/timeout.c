@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "timeout.h"
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <math.h>
+#if defined(__linux__)
+#include <sys/timerfd.h>
+#endif
+#include "builtin.h"
+#include "jobs.h"
+
+/*! \brief Exit status of a command which timed out */
+#define TIMEOUT_STATUS 124
+
+static const char _usage[] =
+	"usage: timeout [-s signal] [-k duration] [--foreground] duration command [arguments]\n";
+
+/*! \brief Names of the signals which can be sent, without the \c SIG prefix */
+static const struct {
+	const char *name;
+	int signal;
+} _signals[] = {
+	{"HUP", SIGHUP},
+	{"INT", SIGINT},
+	{"QUIT", SIGQUIT},
+	{"KILL", SIGKILL},
+	{"USR1", SIGUSR1},
+	{"USR2", SIGUSR2},
+	{"ALRM", SIGALRM},
+	{"TERM", SIGTERM},
+	{"CONT", SIGCONT},
+	{"STOP", SIGSTOP},
+	{NULL, 0}
+};
+
+/*!
+ \brief Parse the signal \a name, a number or a name with or without the
+ \c SIG prefix
+ \return the signal, or \c -1 if it is unknown
+ */
+static int _parseSignal(const char *name)
+{
+	char *end;
+	long number;
+	int index;
+	if(isdigit((unsigned char)name[0])) {
+		number = strtol(name, &end, 10);
+		return *end == '\0' && number > 0 && number < NSIG ? (int)number : -1;
+	}
+	if(strncasecmp(name, "SIG", 3) == 0) {
+		name += 3;
+	}
+	for(index = 0; _signals[index].name != NULL; index++) {
+		if(strcasecmp(_signals[index].name, name) == 0) {
+			return _signals[index].signal;
+		}
+	}
+	return -1;
+}
+
+/*!
+ \brief Parse the duration \a text, in seconds with an optional fraction and
+ unit suffix
+ \return \c 0 on success, \c -1 if it is malformed
+ */
+static int _parseDuration(const char *text, struct timespec *duration)
+{
+	char *end;
+	double seconds;
+	if(!isdigit((unsigned char)text[0]) && text[0] != '.') {
+		return -1;
+	}
+	seconds = strtod(text, &end);
+	switch(*end) {
+		case 'd':
+			seconds *= 24;
+			/* fall through */
+		case 'h':
+			seconds *= 60;
+			/* fall through */
+		case 'm':
+			seconds *= 60;
+			/* fall through */
+		case 's':
+			end++;
+			break;
+	}
+	if(end == text || *end != '\0' || !isfinite(seconds) || seconds > 1e9) {
+		return -1;
+	}
+	duration->tv_sec = (time_t)seconds;
+	duration->tv_nsec = (long)((seconds - (double)duration->tv_sec) * 1e9);
+	return 0;
+}
+
+/*! \brief Convert the wait status \a status into an exit status */
+static int _exitStatus(int status)
+{
+	if(WIFSIGNALED(status)) {
+		return 128 + WTERMSIG(status);
+	}
+	return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+#if defined(__linux__)
+/*!
+ \brief Arm \a timer to expire once after \a duration, or disarm it if the
+ duration is zero
+ */
+static int _armTimer(int timer, const struct timespec *duration)
+{
+	struct itimerspec value;
+	memset(&value, 0, sizeof(value));
+	value.it_value = *duration;
+	return timerfd_settime(timer, 0, &value, NULL);
+}
+
+int cmd_timeout(int argc, char **argv)
+{
+	struct timespec duration;
+	struct timespec killAfter = {0, 0};
+	int signalNumber = SIGTERM;
+	int isForeground = 0;
+	int isTimedOut = 0;
+	int isKilled = 0;
+	int timer;
+	int status = 0;
+	int result;
+	pid_t pid;
+	int argi;
+	for(argi = 1; argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0'; argi++) {
+		if(strcmp(argv[argi], "--") == 0) {
+			argi++;
+			break;
+		} else if(strcmp(argv[argi], "--foreground") == 0) {
+			isForeground = 1;
+		} else if(strcmp(argv[argi], "-s") == 0 && argi + 1 < argc) {
+			signalNumber = _parseSignal(argv[++argi]);
+			if(signalNumber == -1) {
+				fprintf(stderr, "timeout: %s: invalid signal\n", argv[argi]);
+				return TIMEOUT_STATUS + 1;
+			}
+		} else if(strcmp(argv[argi], "-k") == 0 && argi + 1 < argc) {
+			if(_parseDuration(argv[++argi], &killAfter) != 0) {
+				fprintf(stderr, "timeout: %s: invalid duration\n", argv[argi]);
+				return TIMEOUT_STATUS + 1;
+			}
+		} else {
+			fputs(_usage, stderr);
+			return TIMEOUT_STATUS + 1;
+		}
+	}
+	if(argc - argi < 2) {
+		fputs(_usage, stderr);
+		return TIMEOUT_STATUS + 1;
+	}
+	if(_parseDuration(argv[argi], &duration) != 0) {
+		fprintf(stderr, "timeout: %s: invalid duration\n", argv[argi]);
+		return TIMEOUT_STATUS + 1;
+	}
+	argi++;
+	timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if(timer == -1) {
+		fprintf(stderr, "timeout: %s\n", strerror(errno));
+		return TIMEOUT_STATUS + 1;
+	}
+	/* The clock starts once the command was started */
+	if(isForeground) {
+		pid = executeInChild(argc - argi, argv + argi, NULL);
+	} else {
+		pid = executeInChildGroup(argc - argi, argv + argi, NULL);
+	}
+	if(pid == -1) {
+		fprintf(stderr, "timeout: %s: %s\n", argv[argi], strerror(errno));
+		close(timer);
+		return 126;
+	}
+	_armTimer(timer, &duration);
+	while((result = jobsWaitUntil(pid, timer, &status)) == 1) {
+		if(isTimedOut) {
+			kill(isForeground ? pid : -pid, SIGKILL);
+			isKilled = 1;
+			continue;
+		}
+		isTimedOut = 1;
+		isKilled = signalNumber == SIGKILL;
+		kill(isForeground ? pid : -pid, signalNumber);
+		/* A stopped command would not handle the signal */
+		if(!isForeground && signalNumber != SIGKILL && signalNumber != SIGCONT) {
+			kill(-pid, SIGCONT);
+		}
+		_armTimer(timer, &killAfter);
+	}
+	close(timer);
+	if(result == -1) {
+		fprintf(stderr, "timeout: %s\n", strerror(errno));
+		return TIMEOUT_STATUS + 1;
+	}
+	if(isKilled) {
+		return 128 + SIGKILL;
+	}
+	return isTimedOut ? TIMEOUT_STATUS : _exitStatus(status);
+}
+#else
+int cmd_timeout(int argc, char **argv)
+{
+	/* Without timerfd the deadline needs a program of its own */
+	return builtinExecuteProgram(argv);
+}
+#endif
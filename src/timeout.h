@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TIMEOUT_H
+#define TIMEOUT_H
+
+/*!
+ \addtogroup builtin
+ \{
+ */
+
+/*!
+ \brief Run the builtin "timeout" command
+
+ <tt>timeout [-s signal] [-k duration] [--foreground] duration command
+ [arguments]</tt> runs the command, and sends it the signal (\c TERM by
+ default) once the duration elapses, followed by \c KILL after the
+ duration of \c -k if it is still running. Durations are seconds, which
+ may have a fraction and end in \c s, \c m, \c h or \c d. A duration of
+ \c 0 disables the timeout.
+
+ The command leads a new process group, which is signalled as a whole,
+ unless \c --foreground is given. No process is created besides the
+ command: the deadline is a timerfd waited on along with the child.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return \c 124 if the command timed out, \c 137 if it had to be killed,
+ including by a \c KILL signal given with \c -s, and the exit status of the
+ command otherwise
+ */
+int cmd_timeout(int argc, char **argv);
+
+/*!
+ \}
+ */
+
+#endif /* TIMEOUT_H */
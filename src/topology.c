@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include "topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <dirent.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+/*! \brief Highest CPU number taken into account */
+#define TOPOLOGY_MAX_CPUS 1024
+
+/*! \brief Placement of a single CPU */
+typedef struct __topology_cpu_t {
+	int cpu;
+	int node;
+	/*! \brief lowest CPU sharing the last level cache */
+	int lastLevelCache;
+	/*! \brief lowest CPU sharing the level 2 cache */
+	int levelTwoCache;
+} topology_cpu_t;
+
+/*! \brief CPUs sharing a last level cache, adjacent in \c _cpus */
+typedef struct __topology_group_t {
+	size_t start;
+	size_t count;
+	int node;
+	/*! \brief index of the group among those of its node */
+	size_t rank;
+} topology_group_t;
+
+static topology_cpu_t *_cpus = NULL;
+static size_t _cpuCount = 0;
+static topology_group_t *_groups = NULL;
+static size_t _groupCount = 0;
+static int _isLoaded = 0;
+/*! \brief group of the next pipeline */
+static size_t _nextGroup = 0;
+
+/*!
+ \brief Read the list of CPUs in the file at \a path, such as \c "0-3,8",
+ into \a set, indexed by CPU number
+ \return \c 0 on success, \c -1 if the file could not be read
+ */
+static int _readList(const char *path, unsigned char *set)
+{
+	char buffer[4096];
+	char *ptr = buffer;
+	long first;
+	long last;
+	FILE *file = fopen(path, "r");
+	if(file == NULL) {
+		return -1;
+	}
+	if(fgets(buffer, sizeof(buffer), file) == NULL) {
+		buffer[0] = '\0';
+	}
+	fclose(file);
+	memset(set, 0, TOPOLOGY_MAX_CPUS);
+	while(isdigit((unsigned char)*ptr)) {
+		first = strtol(ptr, &ptr, 10);
+		last = first;
+		if(*ptr == '-') {
+			last = strtol(ptr + 1, &ptr, 10);
+		}
+		for(; first <= last && first < TOPOLOGY_MAX_CPUS; first++) {
+			set[first] = 1;
+		}
+		if(*ptr == ',') {
+			ptr++;
+		}
+	}
+	return 0;
+}
+
+/*!
+ \brief Read the number in the file at \a path
+ \return the number, or \c -1 if the file could not be read
+ */
+static int _readNumber(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	int number = -1;
+	if(file == NULL) {
+		return -1;
+	}
+	if(fscanf(file, "%d", &number) != 1) {
+		number = -1;
+	}
+	fclose(file);
+	return number;
+}
+
+/*! \return the lowest CPU of \a set, or \a cpu if the set is empty */
+static int _firstOf(const unsigned char *set, int cpu)
+{
+	int index;
+	for(index = 0; index < TOPOLOGY_MAX_CPUS && !set[index]; index++) {
+	}
+	return index < TOPOLOGY_MAX_CPUS ? index : cpu;
+}
+
+/*!
+ \brief Find the lowest CPU sharing the data cache of \a level with \a cpu,
+ or the last level cache if \a level is \c 0
+ */
+static int _cacheSharedWith(const char *root, int cpu, int level)
+{
+	unsigned char set[TOPOLOGY_MAX_CPUS];
+	char path[512];
+	char type[32];
+	FILE *file;
+	int index;
+	int cacheLevel;
+	int bestLevel = 0;
+	int shared = cpu;
+	for(index = 0; ; index++) {
+		snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%d/cache/index%d/level",
+			root, cpu, index);
+		cacheLevel = _readNumber(path);
+		if(cacheLevel == -1) {
+			break;
+		}
+		snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%d/cache/index%d/type",
+			root, cpu, index);
+		type[0] = '\0';
+		if((file = fopen(path, "r")) != NULL) {
+			if(fscanf(file, "%31s", type) != 1) {
+				type[0] = '\0';
+			}
+			fclose(file);
+		}
+		/* Pipe buffers are data, which instruction caches do not hold */
+		if(strcmp(type, "Instruction") == 0 || (level != 0 && cacheLevel != level)
+		|| cacheLevel <= bestLevel) {
+			continue;
+		}
+		snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list",
+			root, cpu, index);
+		if(_readList(path, set) == 0) {
+			bestLevel = cacheLevel;
+			shared = _firstOf(set, cpu);
+		}
+	}
+	return shared;
+}
+
+/*! \brief Order CPUs by node, then last level cache, then level 2 cache */
+static int _compareCpus(const void *a, const void *b)
+{
+	const topology_cpu_t *first = a;
+	const topology_cpu_t *second = b;
+	if(first->node != second->node) {
+		return first->node - second->node;
+	}
+	if(first->lastLevelCache != second->lastLevelCache) {
+		return first->lastLevelCache - second->lastLevelCache;
+	}
+	if(first->levelTwoCache != second->levelTwoCache) {
+		return first->levelTwoCache - second->levelTwoCache;
+	}
+	return first->cpu - second->cpu;
+}
+
+/*! \brief Order groups so that consecutive ones are on different nodes */
+static int _compareGroups(const void *a, const void *b)
+{
+	const topology_group_t *first = a;
+	const topology_group_t *second = b;
+	if(first->rank != second->rank) {
+		return first->rank < second->rank ? -1 : 1;
+	}
+	return first->node - second->node;
+}
+
+/*!
+ \brief Find the NUMA node of each CPU from the \c nodeN directories
+ \param nodes receives the node of each CPU, \c 0 if unknown
+ */
+static void _readNodes(const char *root, int *nodes)
+{
+	unsigned char set[TOPOLOGY_MAX_CPUS];
+	char path[512];
+	struct dirent *entry;
+	DIR *directory;
+	int node;
+	int cpu;
+	memset(nodes, 0, TOPOLOGY_MAX_CPUS * sizeof(*nodes));
+	snprintf(path, sizeof(path), "%s/devices/system/node", root);
+	directory = opendir(path);
+	if(directory == NULL) {
+		return;
+	}
+	while((entry = readdir(directory)) != NULL) {
+		if(strncmp(entry->d_name, "node", 4) != 0 || !isdigit((unsigned char)entry->d_name[4])) {
+			continue;
+		}
+		node = atoi(entry->d_name + 4);
+		snprintf(path, sizeof(path), "%s/devices/system/node/%s/cpulist", root, entry->d_name);
+		if(_readList(path, set) != 0) {
+			continue;
+		}
+		for(cpu = 0; cpu < TOPOLOGY_MAX_CPUS; cpu++) {
+			if(set[cpu]) {
+				nodes[cpu] = node;
+			}
+		}
+	}
+	closedir(directory);
+}
+
+int topologyLoad(const char *root)
+{
+	unsigned char online[TOPOLOGY_MAX_CPUS];
+	char path[512];
+	topology_cpu_t *cpus;
+	topology_group_t *groups;
+	int *nodes;
+	size_t count = 0;
+	size_t groupCount = 0;
+	size_t index;
+	int cpu;
+#if defined(__linux__)
+	cpu_set_t allowed;
+	int isRestricted = root == NULL && sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+#endif
+	if(root == NULL) {
+		root = "/sys";
+	}
+	_isLoaded = 1;
+	snprintf(path, sizeof(path), "%s/devices/system/cpu/online", root);
+	if(_readList(path, online) != 0) {
+		return -1;
+	}
+	cpus = malloc(TOPOLOGY_MAX_CPUS * sizeof(*cpus));
+	nodes = malloc(TOPOLOGY_MAX_CPUS * sizeof(*nodes));
+	if(cpus == NULL || nodes == NULL) {
+		free(cpus);
+		free(nodes);
+		return -1;
+	}
+	_readNodes(root, nodes);
+	for(cpu = 0; cpu < TOPOLOGY_MAX_CPUS; cpu++) {
+#if defined(__linux__)
+		if(isRestricted && (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed))) {
+			continue;
+		}
+#endif
+		if(!online[cpu]) {
+			continue;
+		}
+		cpus[count].cpu = cpu;
+		cpus[count].node = nodes[cpu];
+		cpus[count].lastLevelCache = _cacheSharedWith(root, cpu, 0);
+		cpus[count].levelTwoCache = _cacheSharedWith(root, cpu, 2);
+		count++;
+	}
+	free(nodes);
+	if(count == 0) {
+		free(cpus);
+		return -1;
+	}
+	qsort(cpus, count, sizeof(*cpus), _compareCpus);
+	groups = malloc(count * sizeof(*groups));
+	if(groups == NULL) {
+		free(cpus);
+		return -1;
+	}
+	for(index = 0; index < count; index++) {
+		if(index > 0 && cpus[index].node == cpus[index - 1].node
+		&& cpus[index].lastLevelCache == cpus[index - 1].lastLevelCache) {
+			groups[groupCount - 1].count++;
+			continue;
+		}
+		groups[groupCount].start = index;
+		groups[groupCount].count = 1;
+		groups[groupCount].node = cpus[index].node;
+		groups[groupCount].rank = groupCount > 0 && groups[groupCount - 1].node == cpus[index].node
+			? groups[groupCount - 1].rank + 1 : 0;
+		groupCount++;
+	}
+	qsort(groups, groupCount, sizeof(*groups), _compareGroups);
+	free(_cpus);
+	free(_groups);
+	_cpus = cpus;
+	_cpuCount = count;
+	_groups = groups;
+	_groupCount = groupCount;
+	_nextGroup = 0;
+	return 0;
+}
+
+int topologyPlacePipeline(void)
+{
+	if(!_isLoaded) {
+		topologyLoad(NULL);
+	}
+	if(_groupCount == 0) {
+		return -1;
+	}
+	return (int)(_nextGroup++ % _groupCount);
+}
+
+int topologyCpuForStage(int group, size_t stage)
+{
+	return _cpus[_groups[group].start + stage % _groups[group].count].cpu;
+}
+
+int topologyPin(int cpu)
+{
+#if defined(__linux__)
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+	return sched_setaffinity(0, sizeof(cpus), &cpus);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
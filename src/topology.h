@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stddef.h>
+
+/*!
+ \addtogroup topology
+ \{
+ */
+
+/*!
+ \brief Read the CPU topology from the sysfs tree at \a root
+
+ Each online CPU is grouped with those sharing its last level cache, and
+ ordered so that CPUs sharing a level 2 cache are adjacent. The groups are
+ ordered so that consecutive groups are on different NUMA nodes. Any
+ previously read topology is replaced.
+
+ \param root mount point of sysfs, or \c NULL for \c /sys, in which case only
+ the CPUs the shell may run on are used
+ \return \c 0 on success, \c -1 if no CPU could be found
+ */
+int topologyLoad(const char *root);
+
+/*!
+ \brief Choose the cache group the stages of the next pipeline are placed on
+
+ Consecutive pipelines are given consecutive groups, so independent
+ pipelines are spread across caches and NUMA nodes. The topology of \c /sys
+ is read on first use.
+
+ \return the group, to be passed to topologyCpuForStage(), or \c -1 if the
+ topology is unknown
+ */
+int topologyPlacePipeline(void);
+
+/*!
+ \brief Choose the CPU of stage \a stage of a pipeline placed on \a group
+
+ Adjacent stages are given adjacent CPUs of the group, which share the
+ cache holding the buffer of the pipe between them. A pipeline with more
+ stages than the group has CPUs wraps around within the group.
+
+ \param group a group returned by topologyPlacePipeline()
+ \param stage index of the command within the pipeline
+ \return the CPU number
+ */
+int topologyCpuForStage(int group, size_t stage);
+
+/*!
+ \brief Restrict the calling process to \a cpu
+ \return \c 0 on success, \c -1 on error with \c errno set
+ */
+int topologyPin(int cpu);
+
+/*!
+ \}
+ */
+
+#endif /* TOPOLOGY_H */
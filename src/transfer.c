@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "transfer.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <errno.h>
+
+/*! \brief Size of the buffer used when data has to pass through the process */
+#define TRANSFER_BUFFER_SIZE (128 * 1024)
+/*! \brief Most bytes requested from the kernel at once */
+#define TRANSFER_CHUNK_SIZE (1 << 30)
+
+/*! \brief Result of a transfer method */
+enum {
+	/*! \brief The method cannot be used, nothing was transferred */
+	kTransferUnsupported = 0,
+	/*! \brief Everything was transferred */
+	kTransferDone = 1,
+	/*! \brief The transfer failed, with \c errno set */
+	kTransferFailed = -1
+};
+
+static int _isKind(int descriptor, mode_t kind)
+{
+	struct stat status;
+	return fstat(descriptor, &status) == 0 && (status.st_mode & S_IFMT) == kind;
+}
+
+static int _writeAll(int descriptor, const char *data, size_t length)
+{
+	ssize_t count;
+	while(length > 0) {
+		count = write(descriptor, data, length);
+		if(count == -1 && errno == EINTR) {
+			continue;
+		}
+		if(count == -1) {
+			return -1;
+		}
+		data += count;
+		length -= count;
+	}
+	return 0;
+}
+
+/*!
+ \brief Copy from \a input to each output which can still be written to
+ \return \c kTransferDone or \c kTransferFailed
+ */
+static int _copyThroughBuffer(int input, int *outputs, size_t count)
+{
+	char *buffer;
+	ssize_t length;
+	size_t index;
+	size_t openCount = count;
+	int error = 0;
+	buffer = malloc(TRANSFER_BUFFER_SIZE);
+	if(buffer == NULL) {
+		return kTransferFailed;
+	}
+	while(openCount > 0) {
+		length = read(input, buffer, TRANSFER_BUFFER_SIZE);
+		if(length == -1 && errno == EINTR) {
+			continue;
+		}
+		if(length <= 0) {
+			error = length == -1 ? errno : error;
+			break;
+		}
+		for(index = 0; index < count; index++) {
+			if(outputs[index] != -1 && _writeAll(outputs[index], buffer, length) != 0) {
+				error = errno;
+				outputs[index] = -1;
+				openCount--;
+			}
+		}
+	}
+	free(buffer);
+	if(error != 0) {
+		errno = error;
+		return kTransferFailed;
+	}
+	return kTransferDone;
+}
+
+#if defined(__linux__)
+static int _copyFileRange(int input, int output)
+{
+	ssize_t count;
+	int isFirst = 1;
+	for(;;) {
+		count = copy_file_range(input, NULL, output, NULL, TRANSFER_CHUNK_SIZE, 0);
+		if(count == -1 && errno == EINTR) {
+			continue;
+		}
+		if(count == -1) {
+			/* E.g. across file systems on older kernels, or appending */
+			if(errno == EXDEV || errno == EINVAL || errno == ENOSYS
+				|| errno == EOPNOTSUPP || errno == EBADF) {
+				return kTransferUnsupported;
+			}
+			return kTransferFailed;
+		}
+		if(count == 0) {
+			/* Files such as those in /proc claim to be empty, so the copy is
+			   repeated the slow way, which finds nothing if they are */
+			return isFirst ? kTransferUnsupported : kTransferDone;
+		}
+		isFirst = 0;
+	}
+}
+
+static int _splice(int input, int output)
+{
+	ssize_t count;
+	for(;;) {
+		count = splice(input, NULL, output, NULL, TRANSFER_CHUNK_SIZE, SPLICE_F_MOVE | SPLICE_F_MORE);
+		if(count == -1 && errno == EINTR) {
+			continue;
+		}
+		if(count == -1) {
+			return errno == EINVAL || errno == ENOSYS ? kTransferUnsupported : kTransferFailed;
+		}
+		if(count == 0) {
+			return kTransferDone;
+		}
+	}
+}
+
+/*!
+ \brief Move exactly \a length bytes from the pipe \a input to \a *output
+
+ Falls back to copying through \a buffer if \a *output does not support
+ splice(). If \a *output cannot be written to, it is set to \c -1 and the
+ bytes are discarded, so \a input stays in step with the other outputs.
+
+ \return \c 0 on success, \c -1 on error with \c errno set
+ */
+static int _moveExactly(int input, int *output, size_t length, char *buffer)
+{
+	ssize_t count;
+	int isBuffered = 0;
+	int error = 0;
+	while(length > 0) {
+		if(*output != -1 && !isBuffered) {
+			count = splice(input, NULL, *output, NULL, length, SPLICE_F_MOVE | SPLICE_F_MORE);
+			if(count > 0) {
+				length -= count;
+			} else if(count == 0 || (count == -1 && errno == EINVAL)) {
+				isBuffered = 1;
+			} else if(count == -1 && errno != EINTR) {
+				error = errno;
+				*output = -1;
+			}
+			continue;
+		}
+		count = read(input, buffer, length < TRANSFER_BUFFER_SIZE ? length : TRANSFER_BUFFER_SIZE);
+		if(count == -1 && errno == EINTR) {
+			continue;
+		}
+		if(count <= 0) {
+			errno = count == 0 ? EIO : errno;
+			return -1;
+		}
+		length -= count;
+		if(*output != -1 && _writeAll(*output, buffer, count) != 0) {
+			error = errno;
+			*output = -1;
+		}
+	}
+	if(error != 0) {
+		errno = error;
+		return -1;
+	}
+	return 0;
+}
+
+/*!
+ \brief Duplicate the pipe \a input onto each output with tee()
+
+ For each chunk, the first piped output (the leader) receives whatever tee()
+ duplicates into it, which determines the size of the chunk. The other
+ outputs receive the chunk through a private pipe, and the last one consumes
+ it from \a input.
+ */
+static int _teeToMany(int input, int *outputs, size_t count)
+{
+	int privatePipe[2];
+	char *buffer;
+	size_t leader;
+	size_t consumer;
+	size_t index;
+	ssize_t length;
+	ssize_t duplicated;
+	int isLeaderPiped;
+	int capacity;
+	int error = 0;
+	for(leader = 0; leader < count && !_isKind(outputs[leader], S_IFIFO); leader++) {
+	}
+	isLeaderPiped = leader < count;
+	if(!isLeaderPiped) {
+		leader = 0;
+	}
+	consumer = leader == count - 1 ? count - 2 : count - 1;
+	if(pipe2(privatePipe, O_CLOEXEC) != 0) {
+		return kTransferUnsupported;
+	}
+	/* An empty private pipe must be able to hold all of the input */
+	capacity = fcntl(input, F_GETPIPE_SZ);
+	if(capacity == -1 || fcntl(privatePipe[1], F_SETPIPE_SZ, capacity) < capacity) {
+		close(privatePipe[0]);
+		close(privatePipe[1]);
+		return kTransferUnsupported;
+	}
+	buffer = malloc(TRANSFER_BUFFER_SIZE);
+	if(buffer == NULL) {
+		close(privatePipe[0]);
+		close(privatePipe[1]);
+		return kTransferFailed;
+	}
+	for(;;) {
+		if(isLeaderPiped && outputs[leader] != -1) {
+			length = tee(input, outputs[leader], TRANSFER_CHUNK_SIZE, 0);
+			/* The others go on without the leader once its reader is gone */
+			if(length == -1 && errno == EPIPE) {
+				error = errno;
+				outputs[leader] = -1;
+				continue;
+			}
+		} else {
+			length = tee(input, privatePipe[1], TRANSFER_CHUNK_SIZE, 0);
+			if(length > 0 && _moveExactly(privatePipe[0], &outputs[leader], length, buffer) != 0) {
+				error = errno;
+			}
+		}
+		if(length == -1 && errno == EINTR) {
+			continue;
+		}
+		if(length <= 0) {
+			error = length == -1 ? errno : error;
+			break;
+		}
+		for(index = 0; index < count; index++) {
+			if(index == leader || index == consumer || outputs[index] == -1) {
+				continue;
+			}
+			do {
+				duplicated = tee(input, privatePipe[1], length, 0);
+			} while(duplicated == -1 && errno == EINTR);
+			if(duplicated != length) {
+				/* Cannot happen with a private pipe as large as the input */
+				error = duplicated == -1 ? errno : EIO;
+				outputs[index] = -1;
+				continue;
+			}
+			if(_moveExactly(privatePipe[0], &outputs[index], length, buffer) != 0) {
+				error = errno;
+			}
+		}
+		if(_moveExactly(input, &outputs[consumer], length, buffer) != 0) {
+			error = errno;
+			if(outputs[consumer] != -1) {
+				break;
+			}
+		}
+		for(index = 0; index < count && outputs[index] == -1; index++) {
+		}
+		if(index == count) {
+			break;
+		}
+	}
+	free(buffer);
+	close(privatePipe[0]);
+	close(privatePipe[1]);
+	if(error != 0) {
+		errno = error;
+		return kTransferFailed;
+	}
+	return kTransferDone;
+}
+#endif
+
+int transferDescriptor(int input, int output)
+{
+	int status = kTransferUnsupported;
+#if defined(__linux__)
+	if(_isKind(input, S_IFREG) && _isKind(output, S_IFREG)) {
+		status = _copyFileRange(input, output);
+	} else if(_isKind(input, S_IFIFO) || _isKind(output, S_IFIFO)) {
+		status = _splice(input, output);
+	}
+#endif
+	if(status == kTransferUnsupported) {
+		status = _copyThroughBuffer(input, &output, 1);
+	}
+	return status == kTransferDone ? 0 : -1;
+}
+
+int transferDescriptorToMany(int input, int *outputs, size_t count)
+{
+	int status = kTransferUnsupported;
+	if(count == 1) {
+		if(transferDescriptor(input, outputs[0]) != 0) {
+			outputs[0] = -1;
+			return -1;
+		}
+		return 0;
+	}
+#if defined(__linux__)
+	if(count > 1 && _isKind(input, S_IFIFO)) {
+		status = _teeToMany(input, outputs, count);
+	}
+#endif
+	if(status == kTransferUnsupported) {
+		status = _copyThroughBuffer(input, outputs, count);
+	}
+	return status == kTransferDone ? 0 : -1;
+}
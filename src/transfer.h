@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include <stddef.h>
+
+/*!
+ \addtogroup transfer
+ \{
+ */
+
+/*!
+ \brief Copy everything readable from \a input to \a output
+
+ Data is moved within the kernel where possible: with copy_file_range()
+ between regular files and with splice() if either side is a pipe. Otherwise,
+ or if the kernel refuses, the data is copied through a buffer.
+
+ \param input descriptor to read from until the end of file
+ \param output descriptor to write to
+ \return \c 0 on success, \c -1 on error with \c errno set
+ */
+int transferDescriptor(int input, int output);
+
+/*!
+ \brief Copy everything readable from \a input to each of \a outputs
+
+ If \a input is a pipe, the data is duplicated with tee() and moved with
+ splice(), without being copied into the process.
+
+ \param input descriptor to read from until the end of file
+ \param outputs descriptors to write to
+ \param count amount of elements in \a outputs
+ \return \c 0 on success, \c -1 on error with \c errno set. Outputs which
+ cannot be written to are set to \c -1 and skipped from then on
+ */
+int transferDescriptorToMany(int input, int *outputs, size_t count);
+
+/*!
+ \}
+ */
+
+#endif /* TRANSFER_H */
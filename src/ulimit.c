@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ulimit.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+/*! \brief A resource which can be limited */
+typedef struct __ulimit_resource_t {
+	/*! \brief option of the builtin */
+	char option;
+	/*! \brief name of the attribute preceding a command */
+	const char *attribute;
+	int resource;
+	/*! \brief size of the unit of the builtin, in bytes for sizes */
+	rlim_t unit;
+	/*! \brief whether attributes of the resource may be given with a suffix */
+	int isSize;
+	const char *description;
+} ulimit_resource_t;
+
+static const ulimit_resource_t _resources[] = {
+	{'c', "core", RLIMIT_CORE, 1024, 1, "core file size (kbytes)"},
+	{'d', "data", RLIMIT_DATA, 1024, 1, "data segment size (kbytes)"},
+	{'f', "filesize", RLIMIT_FSIZE, 1024, 1, "file size (kbytes)"},
+	{'n', "files", RLIMIT_NOFILE, 1, 0, "open files"},
+	{'s', "stack", RLIMIT_STACK, 1024, 1, "stack size (kbytes)"},
+	{'t', "time", RLIMIT_CPU, 1, 0, "cpu time (seconds)"},
+	{'u', "processes", RLIMIT_NPROC, 1, 0, "max user processes"},
+	{'v', "memory", RLIMIT_AS, 1024, 1, "virtual memory (kbytes)"},
+	{'\0', NULL, 0, 0, 0, NULL}
+};
+
+static const ulimit_resource_t *_resourceForOption(char option)
+{
+	const ulimit_resource_t *resource;
+	for(resource = _resources; resource->attribute != NULL; resource++) {
+		if(resource->option == option) {
+			return resource;
+		}
+	}
+	return NULL;
+}
+
+/*!
+ \brief Parse the limit \a value, a number of \a unit or \c "unlimited"
+ \param isSized whether the number may end in \c K, \c M or \c G
+ \return \c 0 on success, \c -1 if the value is malformed or too large
+ */
+static int _parseLimit(const char *value, rlim_t unit, int isSized, rlim_t *limit)
+{
+	unsigned long long number;
+	char *end;
+	if(strcmp(value, "unlimited") == 0) {
+		*limit = RLIM_INFINITY;
+		return 0;
+	}
+	if(!isdigit((unsigned char)value[0])) {
+		return -1;
+	}
+	errno = 0;
+	number = strtoull(value, &end, 10);
+	if(errno != 0) {
+		return -1;
+	}
+	if(isSized && *end != '\0' && end[1] == '\0') {
+		switch(toupper((unsigned char)*end)) {
+			case 'G':
+				unit *= 1024;
+				/* fall through */
+			case 'M':
+				unit *= 1024;
+				/* fall through */
+			case 'K':
+				unit *= 1024;
+				end++;
+				break;
+		}
+	}
+	if(*end != '\0' || number > (unsigned long long)(RLIM_INFINITY - 1) / unit) {
+		return -1;
+	}
+	*limit = (rlim_t)number * unit;
+	return 0;
+}
+
+static void _printLimit(rlim_t limit, rlim_t unit)
+{
+	if(limit == RLIM_INFINITY) {
+		printf("unlimited\n");
+	} else {
+		printf("%llu\n", (unsigned long long)(limit / unit));
+	}
+}
+
+int ulimitApply(const char *attribute)
+{
+	const ulimit_resource_t *resource;
+	const char *value = strchr(attribute, '=');
+	struct rlimit limits;
+	rlim_t limit;
+	if(value == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	for(resource = _resources; resource->attribute != NULL; resource++) {
+		if(strlen(resource->attribute) == (size_t)(value - attribute)
+		&& strncmp(resource->attribute, attribute, value - attribute) == 0) {
+			break;
+		}
+	}
+	if(resource->attribute == NULL || _parseLimit(value + 1, 1, resource->isSize, &limit) != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	limits.rlim_cur = limit;
+	limits.rlim_max = limit;
+	return setrlimit(resource->resource, &limits);
+}
+
+int cmd_ulimit(int argc, char **argv)
+{
+	const ulimit_resource_t *resource = _resourceForOption('f');
+	struct rlimit limits;
+	rlim_t limit;
+	int isHard = 0;
+	int isSoft = 0;
+	int isAll = 0;
+	char *option;
+	int argi;
+	for(argi = 1; argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0'; argi++) {
+		for(option = argv[argi] + 1; *option != '\0'; option++) {
+			if(*option == 'H') {
+				isHard = 1;
+			} else if(*option == 'S') {
+				isSoft = 1;
+			} else if(*option == 'a') {
+				isAll = 1;
+			} else if((resource = _resourceForOption(*option)) == NULL) {
+				fprintf(stderr, "usage: ulimit [-HS] [-a | -cdfnstuv [limit]]\n");
+				return 2;
+			}
+		}
+	}
+	if(argc - argi > 1 || (isAll && argi < argc)) {
+		fprintf(stderr, "usage: ulimit [-HS] [-a | -cdfnstuv [limit]]\n");
+		return 2;
+	}
+	if(isAll) {
+		for(resource = _resources; resource->attribute != NULL; resource++) {
+			if(getrlimit(resource->resource, &limits) != 0) {
+				continue;
+			}
+			printf("%-28s(-%c) ", resource->description, resource->option);
+			_printLimit(isHard ? limits.rlim_max : limits.rlim_cur, resource->unit);
+		}
+		return 0;
+	}
+	if(getrlimit(resource->resource, &limits) != 0) {
+		fprintf(stderr, "ulimit: %s\n", strerror(errno));
+		return 1;
+	}
+	if(argi == argc) {
+		_printLimit(isHard ? limits.rlim_max : limits.rlim_cur, resource->unit);
+		return 0;
+	}
+	if(_parseLimit(argv[argi], resource->unit, 0, &limit) != 0) {
+		fprintf(stderr, "ulimit: %s: invalid limit\n", argv[argi]);
+		return 2;
+	}
+	/* Without either option, both limits are set */
+	if(isHard || !isSoft) {
+		limits.rlim_max = limit;
+	}
+	if(isSoft || !isHard) {
+		limits.rlim_cur = limit;
+	}
+	if(setrlimit(resource->resource, &limits) != 0) {
+		fprintf(stderr, "ulimit: %s: %s\n", argv[argi], strerror(errno));
+		return 1;
+	}
+	return 0;
+}
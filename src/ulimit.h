@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ULIMIT_H
+#define ULIMIT_H
+
+/*!
+ \addtogroup builtin
+ \{
+ */
+
+/*!
+ \brief Run the builtin "ulimit" command
+
+ Prints or sets the soft (\c -S) or hard (\c -H) limit of a resource,
+ both if neither is given, for the shell and the commands it runs:
+ - \c -t CPU time, in seconds
+ - \c -v address space, in kilobytes
+ - \c -d data segment, in kilobytes
+ - \c -s stack, in kilobytes
+ - \c -c core file size, in kilobytes
+ - \c -f file size, in kilobytes (the default)
+ - \c -n open files
+ - \c -u processes
+ \c -a prints every limit.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return exit status of the command
+ */
+int cmd_ulimit(int argc, char **argv);
+
+/*!
+ \brief Apply the resource limit attribute \a attribute to the calling
+ process, from which its children inherit it
+
+ The attribute is written as \c name=value without the leading \c @, where
+ the name is one of \c time (seconds), \c memory (address space, bytes),
+ \c data, \c stack, \c core, \c filesize (bytes), \c files or
+ \c processes. Sizes may end in \c K, \c M or \c G, and \c unlimited lifts
+ the limit. Both the soft and the hard limit are set, so the command cannot
+ raise it again.
+
+ \return \c 0 on success, \c -1 on error with \c errno set. \c EINVAL is
+ set for an unknown name or a malformed value
+ */
+int ulimitApply(const char *attribute);
+
+/*!
+ \}
+ */
+
+#endif /* ULIMIT_H */
@@ -0,0 +1,772 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "variables.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <errno.h>
+#include "arithmetic.h"
+#include "expansion.h"
+#include "hash.h"
+
+/*! \brief Amount of buckets of the variable table, a power of two */
+#define VARIABLES_BUCKET_COUNT 256
+
+/*! \brief Variables, chained by the hash of their name */
+static variable_t *_buckets[VARIABLES_BUCKET_COUNT];
+/*! \brief Positional parameters, starting with \c $0 */
+static char **_positional = NULL;
+/*! \brief Amount of elements in \a _positional */
+static int _positionalCount = 0;
+
+/*!
+ \brief Bucket of \a name
+ */
+static unsigned int _hash(const char *name)
+{
+	return hashString(name) & (VARIABLES_BUCKET_COUNT - 1);
+}
+
+variable_t *variableLookup(const char *name, int isCreated)
+{
+	unsigned int bucket = _hash(name);
+	variable_t *variable;
+	const char *environmentValue;
+	for(variable = _buckets[bucket]; variable != NULL; variable = variable->next) {
+		if(strcmp(variable->name, name) == 0) {
+			return variable;
+		}
+	}
+	environmentValue = getenv(name);
+	if(environmentValue == NULL && !isCreated) {
+		return NULL;
+	}
+	variable = malloc(sizeof(*variable));
+	if(variable == NULL) {
+		return NULL;
+	}
+	variable->name = strdup(name);
+	variable->value = environmentValue != NULL ? strdup(environmentValue) : NULL;
+	variable->valueSize = environmentValue != NULL ? strlen(environmentValue) + 1 : 0;
+	variable->isNumber = 0;
+	variable->number = 0;
+	variable->isExported = environmentValue != NULL;
+	variable->array = NULL;
+	variable->next = _buckets[bucket];
+	_buckets[bucket] = variable;
+	return variable;
+}
+
+/*!
+ \brief Return the value of \a variable, element \c 0 of an array
+ */
+static const char *_scalar(const variable_t *variable)
+{
+	if(variable->array == NULL) {
+		return variable->value;
+	}
+	return variable->array->isAssociative ? arrayGetKey(variable->array, "0")
+		: arrayGetIndex(variable->array, 0);
+}
+
+static int _setScalar(variable_t *variable, const char *value)
+{
+	return variable->array->isAssociative ? arraySetKey(variable->array, "0", value)
+		: arraySetIndex(variable->array, 0, value);
+}
+
+const char *variableGet(const char *name)
+{
+	variable_t *variable = variableLookup(name, 0);
+	return variable != NULL ? _scalar(variable) : NULL;
+}
+
+int variableSet(const char *name, const char *value)
+{
+	variable_t *variable = variableLookup(name, 1);
+	char *copy;
+	if(variable == NULL) {
+		return -1;
+	}
+	if(variable->array != NULL) {
+		return _setScalar(variable, value);
+	}
+	copy = strdup(value);
+	if(copy == NULL) {
+		return -1;
+	}
+	free(variable->value);
+	variable->value = copy;
+	variable->valueSize = strlen(copy) + 1;
+	variable->isNumber = 0;
+	if(variable->isExported) {
+		setenv(name, value, 1);
+	}
+	return 0;
+}
+
+void variableUnset(const char *name)
+{
+	variable_t *variable = variableLookup(name, 0);
+	if(variable == NULL) {
+		return;
+	}
+	free(variable->value);
+	variable->value = NULL;
+	variable->valueSize = 0;
+	variable->isNumber = 0;
+	arrayFree(variable->array);
+	variable->array = NULL;
+	if(variable->isExported) {
+		unsetenv(name);
+	}
+}
+
+array_t *variableArray(variable_t *variable, int isAssociative)
+{
+	array_t *array;
+	if(variable->array != NULL) {
+		return variable->array;
+	}
+	array = arrayNew(isAssociative);
+	if(array == NULL) {
+		return NULL;
+	}
+	variable->array = array;
+	if(variable->value != NULL && _setScalar(variable, variable->value) != 0) {
+		variable->array = NULL;
+		arrayFree(array);
+		return NULL;
+	}
+	free(variable->value);
+	variable->value = NULL;
+	variable->valueSize = 0;
+	variable->isNumber = 0;
+	return array;
+}
+
+int variableSetArray(const char *name, array_t *array)
+{
+	variable_t *variable = variableLookup(name, 1);
+	if(variable == NULL) {
+		arrayFree(array);
+		return -1;
+	}
+	free(variable->value);
+	variable->value = NULL;
+	variable->valueSize = 0;
+	variable->isNumber = 0;
+	arrayFree(variable->array);
+	variable->array = array;
+	return 0;
+}
+
+/*!
+ \brief Evaluate the subscript of an indexed element of \a variable
+ \return \c 0 on success, \c -1 if it is not a valid index
+ */
+static int _index(const variable_t *variable, const char *subscript, size_t *index)
+{
+	long long value;
+	if(arithmeticEvaluate(subscript, strlen(subscript), &value) != 0) {
+		return -1;
+	}
+	/* Negative indices count from the end */
+	if(value < 0) {
+		value += variable->array != NULL ? (long long)variable->array->length
+			: variable->value != NULL;
+	}
+	if(value < 0) {
+		fprintf(stderr, "mush: %s[%s]: bad array subscript\n", variable->name, subscript);
+		return -1;
+	}
+	*index = (size_t)value;
+	return 0;
+}
+
+const char *variableElement(const char *name, const char *subscript)
+{
+	variable_t *variable = variableLookup(name, 0);
+	size_t index;
+	if(variable == NULL) {
+		return NULL;
+	}
+	if(variable->array != NULL && variable->array->isAssociative) {
+		return arrayGetKey(variable->array, subscript);
+	}
+	if(_index(variable, subscript, &index) != 0) {
+		return NULL;
+	}
+	if(variable->array == NULL) {
+		return index == 0 ? variable->value : NULL;
+	}
+	return arrayGetIndex(variable->array, index);
+}
+
+int variableSetElement(const char *name, const char *subscript, const char *value)
+{
+	variable_t *variable = variableLookup(name, 1);
+	array_t *array = variable != NULL ? variableArray(variable, 0) : NULL;
+	size_t index;
+	if(array == NULL) {
+		return -1;
+	}
+	if(array->isAssociative) {
+		return arraySetKey(array, subscript, value);
+	}
+	if(_index(variable, subscript, &index) != 0) {
+		return -1;
+	}
+	if(index >= ARRAY_INDEX_LIMIT) {
+		fprintf(stderr, "mush: %s[%s]: array index out of range\n", name, subscript);
+		return -1;
+	}
+	if(arraySetIndex(array, index, value) != 0) {
+		fprintf(stderr, "mush: %s[%s]: %s\n", name, subscript, strerror(ENOMEM));
+		return -1;
+	}
+	return 0;
+}
+
+int variableUnsetElement(const char *name, const char *subscript)
+{
+	variable_t *variable = variableLookup(name, 0);
+	size_t index;
+	if(variable == NULL) {
+		return 0;
+	}
+	if(variable->array != NULL && variable->array->isAssociative) {
+		arrayRemoveKey(variable->array, subscript);
+		return 0;
+	}
+	if(_index(variable, subscript, &index) != 0) {
+		return -1;
+	}
+	if(variable->array != NULL) {
+		arrayRemoveIndex(variable->array, index);
+	} else if(index == 0) {
+		variableUnset(name);
+	}
+	return 0;
+}
+
+size_t variableElementCount(const char *name)
+{
+	variable_t *variable = variableLookup(name, 0);
+	if(variable == NULL) {
+		return 0;
+	}
+	return variable->array != NULL ? variable->array->count : variable->value != NULL;
+}
+
+int variableSetNumber(variable_t *variable, long long number)
+{
+	char *grown;
+	char formatted[24];
+	/* Large enough for any 64 bit integer */
+	const size_t size = 24;
+	if(variable->array != NULL) {
+		snprintf(formatted, sizeof(formatted), "%lld", number);
+		return _setScalar(variable, formatted);
+	}
+	if(variable->valueSize < size) {
+		grown = realloc(variable->value, size);
+		if(grown == NULL) {
+			return -1;
+		}
+		variable->value = grown;
+		variable->valueSize = size;
+	}
+	snprintf(variable->value, variable->valueSize, "%lld", number);
+	variable->number = number;
+	variable->isNumber = 1;
+	if(variable->isExported) {
+		setenv(variable->name, variable->value, 1);
+	}
+	return 0;
+}
+
+long long variableNumber(variable_t *variable)
+{
+	const char *value;
+	if(variable->array != NULL) {
+		value = _scalar(variable);
+		return value != NULL ? strtoll(value, NULL, 0) : 0;
+	}
+	if(!variable->isNumber) {
+		variable->number = variable->value != NULL ? strtoll(variable->value, NULL, 0) : 0;
+		variable->isNumber = 1;
+	}
+	return variable->number;
+}
+
+size_t variableNameLength(const char *word)
+{
+	size_t length = 0;
+	if(!isalpha((unsigned char)*word) && *word != '_') {
+		return 0;
+	}
+	while(isalnum((unsigned char)word[length]) || word[length] == '_') {
+		length++;
+	}
+	return length;
+}
+
+size_t variableSubscriptLength(const char *text)
+{
+	const char *end;
+	char quote = 0;
+	if(*text != '[') {
+		return 0;
+	}
+	for(end = text + 1; *end != '\0' && (quote != 0 || *end != ']'); end++) {
+		if(*end == '\\' && quote != '\'' && end[1] != '\0') {
+			end++;
+		} else if(quote == 0 && (*end == '\'' || *end == '"')) {
+			quote = *end;
+		} else if(*end == quote) {
+			quote = 0;
+		} else if(quote != '\'' && end[0] == '$' && end[1] == '{'
+			&& (end = expansionFindParameterEnd(end + 2)) == NULL) {
+			return 0;
+		}
+	}
+	return *end == ']' ? end - text + 1 : 0;
+}
+
+int variableIsAssignment(const char *word)
+{
+	size_t length = variableNameLength(word);
+	if(length > 0 && word[length] == '[') {
+		length += variableSubscriptLength(word + length);
+	}
+	/* "name+=value" appends */
+	if(length > 0 && word[length] == '+') {
+		length++;
+	}
+	return length > 0 && word[length] == '=';
+}
+
+/*!
+ \brief Set the element \c "[subscript]=value" of a list assigned to
+ \a array
+ \param index receives the index following the element, for an indexed array
+ */
+static int _assignListElement(array_t *array, const char *word, size_t subscriptLength, size_t *index)
+{
+	char *subscript;
+	char *value;
+	long long number = 0;
+	int status = -1;
+	value = strndup(word + 1, subscriptLength - 2);
+	subscript = value != NULL ? expansionExpandString(value, 0) : NULL;
+	free(value);
+	value = expansionExpandString(word + subscriptLength + 1, 0);
+	if(subscript == NULL || value == NULL) {
+		status = -1;
+	} else if(array->isAssociative) {
+		status = arraySetKey(array, subscript, value);
+	} else if(arithmeticEvaluate(subscript, strlen(subscript), &number) != 0) {
+		status = -1;
+	} else if(number < 0) {
+		fprintf(stderr, "mush: [%s]: bad array subscript\n", subscript);
+	} else if((unsigned long long)number >= ARRAY_INDEX_LIMIT) {
+		fprintf(stderr, "mush: [%s]: array index out of range\n", subscript);
+	} else {
+		*index = (size_t)number + 1;
+		status = arraySetIndex(array, (size_t)number, value);
+	}
+	free(subscript);
+	free(value);
+	return status;
+}
+
+/*!
+ \brief Assign the words of \a list, \c "(words)", to the array \a name,
+ replacing its elements
+
+ The array stays associative if it was one.
+
+ \param isAppend whether to add the elements to those of the array instead,
+ following the highest index of an indexed array
+ */
+static int _assignList(const char *name, const char *list, int isAppend)
+{
+	variable_t *variable = variableLookup(name, isAppend);
+	array_t *array;
+	char **words;
+	char **word;
+	char *single[2] = {NULL, NULL};
+	char **fields;
+	char *text;
+	size_t subscriptLength;
+	size_t index = 0;
+	int fieldCount;
+	int field;
+	int status = 0;
+	if(isAppend) {
+		/* A scalar becomes the first element */
+		array = variable != NULL ? variableArray(variable, 0) : NULL;
+		index = array != NULL && !array->isAssociative ? array->length : 0;
+	} else {
+		array = arrayNew(variable != NULL && variable->array != NULL && variable->array->isAssociative);
+	}
+	text = strndup(list + 1, strlen(list) - 2);
+	words = text != NULL ? expansionSplitWords(text) : NULL;
+	free(text);
+	if(array == NULL || words == NULL) {
+		if(!isAppend) {
+			arrayFree(array);
+		}
+		expansionFree(words);
+		return -1;
+	}
+	for(word = words; *word != NULL && status == 0; word++) {
+		subscriptLength = variableSubscriptLength(*word);
+		if(subscriptLength > 0 && (*word)[subscriptLength] == '=') {
+			status = _assignListElement(array, *word, subscriptLength, &index);
+			continue;
+		}
+		if(array->isAssociative) {
+			fprintf(stderr, "mush: %s: %s: must use a subscript when assigning an associative array\n",
+				name, *word);
+			status = -1;
+			break;
+		}
+		/* Other words become as many elements as they have fields */
+		single[0] = *word;
+		fields = expansionExpandWords(single, &fieldCount);
+		if(fields == NULL) {
+			status = -1;
+			break;
+		}
+		for(field = 0; field < fieldCount && status == 0; field++) {
+			status = arraySetIndex(array, index++, fields[field]);
+		}
+		expansionFree(fields);
+	}
+	expansionFree(words);
+	if(isAppend) {
+		return status;
+	}
+	if(status != 0) {
+		arrayFree(array);
+		return -1;
+	}
+	return variableSetArray(name, array);
+}
+
+int variableAssign(const char *word)
+{
+	size_t nameLength = variableNameLength(word);
+	size_t subscriptLength = variableSubscriptLength(word + nameLength);
+	int isAppend = word[nameLength + subscriptLength] == '+';
+	const char *text = word + nameLength + subscriptLength + isAppend + 1;
+	size_t textLength = strlen(text);
+	const char *previous = NULL;
+	char *name;
+	char *subscript = NULL;
+	char *raw;
+	char *value = NULL;
+	int status = -1;
+	name = strndup(word, nameLength);
+	if(name == NULL) {
+		return -1;
+	}
+	if(subscriptLength == 0 && textLength >= 2 && text[0] == '(' && text[textLength - 1] == ')') {
+		status = _assignList(name, text, isAppend);
+		free(name);
+		return status;
+	}
+	value = expansionExpandString(text, 0);
+	if(subscriptLength > 0) {
+		subscript = strndup(word + nameLength + 1, subscriptLength - 2);
+		raw = subscript;
+		subscript = raw != NULL ? expansionExpandString(raw, 0) : NULL;
+		free(raw);
+	}
+	/* "name+=value" appends to the value, or to the element */
+	if(isAppend && value != NULL && (subscriptLength == 0 || subscript != NULL)) {
+		previous = subscript != NULL ? variableElement(name, subscript) : variableGet(name);
+		raw = value;
+		if(previous != NULL) {
+			value = malloc(strlen(previous) + strlen(raw) + 1);
+			if(value != NULL) {
+				strcpy(value, previous);
+				strcat(value, raw);
+			}
+			free(raw);
+		}
+	}
+	if(subscriptLength > 0) {
+		if(value != NULL && subscript != NULL) {
+			status = variableSetElement(name, subscript, value);
+		}
+	} else if(value != NULL) {
+		status = variableSet(name, value);
+	}
+	free(subscript);
+	free(value);
+	free(name);
+	return status;
+}
+
+void variablesReset()
+{
+	variable_t *variable;
+	size_t bucket;
+	arithmeticReset();
+	for(bucket = 0; bucket < VARIABLES_BUCKET_COUNT; bucket++) {
+		while(_buckets[bucket] != NULL) {
+			variable = _buckets[bucket];
+			_buckets[bucket] = variable->next;
+			arrayFree(variable->array);
+			free(variable->value);
+			free(variable->name);
+			free(variable);
+		}
+	}
+}
+
+void variablesSetPositional(int count, char **values)
+{
+	char **positional;
+	int index;
+	positional = malloc((count + 1) * sizeof(*positional));
+	if(positional == NULL) {
+		return;
+	}
+	for(index = 0; index < count; index++) {
+		positional[index] = strdup(values[index]);
+	}
+	positional[count] = NULL;
+	for(index = 0; index < _positionalCount; index++) {
+		free(_positional[index]);
+	}
+	free(_positional);
+	_positional = positional;
+	_positionalCount = count;
+}
+
+int variablesPushPositional(int count, char **values, variables_positional_t *saved)
+{
+	char **positional;
+	int index;
+	positional = malloc((count + 1) * sizeof(*positional));
+	if(positional == NULL) {
+		return -1;
+	}
+	positional[0] = strdup(_positionalCount > 0 ? _positional[0] : "");
+	for(index = 1; index < count; index++) {
+		positional[index] = strdup(values[index]);
+	}
+	positional[count] = NULL;
+	saved->values = _positional;
+	saved->count = _positionalCount;
+	_positional = positional;
+	_positionalCount = count;
+	return 0;
+}
+
+void variablesPopPositional(variables_positional_t *saved)
+{
+	int index;
+	for(index = 0; index < _positionalCount; index++) {
+		free(_positional[index]);
+	}
+	free(_positional);
+	_positional = saved->values;
+	_positionalCount = saved->count;
+}
+
+const char *variablePositional(int index)
+{
+	if(index < 0 || index >= _positionalCount) {
+		return NULL;
+	}
+	return _positional[index];
+}
+
+int variablesPositionalCount()
+{
+	return _positionalCount > 0 ? _positionalCount - 1 : 0;
+}
+
+/*!
+ \brief Print \a value in double quotes, so that it can be read again
+ */
+static void _printQuoted(const char *value)
+{
+	putchar('"');
+	for(; *value != '\0'; value++) {
+		if(strchr("\"$`\\", *value) != NULL) {
+			putchar('\\');
+		}
+		putchar(*value);
+	}
+	putchar('"');
+}
+
+/*!
+ \brief Print \a variable as a \c declare command
+ */
+static void _printDeclaration(const variable_t *variable)
+{
+	const char *key;
+	const char *value;
+	size_t position;
+	if(variable->array == NULL) {
+		printf("declare %s %s=", variable->isExported ? "-x" : "--", variable->name);
+		_printQuoted(variable->value);
+		putchar('\n');
+		return;
+	}
+	printf("declare -%c %s=(", variable->array->isAssociative ? 'A' : 'a', variable->name);
+	for(position = 0; (value = arrayNext(variable->array, &position, &key)) != NULL; position++) {
+		if(key != NULL) {
+			putchar('[');
+			_printQuoted(key);
+			putchar(']');
+		} else {
+			printf("[%zu]", position);
+		}
+		putchar('=');
+		_printQuoted(value);
+		putchar(' ');
+	}
+	printf(")\n");
+}
+
+int cmd_declare(int argc, char **argv)
+{
+	variable_t *variable;
+	array_t *array;
+	char *name;
+	size_t nameLength;
+	int kind = 0;
+	int isPrinted = 0;
+	int status = 0;
+	int argi;
+	int index;
+	const char *option;
+	for(argi = 1; argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0'; argi++) {
+		if(strcmp(argv[argi], "--") == 0) {
+			argi++;
+			break;
+		}
+		for(option = argv[argi] + 1; *option != '\0'; option++) {
+			if(*option == 'a' || *option == 'A') {
+				kind = *option;
+			} else if(*option == 'p') {
+				isPrinted = 1;
+			} else {
+				fprintf(stderr, "usage: declare [-a|-A] [-p] [name[=value]...]\n");
+				return 2;
+			}
+		}
+	}
+	if(argi == argc && kind == 0) {
+		for(index = 0; index < VARIABLES_BUCKET_COUNT; index++) {
+			for(variable = _buckets[index]; variable != NULL; variable = variable->next) {
+				if(variable->value != NULL || variable->array != NULL) {
+					_printDeclaration(variable);
+				}
+			}
+		}
+		return 0;
+	}
+	for(; argi < argc; argi++) {
+		nameLength = variableNameLength(argv[argi]);
+		if(nameLength == 0 || (argv[argi][nameLength] != '\0' && !variableIsAssignment(argv[argi]))) {
+			fprintf(stderr, "declare: %s: not a valid identifier\n", argv[argi]);
+			status = 1;
+			continue;
+		}
+		name = strndup(argv[argi], nameLength);
+		variable = name != NULL ? variableLookup(name, isPrinted == 0) : NULL;
+		free(name);
+		if(isPrinted) {
+			if(variable == NULL || (variable->value == NULL && variable->array == NULL)) {
+				fprintf(stderr, "declare: %s: not found\n", argv[argi]);
+				status = 1;
+			} else {
+				_printDeclaration(variable);
+			}
+			continue;
+		}
+		if(variable == NULL) {
+			status = 1;
+			continue;
+		}
+		if(kind != 0) {
+			array = variableArray(variable, kind == 'A');
+			if(array == NULL) {
+				status = 1;
+				continue;
+			}
+			if(array->isAssociative != (kind == 'A')) {
+				fprintf(stderr, "declare: %s: cannot convert %s array to %s\n", variable->name,
+					array->isAssociative ? "associative" : "indexed",
+					array->isAssociative ? "indexed" : "associative");
+				status = 1;
+				continue;
+			}
+		}
+		if(argv[argi][nameLength] != '\0' && variableAssign(argv[argi]) != 0) {
+			status = 1;
+		}
+	}
+	return status;
+}
+
+int cmd_unset(int argc, char **argv)
+{
+	char *name;
+	size_t nameLength;
+	size_t subscriptLength;
+	int status = 0;
+	int argi;
+	for(argi = 1; argi < argc; argi++) {
+		nameLength = variableNameLength(argv[argi]);
+		subscriptLength = variableSubscriptLength(argv[argi] + nameLength);
+		if(nameLength == 0 || argv[argi][nameLength + subscriptLength] != '\0') {
+			fprintf(stderr, "unset: %s: not a valid identifier\n", argv[argi]);
+			status = 1;
+			continue;
+		}
+		name = strndup(argv[argi], nameLength);
+		if(name == NULL) {
+			status = 1;
+		} else if(subscriptLength == 0) {
+			variableUnset(name);
+		} else {
+			/* The subscript has been expanded with the rest of the word */
+			argv[argi][nameLength + subscriptLength - 1] = '\0';
+			if(variableUnsetElement(name, argv[argi] + nameLength + 1) != 0) {
+				status = 1;
+			}
+		}
+		free(name);
+	}
+	return status;
+}
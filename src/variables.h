@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef VARIABLES_H
+#define VARIABLES_H
+
+#include <stddef.h>
+#include "array.h"
+
+/*!
+ \addtogroup variables
+ \{
+ */
+
+/*! \brief A shell variable */
+typedef struct __variable_t {
+	/*! \brief name of the variable */
+	char *name;
+	/*! \brief value of the variable, or \a NULL if it is unset */
+	char *value;
+	/*! \brief size of the memory allocated for \a value */
+	size_t valueSize;
+	/*! \brief \a value as an integer, valid if \a isNumber is set */
+	long long number;
+	/*! \brief whether \a number holds the value, so arithmetic does not
+	 convert it again */
+	int isNumber;
+	/*! \brief whether the variable is passed to the environment of programs */
+	int isExported;
+	/*! \brief elements if the variable is an array, \a value is unused then */
+	array_t *array;
+	/*! \brief next variable in the same bucket */
+	struct __variable_t *next;
+} variable_t;
+
+/*!
+ \brief Find the variable called \a name
+
+ Variables of the environment are imported the first time they are looked
+ up, and stay exported.
+
+ \param name name of the variable
+ \param isCreated whether an unset variable is created if it does not exist
+ \return the variable, or \c NULL if it does not exist and \a isCreated is
+ \c 0
+ */
+variable_t *variableLookup(const char *name, int isCreated);
+
+/*!
+ \brief Return the value of the variable called \a name
+
+ The value of an array is its element \c 0.
+
+ \return the value, or \c NULL if the variable is unset
+ */
+const char *variableGet(const char *name);
+
+/*!
+ \brief Assign \a value to the variable called \a name
+
+ The value is copied. If the variable is exported, the environment is
+ updated as well. Assigning to an array sets its element \c 0.
+
+ \return \c 0 on success, \c -1 on error
+ */
+int variableSet(const char *name, const char *value);
+
+/*!
+ \brief Unset the variable called \a name, removing it from the environment
+ */
+void variableUnset(const char *name);
+
+/*!
+ \brief Return the elements of \a variable, making it an array if it is not
+ one yet
+
+ The value of a variable which is not an array becomes its element \c 0.
+
+ \param isAssociative kind of array to create
+ \return the array, which may be of the other kind if it existed before, or
+ \c NULL on error
+ */
+array_t *variableArray(variable_t *variable, int isAssociative);
+
+/*!
+ \brief Replace the value of the variable called \a name with \a array,
+ which belongs to the variable from then on
+ \return \c 0 on success, \c -1 on error
+ */
+int variableSetArray(const char *name, array_t *array);
+
+/*!
+ \brief Return an element of the variable called \a name
+
+ The subscript of an indexed array is an arithmetic expression, negative
+ indices counting from the end. A variable which is not an array only has
+ the element \c 0.
+
+ \param subscript the subscript, already expanded
+ \return the value, or \c NULL if the element is unset
+ */
+const char *variableElement(const char *name, const char *subscript);
+
+/*!
+ \brief Assign \a value to an element of the variable called \a name,
+ making it an indexed array if it is not an array yet
+ \param subscript the subscript, already expanded
+ \return \c 0 on success, \c -1 on error
+ */
+int variableSetElement(const char *name, const char *subscript, const char *value);
+
+/*!
+ \brief Unset an element of the variable called \a name
+ \param subscript the subscript, already expanded
+ \return \c 0 on success, \c -1 if the subscript is invalid
+ */
+int variableUnsetElement(const char *name, const char *subscript);
+
+/*!
+ \brief Return the amount of elements of the variable called \a name, \c 1
+ for a variable which is set but is not an array
+ */
+size_t variableElementCount(const char *name);
+
+/*!
+ \brief Assign the integer \a number to \a variable
+
+ The value is formatted into the memory of the previous value where it fits,
+ and the integer is kept for arithmetic.
+
+ \return \c 0 on success, \c -1 on error
+ */
+int variableSetNumber(variable_t *variable, long long number);
+
+/*!
+ \brief Return the value of \a variable as an integer
+
+ Unset or empty variables and values which are not numbers count as zero.
+ The integer is kept, so the value is only converted once.
+ */
+long long variableNumber(variable_t *variable);
+
+/*!
+ \brief Determine the length of the variable name at the start of \a word
+ \return length of the name, or \c 0 if \a word does not start with a name
+ */
+size_t variableNameLength(const char *word);
+
+/*!
+ \brief Determine the length of the subscript at the start of \a text,
+ i.e. \c "[subscript]"
+ \return length of the subscript including its brackets, or \c 0 if
+ \a text does not start with one
+ */
+size_t variableSubscriptLength(const char *text);
+
+/*!
+ \brief Indicate whether \a word is an assignment, i.e. \c "name=value"
+ or \c "name[subscript]=value", with \c "+=" in place of \c "=" to append
+ */
+int variableIsAssignment(const char *word);
+
+/*!
+ \brief Expand and perform the assignment \a word
+
+ Besides \c "name=value" and \c "name[subscript]=value", \c "name=(words)"
+ assigns a list of words to an array. Each word is expanded into as many
+ elements as it has fields, or sets a single element when it is written as
+ \c "[subscript]=value", which associative arrays require.
+
+ With \c "+=" the value is appended to that of the variable or element, and
+ \c "name+=(words)" adds the elements to the array, following the highest
+ index of an indexed array. A scalar becomes the first element.
+
+ \return \c 0 on success, \c -1 on error
+ */
+int variableAssign(const char *word);
+
+/*!
+ \brief Replace the positional parameters
+
+ The strings are copied. \a values[0] becomes \c $0, the name of the shell or
+ script, the remaining values become \c $1, \c $2 and so on.
+
+ \param count amount of elements in \a values
+ \param values the parameters
+ */
+void variablesSetPositional(int count, char **values);
+
+/*!
+ \brief Forget every variable, as a new shell would
+
+ Exported variables are read from the environment again when they are used.
+ */
+void variablesReset();
+
+/*! \brief Positional parameters set aside while a function runs */
+typedef struct __variables_positional_t {
+	char **values;
+	int count;
+} variables_positional_t;
+
+/*!
+ \brief Replace the positional parameters for the duration of a function,
+ keeping \c $0
+
+ \param count amount of elements in \a values
+ \param values the parameters, \a values[0] being the name of the function
+ \param saved receives the previous parameters, to be passed to
+ variablesPopPositional()
+ \return \c 0 on success, \c -1 on error
+ */
+int variablesPushPositional(int count, char **values, variables_positional_t *saved);
+
+/*!
+ \brief Free the positional parameters of a function and restore those
+ replaced by variablesPushPositional()
+ */
+void variablesPopPositional(variables_positional_t *saved);
+
+/*!
+ \brief Return the positional parameter \a index, \c $0 being the name of the
+ shell
+ \return the parameter, or \c NULL if there are fewer parameters
+ */
+const char *variablePositional(int index);
+
+/*!
+ \brief Return the amount of positional parameters, not counting \c $0
+ */
+int variablesPositionalCount();
+
+/*!
+ \brief Run the builtin "declare" command
+
+ \c "declare -a name" and \c "declare -A name" create indexed and
+ associative arrays, arguments which are assignments are then performed.
+ \c -p, or no arguments, prints the variables as \c declare commands.
+
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return exit status of the command
+ */
+int cmd_declare(int argc, char **argv);
+
+/*!
+ \brief Run the builtin "unset" command, unsetting variables or elements of
+ arrays (\c "name[subscript]")
+ \param argc count of elements in \a argv
+ \param argv arguments to be passed to the command
+ \return exit status of the command
+ */
+int cmd_unset(int argc, char **argv);
+
+/*!
+ \}
+ */
+
+#endif /* VARIABLES_H */
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#define _GNU_SOURCE
+#include "writer.h"
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+
+void writerInitialize(writer_t *writer, int descriptor)
+{
+	writer->descriptor = descriptor;
+	writer->length = 0;
+	writer->error = 0;
+}
+
+/*!
+ \brief Write \a length bytes to the descriptor, retrying short writes
+ \return \c 0 on success, \c -1 on error
+ */
+static int _writeAll(writer_t *writer, const char *data, size_t length)
+{
+	ssize_t count;
+	/* Once a write failed, the remaining output is discarded */
+	if(writer->error != 0) {
+		return -1;
+	}
+	while(length > 0) {
+		count = write(writer->descriptor, data, length);
+		if(count == -1 && errno == EINTR) {
+			continue;
+		}
+		if(count == -1) {
+			writer->error = errno;
+			return -1;
+		}
+		data += count;
+		length -= count;
+	}
+	return 0;
+}
+
+int writerFlush(writer_t *writer)
+{
+	int status = _writeAll(writer, writer->buffer, writer->length);
+	writer->length = 0;
+	if(writer->error != 0) {
+		errno = writer->error;
+		return -1;
+	}
+	return status;
+}
+
+int writerWrite(writer_t *writer, const char *data, size_t length)
+{
+	if(writer->length + length > WRITER_BUFFER_SIZE) {
+		if(writerFlush(writer) != 0) {
+			return -1;
+		}
+		/* Large output is not worth copying */
+		if(length >= WRITER_BUFFER_SIZE) {
+			return _writeAll(writer, data, length);
+		}
+	}
+	memcpy(writer->buffer + writer->length, data, length);
+	writer->length += length;
+	return 0;
+}
+
+int writerPutString(writer_t *writer, const char *string)
+{
+	return writerWrite(writer, string, strlen(string));
+}
+
+int writerPutCharacter(writer_t *writer, char character)
+{
+	if(writer->length == WRITER_BUFFER_SIZE && writerFlush(writer) != 0) {
+		return -1;
+	}
+	writer->buffer[writer->length++] = character;
+	return 0;
+}
+
+int writerPrintf(writer_t *writer, const char *format, ...)
+{
+	va_list arguments;
+	char *formatted;
+	int length;
+	int status;
+	va_start(arguments, format);
+	length = vsnprintf(writer->buffer + writer->length,
+		WRITER_BUFFER_SIZE - writer->length, format, arguments);
+	va_end(arguments);
+	if(length < 0) {
+		return -1;
+	}
+	if((size_t)length < WRITER_BUFFER_SIZE - writer->length) {
+		writer->length += length;
+		return 0;
+	}
+	/* Did not fit into the remaining buffer */
+	va_start(arguments, format);
+	length = vasprintf(&formatted, format, arguments);
+	va_end(arguments);
+	if(length < 0) {
+		return -1;
+	}
+	status = writerWrite(writer, formatted, length);
+	free(formatted);
+	return status;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stddef.h>
+
+/*!
+ \addtogroup writer
+ \{
+ */
+
+/*! \brief Size of the buffer of a writer */
+#define WRITER_BUFFER_SIZE 4096
+
+/*!
+ \brief Buffered output to a file descriptor
+
+ Builtins write their output through a writer and flush it once the command
+ is done, so short commands cost a single write(). Unlike \c stdout, a writer
+ holds no state beyond the command, so output never lingers in the shell
+ after a builtin ran in it, or gets written twice after a fork().
+ */
+typedef struct __writer_t {
+	/*! \brief descriptor written to */
+	int descriptor;
+	/*! \brief amount of buffered bytes */
+	size_t length;
+	/*! \brief errno of the first failed write, or \c 0 */
+	int error;
+	/*! \brief buffered bytes */
+	char buffer[WRITER_BUFFER_SIZE];
+} writer_t;
+
+/*!
+ \brief Prepare \a writer for writing to \a descriptor
+ \param writer the writer to be initialized
+ \param descriptor descriptor to write to
+ */
+void writerInitialize(writer_t *writer, int descriptor);
+
+/*!
+ \brief Append \a length bytes of \a data to the output
+ \param writer the writer
+ \param data bytes to be written
+ \param length amount of bytes in \a data
+ \return \c 0 on success, \c -1 if writing failed
+ */
+int writerWrite(writer_t *writer, const char *data, size_t length);
+
+/*!
+ \brief Append a string to the output
+ \param writer the writer
+ \param string \c NUL terminated string to be written
+ \return \c 0 on success, \c -1 if writing failed
+ */
+int writerPutString(writer_t *writer, const char *string);
+
+/*!
+ \brief Append a single character to the output
+ \param writer the writer
+ \param character character to be written
+ \return \c 0 on success, \c -1 if writing failed
+ */
+int writerPutCharacter(writer_t *writer, char character);
+
+/*!
+ \brief Append formatted output, as with printf()
+ \param writer the writer
+ \param format printf() format string
+ \return \c 0 on success, \c -1 if writing failed
+ */
+int writerPrintf(writer_t *writer, const char *format, ...);
+
+/*!
+ \brief Write all buffered output to the descriptor
+ \param writer the writer
+ \return \c 0 if all output was written, \c -1 otherwise, with \c errno set
+ to the first error
+ */
+int writerFlush(writer_t *writer);
+
+/*!
+ \}
+ */
+
+#endif /* WRITER_H */
@@ -31,6 +31,21 @@
 #include "test_command.h"
 #include "test_parser.h"
 #include "test_builtin.h"
+#include "test_heredoc.h"
+#include "test_redirection.h"
+#include "test_jobs.h"
+#include "test_expansion.h"
+#include "test_launcher.h"
+#include "test_transfer.h"
+#include "test_optimizer.h"
+#include "test_script.h"
+#include "test_arithmetic.h"
+#include "test_functions.h"
+#include "test_array.h"
+#include "test_schedule.h"
+#include "test_topology.h"
+#include "test_server.h"
+#include "test_libmush.h"
 
 int main(int argc, char* argv[]) {
 	const UnitTest tests[] = {
@@ -47,9 +62,52 @@ int main(int argc, char* argv[]) {
 		unit_test(testParseSingleCommand),
 		unit_test(testParseMultipleCommands),
 		unit_test(testParseTerminators),
+		unit_test(testParseConditionalConnections),
 		unit_test(testParseRedirection),
+		unit_test(testParseHereDocument),
+		unit_test(testParseHereString),
+		unit_test(testParseProcessSubstitution),
+		unit_test(testParseDescriptorRedirection),
+		unit_test(testHereDocumentDescriptor),
+		unit_test(testExpansionExpandWords),
+		unit_test(testExpansionParameters),
+		unit_test(testExpansionOperators),
+		unit_test(testOptimizeCommandQueue),
+		unit_test(testScriptCompile),
+		unit_test(testScriptExecute),
+		unit_test(testScriptCompound),
+		unit_test(testScriptRedirection),
+		unit_test(testScriptFileLookup),
+		unit_test(testArithmeticEvaluate),
+		unit_test(testArithmeticExpansion),
+		unit_test(testFunctionCall),
+		unit_test(testAliasExpansion),
+		unit_test(testArrayStorage),
+		unit_test(testArrayExpansion),
+		unit_test(testArrayAppend),
+		unit_test(testRedirectionNew),
+		unit_test(testRedirectionsApply),
+		unit_test(testRedirectionPipe),
+		unit_test(testJobsSlotLimit),
+		unit_test(testJobsSubmit),
+		unit_test(testJobsWait),
+		unit_test(testJobsFinal),
+		unit_test(testLauncherSpawn),
+		unit_test(testTransferDescriptor),
+		unit_test(testTransferDescriptorToMany),
+		unit_test(testScheduleApply),
+		unit_test(testTopologyPlacement),
+		unit_test(testServerRequest),
+		unit_test(testContextParse),
 		unit_test(testPrompt),
 		unit_test(testCd),
+		unit_test(testParallel),
+		unit_test(testEcho),
+		unit_test(testPrintf),
+		unit_test(testTest),
+		unit_test(testRead),
+		unit_test(testUlimit),
+		unit_test(testTimeout),
 	};
 	return run_tests(tests);
 }
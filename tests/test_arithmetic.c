@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmockery.h>
+#include "test_arithmetic.h"
+#include "arithmetic.h"
+#include "expansion.h"
+#include "parser.h"
+#include "variables.h"
+
+static long long _evaluate(const char *expression)
+{
+	long long result = 0;
+	assert_int_equal(arithmeticEvaluate(expression, strlen(expression), &result), 0);
+	return result;
+}
+
+void testArithmeticEvaluate(void **state)
+{
+	long long result;
+
+	assert_int_equal(_evaluate("1 + 2 * 3"), 7);
+	assert_int_equal(_evaluate("(1 + 2) * 3"), 9);
+	assert_int_equal(_evaluate("2 ** 3 ** 2"), 512);
+	assert_int_equal(_evaluate("10 - 4 - 3"), 3);
+	assert_int_equal(_evaluate("-7 / 2"), -3);
+	assert_int_equal(_evaluate("1 << 4 | 1"), 17);
+	assert_int_equal(_evaluate("!0 && 3 > 2"), 1);
+	assert_int_equal(_evaluate("0x10 + 010"), 24);
+	assert_int_equal(_evaluate(""), 0);
+
+	variableSet("n", "5");
+	assert_int_equal(_evaluate("n * $n"), 25);
+	assert_int_equal(_evaluate("n += 2"), 7);
+	assert_string_equal(variableGet("n"), "7");
+	assert_int_equal(_evaluate("n++"), 7);
+	assert_int_equal(_evaluate("++n"), 9);
+	assert_int_equal(_evaluate("n > 8 ? 1 : 2"), 1);
+	/* The short circuit leaves the variable alone */
+	assert_int_equal(_evaluate("0 && n++"), 0);
+	assert_int_equal(_evaluate("m = n = 3, m + n"), 6);
+	assert_string_equal(variableGet("m"), "3");
+
+	/* Evaluating the cached expression again sees the assigned value */
+	variableSet("n", "1");
+	assert_int_equal(_evaluate("n++"), 1);
+	assert_int_equal(_evaluate("n++"), 2);
+	assert_string_equal(variableGet("n"), "3");
+
+	/* Resetting the variables forgets expressions referring to them */
+	variablesReset();
+	variableSet("n", "5");
+	assert_int_equal(_evaluate("n++"), 5);
+	assert_string_equal(variableGet("n"), "6");
+
+	assert_int_equal(arithmeticEvaluate("1 / 0", 5, &result), -1);
+	assert_int_equal(arithmeticEvaluate("1 +", 3, &result), -1);
+	assert_int_equal(arithmeticEvaluate("3 = 1", 5, &result), -1);
+	assert_int_equal(arithmeticEvaluate("(1", 2, &result), -1);
+	/* Only the given length is evaluated */
+	assert_int_equal(arithmeticEvaluate("1 + 1))", 5, &result), 0);
+	assert_int_equal(result, 2);
+}
+
+void testArithmeticExpansion(void **state)
+{
+	char *words[] = {"$((1 + 2))", "x$((n*2))y", "\"$(( (n) ))\"", NULL};
+	char **arguments;
+	char *input;
+	queue_t *commands;
+	int count;
+
+	variableSet("n", "4");
+	arguments = expansionExpandWords(words, &count);
+	assert_true(arguments != NULL);
+	assert_int_equal(count, 3);
+	assert_string_equal(arguments[0], "3");
+	assert_string_equal(arguments[1], "x8y");
+	assert_string_equal(arguments[2], "4");
+	expansionFree(arguments);
+
+	/* Blanks and operators within the expansion do not end the word */
+	input = strdup("echo $(( 1 | 2 )) done");
+	commands = commandQueueFromInput(input);
+	assert_true(commands != NULL);
+	assert_int_equal(queueCount(commands), 1);
+	queueFree(commands);
+	free(input);
+
+	input = strdup("echo $(( 1 +");
+	assert_true(commandQueueFromInput(input) == NULL);
+	free(input);
+}
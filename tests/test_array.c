@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <stdio.h>
+#include <cmockery.h>
+#include "test_array.h"
+#include "array.h"
+#include "command.h"
+#include "parser.h"
+#include "expansion.h"
+#include "variables.h"
+
+void testArrayStorage(void **state)
+{
+	array_t *array;
+	const char *value;
+	const char *key;
+	char name[16];
+	size_t position;
+	size_t count = 0;
+	int index;
+
+	array = arrayNew(0);
+	assert_true(array != NULL);
+	assert_int_equal(arraySetIndex(array, 0, "a"), 0);
+	assert_int_equal(arraySetIndex(array, 20, "b"), 0);
+	assert_int_equal(array->count, 2);
+	assert_int_equal(array->length, 21);
+	assert_string_equal(arrayGetIndex(array, 20), "b");
+	assert_true(arrayGetIndex(array, 1) == NULL);
+	assert_true(arrayGetIndex(array, 100) == NULL);
+	assert_int_equal(arraySetIndex(array, ARRAY_INDEX_LIMIT, "c"), -1);
+	assert_int_equal(array->length, 21);
+	/* Unset elements are skipped, the others are visited in order */
+	position = 0;
+	assert_string_equal(arrayNext(array, &position, &key), "a");
+	position++;
+	assert_string_equal(arrayNext(array, &position, &key), "b");
+	assert_int_equal(position, 20);
+	assert_true(key == NULL);
+	arrayRemoveIndex(array, 20);
+	assert_int_equal(array->length, 1);
+	arrayFree(array);
+
+	/* Enough keys to grow the table several times */
+	array = arrayNew(1);
+	assert_true(array != NULL);
+	for(index = 0; index < 100; index++) {
+		snprintf(name, sizeof(name), "key%d", index);
+		assert_int_equal(arraySetKey(array, name, name + 3), 0);
+	}
+	assert_int_equal(arraySetKey(array, "key7", "seven"), 0);
+	assert_int_equal(array->count, 100);
+	assert_string_equal(arrayGetKey(array, "key7"), "seven");
+	assert_int_equal(arraySetKey(array, "key7", "7"), 0);
+	assert_string_equal(arrayGetKey(array, "key99"), "99");
+	assert_true(arrayGetKey(array, "missing") == NULL);
+	/* Removing keys keeps the others reachable */
+	for(index = 0; index < 100; index += 2) {
+		snprintf(name, sizeof(name), "key%d", index);
+		arrayRemoveKey(array, name);
+	}
+	assert_int_equal(array->count, 50);
+	for(index = 0; index < 100; index++) {
+		snprintf(name, sizeof(name), "key%d", index);
+		assert_int_equal(arrayGetKey(array, name) != NULL, index % 2);
+	}
+	for(position = 0; (value = arrayNext(array, &position, &key)) != NULL; position++) {
+		assert_string_equal(key + 3, value);
+		count++;
+	}
+	assert_int_equal(count, 50);
+	arrayFree(array);
+}
+
+void testArrayExpansion(void **state)
+{
+	char *words[] = {"\"${list[@]}\"", "${#list[@]}", "${list[1]}", "${list[-1]}",
+		"\"${list[*]}\"", "${!list[@]}", "\"${table[a b]}\"", "${#table[@]}",
+		"\"${empty[@]}\"", NULL};
+	char **arguments;
+	int count;
+
+	assert_int_equal(variableAssign("list=(one 'two words' [5]=six)"), 0);
+	assert_int_equal(variableAssign("list[2]=three"), 0);
+	variableSetArray("table", arrayNew(1));
+	assert_int_equal(variableAssign("table[\"a b\"]=c"), 0);
+	assert_int_equal(variableAssign("empty=()"), 0);
+	arguments = expansionExpandWords(words, &count);
+	assert_true(arguments != NULL);
+	assert_int_equal(count, 15);
+	/* Quoted elements stay separate arguments, without being joined */
+	assert_string_equal(arguments[0], "one");
+	assert_string_equal(arguments[1], "two words");
+	assert_string_equal(arguments[2], "three");
+	assert_string_equal(arguments[3], "six");
+	assert_string_equal(arguments[4], "4");
+	assert_string_equal(arguments[5], "two");
+	assert_string_equal(arguments[6], "words");
+	assert_string_equal(arguments[7], "six");
+	assert_string_equal(arguments[8], "one two words three six");
+	assert_string_equal(arguments[9], "0");
+	assert_string_equal(arguments[10], "1");
+	assert_string_equal(arguments[11], "2");
+	assert_string_equal(arguments[12], "5");
+	assert_string_equal(arguments[13], "c");
+	assert_string_equal(arguments[14], "1");
+	expansionFree(arguments);
+	assert_string_equal(variableGet("list"), "one");
+
+	/* Associative arrays require keys */
+	assert_int_equal(variableAssign("table=(d)"), -1);
+	/* Indices out of range are errors rather than allocations */
+	assert_int_equal(variableAssign("list[100000000000]=x"), -1);
+	assert_int_equal(variableAssign("list=([100000000000]=x)"), -1);
+	variableUnset("list");
+	variableUnset("table");
+	variableUnset("empty");
+	assert_true(variableGet("list") == NULL);
+}
+
+void testArrayAppend(void **state)
+{
+	char input[] = "list+=(c 'd e')";
+	queue_t *commands;
+	command_t *command;
+
+	/* The words appended to an array stay in one word */
+	commands = commandQueueFromInput(input);
+	assert_true(commands != NULL);
+	command = commands->head->data;
+	assert_int_equal(command->argc, 1);
+	assert_string_equal(command->argv[0], "list+=(c 'd e')");
+	assert_true(variableIsAssignment(command->argv[0]));
+	queueFree(commands);
+
+	/* A scalar becomes the first element */
+	assert_int_equal(variableAssign("list=a"), 0);
+	assert_int_equal(variableAssign("list+=(b)"), 0);
+	assert_int_equal(variableAssign("list+=(c 'd e')"), 0);
+	assert_int_equal(variableElementCount("list"), 4);
+	assert_string_equal(variableElement("list", "0"), "a");
+	assert_string_equal(variableElement("list", "1"), "b");
+	assert_string_equal(variableElement("list", "3"), "d e");
+	/* Elements follow the highest index */
+	assert_int_equal(variableAssign("list[9]=j"), 0);
+	assert_int_equal(variableAssign("list+=(k)"), 0);
+	assert_string_equal(variableElement("list", "10"), "k");
+	assert_int_equal(variableAssign("list[1]+=x"), 0);
+	assert_string_equal(variableElement("list", "1"), "bx");
+	assert_int_equal(variableAssign("list+=y"), 0);
+	assert_string_equal(variableGet("list"), "ay");
+
+	variableSetArray("table", arrayNew(1));
+	assert_int_equal(variableAssign("table+=([a]=b [c]=d)"), 0);
+	assert_int_equal(variableAssign("table+=([a]=e)"), 0);
+	assert_int_equal(variableAssign("table[c]+=f"), 0);
+	assert_int_equal(variableElementCount("table"), 2);
+	assert_string_equal(variableElement("table", "a"), "e");
+	assert_string_equal(variableElement("table", "c"), "df");
+	/* A failed append keeps the elements */
+	assert_int_equal(variableAssign("table+=(g)"), -1);
+	assert_int_equal(variableElementCount("table"), 2);
+
+	assert_int_equal(variableAssign("text=abc"), 0);
+	assert_int_equal(variableAssign("text+=def"), 0);
+	assert_string_equal(variableGet("text"), "abcdef");
+	assert_int_equal(variableAssign("unset+=g"), 0);
+	assert_string_equal(variableGet("unset"), "g");
+
+	variableUnset("list");
+	variableUnset("table");
+	variableUnset("text");
+	variableUnset("unset");
+}
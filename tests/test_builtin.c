@@ -26,9 +26,15 @@
 #include <setjmp.h>
 #include <cmockery.h>
 #include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <time.h>
 #include "test_builtin.h"
 #include "command.h"
 #include "builtin.h"
+#include "variables.h"
 
 void testPrompt(void **state)
 {
@@ -53,3 +59,232 @@ void testCd(void **state)
 	assert_string_equal(cwd, "/");
 	free(cwd);
 }
+
+/*!
+ \brief Run \a function, returning what it wrote to standard output
+ \return newly allocated output
+ */
+static char *_captureOutput(commandBuiltinFunction function, int argc, char **argv, int *status)
+{
+	char *buffer = malloc(256);
+	int pipeDescriptors[2];
+	int savedOutput;
+	ssize_t length;
+
+	assert_int_equal(pipe(pipeDescriptors), 0);
+	fflush(stdout);
+	savedOutput = dup(STDOUT_FILENO);
+	dup2(pipeDescriptors[1], STDOUT_FILENO);
+	*status = function(argc, argv);
+	dup2(savedOutput, STDOUT_FILENO);
+	close(savedOutput);
+	close(pipeDescriptors[1]);
+	length = read(pipeDescriptors[0], buffer, 255);
+	close(pipeDescriptors[0]);
+	buffer[length > 0 ? length : 0] = '\0';
+	return buffer;
+}
+
+void testParallel(void **state)
+{
+	char *argv[10] = {"parallel", "-k", "-j", "2", "echo", "item", ":::", "a", "b", NULL};
+	char *failingArgv[6] = {"parallel", "false", ":::", "1", "2", NULL};
+	char buffer[64];
+	int pipeDescriptors[2];
+	int savedOutput;
+	ssize_t length;
+
+	assert_int_equal(pipe(pipeDescriptors), 0);
+	fflush(stdout);
+	savedOutput = dup(STDOUT_FILENO);
+	dup2(pipeDescriptors[1], STDOUT_FILENO);
+	assert_int_equal(cmd_parallel(9, argv), 0);
+	dup2(savedOutput, STDOUT_FILENO);
+	close(savedOutput);
+	close(pipeDescriptors[1]);
+	length = read(pipeDescriptors[0], buffer, sizeof(buffer) - 1);
+	close(pipeDescriptors[0]);
+	assert_true(length > 0);
+	buffer[length] = '\0';
+	assert_string_equal(buffer, "item a\nitem b\n");
+
+	/* The exit status is the amount of failed commands */
+	assert_int_equal(cmd_parallel(5, failingArgv), 2);
+}
+
+void testEcho(void **state)
+{
+	char *argv[5] = {"echo", "a", "", "b", NULL};
+	char *noNewLineArgv[4] = {"echo", "-n", "a", NULL};
+	char *escapeArgv[4] = {"echo", "-e", "x\\ty\\cz", NULL};
+	char *output;
+	int status;
+
+	output = _captureOutput(cmd_echo, 4, argv, &status);
+	assert_int_equal(status, 0);
+	assert_string_equal(output, "a  b\n");
+	free(output);
+	output = _captureOutput(cmd_echo, 3, noNewLineArgv, &status);
+	assert_string_equal(output, "a");
+	free(output);
+	output = _captureOutput(cmd_echo, 3, escapeArgv, &status);
+	assert_string_equal(output, "x\ty");
+	free(output);
+}
+
+void testPrintf(void **state)
+{
+	char *argv[8] = {"printf", "%s=%03d|%-3s|\\n", "a", "7", "b", "c", "8", NULL};
+	char *conversionArgv[8] = {"printf", "%x %o %c %.2f %b", "255", "8", "yes", "1.5", "\\0101", NULL};
+	char *invalidArgv[4] = {"printf", "%d", "x", NULL};
+	char *output;
+	int status;
+
+	/* The format is reused for the remaining arguments */
+	output = _captureOutput(cmd_printf, 7, argv, &status);
+	assert_int_equal(status, 0);
+	assert_string_equal(output, "a=007|b  |\nc=008|   |\n");
+	free(output);
+	output = _captureOutput(cmd_printf, 7, conversionArgv, &status);
+	assert_string_equal(output, "ff 10 y 1.50 A");
+	free(output);
+	output = _captureOutput(cmd_printf, 3, invalidArgv, &status);
+	assert_int_equal(status, 1);
+	free(output);
+}
+
+void testTest(void **state)
+{
+	char *fileArgv[4] = {"test", "-d", "/", NULL};
+	char *bracketArgv[6] = {"[", "a", "=", "b", "]", NULL};
+	char *unterminatedArgv[3] = {"[", "a", NULL};
+	char *negatedArgv[5] = {"test", "!", "-z", "a", NULL};
+	char *compoundArgv[9] = {"test", "(", "1", "-lt", "2", ")", "-a", "x", NULL};
+	char *invalidArgv[5] = {"test", "1", "-eq", "a", NULL};
+	char *emptyArgv[2] = {"test", NULL};
+
+	assert_int_equal(cmd_test(3, fileArgv), 0);
+	assert_int_equal(cmd_test(5, bracketArgv), 1);
+	assert_int_equal(cmd_test(2, unterminatedArgv), 2);
+	assert_int_equal(cmd_test(4, negatedArgv), 0);
+	assert_int_equal(cmd_test(8, compoundArgv), 0);
+	assert_int_equal(cmd_test(4, invalidArgv), 2);
+	assert_int_equal(cmd_test(1, emptyArgv), 1);
+}
+
+void testRead(void **state)
+{
+	char contents[] = "  one two  three  \nback\\ slash\\\ncontinued\nx:y\nlast";
+	char *fieldsArgv[5] = {"read", "-u", NULL, "first", "rest"};
+	char *rawArgv[5] = {"read", "-r", "-u", NULL, "line"};
+	char *replyArgv[3] = {"read", "-u", NULL};
+	char *countArgv[6] = {"read", "-n", "2", "-u", NULL, "pair"};
+	char descriptorArgument[16];
+	char buffer[16];
+	FILE *file = tmpfile();
+	int pipeDescriptors[2];
+	int descriptor;
+
+	assert_true(file != NULL);
+	descriptor = fileno(file);
+	assert_int_equal(write(descriptor, contents, strlen(contents)), strlen(contents));
+	lseek(descriptor, 0, SEEK_SET);
+	snprintf(descriptorArgument, sizeof(descriptorArgument), "%d", descriptor);
+	fieldsArgv[2] = replyArgv[2] = countArgv[4] = descriptorArgument;
+	rawArgv[3] = descriptorArgument;
+
+	assert_int_equal(cmd_read(5, fieldsArgv), 0);
+	assert_string_equal(variableGet("first"), "one");
+	assert_string_equal(variableGet("rest"), "two  three");
+	/* The file is left just past the line read */
+	assert_int_equal(lseek(descriptor, 0, SEEK_CUR), 19);
+	assert_int_equal(cmd_read(5, fieldsArgv), 0);
+	/* The quoted blank does not separate fields, the new line continues */
+	assert_string_equal(variableGet("first"), "back slashcontinued");
+	assert_string_equal(variableGet("rest"), "");
+	assert_int_equal(cmd_read(6, countArgv), 0);
+	assert_string_equal(variableGet("pair"), "x:");
+	assert_int_equal(cmd_read(3, replyArgv), 0);
+	assert_string_equal(variableGet("REPLY"), "y");
+	/* An unterminated line is assigned, but fails */
+	assert_int_equal(cmd_read(5, rawArgv), 1);
+	assert_string_equal(variableGet("line"), "last");
+	fclose(file);
+
+	/* A pipe is read one character at a time, leaving the rest */
+	assert_int_equal(pipe(pipeDescriptors), 0);
+	assert_int_equal(write(pipeDescriptors[1], "a\\b\nrest", 8), 8);
+	close(pipeDescriptors[1]);
+	snprintf(descriptorArgument, sizeof(descriptorArgument), "%d", pipeDescriptors[0]);
+	assert_int_equal(cmd_read(5, rawArgv), 0);
+	assert_string_equal(variableGet("line"), "a\\b");
+	assert_int_equal(read(pipeDescriptors[0], buffer, sizeof(buffer)), 4);
+	close(pipeDescriptors[0]);
+}
+
+void testUlimit(void **state)
+{
+	char *softArgv[4] = {"ulimit", "-S", "-c", "0"};
+	char *invalidArgv[3] = {"ulimit", "-n", "many"};
+	char *usageArgv[3] = {"ulimit", "-x", "1"};
+	struct rlimit original;
+	struct rlimit limits;
+	pid_t pid;
+	int status;
+
+	/* Only the soft limit is lowered, so it can be restored */
+	assert_int_equal(getrlimit(RLIMIT_CORE, &original), 0);
+	assert_int_equal(cmd_ulimit(4, softArgv), 0);
+	assert_int_equal(getrlimit(RLIMIT_CORE, &limits), 0);
+	assert_int_equal(limits.rlim_cur, 0);
+	assert_true(limits.rlim_max == original.rlim_max);
+	assert_int_equal(setrlimit(RLIMIT_CORE, &original), 0);
+	assert_int_equal(cmd_ulimit(3, invalidArgv), 2);
+	assert_int_equal(cmd_ulimit(3, usageArgv), 2);
+
+	assert_int_equal(ulimitApply("memory=1X"), -1);
+	assert_int_equal(ulimitApply("weight=1"), -1);
+	assert_int_equal(ulimitApply("files=-1"), -1);
+
+	/* Attributes set both limits, so they are tried in a child */
+	pid = fork();
+	assert_true(pid != -1);
+	if(pid == 0) {
+		if(ulimitApply("files=64") != 0 || ulimitApply("memory=1G") != 0) {
+			_exit(1);
+		}
+		getrlimit(RLIMIT_NOFILE, &limits);
+		if(limits.rlim_cur != 64 || limits.rlim_max != 64) {
+			_exit(1);
+		}
+		getrlimit(RLIMIT_AS, &limits);
+		_exit(limits.rlim_cur == 1024 * 1024 * 1024 ? 0 : 1);
+	}
+	assert_int_equal(waitpid(pid, &status, 0), pid);
+	assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+void testTimeout(void **state)
+{
+	char *expiredArgv[5] = {"timeout", "0.1", "/bin/sleep", "5", NULL};
+	char *killedArgv[8] = {"timeout", "-k", "0.1", "0.1", "/bin/sh", "-c", NULL, NULL};
+	char *finishedArgv[6] = {"timeout", "5", "/bin/sh", "-c", "exit 3", NULL};
+	char *invalidArgv[4] = {"timeout", "soon", "true", NULL};
+	char *signalArgv[7] = {"timeout", "-s", "KILL", "0.1", "/bin/sleep", "5", NULL};
+	struct timespec start;
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	assert_int_equal(cmd_timeout(4, expiredArgv), 124);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	assert_true(end.tv_sec - start.tv_sec < 2);
+
+	/* A command ignoring the signal is killed after the second duration */
+	killedArgv[6] = "trap '' TERM; sleep 5";
+	assert_int_equal(cmd_timeout(7, killedArgv), 137);
+	/* So is a command sent KILL in the first place */
+	assert_int_equal(cmd_timeout(6, signalArgv), 137);
+
+	assert_int_equal(cmd_timeout(5, finishedArgv), 3);
+	assert_int_equal(cmd_timeout(3, invalidArgv), 125);
+}
@@ -34,4 +34,39 @@ void testPrompt(void **state);
  */
 void testCd(void **state);
 
+/*!
+ \brief Test running commands in parallel with ordered output
+ */
+void testParallel(void **state);
+
+/*!
+ \brief Test echo and its options
+ */
+void testEcho(void **state);
+
+/*!
+ \brief Test printf conversions and reuse of the format
+ */
+void testPrintf(void **state);
+
+/*!
+ \brief Test evaluating conditional expressions
+ */
+void testTest(void **state);
+
+/*!
+ \brief Test reading lines into variables from files and pipes
+ */
+void testRead(void **state);
+
+/*!
+ \brief Test setting resource limits with the builtin and attributes
+ */
+void testUlimit(void **state);
+
+/*!
+ \brief Test signalling commands which outlive their duration
+ */
+void testTimeout(void **state);
+
 /*! \} */
@@ -113,6 +113,10 @@ void testCommandIsBuiltin(void **state)
 	commandSetPath(command, "pwd");
 	assert_true(commandIsBuiltIn(command));
 	commandSetPath(command, "echo");
+	assert_true(commandIsBuiltIn(command));
+	commandSetPath(command, "[");
+	assert_true(commandIsBuiltIn(command));
+	commandSetPath(command, "sort");
 	assert_false(commandIsBuiltIn(command));
 	commandFree(command);
 }
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmockery.h>
+#include "test_expansion.h"
+#include "expansion.h"
+#include "variables.h"
+
+void testExpansionExpandWords(void **state)
+{
+	char *words[] = {"echo", "'a b'", "\"c\"d", "e\\ f", "'/*'", "/[e]tc", "/nonexistent*", NULL};
+	char **arguments;
+	int count;
+
+	arguments = expansionExpandWords(words, &count);
+	assert_true(arguments != NULL);
+	assert_int_equal(count, 7);
+	assert_string_equal(arguments[1], "a b");
+	assert_string_equal(arguments[2], "cd");
+	assert_string_equal(arguments[3], "e f");
+	/* Quoted pattern characters match literally */
+	assert_string_equal(arguments[4], "/*");
+	assert_string_equal(arguments[5], "/etc");
+	/* Patterns without matches are kept */
+	assert_string_equal(arguments[6], "/nonexistent*");
+	assert_true(arguments[7] == NULL);
+	expansionFree(arguments);
+}
+
+void testExpansionParameters(void **state)
+{
+	char *words[] = {"$a", "\"$a\"", "'$a'", "x${a}y", "$unset", "\"$1\"", "$#", NULL};
+	char *positional[] = {"mush", "first"};
+	char **arguments;
+	char *string;
+	int count;
+
+	variableSet("a", "1 2");
+	variablesSetPositional(2, positional);
+	arguments = expansionExpandWords(words, &count);
+	assert_true(arguments != NULL);
+	/* Unquoted values are split, unset ones vanish */
+	assert_int_equal(count, 8);
+	assert_string_equal(arguments[0], "1");
+	assert_string_equal(arguments[1], "2");
+	assert_string_equal(arguments[2], "1 2");
+	assert_string_equal(arguments[3], "$a");
+	assert_string_equal(arguments[4], "x1");
+	assert_string_equal(arguments[5], "2y");
+	assert_string_equal(arguments[6], "first");
+	assert_string_equal(arguments[7], "1");
+	expansionFree(arguments);
+
+	string = expansionExpandString("'*'$a", 1);
+	assert_string_equal(string, "\\*1 2");
+	free(string);
+}
+
+void testExpansionOperators(void **state)
+{
+	char *words[] = {"${path##*/}", "${path%.*}", "${path#*/}", "${path%%/*}",
+		"\"${text/o/0}\"", "\"${text//o/0}\"", "\"${text/#h/H}\"", "\"${text/%d/D}\"",
+		"${#text}", "\"${text:6}\"", "\"${text:0:5}\"", "\"${text: -3}\"", "\"${text^^}\"",
+		"${text/ /_}", "${unset:-${other:-nested}}", "${unset-a}${path+b}${unset:+c}",
+		NULL};
+	char *assign[] = {"${assigned:=value}", "$assigned", NULL};
+	char *error[] = {"${unset:?}", NULL};
+	char **arguments;
+	int count;
+
+	variableSet("path", "a/b/c.txt");
+	variableSet("text", "hello world");
+	arguments = expansionExpandWords(words, &count);
+	assert_true(arguments != NULL);
+	assert_int_equal(count, 16);
+	/* Prefixes and suffixes matching a pattern are removed */
+	assert_string_equal(arguments[0], "c.txt");
+	assert_string_equal(arguments[1], "a/b/c");
+	assert_string_equal(arguments[2], "b/c.txt");
+	assert_string_equal(arguments[3], "a");
+	/* Matches are replaced once, everywhere, or when anchored */
+	assert_string_equal(arguments[4], "hell0 world");
+	assert_string_equal(arguments[5], "hell0 w0rld");
+	assert_string_equal(arguments[6], "Hello world");
+	assert_string_equal(arguments[7], "hello worlD");
+	assert_string_equal(arguments[8], "11");
+	assert_string_equal(arguments[9], "world");
+	assert_string_equal(arguments[10], "hello");
+	assert_string_equal(arguments[11], "rld");
+	assert_string_equal(arguments[12], "HELLO WORLD");
+	/* Blanks in the operator do not split the word */
+	assert_string_equal(arguments[13], "hello_world");
+	assert_string_equal(arguments[14], "nested");
+	assert_string_equal(arguments[15], "ab");
+	expansionFree(arguments);
+
+	/* Assigning a default sets the variable */
+	arguments = expansionExpandWords(assign, &count);
+	assert_true(arguments != NULL);
+	assert_int_equal(count, 2);
+	assert_string_equal(arguments[0], "value");
+	assert_string_equal(arguments[1], "value");
+	expansionFree(arguments);
+
+	/* An unset parameter with ? is an error */
+	assert_true(expansionExpandWords(error, &count) == NULL);
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmockery.h>
+#include "test_functions.h"
+#include "functions.h"
+#include "alias.h"
+#include "script.h"
+#include "parser.h"
+#include "exec.h"
+#include "mush_error.h"
+#include "variables.h"
+
+static int _execute(const char *source)
+{
+	queue_t *commands;
+	script_t *script;
+	char *input = strdup(source);
+	int status;
+	commands = commandQueueFromInput(input);
+	free(input);
+	assert_true(commands != NULL);
+	script = scriptCompile(commands);
+	queueFree(commands);
+	if(script == NULL) {
+		return mushError();
+	}
+	status = scriptExecute(script);
+	scriptFree(script);
+	return status;
+}
+
+void testFunctionCall(void **state)
+{
+	char *positional[] = {"mush", "outer"};
+	function_t *function;
+
+	variablesSetPositional(2, positional);
+	assert_int_equal(_execute("setter() { value=$1; count=$#; }"), kMushNoError);
+	function = functionLookup("setter");
+	assert_true(function != NULL);
+	/* The definition outlives the script which compiled it */
+	assert_int_equal(_execute("setter a b"), kMushNoError);
+	assert_string_equal(variableGet("value"), "a");
+	assert_string_equal(variableGet("count"), "2");
+	assert_string_equal(variablePositional(1), "outer");
+
+	/* "return" leaves the function, and loops within it */
+	assert_int_equal(_execute("early () {\n"
+		"for i in 1 2 3; do reached=$i; test $i = 2 && return 7; done\n"
+		"reached=end\n"
+		"}\n"
+		"early"), kMushNoError);
+	assert_string_equal(variableGet("reached"), "2");
+	assert_int_equal(executeLastStatus(), 7);
+
+	/* A function may redefine itself while it runs */
+	assert_int_equal(_execute("once() { calls=first; once() { calls=again; }; }; once; once"),
+		kMushNoError);
+	assert_string_equal(variableGet("calls"), "again");
+
+	assert_int_equal(_execute("open() { true;"), kMushIncompleteInputError);
+	assert_int_equal(_execute("}"), kMushParseError);
+}
+
+void testAliasExpansion(void **state)
+{
+	alias_t *alias;
+
+	assert_int_equal(aliasDefine("assign", "setter \"two words\" x"), 0);
+	alias = aliasLookup("assign");
+	assert_true(alias != NULL);
+	assert_string_equal(alias->words[0], "setter");
+	assert_string_equal(alias->words[1], "\"two words\"");
+	assert_true(alias->words[3] == NULL);
+
+	/* Aliases are resolved before functions, with the remaining arguments */
+	assert_int_equal(_execute("setter() { value=$1; count=$#; }; assign y"), kMushNoError);
+	assert_string_equal(variableGet("value"), "two words");
+	assert_string_equal(variableGet("count"), "3");
+
+	assert_int_equal(aliasRemove("assign"), 0);
+	assert_true(aliasLookup("assign") == NULL);
+	assert_int_equal(aliasRemove("assign"), -1);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmockery.h>
+#include <unistd.h>
+#include "test_heredoc.h"
+#include "heredoc.h"
+
+static char *_readAll(int fd, size_t size)
+{
+	char *buffer = malloc(size + 1);
+	size_t length = 0;
+	ssize_t count;
+	while(length < size && (count = read(fd, buffer + length, size - length)) > 0) {
+		length += count;
+	}
+	buffer[length] = '\0';
+	return buffer;
+}
+
+void testHereDocumentDescriptor(void **state)
+{
+	char *contents;
+	char *buffer;
+	size_t size = 256 * 1024;
+	int fd;
+
+	fd = hereDocumentDescriptor("small\n");
+	assert_true(fd != -1);
+	buffer = _readAll(fd, 16);
+	assert_string_equal(buffer, "small\n");
+	free(buffer);
+	close(fd);
+
+	/* Larger than a pipe can hold without a reader */
+	contents = malloc(size + 1);
+	memset(contents, 'x', size);
+	contents[size] = '\0';
+	fd = hereDocumentDescriptor(contents);
+	assert_true(fd != -1);
+	buffer = _readAll(fd, size);
+	assert_int_equal(strlen(buffer), size);
+	assert_true(strcmp(buffer, contents) == 0);
+	free(buffer);
+	free(contents);
+	close(fd);
+}
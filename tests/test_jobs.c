@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmockery.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <limits.h>
+#include <sys/wait.h>
+#include "test_jobs.h"
+#include "jobs.h"
+#include "parser.h"
+#include "exec.h"
+
+void testJobsSlotLimit(void **state)
+{
+	jobsSetSlotLimit(3);
+	assert_int_equal(jobsSlotLimit(), 3);
+	/* Derived from the processors, which always leaves one slot */
+	jobsSetSlotLimit(0);
+	assert_true(jobsSlotLimit() >= 1);
+}
+
+void testJobsSubmit(void **state)
+{
+	job_t *first;
+	job_t *second;
+	int attempts;
+
+	jobsSetSlotLimit(1);
+	first = jobsSubmit(commandQueueFromInput("sleep 0.1 &"));
+	second = jobsSubmit(commandQueueFromInput("sleep 0 &"));
+	assert_true(first != NULL);
+	assert_true(second != NULL);
+	assert_int_equal(first->state, kJobStateRunning);
+	assert_int_equal(second->state, kJobStateQueued);
+	assert_string_equal(second->description, "sleep 0");
+	/* The second job starts once the first one terminated */
+	for(attempts = 0; attempts < 100 && second->state != kJobStateDone; attempts++) {
+		usleep(20000);
+		jobsReap();
+	}
+	assert_int_equal(first->state, kJobStateDone);
+	assert_int_equal(second->state, kJobStateDone);
+	jobsNotify();
+}
+
+void testJobsWait(void **state)
+{
+	char *waitAll[] = {"wait", NULL};
+	char *waitSecond[] = {"wait", NULL, NULL};
+	char identifier[16];
+	char before[PATH_MAX];
+	char after[PATH_MAX];
+	job_t *first;
+	job_t *second;
+	queue_t *commands;
+
+	jobsSetSlotLimit(1);
+	first = jobsSubmit(commandQueueFromInput("sleep 0.1 &"));
+	second = jobsSubmit(commandQueueFromInput("false &"));
+	assert_int_equal(second->state, kJobStateQueued);
+	/* Waiting for a queued job starts it once a slot is free */
+	snprintf(identifier, sizeof(identifier), "%%%d", second->identifier);
+	waitSecond[1] = identifier;
+	assert_int_equal(cmd_wait(2, waitSecond), 1);
+	assert_int_equal(first->state, kJobStateDone);
+	assert_int_equal(second->state, kJobStateDone);
+	waitSecond[1] = "%999";
+	assert_int_equal(cmd_wait(2, waitSecond), 127);
+	jobsNotify();
+
+	/* Builtins changing the shell run in a child when run in the background */
+	assert_true(getcwd(before, sizeof(before)) != NULL);
+	commands = commandQueueFromInput("sleep 0.1 & cd / &");
+	executeCommandsInQueue(commands);
+	queueFree(commands);
+	assert_int_equal(cmd_wait(1, waitAll), 0);
+	assert_true(getcwd(after, sizeof(after)) != NULL);
+	assert_string_equal(after, before);
+	jobsNotify();
+}
+
+void testJobsFinal(void **state)
+{
+	queue_t *commands;
+	pid_t pid;
+	int status;
+
+	/* The last program only replaces the shell once no job is pending */
+	fflush(NULL);
+	pid = fork();
+	if(pid == 0) {
+		jobsSetSlotLimit(1);
+		jobsSubmit(commandQueueFromInput("sleep 0.1 &"));
+		commands = commandQueueFromInput("sh -c 'exit 3'");
+		executeFinal(commands);
+		_exit(executeLastStatus() == 3 ? 42 : 1);
+	}
+	assert_true(pid > 0);
+	assert_int_equal(waitpid(pid, &status, 0), pid);
+	assert_true(WIFEXITED(status));
+	assert_int_equal(WEXITSTATUS(status), 42);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmockery.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "test_launcher.h"
+#include "launcher.h"
+#include "redirection.h"
+
+void testLauncherSpawn(void **state)
+{
+	char *argv[] = {"sh", "-c", "echo launched >&3; exit 3", NULL};
+	char *limitArgv[] = {"sh", "-c", "echo $(ulimit -c) $(umask) >&3", NULL};
+	struct rlimit limit;
+	struct rlimit saved;
+	mode_t mask;
+	queue_t *redirections;
+	char buffer[16] = {0};
+	int pipeDescriptors[2];
+	int status;
+	pid_t pid;
+
+	assert_int_equal(launcherStart(), 0);
+	assert_true(launcherIsRunning());
+	assert_int_equal(redirectionPipe(pipeDescriptors), 0);
+	redirections = queueNew();
+	queueInsert(redirections, redirectionNewDuplicate(3, pipeDescriptors[1]),
+		(queueNodeFreeFunction)redirectionFree);
+	pid = launcherSpawn(argv, redirections);
+	queueFree(redirections);
+	close(pipeDescriptors[1]);
+	assert_true(pid > 0);
+	/* The process is a child of the caller, not of the launcher */
+	assert_int_equal(waitpid(pid, &status, 0), pid);
+	assert_true(WIFEXITED(status));
+	assert_int_equal(WEXITSTATUS(status), 3);
+	assert_true(read(pipeDescriptors[0], buffer, sizeof(buffer) - 1) > 0);
+	assert_string_equal(buffer, "launched\n");
+	close(pipeDescriptors[0]);
+
+	/* Limits and the mask changed after the launcher started still apply */
+	assert_int_equal(getrlimit(RLIMIT_CORE, &limit), 0);
+	saved = limit;
+	limit.rlim_cur = 0;
+	assert_int_equal(setrlimit(RLIMIT_CORE, &limit), 0);
+	mask = umask(027);
+	assert_int_equal(redirectionPipe(pipeDescriptors), 0);
+	redirections = queueNew();
+	queueInsert(redirections, redirectionNewDuplicate(3, pipeDescriptors[1]),
+		(queueNodeFreeFunction)redirectionFree);
+	pid = launcherSpawn(limitArgv, redirections);
+	queueFree(redirections);
+	close(pipeDescriptors[1]);
+	umask(mask);
+	setrlimit(RLIMIT_CORE, &saved);
+	assert_true(pid > 0);
+	assert_int_equal(waitpid(pid, &status, 0), pid);
+	memset(buffer, 0, sizeof(buffer));
+	assert_true(read(pipeDescriptors[0], buffer, sizeof(buffer) - 1) > 0);
+	assert_string_equal(buffer, "0 0027\n");
+	close(pipeDescriptors[0]);
+	launcherStop();
+	assert_false(launcherIsRunning());
+}
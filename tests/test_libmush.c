@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmockery.h>
+#include <pthread.h>
+#include "test_libmush.h"
+#include "libmush.h"
+#include "variables.h"
+
+/*! \brief Amount of threads parsing at once */
+#define THREAD_COUNT 4
+
+/*!
+ \brief Parse valid and incomplete input alternately with a context of the
+ thread's own
+ \return \c NULL if every outcome was as expected
+ */
+static void *_parseRepeatedly(void *argument)
+{
+	mush_context_t *context = mushContextNew();
+	script_t *script;
+	void *result = NULL;
+	int iteration;
+	for(iteration = 0; iteration < 200 && result == NULL; iteration++) {
+		script = mushContextParse(context, "for i in 1 2; do echo $i | cat; done");
+		if(script == NULL || context->error != kMushNoError) {
+			result = argument;
+		}
+		scriptFree(script);
+		script = mushContextParse(context, "while true; do");
+		if(script != NULL || context->error != kMushIncompleteInputError
+		|| context->errorDescription == NULL) {
+			result = argument;
+		}
+	}
+	mushContextFree(context);
+	return result;
+}
+
+void testContextParse(void **state)
+{
+	mush_context_t *context = mushContextNew();
+	pthread_t threads[THREAD_COUNT];
+	script_t *script;
+	void *result;
+	int index;
+	assert_true(context != NULL);
+
+	script = mushContextParse(context, "if true; then echo a; fi");
+	assert_true(script != NULL);
+	assert_int_equal(context->error, kMushNoError);
+	assert_true(context->errorDescription == NULL);
+	scriptFree(script);
+	assert_true(mushContextParse(context, "case a in") == NULL);
+	assert_int_equal(context->error, kMushIncompleteInputError);
+	assert_true(context->errorDescription != NULL);
+
+	/* The errors of one thread do not show up in another */
+	for(index = 0; index < THREAD_COUNT; index++) {
+		assert_int_equal(pthread_create(&threads[index], NULL, _parseRepeatedly, context), 0);
+	}
+	for(index = 0; index < THREAD_COUNT; index++) {
+		assert_int_equal(pthread_join(threads[index], &result), 0);
+		assert_true(result == NULL);
+	}
+
+	assert_int_equal(mushProcessRun(context, "libmush_x=5; test $libmush_x = 5"), 0);
+	assert_string_equal(variableGet("libmush_x"), "5");
+	assert_int_equal(mushProcessRun(context, "test 1 = 2"), 1);
+	assert_int_equal(context->status, 1);
+	assert_int_equal(mushProcessRun(context, "for"), -1);
+
+	/* The script ends, rather than the process running the tests */
+	assert_int_equal(mushProcessRun(context, "libmush_y=0; exit 7; libmush_y=1"), 7);
+	assert_int_equal(context->status, 7);
+	assert_string_equal(variableGet("libmush_y"), "0");
+	assert_int_equal(mushProcessRun(context, "libmush_f() { exit 3; }; "
+		"while true; do libmush_f; libmush_y=2; done; libmush_y=3"), 3);
+	assert_string_equal(variableGet("libmush_y"), "0");
+	assert_int_equal(mushProcessRun(context, "exec sh -c 'exit 5'; libmush_y=4"), 5);
+	assert_string_equal(variableGet("libmush_y"), "0");
+	assert_int_equal(mushProcessRun(context, "(exit 6)"), 6);
+	assert_int_equal(mushProcessRun(context, "exec 3< /dev/null"), 1);
+	assert_int_equal(mushProcessRun(context, "test 1 = 1"), 0);
+	mushContextFree(context);
+}
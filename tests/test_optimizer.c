@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmockery.h>
+#include "test_optimizer.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "command.h"
+
+void testOptimizeCommandQueue(void **state)
+{
+	queue_t *commands;
+	command_t *command;
+	redirection_t *redirection;
+
+	/* The file becomes the input of the next command as the pipeline runs */
+	commands = commandQueueFromInput("cat Makefile | wc -l");
+	assert_true(commands != NULL);
+	optimizeCommandQueue(commands);
+	assert_int_equal(queueCount(commands), 2);
+	command = commands->head->data;
+	assert_int_equal(command->isInputPassed, 1);
+	assert_int_equal(command->isOutputCaptured, 0);
+	command = commands->head->next->data;
+	assert_int_equal(command->isInputPassed, 0);
+	queueFree(commands);
+
+	/* Commands which run in the shell when alone stay piped */
+	commands = commandQueueFromInput("cat Makefile | exec wc -l");
+	optimizeCommandQueue(commands);
+	assert_int_equal(queueCount(commands), 2);
+	command = commands->head->data;
+	assert_int_equal(command->isInputPassed, 0);
+	queueFree(commands);
+
+	/* Builtins write into a capture file instead of a pipe */
+	commands = commandQueueFromInput("echo a | wc -c");
+	optimizeCommandQueue(commands);
+	assert_int_equal(queueCount(commands), 2);
+	command = commands->head->data;
+	assert_int_equal(command->isOutputCaptured, 1);
+	command = commands->head->next->data;
+	assert_int_equal(command->isOutputCaptured, 0);
+	queueFree(commands);
+
+	/* Output which is discarded is not produced */
+	commands = commandQueueFromInput("echo a > /dev/null; test -d / 2>&1 > /dev/null");
+	optimizeCommandQueue(commands);
+	assert_int_equal(queueCount(commands), 2);
+	command = commands->head->data;
+	assert_string_equal(command->argv[0], "true");
+	assert_int_equal(command->argc, 1);
+	assert_int_equal(queueCount(command->redirections), 0);
+	command = commands->head->next->data;
+	assert_int_equal(queueCount(command->redirections), 1);
+	redirection = command->redirections->head->data;
+	assert_int_equal(redirection->action, kRedirectionActionDuplicate);
+	queueFree(commands);
+
+	/* Arguments are still expanded for their side effects */
+	commands = commandQueueFromInput("echo $((x += 1)) > /dev/null");
+	optimizeCommandQueue(commands);
+	command = commands->head->data;
+	assert_string_equal(command->argv[0], "echo");
+	assert_int_equal(queueCount(command->redirections), 1);
+	queueFree(commands);
+}
@@ -28,6 +28,8 @@
 #include "queue.h"
 #include "parser.h"
 #include "command.h"
+#include "mush_error.h"
+#include <fcntl.h>
 
 void testParseSingleCommand(void **state)
 {
@@ -124,6 +126,53 @@ void testParseTerminators(void **state)
 	queueFree(commands);
 }
 
+void testParseConditionalConnections(void **state)
+{
+	char *input;
+	queue_t *commands;
+	command_t *command;
+
+	input = "test -f x && echo y || echo n";
+	commands = commandQueueFromInput(input);
+	assert_int_equal(queueCount(commands), 3);
+	queueRemove(commands, (void *)&command);
+	assert_int_equal(command->connectionMask, kCommandConnectionAnd);
+	assert_int_equal(command->argc, 3);
+	commandFree(command);
+	queueRemove(commands, (void *)&command);
+	assert_int_equal(command->connectionMask, kCommandConnectionOr);
+	assert_string_equal(command->argv[1], "y");
+	commandFree(command);
+	queueRemove(commands, (void *)&command);
+	assert_int_equal(command->connectionMask, kCommandConnectionNone);
+	commandFree(command);
+	queueFree(commands);
+
+	input = "true &&";
+	commands = commandQueueFromInput(input);
+	assert_true(commands == NULL); /* parse error */
+
+	/* A fan-out is not an or-list */
+	input = "seq 3 |+ wc -l|+md5sum";
+	commands = commandQueueFromInput(input);
+	assert_int_equal(queueCount(commands), 3);
+	queueRemove(commands, (void *)&command);
+	assert_int_equal(command->connectionMask, kCommandConnectionFanOut);
+	commandFree(command);
+	queueRemove(commands, (void *)&command);
+	assert_int_equal(command->connectionMask, kCommandConnectionFanOut);
+	assert_int_equal(command->argc, 2);
+	commandFree(command);
+	queueRemove(commands, (void *)&command);
+	assert_string_equal(command->argv[0], "md5sum");
+	commandFree(command);
+	queueFree(commands);
+
+	input = "seq 3 |+";
+	commands = commandQueueFromInput(input);
+	assert_true(commands == NULL);
+}
+
 void testParseRedirection(void **state)
 {
 	char *input;
@@ -158,4 +207,132 @@ void testParseRedirection(void **state)
 	assert_true(commands == NULL); /* parse error */
 }
 
+void testParseDescriptorRedirection(void **state)
+{
+	char *input = "make >> log 2>&1 3<> data 4>&- 5< input";
+	queue_t *commands;
+	command_t *command;
+	redirection_t *redirection;
+
+	commands = commandQueueFromInput(input);
+	queueRemove(commands, (void *)&command);
+	assert_int_equal(command->argc, 1);
+	assert_int_equal(queueCount(command->redirections), 5);
+	queueRemove(command->redirections, (void *)&redirection);
+	assert_int_equal(redirection->action, kRedirectionActionOpen);
+	assert_int_equal(redirection->descriptor, 1);
+	assert_string_equal(redirection->path, "log");
+	assert_int_equal(redirection->flags, O_WRONLY | O_CREAT | O_APPEND);
+	redirectionFree(redirection);
+	queueRemove(command->redirections, (void *)&redirection);
+	assert_int_equal(redirection->action, kRedirectionActionDuplicate);
+	assert_int_equal(redirection->descriptor, 2);
+	assert_int_equal(redirection->sourceDescriptor, 1);
+	redirectionFree(redirection);
+	queueRemove(command->redirections, (void *)&redirection);
+	assert_int_equal(redirection->descriptor, 3);
+	assert_int_equal(redirection->flags, O_RDWR | O_CREAT);
+	redirectionFree(redirection);
+	queueRemove(command->redirections, (void *)&redirection);
+	assert_int_equal(redirection->action, kRedirectionActionClose);
+	assert_int_equal(redirection->descriptor, 4);
+	redirectionFree(redirection);
+	queueRemove(command->redirections, (void *)&redirection);
+	assert_int_equal(redirection->descriptor, 5);
+	assert_int_equal(redirection->flags, O_RDONLY);
+	redirectionFree(redirection);
+	/* The standard input was not redirected */
+	assert_true(command->redirectFromPath == NULL);
+	commandFree(command);
+	queueFree(commands);
+
+	input = "echo a 2>&file";
+	commands = commandQueueFromInput(input);
+	assert_true(commands == NULL);
+}
+
+void testParseHereDocument(void **state)
+{
+	char *input;
+	queue_t *commands;
+	command_t *command;
+
+	input = "cat <<EOF\nline one\n  line two\nEOF\necho done";
+	commands = commandQueueFromInput(input);
+	assert_int_equal(queueCount(commands), 2);
+	queueRemove(commands, (void *)&command);
+	assert_string_equal(command->path, "cat");
+	assert_string_equal(command->hereDocument, "line one\n  line two\n");
+	assert_true(command->hereDocumentDelimiter == NULL);
+	commandFree(command);
+	queueRemove(commands, (void *)&command);
+	assert_string_equal(command->path, "echo");
+	commandFree(command);
+	queueFree(commands);
+
+	input = "cat <<-'EOF'\n\tindented\n\tEOF";
+	commands = commandQueueFromInput(input);
+	queueRemove(commands, (void *)&command);
+	assert_string_equal(command->hereDocument, "indented\n");
+	commandFree(command);
+	queueFree(commands);
+
+	/* Here-documents are read in order once the command line ends */
+	input = "cat <<A | cat <<B\na\nA\nb\nB";
+	commands = commandQueueFromInput(input);
+	assert_int_equal(queueCount(commands), 2);
+	queueRemove(commands, (void *)&command);
+	assert_string_equal(command->hereDocument, "a\n");
+	commandFree(command);
+	queueRemove(commands, (void *)&command);
+	assert_string_equal(command->hereDocument, "b\n");
+	commandFree(command);
+	queueFree(commands);
+
+	input = "cat <<EOF\nunterminated";
+	commands = commandQueueFromInput(input);
+	assert_true(commands == NULL);
+	assert_int_equal(mushError(), kMushIncompleteInputError);
+}
+
+void testParseHereString(void **state)
+{
+	char *input = "cat <<< 'a string' > output";
+	queue_t *commands;
+	command_t *command;
+
+	commands = commandQueueFromInput(input);
+	queueRemove(commands, (void *)&command);
+	/* The word is expanded as the command runs */
+	assert_string_equal(command->hereDocument, "'a string'");
+	assert_true(command->isHereString);
+	assert_string_equal(command->redirectToPath, "output");
+	commandFree(command);
+	queueFree(commands);
+}
+
+void testParseProcessSubstitution(void **state)
+{
+	char input[] = "diff <(sort \"a b\") >(cat) < <(echo ')')";
+	queue_t *commands;
+	command_t *command;
+	redirection_t *redirection;
+
+	commands = commandQueueFromInput(input);
+	assert_true(commands != NULL);
+	assert_int_equal(queueCount(commands), 1);
+	command = commands->head->data;
+	assert_int_equal(command->argc, 3);
+	/* The commands are kept as written, to be parsed once they run */
+	assert_string_equal(command->argv[1], "<(sort \"a b\")");
+	assert_string_equal(command->argv[2], ">(cat)");
+	redirection = command->redirections->head->data;
+	assert_string_equal(redirection->path, "<(echo ')')");
+	queueFree(commands);
+
+	commands = commandQueueFromInput("cat <(echo a");
+	assert_true(commands == NULL);
+	assert_int_equal(mushError(), kMushIncompleteInputError);
+}
+
 /* TODO: Test quotes */
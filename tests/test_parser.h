@@ -39,9 +39,34 @@ void testParseMultipleCommands(void **state);
  */
 void testParseTerminators(void **state);
 
+/*!
+ \brief Test parsing the "&&" and "||" connections
+ */
+void testParseConditionalConnections(void **state);
+
 /*!
  \brief Test proper allocation of redirection paths
  */
 void testParseRedirection(void **state);
 
+/*!
+ \brief Test parsing of redirections of explicit descriptors
+ */
+void testParseDescriptorRedirection(void **state);
+
+/*!
+ \brief Test parsing of here-documents and their contents
+ */
+void testParseHereDocument(void **state);
+
+/*!
+ \brief Test parsing of here-strings
+ */
+void testParseHereString(void **state);
+
+/*!
+ \brief Test parsing of process substitutions as words and redirections
+ */
+void testParseProcessSubstitution(void **state);
+
 /*! \} */
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmockery.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "test_redirection.h"
+#include "redirection.h"
+#include "queue.h"
+
+void testRedirectionNew(void **state)
+{
+	char *path = "output";
+	redirection_t *redirection;
+
+	redirection = redirectionNewOpen(2, path, O_WRONLY | O_APPEND);
+	assert_int_equal(redirection->action, kRedirectionActionOpen);
+	assert_int_equal(redirection->descriptor, 2);
+	assert_string_equal(redirection->path, path);
+	assert_true(redirection->path != path);
+	assert_int_equal(redirection->flags, O_WRONLY | O_APPEND);
+	redirectionFree(redirection);
+
+	redirection = redirectionNewDuplicate(2, 1);
+	assert_int_equal(redirection->action, kRedirectionActionDuplicate);
+	assert_int_equal(redirection->descriptor, 2);
+	assert_int_equal(redirection->sourceDescriptor, 1);
+	redirectionFree(redirection);
+
+	redirection = redirectionNewClose(3);
+	assert_int_equal(redirection->action, kRedirectionActionClose);
+	assert_int_equal(redirection->descriptor, 3);
+	redirectionFree(redirection);
+}
+
+void testRedirectionsApply(void **state)
+{
+	queue_t *redirections = queueNew();
+	int pipeDescriptors[2];
+	/* High descriptors, so those of the test runner are left alone */
+	int descriptor = 40;
+	int duplicate = 41;
+	char buffer[8];
+
+	assert_int_equal(redirectionPipe(pipeDescriptors), 0);
+	queueInsert(redirections, redirectionNewDuplicate(descriptor, pipeDescriptors[1]),
+		(queueNodeFreeFunction)redirectionFree);
+	queueInsert(redirections, redirectionNewDuplicate(duplicate, descriptor),
+		(queueNodeFreeFunction)redirectionFree);
+	queueInsert(redirections, redirectionNewClose(descriptor),
+		(queueNodeFreeFunction)redirectionFree);
+	assert_true(redirectionsApply(redirections) == NULL);
+	/* The duplicate survives exec, unlike the original pipe */
+	assert_int_equal(fcntl(duplicate, F_GETFD) & FD_CLOEXEC, 0);
+	assert_int_equal(fcntl(descriptor, F_GETFD), -1);
+	assert_int_equal(write(duplicate, "abc", 3), 3);
+	close(duplicate);
+	close(pipeDescriptors[1]);
+	assert_int_equal(read(pipeDescriptors[0], buffer, sizeof(buffer)), 3);
+	assert_true(memcmp(buffer, "abc", 3) == 0);
+	close(pipeDescriptors[0]);
+	queueFree(redirections);
+
+	redirections = queueNew();
+	queueInsert(redirections, redirectionNewOpen(descriptor, "/nonexistent/file", O_RDONLY),
+		(queueNodeFreeFunction)redirectionFree);
+	assert_true(redirectionsApply(redirections) == redirections->head->data);
+	queueFree(redirections);
+}
+
+void testRedirectionPipe(void **state)
+{
+	int pipeDescriptors[2];
+	int descriptor;
+	assert_int_equal(redirectionPipe(pipeDescriptors), 0);
+	assert_true(fcntl(pipeDescriptors[0], F_GETFD) & FD_CLOEXEC);
+	assert_true(fcntl(pipeDescriptors[1], F_GETFD) & FD_CLOEXEC);
+	close(pipeDescriptors[0]);
+	close(pipeDescriptors[1]);
+
+	/* Descriptors of the shell are kept out of the way of scripts */
+	assert_int_equal(dup2(STDIN_FILENO, 9), 9);
+	descriptor = redirectionMoveAside(9);
+	assert_true(descriptor >= 10);
+	assert_true(fcntl(descriptor, F_GETFD) & FD_CLOEXEC);
+	assert_int_equal(fcntl(9, F_GETFD), -1);
+	close(descriptor);
+}
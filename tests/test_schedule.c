@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmockery.h>
+#include <stdio.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include "test_schedule.h"
+#include "schedule.h"
+
+void testScheduleApply(void **state)
+{
+	cpu_set_t original;
+	cpu_set_t applied;
+	char attribute[32];
+	int cpu;
+
+	assert_true(scheduleIsAttribute("@nice=5"));
+	assert_true(scheduleIsAttribute("@cpus="));
+	assert_false(scheduleIsAttribute("nice=5"));
+	assert_false(scheduleIsAttribute("@5=nice"));
+	assert_false(scheduleIsAttribute("@nice"));
+
+	/* Restating the current niceness leaves the test runner as it was */
+	errno = 0;
+	snprintf(attribute, sizeof(attribute), "nice=%d", getpriority(PRIO_PROCESS, 0));
+	assert_int_equal(errno, 0);
+	assert_int_equal(scheduleApply(attribute), 0);
+
+	/* The runner is restricted to the first CPU it may run on, then restored */
+	assert_int_equal(sched_getaffinity(0, sizeof(original), &original), 0);
+	for(cpu = 0; !CPU_ISSET(cpu, &original); cpu++) {
+	}
+	snprintf(attribute, sizeof(attribute), "cpus=%d", cpu);
+	assert_int_equal(scheduleApply(attribute), 0);
+	assert_int_equal(sched_getaffinity(0, sizeof(applied), &applied), 0);
+	assert_int_equal(CPU_COUNT(&applied), 1);
+	assert_true(CPU_ISSET(cpu, &applied));
+	assert_int_equal(sched_setaffinity(0, sizeof(original), &original), 0);
+
+	assert_int_equal(scheduleApply("io=best-effort:4"), 0);
+
+	/* Malformed values are rejected before anything is applied */
+	assert_int_equal(scheduleApply("cpus=0-"), -1);
+	assert_int_equal(errno, EINVAL);
+	assert_int_equal(scheduleApply("cpus=3-1"), -1);
+	assert_int_equal(scheduleApply("cpus=0,x"), -1);
+	assert_int_equal(scheduleApply("nice=high"), -1);
+	assert_int_equal(scheduleApply("io=fast"), -1);
+	assert_int_equal(scheduleApply("io=be:8"), -1);
+	assert_int_equal(scheduleApply("weight=1"), -1);
+	assert_int_equal(errno, EINVAL);
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmockery.h>
+#include "test_script.h"
+#include "script.h"
+#include "parser.h"
+#include "exec.h"
+#include "mush_error.h"
+#include "variables.h"
+#include "command.h"
+#include "scriptfile.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static script_t *_compile(const char *source)
+{
+	queue_t *commands;
+	script_t *script;
+	char *input = strdup(source);
+	commands = commandQueueFromInput(input);
+	free(input);
+	if(commands == NULL) {
+		return NULL;
+	}
+	script = scriptCompile(commands);
+	queueFree(commands);
+	return script;
+}
+
+static void _execute(const char *source)
+{
+	script_t *script = _compile(source);
+	assert_true(script != NULL);
+	assert_int_equal(scriptExecute(script), kMushNoError);
+	scriptFree(script);
+}
+
+void testScriptCompile(void **state)
+{
+	script_t *script;
+
+	script = _compile("if true; then a; else b; fi");
+	assert_true(script != NULL);
+	assert_int_equal(script->pipelineCount, 3);
+	assert_int_equal(script->instructionCount, 5);
+	assert_int_equal(script->instructions[0].opcode, kScriptOpRun);
+	assert_int_equal(script->instructions[1].opcode, kScriptOpJumpIfFailed);
+	assert_int_equal(script->instructions[1].target, 4);
+	assert_int_equal(script->instructions[3].opcode, kScriptOpJump);
+	assert_int_equal(script->instructions[3].target, 5);
+	scriptFree(script);
+
+	/* The body of a loop is only compiled once */
+	script = _compile("for i in a b c\ndo\n\tx\ndone");
+	assert_true(script != NULL);
+	assert_int_equal(script->pipelineCount, 1);
+	assert_int_equal(script->instructions[0].opcode, kScriptOpForBegin);
+	assert_int_equal(script->instructions[1].opcode, kScriptOpForNext);
+	assert_int_equal(script->instructions[1].target, 4);
+	assert_int_equal(script->instructions[3].target, 1);
+	scriptFree(script);
+
+	/* Unterminated constructs ask for more input */
+	assert_true(_compile("while true; do x") == NULL);
+	assert_int_equal(mushError(), kMushIncompleteInputError);
+	assert_true(_compile("then x") == NULL);
+	assert_int_equal(mushError(), kMushParseError);
+}
+
+void testScriptExecute(void **state)
+{
+	script_t *script;
+
+	_execute("r=; for i in 1 2 3; do r=$r$i; done");
+	assert_string_equal(variableGet("r"), "123");
+
+	_execute("r=; for i in 1 2 3; do for j in a b; do "
+		"if test $j = b; then continue; fi; "
+		"if test $i = 3; then break 2; fi; r=$r$i$j; done; done");
+	assert_string_equal(variableGet("r"), "1a2a");
+
+	_execute("v=xyz; case $v in a|x*) r=first;; *) r=second;; esac");
+	assert_string_equal(variableGet("r"), "first");
+	_execute("case '*' in a) r=a;; \\*) r=star;; esac");
+	assert_string_equal(variableGet("r"), "star");
+
+	_execute("false && r=and || r=or");
+	assert_string_equal(variableGet("r"), "or");
+
+	/* A loop whose condition fails right away succeeds */
+	_execute("false; while false; do r=body; done");
+	assert_int_equal(executeLastStatus(), 0);
+	_execute("if false; then r=then; fi");
+	assert_int_equal(executeLastStatus(), 0);
+
+	/* The optimizer is consulted as each pipeline runs */
+	script = _compile("set +o optimize; echo a | wc -c; set -o optimize; echo a | wc -c");
+	assert_true(script != NULL);
+	assert_int_equal(scriptExecute(script), kMushNoError);
+	assert_true(script->optimized != NULL);
+	assert_true(script->optimized[1] == NULL);
+	assert_true(script->optimized[3] != NULL);
+	scriptFree(script);
+}
+
+void testScriptCompound(void **state)
+{
+	script_t *script;
+	command_t *command;
+
+	/* The group is a single command of the pipeline */
+	script = _compile("{ a; b; } | c");
+	assert_true(script != NULL);
+	assert_int_equal(script->pipelineCount, 1);
+	assert_int_equal(queueCount(script->pipelines[0]), 2);
+	assert_true(((command_t *)script->pipelines[0]->head->data)->body != NULL);
+	scriptFree(script);
+	assert_true(_compile("( a ) b") == NULL);
+	assert_int_equal(mushError(), kMushParseError);
+	assert_true(_compile("( a; ( b )") == NULL);
+	assert_int_equal(mushError(), kMushIncompleteInputError);
+
+	/* Groups change the shell, subshells do not */
+	_execute("r=a; { r=b; }; (r=c)");
+	assert_string_equal(variableGet("r"), "b");
+	_execute("r=; (( r=x ) ); ( for i in 1 2; do r=$r$i; done ); { r=$r$?; }");
+	assert_string_equal(variableGet("r"), "0");
+	_execute("r=; case x in (x) r=paren;; esac");
+	assert_string_equal(variableGet("r"), "paren");
+
+	/* Process substitutions are read through a pipe */
+	_execute("r=; read -r r < <(cat <(echo \"a (b)\"))");
+	assert_string_equal(variableGet("r"), "a (b)");
+
+	/* Each branch of a fan-out reads all of the output */
+	_execute("r=; seq 3 |+ cat > /dev/null |+ { read -r a; read -r b; r=$a$b; }");
+	assert_string_equal(variableGet("r"), "12");
+	_execute("echo fan |+ head -c 0 |+ read -r r");
+	assert_string_equal(variableGet("r"), "fan");
+
+	/* Scheduling attributes apply to the whole group */
+	script = _compile("@nice=0 @io=idle { a; } | b");
+	assert_true(script != NULL);
+	command = script->pipelines[0]->head->data;
+	assert_true(command->body != NULL);
+	assert_string_equal(command->attributes[0], "@nice=0");
+	assert_string_equal(command->attributes[1], "@io=idle");
+	assert_true(command->attributes[2] == NULL);
+	scriptFree(script);
+	_execute("@nice=0 read -r r <<< child");
+	assert_true(variableGet("r") == NULL || strcmp(variableGet("r"), "child") != 0);
+
+	/* return leaves the function from within a group */
+	_execute("f() { { r=group; return 3; }; r=after; }; f");
+	assert_string_equal(variableGet("r"), "group");
+	assert_int_equal(executeLastStatus(), 3);
+}
+
+void testScriptRedirection(void **state)
+{
+	char directory[] = "/tmp/mush_redirectionXXXXXX";
+	char path[64];
+	char cwd[4096];
+	script_t *script;
+	assert_true(mkdtemp(directory) != NULL);
+	snprintf(path, sizeof(path), "%s/output", directory);
+	variableSet("f", path);
+
+	/* Targets and here-strings are expanded each time the command runs */
+	_execute("r=; echo expanded > $f; read -r r < \"$f\"");
+	assert_string_equal(variableGet("r"), "expanded");
+	_execute("x='a b'; read -r p q <<< \"$x\"; r=$q$p");
+	assert_string_equal(variableGet("r"), "ba");
+	_execute("read -r r <<< '$x'");
+	assert_string_equal(variableGet("r"), "$x");
+
+	/* Redirections after done, fi and esac apply to the whole construct */
+	_execute("for i in a b; do echo $i; done > $f; r=; while read -r l; do r=$r$l; done < $f");
+	assert_string_equal(variableGet("r"), "ab");
+	_execute("if true; then echo yes; fi > $f; read -r r < $f");
+	assert_string_equal(variableGet("r"), "yes");
+	_execute("case a in a) echo matched;; esac > $f; read -r r < $f");
+	assert_string_equal(variableGet("r"), "matched");
+	_execute("n=0; while read -r l; do n=$((n+1)); break; done < $f; r=$n");
+	assert_string_equal(variableGet("r"), "1");
+
+	/* Loops read their input line by line from a file or a pipe */
+	_execute("printf 'a\\nb\\nc\\n' > $f; n=0; while read -r l; do n=$((n+1)); done < $f; r=$n");
+	assert_string_equal(variableGet("r"), "3");
+	_execute("printf 'a\\nb\\n' | while read -r l; do echo $l$l; done > $f; r=; while read -r l; do r=$r$l; done < $f");
+	assert_string_equal(variableGet("r"), "aabb");
+	_execute("echo a b | for i in 1 2; do read -r l; echo $i$l; done > $f; read -r r < $f");
+	assert_string_equal(variableGet("r"), "1a b");
+
+	/* The file cat passes on is opened in the working directory as it runs */
+	assert_true(getcwd(cwd, sizeof(cwd)) != NULL);
+	assert_int_equal(chdir(directory), 0);
+	script = _compile("cat output | read -r r; cd /; s=x; cat output | read -r s");
+	assert_true(script != NULL);
+	assert_int_equal(scriptExecute(script), kMushNoError);
+	scriptFree(script);
+	assert_int_equal(chdir(cwd), 0);
+	assert_string_equal(variableGet("r"), "1a b");
+	assert_string_equal(variableGet("s"), "");
+
+	unlink(path);
+	rmdir(directory);
+}
+
+static void _writeProgram(const char *path, const char *contents)
+{
+	FILE *file = fopen(path, "w");
+	assert_true(file != NULL);
+	fputs(contents, file);
+	fclose(file);
+	chmod(path, 0755);
+}
+
+void testScriptFileLookup(void **state)
+{
+	char directory[] = "/tmp/mush_scriptXXXXXX";
+	char program[64];
+	char *path = NULL;
+	script_t *script;
+	script_t *cached;
+	char *savedPath = strdup(getenv("PATH"));
+	assert_true(mkdtemp(directory) != NULL);
+	snprintf(program, sizeof(program), "%s/program", directory);
+
+	_writeProgram(program, "#!/bin/sh\necho a\n");
+	assert_true(scriptFileLookup(program, &path) == NULL);
+	_writeProgram(program, "#!/usr/local/bin/notmush\necho a\n");
+	assert_true(scriptFileLookup(program, &path) == NULL);
+
+	/* Scripts are only compiled again once they change */
+	_writeProgram(program, "#! /usr/bin/env mush\necho a\n");
+	script = scriptFileLookup(program, &path);
+	assert_true(script != NULL);
+	assert_string_equal(path, program);
+	free(path);
+	cached = scriptFileLookup(program, &path);
+	assert_true(cached == script);
+	free(path);
+	scriptFree(cached);
+	scriptFree(script);
+	_writeProgram(program, "#!/bin/mush\necho a; echo b\n");
+	script = scriptFileLookup(program, &path);
+	assert_true(script != NULL);
+	assert_int_equal(script->pipelineCount, 2);
+	free(path);
+	scriptFree(script);
+
+	/* Names are found in PATH again once it changes or the program is gone */
+	setenv("PATH", directory, 1);
+	script = scriptFileLookup("program", &path);
+	assert_true(script != NULL);
+	assert_string_equal(path, program);
+	free(path);
+	scriptFree(script);
+	setenv("PATH", "/nonexistent", 1);
+	assert_true(scriptFileLookup("program", &path) == NULL);
+	setenv("PATH", directory, 1);
+	unlink(program);
+	assert_true(scriptFileLookup("program", &path) == NULL);
+	setenv("PATH", savedPath, 1);
+	free(savedPath);
+
+	scriptFileForget();
+	rmdir(directory);
+}
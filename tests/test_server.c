@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmockery.h>
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "test_server.h"
+#include "server.h"
+
+/*!
+ \brief Send \a source and collect the output until the status arrives
+ \return the exit status
+ */
+static int _request(int connection, const char *source, int *descriptors, size_t count,
+	char *output, char *errors)
+{
+	server_header_t header;
+	char *payload;
+	int32_t status = -1;
+	output[0] = '\0';
+	errors[0] = '\0';
+	assert_int_equal(serverSendMessage(connection, kServerMessageCommand, source, strlen(source),
+		descriptors, count), 0);
+	while(serverReceiveMessage(connection, &header, &payload, NULL, NULL) == 0) {
+		if(header.type == kServerMessageOutput) {
+			strcat(output, payload);
+		} else if(header.type == kServerMessageError) {
+			strcat(errors, payload);
+		} else if(header.type == kServerMessageStatus) {
+			memcpy(&status, payload, sizeof(status));
+			free(payload);
+			break;
+		}
+		free(payload);
+	}
+	return status;
+}
+
+void testServerRequest(void **state)
+{
+	char directory[] = "/tmp/mush_serverXXXXXX";
+	char output[256];
+	char errors[256];
+	struct sockaddr_un address;
+	int descriptors[2];
+	int pipeDescriptors[2];
+	struct pollfd running;
+	int connection;
+	int busyConnection;
+	int attempt;
+	int status;
+	pid_t pid;
+	assert_true(mkdtemp(directory) != NULL);
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	snprintf(address.sun_path, sizeof(address.sun_path), "%s/socket", directory);
+
+	/* The server flushes the streams it inherits, which must be empty */
+	fflush(NULL);
+	pid = fork();
+	assert_true(pid != -1);
+	if(pid == 0) {
+		_exit(serverRun(address.sun_path, 2));
+	}
+	connection = socket(AF_UNIX, SOCK_STREAM, 0);
+	assert_true(connection != -1);
+	for(attempt = 0; attempt < 100; attempt++) {
+		if(connect(connection, (struct sockaddr *)&address, sizeof(address)) == 0) {
+			break;
+		}
+		usleep(10000);
+	}
+	assert_true(attempt < 100);
+
+	assert_int_equal(_request(connection, "echo out; echo err >&2; exit 3", NULL, 0,
+		output, errors), 3);
+	assert_string_equal(output, "out\n");
+	assert_string_equal(errors, "err\n");
+	/* Variables do not leak into the next command line */
+	assert_int_equal(_request(connection, "x=1", NULL, 0, output, errors), 0);
+	assert_int_equal(_request(connection, "echo \"[$x]\"", NULL, 0, output, errors), 0);
+	assert_string_equal(output, "[]\n");
+	assert_int_equal(_request(connection, "if true; then", NULL, 0, output, errors), 2);
+	assert_true(strncmp(errors, "mush: ", 6) == 0);
+
+	/* Passed descriptors replace the standard ones */
+	assert_int_equal(pipe(pipeDescriptors), 0);
+	descriptors[0] = pipeDescriptors[0];
+	descriptors[1] = pipeDescriptors[1];
+	assert_int_equal(write(pipeDescriptors[1], "in\n", 3), 3);
+	assert_int_equal(_request(connection, "read -r line; echo \"got $line\"", descriptors, 2,
+		output, errors), 0);
+	assert_string_equal(output, "");
+	assert_int_equal(read(pipeDescriptors[0], output, sizeof(output)), 7);
+	assert_true(strncmp(output, "got in\n", 7) == 0);
+	close(pipeDescriptors[0]);
+	close(pipeDescriptors[1]);
+
+	/* Commands still running stop with the server */
+	busyConnection = socket(AF_UNIX, SOCK_STREAM, 0);
+	assert_true(busyConnection != -1);
+	assert_int_equal(connect(busyConnection, (struct sockaddr *)&address, sizeof(address)), 0);
+	assert_int_equal(pipe(pipeDescriptors), 0);
+	descriptors[0] = open("/dev/null", O_RDONLY);
+	descriptors[1] = pipeDescriptors[1];
+	assert_int_equal(serverSendMessage(busyConnection, kServerMessageCommand,
+		"echo started; sleep 30", 22, descriptors, 2), 0);
+	close(descriptors[0]);
+	close(pipeDescriptors[1]);
+	assert_int_equal(read(pipeDescriptors[0], output, 8), 8);
+	assert_true(strncmp(output, "started\n", 8) == 0);
+
+	close(connection);
+	kill(pid, SIGTERM);
+	assert_int_equal(waitpid(pid, &status, 0), pid);
+	assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	/* The output pipe is closed once sleep is gone */
+	running.fd = pipeDescriptors[0];
+	running.events = POLLIN;
+	assert_int_equal(poll(&running, 1, 5000), 1);
+	assert_int_equal(read(pipeDescriptors[0], output, sizeof(output)), 0);
+	close(pipeDescriptors[0]);
+	close(busyConnection);
+	assert_int_equal(access(address.sun_path, F_OK), -1);
+	rmdir(directory);
+}
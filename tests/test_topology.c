@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmockery.h>
+#include <stdio.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "test_topology.h"
+#include "topology.h"
+
+/*! \brief Write \a contents to \a path below \a root, creating directories */
+static void _writeFile(const char *root, const char *path, const char *contents)
+{
+	char full[512];
+	char *slash;
+	FILE *file;
+	snprintf(full, sizeof(full), "%s/%s", root, path);
+	for(slash = strchr(full + strlen(root) + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+		*slash = '\0';
+		mkdir(full, 0755);
+		*slash = '/';
+	}
+	file = fopen(full, "w");
+	assert_true(file != NULL);
+	fputs(contents, file);
+	fclose(file);
+}
+
+static int _removeEntry(const char *path, const struct stat *sb, int flag, struct FTW *ftw)
+{
+	return remove(path);
+}
+
+void testTopologyPlacement(void **state)
+{
+	char root[] = "/tmp/mush_topologyXXXXXX";
+	char path[128];
+	/* Two nodes with two last level caches each, CPUs numbered across them */
+	const char *lastLevelCaches[] = {"0,2", "1,3", "0,2", "1,3", "4,6", "5,7", "4,6", "5,7"};
+	int group;
+	int cpu;
+	assert_true(mkdtemp(root) != NULL);
+
+	assert_int_equal(topologyLoad(root), -1);
+
+	_writeFile(root, "devices/system/cpu/online", "0-7\n");
+	_writeFile(root, "devices/system/node/node0/cpulist", "0-3\n");
+	_writeFile(root, "devices/system/node/node1/cpulist", "4-7\n");
+	for(cpu = 0; cpu < 8; cpu++) {
+		/* The instruction cache is not shared, but is ignored regardless */
+		snprintf(path, sizeof(path), "devices/system/cpu/cpu%d/cache/index0/level", cpu);
+		_writeFile(root, path, "1\n");
+		snprintf(path, sizeof(path), "devices/system/cpu/cpu%d/cache/index0/type", cpu);
+		_writeFile(root, path, "Instruction\n");
+		snprintf(path, sizeof(path), "devices/system/cpu/cpu%d/cache/index0/shared_cpu_list", cpu);
+		_writeFile(root, path, "0-7\n");
+		snprintf(path, sizeof(path), "devices/system/cpu/cpu%d/cache/index1/level", cpu);
+		_writeFile(root, path, "3\n");
+		snprintf(path, sizeof(path), "devices/system/cpu/cpu%d/cache/index1/type", cpu);
+		_writeFile(root, path, "Unified\n");
+		snprintf(path, sizeof(path), "devices/system/cpu/cpu%d/cache/index1/shared_cpu_list", cpu);
+		_writeFile(root, path, lastLevelCaches[cpu]);
+	}
+	assert_int_equal(topologyLoad(root), 0);
+
+	/* Adjacent stages share a cache, and wrap around within it */
+	group = topologyPlacePipeline();
+	assert_int_equal(group, 0);
+	assert_int_equal(topologyCpuForStage(group, 0), 0);
+	assert_int_equal(topologyCpuForStage(group, 1), 2);
+	assert_int_equal(topologyCpuForStage(group, 2), 0);
+
+	/* Consecutive pipelines alternate between nodes */
+	group = topologyPlacePipeline();
+	assert_int_equal(topologyCpuForStage(group, 0), 4);
+	assert_int_equal(topologyCpuForStage(group, 1), 6);
+	group = topologyPlacePipeline();
+	assert_int_equal(topologyCpuForStage(group, 0), 1);
+	assert_int_equal(topologyCpuForStage(group, 1), 3);
+	group = topologyPlacePipeline();
+	assert_int_equal(topologyCpuForStage(group, 0), 5);
+	assert_int_equal(topologyPlacePipeline(), 0);
+
+	nftw(root, _removeEntry, 8, FTW_DEPTH | FTW_PHYS);
+}
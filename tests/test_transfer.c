@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2008 Sebastian Nowicki <sebnow@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmockery.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "test_transfer.h"
+#include "transfer.h"
+
+/*! \brief Contents moved around by the tests, small enough for a pipe */
+#define TEST_CONTENTS "line one\nline two\n"
+
+static int _temporaryFile(const char *contents)
+{
+	FILE *file = tmpfile();
+	int descriptor = dup(fileno(file));
+	fclose(file);
+	write(descriptor, contents, strlen(contents));
+	lseek(descriptor, 0, SEEK_SET);
+	return descriptor;
+}
+
+static char *_readFile(int descriptor)
+{
+	char *buffer = calloc(1, 256);
+	lseek(descriptor, 0, SEEK_SET);
+	read(descriptor, buffer, 255);
+	return buffer;
+}
+
+void testTransferDescriptor(void **state)
+{
+	int input = _temporaryFile(TEST_CONTENTS);
+	int output = _temporaryFile("");
+	int pipeDescriptors[2];
+	char *contents;
+
+	/* File to file */
+	assert_int_equal(transferDescriptor(input, output), 0);
+	contents = _readFile(output);
+	assert_string_equal(contents, TEST_CONTENTS);
+	free(contents);
+
+	/* File to pipe and back into a file */
+	assert_int_equal(pipe(pipeDescriptors), 0);
+	lseek(input, 0, SEEK_SET);
+	assert_int_equal(transferDescriptor(input, pipeDescriptors[1]), 0);
+	close(pipeDescriptors[1]);
+	ftruncate(output, 0);
+	lseek(output, 0, SEEK_SET);
+	assert_int_equal(transferDescriptor(pipeDescriptors[0], output), 0);
+	close(pipeDescriptors[0]);
+	contents = _readFile(output);
+	assert_string_equal(contents, TEST_CONTENTS);
+	free(contents);
+	close(input);
+	close(output);
+}
+
+void testTransferDescriptorToMany(void **state)
+{
+	int inputPipe[2];
+	int outputPipe[2];
+	int outputs[3];
+	char buffer[64] = {0};
+	char *contents;
+
+	assert_int_equal(pipe(inputPipe), 0);
+	assert_int_equal(pipe(outputPipe), 0);
+	write(inputPipe[1], TEST_CONTENTS, strlen(TEST_CONTENTS));
+	close(inputPipe[1]);
+	outputs[0] = outputPipe[1];
+	outputs[1] = _temporaryFile("");
+	outputs[2] = _temporaryFile("");
+	assert_int_equal(transferDescriptorToMany(inputPipe[0], outputs, 3), 0);
+	close(inputPipe[0]);
+	close(outputPipe[1]);
+	read(outputPipe[0], buffer, sizeof(buffer) - 1);
+	close(outputPipe[0]);
+	assert_string_equal(buffer, TEST_CONTENTS);
+	contents = _readFile(outputs[1]);
+	assert_string_equal(contents, TEST_CONTENTS);
+	free(contents);
+	contents = _readFile(outputs[2]);
+	assert_string_equal(contents, TEST_CONTENTS);
+	free(contents);
+	close(outputs[1]);
+	close(outputs[2]);
+}